@@ -6,6 +6,7 @@
 #include "ArchiverRaw/RuntimeArchiverRaw.h"
 #include "ArchiverTar/RuntimeArchiverTar.h"
 #include "Streams/RuntimeArchiverFileStream.h"
+#include "Streams/RuntimeArchiverGZipStream.h"
 #include "Streams/RuntimeArchiverMemoryStream.h"
 
 URuntimeArchiverGZip::URuntimeArchiverGZip()
@@ -78,25 +79,8 @@ bool URuntimeArchiverGZip::OpenArchiveFromStorage(FString ArchivePath)
 		return false;
 	}
 
-	TArray64<uint8> CompressedArchiveData;
-	CompressedArchiveData.SetNumUninitialized(CompressedStream->Size());
-
-	if (!CompressedStream->Read(CompressedArchiveData.GetData(), CompressedArchiveData.Num()))
-	{
-		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to read gzip compressed stream to get archive data"));
-		Reset();
-		return false;
-	}
-
-	TArray64<uint8> TarArchiveData;
-	if (!URuntimeArchiverRaw::UncompressRawData(ERuntimeArchiverRawFormat::GZip, MoveTemp(CompressedArchiveData), TarArchiveData))
-	{
-		ReportError(ERuntimeArchiverErrorCode::GetError, FString::Printf(TEXT("Unable to uncompress gzip to tar data to open archive from storage '%s'"), *ArchivePath));
-		Reset();
-		return false;
-	}
-
-	if (!TarArchiver->OpenArchiveFromMemory(TarArchiveData))
+	// Inflating on the fly as the tar archiver reads, instead of decompressing the whole archive into memory
+	if (!TarArchiver->OpenArchiveFromStream(MakeUnique<FRuntimeArchiverGZipStream>(*CompressedStream)))
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open gzip archive from storage due to tar archiver error"));
 		Reset();
@@ -114,7 +98,7 @@ bool URuntimeArchiverGZip::OpenArchiveFromMemory(const TArray64<uint8>& ArchiveD
 		return false;
 	}
 
-	CompressedStream.Reset(new FRuntimeArchiverMemoryStream(ArchiveData));
+	CompressedStream.Reset(CreateMemoryReadStream(ArchiveData));
 	if (!CompressedStream->IsValid())
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open gzip stream because it is not valid"));
@@ -122,15 +106,7 @@ bool URuntimeArchiverGZip::OpenArchiveFromMemory(const TArray64<uint8>& ArchiveD
 		return false;
 	}
 
-	TArray64<uint8> TarArchiveData;
-	if (!URuntimeArchiverRaw::UncompressRawData(ERuntimeArchiverRawFormat::GZip, ArchiveData, TarArchiveData))
-	{
-		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to uncompress gzip to tar data to open archive from memory"));
-		Reset();
-		return false;
-	}
-
-	if (!TarArchiver->OpenArchiveFromMemory(TarArchiveData))
+	if (!TarArchiver->OpenArchiveFromStream(MakeUnique<FRuntimeArchiverGZipStream>(*CompressedStream)))
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open gzip archive from memory due to tar archiver error"));
 		Reset();
@@ -150,8 +126,9 @@ bool URuntimeArchiverGZip::CloseArchive()
 
 	if (Mode == ERuntimeArchiverMode::Write && Location == ERuntimeArchiverLocation::Storage)
 	{
+		// Moving the tar data out closes the tar archiver
 		TArray64<uint8> ArchiveData;
-		if (!GetArchiveData(ArchiveData))
+		if (!CompressTarArchiveData(ArchiveData))
 		{
 			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get archive data to close archive"));
 			return false;
@@ -169,8 +146,7 @@ bool URuntimeArchiverGZip::CloseArchive()
 			return false;
 		}
 	}
-
-	if (!TarArchiver->CloseArchive())
+	else if (!TarArchiver->CloseArchive())
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to close gzip archive due to tar archiver error"));
 		return false;
@@ -224,6 +200,24 @@ bool URuntimeArchiverGZip::GetArchiveData(TArray64<uint8>& ArchiveData)
 	return true;
 }
 
+bool URuntimeArchiverGZip::MoveArchiveData(TArray64<uint8>& ArchiveData)
+{
+	if (Mode != ERuntimeArchiverMode::Write || Location != ERuntimeArchiverLocation::Memory)
+	{
+		return Super::MoveArchiveData(ArchiveData);
+	}
+
+	if (!CompressTarArchiveData(ArchiveData))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to move gzip archive data due to tar archiver error"));
+		return false;
+	}
+
+	Reset();
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully moved gzip archive data out of memory with size '%lld'"), ArchiveData.Num());
+	return true;
+}
+
 bool URuntimeArchiverGZip::GetArchiveEntries(int32& NumOfArchiveEntries)
 {
 	if (!Super::GetArchiveEntries(NumOfArchiveEntries))
@@ -275,7 +269,7 @@ bool URuntimeArchiverGZip::GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntime
 	return true;
 }
 
-bool URuntimeArchiverGZip::AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
+bool URuntimeArchiverGZip::AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
 {
 	if (!Super::AddEntryFromMemory(EntryName, DataToBeArchived, CompressionLevel))
 	{
@@ -311,6 +305,42 @@ bool URuntimeArchiverGZip::ExtractEntryToMemory(const FRuntimeArchiveEntry& Entr
 	return true;
 }
 
+bool URuntimeArchiverGZip::ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed)
+{
+	if (!TarArchiver->ExtractFileEntryToStorage(EntryInfo, FilePath, OnProcessed))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to extract gzip entry due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted gzip entry '%s' into file '%s'"), *EntryInfo.Name, *FilePath);
+	return true;
+}
+
+bool URuntimeArchiverGZip::TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress)
+{
+	// Reading the tar data through the gzip stream also verifies that it decompresses
+	if (!TarArchiver->TestArchive_Internal(TestResult, OnProgress))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to test gzip archive due to tar archiver error"));
+		return false;
+	}
+
+	return true;
+}
+
+bool URuntimeArchiverGZip::ExtractEntriesToStorage_Directory_Internal(const FString& BaseName, const FString& DirectoryPath, const FString& BaseDirectoryPathToExclude, bool bForceOverwrite, TArray<FString>& FilePaths)
+{
+	// The tar archiver extracts the entries while reading the headers, so that the archive is only inflated once
+	if (!TarArchiver->ExtractEntriesToStorage_Directory_Internal(BaseName, DirectoryPath, BaseDirectoryPathToExclude, bForceOverwrite, FilePaths))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to extract gzip entries due to tar archiver error"));
+		return false;
+	}
+
+	return true;
+}
+
 bool URuntimeArchiverGZip::Initialize()
 {
 	if (!Super::Initialize())
@@ -333,6 +363,24 @@ bool URuntimeArchiverGZip::IsInitialized() const
 	return Super::IsInitialized() && TarArchiver.IsValid() && TarArchiver->IsInitialized();
 }
 
+bool URuntimeArchiverGZip::CompressTarArchiveData(TArray64<uint8>& ArchiveData)
+{
+	TArray64<uint8> TarArchiveData;
+	if (!TarArchiver->MoveArchiveData(TarArchiveData))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to move tar data out of gzip archive due to tar archiver error"));
+		return false;
+	}
+
+	if (!URuntimeArchiverRaw::CompressRawData(ERuntimeArchiverRawFormat::GZip, LastCompressionLevel, TarArchiveData, ArchiveData))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to compress tar to gzip data"));
+		return false;
+	}
+
+	return true;
+}
+
 void URuntimeArchiverGZip::Reset()
 {
 	if (TarArchiver.IsValid())
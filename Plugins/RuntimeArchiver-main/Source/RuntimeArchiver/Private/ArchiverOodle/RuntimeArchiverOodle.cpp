@@ -6,10 +6,12 @@
 #include "ArchiverRaw/RuntimeArchiverRaw.h"
 #include "ArchiverTar/RuntimeArchiverTar.h"
 #include "Streams/RuntimeArchiverFileStream.h"
+#include "Streams/RuntimeArchiverBlockStream.h"
 #include "Streams/RuntimeArchiverMemoryStream.h"
 
 URuntimeArchiverOodle::URuntimeArchiverOodle()
-	: LastCompressionLevel{ERuntimeArchiverCompressionLevel::Compression6}
+	: MaxBlockWorkers{0}
+  , BlockStream{nullptr}
 {
 }
 
@@ -28,7 +30,9 @@ bool URuntimeArchiverOodle::CreateArchiveInStorage(FString ArchivePath)
 		return false;
 	}
 
-	if (!TarArchiver->CreateArchiveInMemory(0))
+	// The tar data is compressed block by block as it is written
+	BlockStream = FRuntimeArchiverBlockStream::Create(ERuntimeArchiverRawFormat::Oodle, *CompressedStream, true, MaxBlockWorkers);
+	if (!BlockStream || !TarArchiver->CreateArchiveInStream(TUniquePtr<FRuntimeArchiverBaseStream>(BlockStream)))
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to create Oodle archive in storage '%s' due to tar archiver error"), *ArchivePath);
 		Reset();
@@ -53,7 +57,8 @@ bool URuntimeArchiverOodle::CreateArchiveInMemory(int32 InitialAllocationSize)
 		return false;
 	}
 
-	if (!TarArchiver->CreateArchiveInMemory(InitialAllocationSize))
+	BlockStream = FRuntimeArchiverBlockStream::Create(ERuntimeArchiverRawFormat::Oodle, *CompressedStream, true, MaxBlockWorkers);
+	if (!BlockStream || !TarArchiver->CreateArchiveInStream(TUniquePtr<FRuntimeArchiverBaseStream>(BlockStream)))
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to create Oodle archive in memory due to tar archiver error"));
 		Reset();
@@ -78,10 +83,25 @@ bool URuntimeArchiverOodle::OpenArchiveFromStorage(FString ArchivePath)
 		return false;
 	}
 
+	if (FRuntimeArchiverBlockStream::IsBlockFormat(ERuntimeArchiverRawFormat::Oodle, *CompressedStream))
+	{
+		// Decompressing blocks as the tar archiver reads them
+		if (!TarArchiver->OpenArchiveFromStream(TUniquePtr<FRuntimeArchiverBaseStream>(FRuntimeArchiverBlockStream::Create(ERuntimeArchiverRawFormat::Oodle, *CompressedStream, false, MaxBlockWorkers))))
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open Oodle archive from storage due to tar archiver error"));
+			Reset();
+			return false;
+		}
+
+		UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully opened Oodle archive '%s' in '%s' to read"), *GetName(), *ArchivePath);
+		return true;
+	}
+
+	// Archives created by earlier versions are compressed as a whole
 	TArray64<uint8> CompressedArchiveData;
 	CompressedArchiveData.SetNumUninitialized(CompressedStream->Size());
 
-	if (!CompressedStream->Read(CompressedArchiveData.GetData(), CompressedArchiveData.Num()))
+	if (!CompressedStream->Seek(0) || !CompressedStream->Read(CompressedArchiveData.GetData(), CompressedArchiveData.Num()))
 	{
 		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to read Oodle compressed stream to get archive data"));
 		Reset();
@@ -96,7 +116,7 @@ bool URuntimeArchiverOodle::OpenArchiveFromStorage(FString ArchivePath)
 		return false;
 	}
 
-	if (!TarArchiver->OpenArchiveFromMemory(TarArchiveData))
+	if (!TarArchiver->OpenArchiveFromMemory(MoveTemp(TarArchiveData)))
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open Oodle archive from storage due to tar archiver error"));
 		Reset();
@@ -114,7 +134,7 @@ bool URuntimeArchiverOodle::OpenArchiveFromMemory(const TArray64<uint8>& Archive
 		return false;
 	}
 
-	CompressedStream.Reset(new FRuntimeArchiverMemoryStream(ArchiveData));
+	CompressedStream.Reset(CreateMemoryReadStream(ArchiveData));
 	if (!CompressedStream->IsValid())
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open Oodle stream because it is not valid"));
@@ -122,6 +142,20 @@ bool URuntimeArchiverOodle::OpenArchiveFromMemory(const TArray64<uint8>& Archive
 		return false;
 	}
 
+	if (FRuntimeArchiverBlockStream::IsBlockFormat(ERuntimeArchiverRawFormat::Oodle, *CompressedStream))
+	{
+		if (!TarArchiver->OpenArchiveFromStream(TUniquePtr<FRuntimeArchiverBaseStream>(FRuntimeArchiverBlockStream::Create(ERuntimeArchiverRawFormat::Oodle, *CompressedStream, false, MaxBlockWorkers))))
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open Oodle archive from memory due to tar archiver error"));
+			Reset();
+			return false;
+		}
+
+		UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully opened in-memory Oodle archive '%s' to read"), *GetName());
+		return true;
+	}
+
+	// Archives created by earlier versions are compressed as a whole
 	TArray64<uint8> TarArchiveData;
 	if (!URuntimeArchiverRaw::UncompressRawData(ERuntimeArchiverRawFormat::Oodle, ArchiveData, TarArchiveData))
 	{
@@ -130,7 +164,7 @@ bool URuntimeArchiverOodle::OpenArchiveFromMemory(const TArray64<uint8>& Archive
 		return false;
 	}
 
-	if (!TarArchiver->OpenArchiveFromMemory(TarArchiveData))
+	if (!TarArchiver->OpenArchiveFromMemory(MoveTemp(TarArchiveData)))
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open Oodle archive from memory due to tar archiver error"));
 		Reset();
@@ -148,26 +182,10 @@ bool URuntimeArchiverOodle::CloseArchive()
 		return false;
 	}
 
-	if (Mode == ERuntimeArchiverMode::Write && Location == ERuntimeArchiverLocation::Storage)
+	if (Mode == ERuntimeArchiverMode::Write && !FinishArchive())
 	{
-		TArray64<uint8> ArchiveData;
-		if (!GetArchiveData(ArchiveData))
-		{
-			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get archive data to close archive"));
-			return false;
-		}
-
-		if (!CompressedStream->Seek(0))
-		{
-			ReportError(ERuntimeArchiverErrorCode::CloseError, TEXT("Unable to seek first position in Oodle archive to close archive"));
-			return false;
-		}
-
-		if (!CompressedStream->Write(ArchiveData.GetData(), ArchiveData.Num()))
-		{
-			ReportError(ERuntimeArchiverErrorCode::CloseError, TEXT("Unable to write archive data to Oodle compressed stream to close archive"));
-			return false;
-		}
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish Oodle archive to close archive"));
+		return false;
 	}
 
 	if (!TarArchiver->CloseArchive())
@@ -188,42 +206,55 @@ bool URuntimeArchiverOodle::GetArchiveData(TArray64<uint8>& ArchiveData)
 		return false;
 	}
 
-	if (Mode == ERuntimeArchiverMode::Read)
+	// The compressed data is complete only once the archive is finished, so nothing can be added afterwards
+	if (Mode == ERuntimeArchiverMode::Write && !FinishArchive())
 	{
-		ArchiveData.SetNumUninitialized(CompressedStream->Size());
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish Oodle archive to get archive data"));
+		return false;
+	}
 
-		if (!CompressedStream->Seek(0))
-		{
-			ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to seek first position in Oodle archive to get archive data"));
-			return false;
-		}
+	ArchiveData.SetNumUninitialized(CompressedStream->Size());
 
-		if (!CompressedStream->Read(ArchiveData.GetData(), ArchiveData.Num()))
-		{
-			ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to read Oodle compressed stream to get archive data"));
-			return false;
-		}
-	}
-	else if (Mode == ERuntimeArchiverMode::Write)
+	if (!CompressedStream->Seek(0))
 	{
-		TArray64<uint8> TarArchiveData;
-		if (!TarArchiver->GetArchiveData(TarArchiveData))
-		{
-			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get Oodle archive data due to tar archiver error"));
-			return false;
-		}
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to seek first position in Oodle archive to get archive data"));
+		return false;
+	}
 
-		if (!URuntimeArchiverRaw::CompressRawData(ERuntimeArchiverRawFormat::Oodle, LastCompressionLevel, TarArchiveData, ArchiveData))
-		{
-			ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to compress tar to Oodle data to get archive data"));
-			return false;
-		}
+	if (!CompressedStream->Read(ArchiveData.GetData(), ArchiveData.Num()))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to read Oodle compressed stream to get archive data"));
+		return false;
 	}
 
 	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully retrieved Oodle archive data from memory with size '%lld'"), ArchiveData.Num());
 	return true;
 }
 
+bool URuntimeArchiverOodle::MoveArchiveData(TArray64<uint8>& ArchiveData)
+{
+	if (Mode != ERuntimeArchiverMode::Write || Location != ERuntimeArchiverLocation::Memory)
+	{
+		return Super::MoveArchiveData(ArchiveData);
+	}
+
+	if (!FinishArchive())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish oodle archive to move archive data"));
+		return false;
+	}
+
+	if (!CompressedStream->MoveData(ArchiveData))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to move oodle compressed stream data out of memory"));
+		return false;
+	}
+
+	Reset();
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully moved oodle archive data out of memory with size '%lld'"), ArchiveData.Num());
+	return true;
+}
+
 bool URuntimeArchiverOodle::GetArchiveEntries(int32& NumOfArchiveEntries)
 {
 	if (!Super::GetArchiveEntries(NumOfArchiveEntries))
@@ -275,20 +306,24 @@ bool URuntimeArchiverOodle::GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntim
 	return true;
 }
 
-bool URuntimeArchiverOodle::AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
+bool URuntimeArchiverOodle::AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
 {
 	if (!Super::AddEntryFromMemory(EntryName, DataToBeArchived, CompressionLevel))
 	{
 		return false;
 	}
 
+	if (BlockStream)
+	{
+		BlockStream->SetCompressionLevel(GetEntryCompressionLevel(EntryName, DataToBeArchived.GetData(), DataToBeArchived.Num(), CompressionLevel));
+	}
+
 	if (!TarArchiver->AddEntryFromMemory(EntryName, DataToBeArchived, CompressionLevel))
 	{
 		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to add Oodle entry due to tar archiver error"));
 		return false;
 	}
 
-	LastCompressionLevel = CompressionLevel;
 	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully added Oodle entry '%s' with size %lld bytes from memory"), *EntryName, DataToBeArchived.Num());
 	return true;
 }
@@ -310,6 +345,30 @@ bool URuntimeArchiverOodle::ExtractEntryToMemory(const FRuntimeArchiveEntry& Ent
 	return true;
 }
 
+bool URuntimeArchiverOodle::ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed)
+{
+	if (!TarArchiver->ExtractFileEntryToStorage(EntryInfo, FilePath, OnProcessed))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to extract Oodle entry due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted Oodle entry '%s' into file '%s'"), *EntryInfo.Name, *FilePath);
+	return true;
+}
+
+bool URuntimeArchiverOodle::TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress)
+{
+	// Reading the tar data through the Oodle stream also verifies that it decompresses
+	if (!TarArchiver->TestArchive_Internal(TestResult, OnProgress))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to test Oodle archive due to tar archiver error"));
+		return false;
+	}
+
+	return true;
+}
+
 bool URuntimeArchiverOodle::Initialize()
 {
 	if (!Super::Initialize())
@@ -332,6 +391,29 @@ bool URuntimeArchiverOodle::IsInitialized() const
 	return Super::IsInitialized() && TarArchiver.IsValid() && TarArchiver->IsInitialized();
 }
 
+bool URuntimeArchiverOodle::FinishArchive()
+{
+	if (!BlockStream)
+	{
+		ReportError(ERuntimeArchiverErrorCode::CloseError, TEXT("Unable to finish Oodle archive because the block stream is not valid"));
+		return false;
+	}
+
+	if (!TarArchiver->FinalizeArchive())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish Oodle archive due to tar archiver error"));
+		return false;
+	}
+
+	if (!BlockStream->Finish())
+	{
+		ReportError(ERuntimeArchiverErrorCode::CloseError, TEXT("Unable to compress the remaining Oodle blocks to finish archive"));
+		return false;
+	}
+
+	return true;
+}
+
 void URuntimeArchiverOodle::Reset()
 {
 	if (TarArchiver.IsValid())
@@ -340,6 +422,8 @@ void URuntimeArchiverOodle::Reset()
 		TarArchiver.Reset();
 	}
 
+	// The block stream is owned by the tar archiver and must be destroyed before the compressed stream it writes to
+	BlockStream = nullptr;
 	CompressedStream.Reset();
 	Super::Reset();
 	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully uninitialized Oodle archiver '%s'"), *GetName());
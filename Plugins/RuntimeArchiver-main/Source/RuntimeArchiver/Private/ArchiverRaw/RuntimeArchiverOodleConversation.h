@@ -0,0 +1,78 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "RuntimeArchiverTypes.h"
+#include "Misc/EngineVersionComparison.h"
+
+#if UE_VERSION_NEWER_THAN(5, 0, 0)
+#include "Compression/OodleDataCompression.h"
+
+/**
+ * Convert plugin-specific archiver data to Oodle compressor-specific data
+ */
+namespace OodleConversation
+{
+	inline FOodleDataCompression::ECompressor GetCompressor(ERuntimeArchiverCompressionLevel CompressionLevel)
+	{
+		switch (CompressionLevel)
+		{
+		case ERuntimeArchiverCompressionLevel::Compression0:
+			return FOodleDataCompression::ECompressor::Selkie;
+		case ERuntimeArchiverCompressionLevel::Compression1:
+			return FOodleDataCompression::ECompressor::Selkie;
+		case ERuntimeArchiverCompressionLevel::Compression2:
+			return FOodleDataCompression::ECompressor::Mermaid;
+		case ERuntimeArchiverCompressionLevel::Compression3:
+			return FOodleDataCompression::ECompressor::Mermaid;
+		case ERuntimeArchiverCompressionLevel::Compression4:
+			return FOodleDataCompression::ECompressor::Mermaid;
+		case ERuntimeArchiverCompressionLevel::Compression5:
+			return FOodleDataCompression::ECompressor::Kraken;
+		case ERuntimeArchiverCompressionLevel::Compression6:
+			return FOodleDataCompression::ECompressor::Kraken;
+		case ERuntimeArchiverCompressionLevel::Compression7:
+			return FOodleDataCompression::ECompressor::Kraken;
+		case ERuntimeArchiverCompressionLevel::Compression8:
+			return FOodleDataCompression::ECompressor::Leviathan;
+		case ERuntimeArchiverCompressionLevel::Compression9:
+			return FOodleDataCompression::ECompressor::Leviathan;
+		case ERuntimeArchiverCompressionLevel::Compression10:
+			return FOodleDataCompression::ECompressor::Leviathan;
+		default:
+			return FOodleDataCompression::ECompressor::NotSet;
+		}
+	}
+
+	inline FOodleDataCompression::ECompressionLevel GetCompressionLevel(ERuntimeArchiverCompressionLevel CompressionLevel)
+	{
+		switch (CompressionLevel)
+		{
+		case ERuntimeArchiverCompressionLevel::Compression0:
+			return FOodleDataCompression::ECompressionLevel::HyperFast1;
+		case ERuntimeArchiverCompressionLevel::Compression1:
+			return FOodleDataCompression::ECompressionLevel::SuperFast;
+		case ERuntimeArchiverCompressionLevel::Compression2:
+			return FOodleDataCompression::ECompressionLevel::VeryFast;
+		case ERuntimeArchiverCompressionLevel::Compression3:
+			return FOodleDataCompression::ECompressionLevel::Fast;
+		case ERuntimeArchiverCompressionLevel::Compression4:
+			return FOodleDataCompression::ECompressionLevel::Normal;
+		case ERuntimeArchiverCompressionLevel::Compression5:
+			return FOodleDataCompression::ECompressionLevel::Fast;
+		case ERuntimeArchiverCompressionLevel::Compression6:
+			return FOodleDataCompression::ECompressionLevel::Normal;
+		case ERuntimeArchiverCompressionLevel::Compression7:
+			return FOodleDataCompression::ECompressionLevel::Optimal1;
+		case ERuntimeArchiverCompressionLevel::Compression8:
+			return FOodleDataCompression::ECompressionLevel::Optimal2;
+		case ERuntimeArchiverCompressionLevel::Compression9:
+			return FOodleDataCompression::ECompressionLevel::Optimal3;
+		case ERuntimeArchiverCompressionLevel::Compression10:
+			return FOodleDataCompression::ECompressionLevel::Optimal4;
+		default:
+			return FOodleDataCompression::ECompressionLevel::None;
+		}
+	}
+}
+#endif
@@ -2,11 +2,13 @@
 
 #include "ArchiverRaw/RuntimeArchiverRaw.h"
 #include "RuntimeArchiverDefines.h"
+#include "RuntimeArchiverThreadPool.h"
 #include "Async/Async.h"
 #include "Misc/EngineVersionComparison.h"
 #include "Misc/Compression.h"
 #if UE_VERSION_NEWER_THAN(5, 0, 0)
 #include "Compression/OodleDataCompressionUtil.h"
+#include "RuntimeArchiverOodleConversation.h"
 #endif
 
 namespace
@@ -60,76 +62,6 @@ namespace
 	}
 }
 
-#if UE_VERSION_NEWER_THAN(5, 0, 0)
-/**
- * Convert plugin-specific archiver data to Oodle compressor-specific data
- */
-namespace OodleConversation
-{
-	FOodleDataCompression::ECompressor GetCompressor(ERuntimeArchiverCompressionLevel CompressionLevel)
-	{
-		switch (CompressionLevel)
-		{
-		case ERuntimeArchiverCompressionLevel::Compression0:
-			return FOodleDataCompression::ECompressor::Selkie;
-		case ERuntimeArchiverCompressionLevel::Compression1:
-			return FOodleDataCompression::ECompressor::Selkie;
-		case ERuntimeArchiverCompressionLevel::Compression2:
-			return FOodleDataCompression::ECompressor::Mermaid;
-		case ERuntimeArchiverCompressionLevel::Compression3:
-			return FOodleDataCompression::ECompressor::Mermaid;
-		case ERuntimeArchiverCompressionLevel::Compression4:
-			return FOodleDataCompression::ECompressor::Mermaid;
-		case ERuntimeArchiverCompressionLevel::Compression5:
-			return FOodleDataCompression::ECompressor::Kraken;
-		case ERuntimeArchiverCompressionLevel::Compression6:
-			return FOodleDataCompression::ECompressor::Kraken;
-		case ERuntimeArchiverCompressionLevel::Compression7:
-			return FOodleDataCompression::ECompressor::Kraken;
-		case ERuntimeArchiverCompressionLevel::Compression8:
-			return FOodleDataCompression::ECompressor::Leviathan;
-		case ERuntimeArchiverCompressionLevel::Compression9:
-			return FOodleDataCompression::ECompressor::Leviathan;
-		case ERuntimeArchiverCompressionLevel::Compression10:
-			return FOodleDataCompression::ECompressor::Leviathan;
-		default:
-			return FOodleDataCompression::ECompressor::NotSet;
-		}
-	}
-
-	FOodleDataCompression::ECompressionLevel GetCompressionLevel(ERuntimeArchiverCompressionLevel CompressionLevel)
-	{
-		switch (CompressionLevel)
-		{
-		case ERuntimeArchiverCompressionLevel::Compression0:
-			return FOodleDataCompression::ECompressionLevel::HyperFast1;
-		case ERuntimeArchiverCompressionLevel::Compression1:
-			return FOodleDataCompression::ECompressionLevel::SuperFast;
-		case ERuntimeArchiverCompressionLevel::Compression2:
-			return FOodleDataCompression::ECompressionLevel::VeryFast;
-		case ERuntimeArchiverCompressionLevel::Compression3:
-			return FOodleDataCompression::ECompressionLevel::Fast;
-		case ERuntimeArchiverCompressionLevel::Compression4:
-			return FOodleDataCompression::ECompressionLevel::Normal;
-		case ERuntimeArchiverCompressionLevel::Compression5:
-			return FOodleDataCompression::ECompressionLevel::Fast;
-		case ERuntimeArchiverCompressionLevel::Compression6:
-			return FOodleDataCompression::ECompressionLevel::Normal;
-		case ERuntimeArchiverCompressionLevel::Compression7:
-			return FOodleDataCompression::ECompressionLevel::Optimal1;
-		case ERuntimeArchiverCompressionLevel::Compression8:
-			return FOodleDataCompression::ECompressionLevel::Optimal2;
-		case ERuntimeArchiverCompressionLevel::Compression9:
-			return FOodleDataCompression::ECompressionLevel::Optimal3;
-		case ERuntimeArchiverCompressionLevel::Compression10:
-			return FOodleDataCompression::ECompressionLevel::Optimal4;
-		default:
-			return FOodleDataCompression::ECompressionLevel::None;
-		}
-	}
-}
-#endif
-
 void URuntimeArchiverRaw::CompressRawDataAsync(ERuntimeArchiverRawFormat RawFormat, ERuntimeArchiverCompressionLevel CompressionLevel, TArray<uint8> UncompressedData, const FRuntimeArchiverRawMemoryResult& OnResult)
 {
 	CompressRawDataAsync(RawFormat, CompressionLevel, TArray64<uint8>(MoveTemp(UncompressedData)),
@@ -147,7 +79,7 @@ void URuntimeArchiverRaw::CompressRawDataAsync(ERuntimeArchiverRawFormat RawForm
 
 void URuntimeArchiverRaw::CompressRawDataAsync(ERuntimeArchiverRawFormat RawFormat, ERuntimeArchiverCompressionLevel CompressionLevel, TArray64<uint8> UncompressedData, const FRuntimeArchiverRawMemoryResultNative& OnResult)
 {
-	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [RawFormat, CompressionLevel, UncompressedData = MoveTemp(UncompressedData), OnResult]() mutable
+	RuntimeArchiverThreadPool::Launch([RawFormat, CompressionLevel, UncompressedData = MoveTemp(UncompressedData), OnResult]() mutable
 	{
 		TArray64<uint8> CompressedData;
 		CompressRawData(RawFormat, CompressionLevel, MoveTemp(UncompressedData), CompressedData);
@@ -219,7 +151,7 @@ void URuntimeArchiverRaw::UncompressRawDataAsync(ERuntimeArchiverRawFormat RawFo
 
 void URuntimeArchiverRaw::UncompressRawDataAsync(ERuntimeArchiverRawFormat RawFormat, TArray64<uint8> CompressedData, const FRuntimeArchiverRawMemoryResultNative& OnResult)
 {
-	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [RawFormat, CompressedData = MoveTemp(CompressedData), OnResult]() mutable
+	RuntimeArchiverThreadPool::Launch([RawFormat, CompressedData = MoveTemp(CompressedData), OnResult]() mutable
 	{
 		TArray64<uint8> UncompressedData;
 		UncompressRawData(RawFormat, CompressedData = MoveTemp(CompressedData), UncompressedData);
@@ -0,0 +1,555 @@
+﻿// Georgy Treshchev 2024.
+
+#include "ArchiverSeekable/RuntimeArchiverSeekable.h"
+#include "RuntimeArchiverDefines.h"
+#include "RuntimeArchiverUtilities.h"
+#include "ArchiverTar/RuntimeArchiverTar.h"
+#include "Streams/RuntimeArchiverFileStream.h"
+#include "Streams/RuntimeArchiverMappedFileStream.h"
+#include "Streams/RuntimeArchiverMemoryStream.h"
+#include "Streams/RuntimeArchiverSeekableStream.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	/** Version of the file table layout */
+	constexpr int32 SeekableFileTableVersion = 1;
+
+	/**
+	 * Serialize the entries into the file table stored in the seekable stream
+	 */
+	void SerializeFileTable(const TArray<FRuntimeArchiverTarIndexedEntry>& Entries, TArray64<uint8>& FileTable)
+	{
+		FMemoryWriter64 Writer(FileTable);
+
+		int32 Version = SeekableFileTableVersion;
+		int32 NumOfEntries = Entries.Num();
+		Writer << Version << NumOfEntries;
+
+		for (const FRuntimeArchiverTarIndexedEntry& IndexedEntry : Entries)
+		{
+			FRuntimeArchiveEntry Entry = IndexedEntry.Entry;
+			int64 HeaderOffset = IndexedEntry.HeaderOffset;
+			Writer << Entry.Name << Entry.bIsDirectory << Entry.UncompressedSize << Entry.CompressedSize << Entry.CreationTime << HeaderOffset;
+		}
+	}
+
+	/**
+	 * Deserialize the entries from the file table stored in the seekable stream
+	 *
+	 * @return Whether the file table is valid or not
+	 */
+	bool DeserializeFileTable(const TArray64<uint8>& FileTable, TArray<FRuntimeArchiverTarIndexedEntry>& Entries)
+	{
+		FLargeMemoryReader Reader(FileTable.GetData(), FileTable.Num());
+
+		int32 Version = 0;
+		int32 NumOfEntries = 0;
+		Reader << Version << NumOfEntries;
+
+		if (Reader.IsError() || Version != SeekableFileTableVersion || NumOfEntries < 0)
+		{
+			return false;
+		}
+
+		Entries.Reset(NumOfEntries);
+
+		for (int32 Index = 0; Index < NumOfEntries && !Reader.IsError(); ++Index)
+		{
+			FRuntimeArchiverTarIndexedEntry& IndexedEntry = Entries.AddDefaulted_GetRef();
+			IndexedEntry.Entry.Index = Index;
+			Reader << IndexedEntry.Entry.Name << IndexedEntry.Entry.bIsDirectory << IndexedEntry.Entry.UncompressedSize << IndexedEntry.Entry.CompressedSize << IndexedEntry.Entry.CreationTime << IndexedEntry.HeaderOffset;
+		}
+
+		return !Reader.IsError() && Reader.AtEnd();
+	}
+}
+
+URuntimeArchiverSeekable::URuntimeArchiverSeekable()
+	: MaxFrameWorkers{0}
+  , SeekableStream{nullptr}
+{
+}
+
+bool URuntimeArchiverSeekable::CreateArchiveInStorage(FString ArchivePath)
+{
+	if (!Super::CreateArchiveInStorage(ArchivePath))
+	{
+		return false;
+	}
+
+	CompressedStream.Reset(new FRuntimeArchiverFileStream(ArchivePath, true));
+	if (!CompressedStream->IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open seekable stream because it is not valid"));
+		Reset();
+		return false;
+	}
+
+	// The tar data is compressed frame by frame as it is written
+	SeekableStream = new FRuntimeArchiverSeekableStream(*CompressedStream, true, MaxFrameWorkers);
+	if (!TarArchiver->CreateArchiveInStream(TUniquePtr<FRuntimeArchiverBaseStream>(SeekableStream)))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to create seekable archive in storage '%s' due to tar archiver error"), *ArchivePath);
+		Reset();
+		return false;
+	}
+
+	// Written entries are kept for the file table
+	TarArchiver->TarEncapsulator->SetRecordIndexedEntries(true);
+
+	return true;
+}
+
+bool URuntimeArchiverSeekable::CreateArchiveInMemory(int32 InitialAllocationSize)
+{
+	if (!Super::CreateArchiveInMemory(InitialAllocationSize))
+	{
+		return false;
+	}
+
+	CompressedStream.Reset(new FRuntimeArchiverMemoryStream(InitialAllocationSize));
+	if (!CompressedStream->IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open seekable stream because it is not valid"));
+		Reset();
+		return false;
+	}
+
+	SeekableStream = new FRuntimeArchiverSeekableStream(*CompressedStream, true, MaxFrameWorkers);
+	if (!TarArchiver->CreateArchiveInStream(TUniquePtr<FRuntimeArchiverBaseStream>(SeekableStream)))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to create seekable archive in memory due to tar archiver error"));
+		Reset();
+		return false;
+	}
+
+	TarArchiver->TarEncapsulator->SetRecordIndexedEntries(true);
+
+	return true;
+}
+
+bool URuntimeArchiverSeekable::OpenArchiveFromStorage(FString ArchivePath)
+{
+	if (!Super::OpenArchiveFromStorage(ArchivePath))
+	{
+		return false;
+	}
+
+	// Frames are read at random offsets, which is cheapest through a memory mapping
+	CompressedStream.Reset(new FRuntimeArchiverMappedFileStream(ArchivePath));
+	if (!CompressedStream->IsValid())
+	{
+		CompressedStream.Reset(new FRuntimeArchiverFileStream(ArchivePath, false));
+	}
+
+	if (!CompressedStream->IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open seekable stream because it is not valid"));
+		Reset();
+		return false;
+	}
+
+	if (!OpenSeekableStream())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open seekable archive from storage '%s'"), *ArchivePath);
+		Reset();
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully opened seekable archive '%s' in '%s' to read"), *GetName(), *ArchivePath);
+	return true;
+}
+
+bool URuntimeArchiverSeekable::OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData)
+{
+	if (!Super::OpenArchiveFromMemory(ArchiveData))
+	{
+		return false;
+	}
+
+	CompressedStream.Reset(CreateMemoryReadStream(ArchiveData));
+	if (!CompressedStream->IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open seekable stream because it is not valid"));
+		Reset();
+		return false;
+	}
+
+	if (!OpenSeekableStream())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open seekable archive from memory"));
+		Reset();
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully opened in-memory seekable archive '%s' to read"), *GetName());
+	return true;
+}
+
+bool URuntimeArchiverSeekable::OpenSeekableStream()
+{
+	if (!FRuntimeArchiverSeekableStream::IsSeekableFormat(*CompressedStream))
+	{
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to open seekable archive because the data is not in the seekable format"));
+		return false;
+	}
+
+	TUniquePtr<FRuntimeArchiverSeekableStream> Stream = MakeUnique<FRuntimeArchiverSeekableStream>(*CompressedStream, false, MaxFrameWorkers);
+	if (!Stream->IsValid())
+	{
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to read the frame index of seekable archive"));
+		return false;
+	}
+
+	FileTableEntries.Reset();
+	FileTableIndicesByName.Reset();
+
+	// Archives without a file table are still readable, the tar headers are scanned instead
+	if (Stream->GetFileTable().Num() > 0)
+	{
+		if (!DeserializeFileTable(Stream->GetFileTable(), FileTableEntries))
+		{
+			ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to parse the file table of seekable archive"));
+			return false;
+		}
+
+		for (const FRuntimeArchiverTarIndexedEntry& IndexedEntry : FileTableEntries)
+		{
+			if (!FileTableIndicesByName.Contains(IndexedEntry.Entry.Name))
+			{
+				FileTableIndicesByName.Add(IndexedEntry.Entry.Name, IndexedEntry.Entry.Index);
+			}
+		}
+	}
+
+	SeekableStream = Stream.Get();
+
+	if (!TarArchiver->OpenArchiveFromStream(MoveTemp(Stream), FileTableEntries.Num() > 0 ? &FileTableEntries : nullptr))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open seekable archive due to tar archiver error"));
+		SeekableStream = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+bool URuntimeArchiverSeekable::CloseArchive()
+{
+	if (!Super::CloseArchive())
+	{
+		return false;
+	}
+
+	if (Mode == ERuntimeArchiverMode::Write && !FinishArchive())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish seekable archive to close archive"));
+		return false;
+	}
+
+	if (!TarArchiver->CloseArchive())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to close seekable archive due to tar archiver error"));
+		return false;
+	}
+
+	Reset();
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully closed seekable archive '%s'"), *GetName());
+	return true;
+}
+
+bool URuntimeArchiverSeekable::GetArchiveData(TArray64<uint8>& ArchiveData)
+{
+	if (!Super::GetArchiveData(ArchiveData))
+	{
+		return false;
+	}
+
+	// The frame index and the file table are written only once the archive is finished, so nothing can be added afterwards
+	if (Mode == ERuntimeArchiverMode::Write && !FinishArchive())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish seekable archive to get archive data"));
+		return false;
+	}
+
+	ArchiveData.SetNumUninitialized(CompressedStream->Size());
+
+	if (!CompressedStream->Seek(0))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to seek first position in seekable archive to get archive data"));
+		return false;
+	}
+
+	if (!CompressedStream->Read(ArchiveData.GetData(), ArchiveData.Num()))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to read seekable compressed stream to get archive data"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully retrieved seekable archive data from memory with size '%lld'"), ArchiveData.Num());
+	return true;
+}
+
+bool URuntimeArchiverSeekable::MoveArchiveData(TArray64<uint8>& ArchiveData)
+{
+	if (Mode != ERuntimeArchiverMode::Write || Location != ERuntimeArchiverLocation::Memory)
+	{
+		return Super::MoveArchiveData(ArchiveData);
+	}
+
+	if (!FinishArchive())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish seekable archive to move archive data"));
+		return false;
+	}
+
+	if (!CompressedStream->MoveData(ArchiveData))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to move seekable compressed stream data out of memory"));
+		return false;
+	}
+
+	Reset();
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully moved seekable archive data out of memory with size '%lld'"), ArchiveData.Num());
+	return true;
+}
+
+bool URuntimeArchiverSeekable::GetArchiveEntries(int32& NumOfArchiveEntries)
+{
+	if (!Super::GetArchiveEntries(NumOfArchiveEntries))
+	{
+		return false;
+	}
+
+	if (!TarArchiver->GetArchiveEntries(NumOfArchiveEntries))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to the get number of seekable entries due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully retrieved %d seekable entries"), NumOfArchiveEntries);
+	return true;
+}
+
+bool URuntimeArchiverSeekable::GetArchiveEntryInfoByName(FString EntryName, FRuntimeArchiveEntry& EntryInfo)
+{
+	if (!Super::GetArchiveEntryInfoByName(EntryName, EntryInfo))
+	{
+		return false;
+	}
+
+	// Entries listed in the file table are retrieved without decompressing the frame containing the header
+	if (const int32* FileTableIndex = FileTableIndicesByName.Find(EntryName))
+	{
+		EntryInfo = FileTableEntries[*FileTableIndex].Entry;
+		UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully retrieved seekable entry '%s' by name from the file table"), *EntryInfo.Name);
+		return true;
+	}
+
+	if (!TarArchiver->GetArchiveEntryInfoByName(MoveTemp(EntryName), EntryInfo))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get seekable entry by name due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully retrieved seekable entry '%s' by name"), *EntryInfo.Name);
+	return true;
+}
+
+bool URuntimeArchiverSeekable::GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeArchiveEntry& EntryInfo)
+{
+	if (!Super::GetArchiveEntryInfoByIndex(EntryIndex, EntryInfo))
+	{
+		return false;
+	}
+
+	if (FileTableEntries.IsValidIndex(EntryIndex))
+	{
+		EntryInfo = FileTableEntries[EntryIndex].Entry;
+		UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully retrieved seekable entry '%s' by index from the file table"), *EntryInfo.Name);
+		return true;
+	}
+
+	if (!TarArchiver->GetArchiveEntryInfoByIndex(EntryIndex, EntryInfo))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get seekable entry by index due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully retrieved seekable entry '%s' by index"), *EntryInfo.Name);
+	return true;
+}
+
+bool URuntimeArchiverSeekable::AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
+{
+	if (!Super::AddEntryFromMemory(EntryName, DataToBeArchived, CompressionLevel))
+	{
+		return false;
+	}
+
+	if (SeekableStream)
+	{
+		SeekableStream->SetCompressionLevel(GetEntryCompressionLevel(EntryName, DataToBeArchived.GetData(), DataToBeArchived.Num(), CompressionLevel));
+	}
+
+	if (!TarArchiver->AddEntryFromMemory(EntryName, DataToBeArchived, CompressionLevel))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to add seekable entry due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully added seekable entry '%s' with size %lld bytes from memory"), *EntryName, DataToBeArchived.Num());
+	return true;
+}
+
+bool URuntimeArchiverSeekable::ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData)
+{
+	if (!Super::ExtractEntryToMemory(EntryInfo, UnarchivedData))
+	{
+		return false;
+	}
+
+	if (!TarArchiver->ExtractEntryToMemory(EntryInfo, UnarchivedData))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to extract seekable entry due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted seekable entry '%s' into memory"), *EntryInfo.Name);
+	return true;
+}
+
+bool URuntimeArchiverSeekable::ExtractEntryRangeToMemory(const FRuntimeArchiveEntry& EntryInfo, int64 Offset, int64 Size, TArray64<uint8>& UnarchivedData)
+{
+	if (!IsInitialized() || Mode != ERuntimeArchiverMode::Read)
+	{
+		ReportError(ERuntimeArchiverErrorCode::UnsupportedMode, TEXT("Unable to extract seekable entry range because the archive is not opened for reading"));
+		return false;
+	}
+
+	if (!TarArchiver->ExtractEntryRangeToMemory(EntryInfo, Offset, Size, UnarchivedData))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to extract seekable entry range due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted %lld bytes at offset %lld of seekable entry '%s' into memory"), Size, Offset, *EntryInfo.Name);
+	return true;
+}
+
+bool URuntimeArchiverSeekable::ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed)
+{
+	if (!TarArchiver->ExtractFileEntryToStorage(EntryInfo, FilePath, OnProcessed))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to extract seekable entry due to tar archiver error"));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted seekable entry '%s' into file '%s'"), *EntryInfo.Name, *FilePath);
+	return true;
+}
+
+bool URuntimeArchiverSeekable::VerifyArchive(int32& FirstCorruptedFrame)
+{
+	FirstCorruptedFrame = INDEX_NONE;
+
+	if (!IsInitialized() || Mode != ERuntimeArchiverMode::Read || !SeekableStream)
+	{
+		ReportError(ERuntimeArchiverErrorCode::UnsupportedMode, TEXT("Unable to verify seekable archive because it is not opened for reading"));
+		return false;
+	}
+
+	if (!SeekableStream->Verify(FirstCorruptedFrame))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, FString::Printf(TEXT("Seekable archive is corrupted, the first corrupted frame is %d"), FirstCorruptedFrame));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully verified seekable archive '%s'"), *GetName());
+	return true;
+}
+
+bool URuntimeArchiverSeekable::TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress)
+{
+	// Reading the tar data through the seekable stream also verifies that it decompresses
+	if (!TarArchiver->TestArchive_Internal(TestResult, OnProgress))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to test seekable archive due to tar archiver error"));
+		return false;
+	}
+
+	return true;
+}
+
+bool URuntimeArchiverSeekable::Initialize()
+{
+	if (!Super::Initialize())
+	{
+		return false;
+	}
+
+	TarArchiver.Reset(Cast<URuntimeArchiverTar>(CreateRuntimeArchiver(this, URuntimeArchiverTar::StaticClass())));
+	if (!TarArchiver.IsValid())
+	{
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to allocate memory for seekable archiver"));
+		return false;
+	}
+
+	return true;
+}
+
+bool URuntimeArchiverSeekable::IsInitialized() const
+{
+	return Super::IsInitialized() && TarArchiver.IsValid() && TarArchiver->IsInitialized();
+}
+
+bool URuntimeArchiverSeekable::FinishArchive()
+{
+	if (!SeekableStream)
+	{
+		ReportError(ERuntimeArchiverErrorCode::CloseError, TEXT("Unable to finish seekable archive because the seekable stream is not valid"));
+		return false;
+	}
+
+	if (!TarArchiver->FinalizeArchive())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish seekable archive due to tar archiver error"));
+		return false;
+	}
+
+	TArray64<uint8> FileTable;
+	SerializeFileTable(TarArchiver->TarEncapsulator->GetIndexedEntries(), FileTable);
+	SeekableStream->SetFileTable(MoveTemp(FileTable));
+
+	if (!SeekableStream->Finish())
+	{
+		ReportError(ERuntimeArchiverErrorCode::CloseError, TEXT("Unable to write the remaining frames and the frame index to finish seekable archive"));
+		return false;
+	}
+
+	return true;
+}
+
+void URuntimeArchiverSeekable::Reset()
+{
+	if (TarArchiver.IsValid())
+	{
+		TarArchiver->Reset();
+		TarArchiver.Reset();
+	}
+
+	// The seekable stream is owned by the tar archiver and must be destroyed before the compressed stream it works with
+	SeekableStream = nullptr;
+	CompressedStream.Reset();
+	FileTableEntries.Empty();
+	FileTableIndicesByName.Empty();
+	Super::Reset();
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully uninitialized seekable archiver '%s'"), *GetName());
+}
+
+void URuntimeArchiverSeekable::ReportError(ERuntimeArchiverErrorCode ErrorCode, const FString& ErrorString) const
+{
+	Super::ReportError(ErrorCode, ErrorString);
+}
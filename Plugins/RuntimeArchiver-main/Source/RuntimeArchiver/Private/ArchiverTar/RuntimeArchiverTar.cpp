@@ -4,10 +4,15 @@
 #include "RuntimeArchiverDefines.h"
 #include "RuntimeArchiverTarOperations.h"
 #include "RuntimeArchiverUtilities.h"
+#include "RuntimeArchiverProgressReporter.h"
 #include "ArchiverTar/RuntimeArchiverTarHeader.h"
 #include "Streams/RuntimeArchiverFileStream.h"
+#include "Streams/RuntimeArchiverMappedFileStream.h"
 #include "Streams/RuntimeArchiverMemoryStream.h"
+#include "HAL/PlatformFileManager.h"
 #include "Misc/Paths.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
 
 bool URuntimeArchiverTar::CreateArchiveInStorage(FString ArchivePath)
 {
@@ -77,7 +82,7 @@ bool URuntimeArchiverTar::OpenArchiveFromMemory(const TArray64<uint8>& ArchiveDa
 		return false;
 	}
 
-	if (!TarEncapsulator->OpenMemory(ArchiveData, 0, false))
+	if (!TarEncapsulator->OpenStream(TUniquePtr<FRuntimeArchiverBaseStream>(CreateMemoryReadStream(ArchiveData))))
 	{
 		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to open in-memory tar archive to read"));
 		Reset();
@@ -89,6 +94,71 @@ bool URuntimeArchiverTar::OpenArchiveFromMemory(const TArray64<uint8>& ArchiveDa
 	return true;
 }
 
+bool URuntimeArchiverTar::CreateArchiveInStream(TUniquePtr<FRuntimeArchiverBaseStream>&& Stream)
+{
+	if (!Initialize())
+	{
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to initialize tar archiver to write to stream"));
+		Reset();
+		return false;
+	}
+
+	Mode = ERuntimeArchiverMode::Write;
+	Location = ERuntimeArchiverLocation::Storage;
+
+	if (!Stream.IsValid() || !Stream->IsWrite() || !TarEncapsulator->OpenStream(MoveTemp(Stream)))
+	{
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to create tar archive in stream to write"));
+		Reset();
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully created tar archive '%s' in stream"), *GetName());
+
+	return true;
+}
+
+bool URuntimeArchiverTar::OpenArchiveFromStream(TUniquePtr<FRuntimeArchiverBaseStream>&& Stream, const TArray<FRuntimeArchiverTarIndexedEntry>* Index)
+{
+	if (!Initialize())
+	{
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to initialize tar archiver to read from stream"));
+		Reset();
+		return false;
+	}
+
+	Mode = ERuntimeArchiverMode::Read;
+	Location = ERuntimeArchiverLocation::Storage;
+
+	if (!Stream.IsValid() || Stream->IsWrite() || !TarEncapsulator->OpenStream(MoveTemp(Stream), Index))
+	{
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Unable to open tar archive from stream to read"));
+		Reset();
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully opened tar archive '%s' from stream to read"), *GetName());
+
+	return true;
+}
+
+bool URuntimeArchiverTar::FinalizeArchive()
+{
+	if (!IsInitialized() || Mode != ERuntimeArchiverMode::Write)
+	{
+		ReportError(ERuntimeArchiverErrorCode::UnsupportedMode, TEXT("Unable to finalize tar archive because it is not opened for writing"));
+		return false;
+	}
+
+	if (!TarEncapsulator->Finalize())
+	{
+		ReportError(ERuntimeArchiverErrorCode::CloseError, TEXT("Unable to finalize tar archive"));
+		return false;
+	}
+
+	return true;
+}
+
 bool URuntimeArchiverTar::CloseArchive()
 {
 	if (!Super::CloseArchive())
@@ -123,6 +193,39 @@ bool URuntimeArchiverTar::GetArchiveData(TArray64<uint8>& ArchiveData)
 	return true;
 }
 
+bool URuntimeArchiverTar::MoveArchiveData(TArray64<uint8>& ArchiveData)
+{
+	if (Mode != ERuntimeArchiverMode::Write || Location != ERuntimeArchiverLocation::Memory)
+	{
+		return Super::MoveArchiveData(ArchiveData);
+	}
+
+	if (!TarEncapsulator->MoveArchiveData(ArchiveData))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Unable to move tar archive data out of memory"));
+		return false;
+	}
+
+	Reset();
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully moved tar archive data out of memory with size '%lld'"), ArchiveData.Num());
+
+	return true;
+}
+
+bool URuntimeArchiverTar::TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress)
+{
+	if (!TarEncapsulator->TestEntries(TestResult, OnProgress))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Tar archive test failed at entry %d (offset %lld): %s"), TestResult.BadEntryIndex, TestResult.BadEntryOffset, *TestResult.ErrorDescription);
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully tested %d tar entries"), TestResult.NumOfTestedEntries);
+
+	return true;
+}
+
 bool URuntimeArchiverTar::GetArchiveEntries(int32& NumOfArchiveEntries)
 {
 	if (!Super::GetArchiveEntries(NumOfArchiveEntries))
@@ -151,10 +254,7 @@ bool URuntimeArchiverTar::GetArchiveEntryInfoByName(FString EntryName, FRuntimeA
 	int32 EntryIndex;
 
 	// Searching for a header by the entry name
-	const bool bFound = TarEncapsulator->FindIf([&EntryName](const FTarHeader& PossibleHeader, int32 PossibleIndex)
-	{
-		return EntryName.Equals(StringCast<TCHAR>(PossibleHeader.GetName()).Get());
-	}, Header, EntryIndex, true);
+	const bool bFound = TarEncapsulator->FindByName(EntryName, Header, EntryIndex, true);
 
 	if (!bFound)
 	{
@@ -183,10 +283,7 @@ bool URuntimeArchiverTar::GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeA
 	FTarHeader Header;
 
 	// Searching for a header by the entry index
-	const bool bFound = TarEncapsulator->FindIf([EntryIndex](const FTarHeader& PossibleHeader, int32 PossibleIndex)
-	{
-		return EntryIndex == PossibleIndex;
-	}, Header, EntryIndex, true);
+	const bool bFound = TarEncapsulator->FindByIndex(EntryIndex, Header, true);
 
 	if (!bFound)
 	{
@@ -205,7 +302,7 @@ bool URuntimeArchiverTar::GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeA
 	return true;
 }
 
-bool URuntimeArchiverTar::AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
+bool URuntimeArchiverTar::AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
 {
 	if (!Super::AddEntryFromMemory(EntryName, DataToBeArchived, CompressionLevel))
 	{
@@ -220,15 +317,9 @@ bool URuntimeArchiverTar::AddEntryFromMemory(FString EntryName, const TArray64<u
 		for (const FString& Directory : Directories)
 		{
 			FTarHeader Header;
-			int32 Index;
 
 			// Skip if the archive already contains this directory entry
-			const bool bFound = TarEncapsulator->FindIf([&Directory](const FTarHeader& PotentialHeader, int32 Index)
-			{
-				return Directory.Equals(StringCast<TCHAR>(PotentialHeader.GetName()).Get());
-			}, Header, Index, true);
-
-			if (!bFound)
+			if (!TarEncapsulator->Contains(Directory))
 			{
 				if (!FTarHeader::GenerateHeader(Directory, 0, FDateTime::Now(), true, Header))
 				{
@@ -280,23 +371,18 @@ bool URuntimeArchiverTar::ExtractEntryToMemory(const FRuntimeArchiveEntry& Entry
 		return false;
 	}
 
-	int32 NumOfArchiveEntries;
-	if (!GetArchiveEntries(NumOfArchiveEntries) || EntryInfo.Index > (NumOfArchiveEntries - 1))
+	// Only the headers up to the entry are indexed, counting all entries would read the whole archive
+	if (!TarEncapsulator->GetEntryLocation(EntryInfo.Index))
 	{
+		int32 NumOfArchiveEntries;
+		TarEncapsulator->GetArchiveEntries(NumOfArchiveEntries);
+
 		ReportError(ERuntimeArchiverErrorCode::InvalidArgument, FString::Printf(TEXT("Tar entry index %d is invalid. Min index: 0, Max index: %d"), EntryInfo.Index, (NumOfArchiveEntries - 1)));
 		return false;
 	}
 
 	FTarHeader Header;
-	int32 Index;
-
-	// Make sure we have such entry
-	const bool bFound = TarEncapsulator->FindIf([&EntryInfo](const FTarHeader& PotentialHeader, int32 Index)
-	{
-		return EntryInfo.Name.Equals(StringCast<TCHAR>(PotentialHeader.GetName()).Get());
-	}, Header, Index, false);
-
-	if (!bFound)
+	if (!FindEntryHeader(EntryInfo, Header))
 	{
 		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to find tar entry '%s' to write into memory"), *EntryInfo.Name));
 		return false;
@@ -316,6 +402,148 @@ bool URuntimeArchiverTar::ExtractEntryToMemory(const FRuntimeArchiveEntry& Entry
 	return true;
 }
 
+bool URuntimeArchiverTar::ExtractEntryRangeToMemory(const FRuntimeArchiveEntry& EntryInfo, int64 Offset, int64 Size, TArray64<uint8>& UnarchivedData)
+{
+	if (!IsInitialized() || Mode != ERuntimeArchiverMode::Read)
+	{
+		ReportError(ERuntimeArchiverErrorCode::UnsupportedMode, TEXT("Unable to extract tar entry range because the archive is not opened for reading"));
+		return false;
+	}
+
+	FTarHeader Header;
+	if (!FindEntryHeader(EntryInfo, Header))
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to find tar entry '%s' to extract range into memory"), *EntryInfo.Name));
+		return false;
+	}
+
+	if (Offset < 0 || Size < 0 || Offset + Size > Header.GetSize())
+	{
+		ReportError(ERuntimeArchiverErrorCode::InvalidArgument, FString::Printf(TEXT("Range at offset %lld with size %lld is out of tar entry '%s' with size %lld"), Offset, Size, *EntryInfo.Name, Header.GetSize()));
+		return false;
+	}
+
+	UnarchivedData.SetNumUninitialized(Size);
+
+	if (!TarEncapsulator->ReadDataRange(Offset, UnarchivedData))
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to read range at offset %lld with size %lld from tar entry '%s'"), Offset, Size, *EntryInfo.Name));
+		UnarchivedData.Empty();
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted %lld bytes at offset %lld of tar entry '%s' into memory"), Size, Offset, *EntryInfo.Name);
+
+	return true;
+}
+
+bool URuntimeArchiverTar::ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed)
+{
+	// Only the headers up to the entry are indexed, counting all entries would read the whole archive
+	if (!TarEncapsulator->GetEntryLocation(EntryInfo.Index))
+	{
+		int32 NumOfArchiveEntries;
+		TarEncapsulator->GetArchiveEntries(NumOfArchiveEntries);
+
+		ReportError(ERuntimeArchiverErrorCode::InvalidArgument, FString::Printf(TEXT("Tar entry index %d is invalid. Min index: 0, Max index: %d"), EntryInfo.Index, (NumOfArchiveEntries - 1)));
+		return false;
+	}
+
+	FTarHeader Header;
+	if (!FindEntryHeader(EntryInfo, Header))
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to find tar entry '%s' to write into file '%s'"), *EntryInfo.Name, *FilePath));
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*FilePath));
+	if (!FileHandle.IsValid())
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to open file '%s' to extract tar entry '%s'"), *FilePath, *EntryInfo.Name));
+		return false;
+	}
+
+	// Copying the entry in chunks, so that memory usage does not depend on the entry size
+	constexpr int64 ChunkSize = 1024 * 1024;
+	TArray64<uint8> Chunk;
+
+	for (int64 RemainingSize = Header.GetSize(), CurrentChunkSize = 0; RemainingSize > 0; RemainingSize -= CurrentChunkSize)
+	{
+		CurrentChunkSize = FMath::Min(RemainingSize, ChunkSize);
+
+		// Mapped and in-memory archives are written to the file straight from the archive data
+		const uint8* ChunkData = TarEncapsulator->ReadDataView(CurrentChunkSize);
+		if (!ChunkData)
+		{
+			Chunk.SetNumUninitialized(CurrentChunkSize);
+			ChunkData = TarEncapsulator->ReadData(Chunk) ? Chunk.GetData() : nullptr;
+		}
+
+		if (!ChunkData || !FileHandle->Write(ChunkData, CurrentChunkSize))
+		{
+			ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to copy data from tar entry '%s' to file '%s'"), *EntryInfo.Name, *FilePath));
+			FileHandle.Reset();
+			PlatformFile.DeleteFile(*FilePath);
+			return false;
+		}
+
+		OnProcessed(CurrentChunkSize);
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted tar entry '%s' into file '%s'"), *EntryInfo.Name, *FilePath);
+
+	return true;
+}
+
+bool URuntimeArchiverTar::ExtractEntriesToStorage_Directory_Internal(const FString& BaseName, const FString& DirectoryPath, const FString& BaseDirectoryPathToExclude, bool bForceOverwrite, TArray<FString>& FilePaths)
+{
+	if (!TarEncapsulator->IsSequential())
+	{
+		return Super::ExtractEntriesToStorage_Directory_Internal(BaseName, DirectoryPath, BaseDirectoryPathToExclude, bForceOverwrite, FilePaths);
+	}
+
+	// Listing the entries before extracting them would read a compressed archive twice, so each entry is extracted right after its header is read
+	for (int32 EntryIndex = 0; TarEncapsulator->GetEntryLocation(EntryIndex); ++EntryIndex)
+	{
+		FRuntimeArchiveEntry ArchiveEntry;
+		if (!GetArchiveEntryInfoByIndex(EntryIndex, ArchiveEntry))
+		{
+			ReportError(ERuntimeArchiverErrorCode::GetError, FString::Printf(TEXT("Cannot get '%d' entry to extract. Aborting recursive extracting entries"), EntryIndex));
+			return false;
+		}
+
+		if (!BaseName.IsEmpty() && !CheckEntryNameBelongsToBaseName(BaseName, ArchiveEntry.Name))
+		{
+			continue;
+		}
+
+		const FString FilePath = FPaths::Combine(DirectoryPath, ArchiveEntry.Name.RightChop(BaseDirectoryPathToExclude.Len()));
+
+		if (!ExtractEntryToStorage(ArchiveEntry, FilePath, bForceOverwrite))
+		{
+			ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Cannot extract '%s' entry. Aborting extracting entries"), *ArchiveEntry.Name));
+			return false;
+		}
+
+		FilePaths.Add(FilePath);
+	}
+
+	return true;
+}
+
+bool URuntimeArchiverTar::FindEntryHeader(const FRuntimeArchiveEntry& EntryInfo, FTarHeader& Header)
+{
+	// The index is checked first, falling back to the name in case the entry info is out of date
+	if (TarEncapsulator->FindByIndex(EntryInfo.Index, Header, false) && EntryInfo.Name.Equals(StringCast<TCHAR>(Header.GetName()).Get(), ESearchCase::CaseSensitive))
+	{
+		return true;
+	}
+
+	int32 Index;
+	return TarEncapsulator->FindByName(EntryInfo.Name, Header, Index, false);
+}
+
 bool URuntimeArchiverTar::Initialize()
 {
 	if (!Super::Initialize())
@@ -356,9 +584,11 @@ void URuntimeArchiverTar::ReportError(ERuntimeArchiverErrorCode ErrorCode, const
 }
 
 FRuntimeArchiverTarEncapsulator::FRuntimeArchiverTarEncapsulator()
-	: RemainingDataSize{0}
+	: NextIndexedHeaderOffset{0}
+  , bIsIndexComplete{false}
+  , RemainingDataSize{0}
   , LastHeaderPosition{0}
-  , CachedNumOfHeaders{0}
+  , bRecordIndexedEntries{false}
   , bIsFinalized{false}
 {
 }
@@ -406,7 +636,21 @@ bool FRuntimeArchiverTarEncapsulator::OpenFile(const FString& ArchivePath, bool
 		return false;
 	}
 
-	Stream.Reset(new FRuntimeArchiverFileStream(ArchivePath, bWrite));
+	// Reading through a memory mapping avoids a system call for every header and allows copying entries without intermediate buffers
+	if (!bWrite)
+	{
+		Stream.Reset(new FRuntimeArchiverMappedFileStream(ArchivePath));
+		if (!Stream->IsValid())
+		{
+			UE_LOG(LogRuntimeArchiver, Log, TEXT("Unable to map tar archive '%s', reading it through the file stream instead"), *ArchivePath);
+			Stream.Reset();
+		}
+	}
+
+	if (!Stream.IsValid())
+	{
+		Stream.Reset(new FRuntimeArchiverFileStream(ArchivePath, bWrite));
+	}
 
 	if (!Stream->IsValid())
 	{
@@ -414,7 +658,7 @@ bool FRuntimeArchiverTarEncapsulator::OpenFile(const FString& ArchivePath, bool
 		return false;
 	}
 
-	return TestArchive();
+	return TestArchive() && ResetIndex();
 }
 
 bool FRuntimeArchiverTarEncapsulator::OpenMemory(const TArray64<uint8>& ArchiveData, int32 InitialAllocationSize, bool bWrite)
@@ -433,7 +677,204 @@ bool FRuntimeArchiverTarEncapsulator::OpenMemory(const TArray64<uint8>& ArchiveD
 		return false;
 	}
 
-	return TestArchive();
+	return TestArchive() && ResetIndex();
+}
+
+bool FRuntimeArchiverTarEncapsulator::OpenStream(TUniquePtr<FRuntimeArchiverBaseStream>&& InStream, const TArray<FRuntimeArchiverTarIndexedEntry>* Index)
+{
+	if (Stream.IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open tar stream because it has already been opened"));
+		return false;
+	}
+
+	if (!InStream.IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open tar stream because it is not specified"));
+		return false;
+	}
+
+	Stream = MoveTemp(InStream);
+
+	if (!IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open tar stream because it is not valid"));
+		return false;
+	}
+
+	if (!TestArchive())
+	{
+		return false;
+	}
+
+	if (!Index || Stream->IsWrite())
+	{
+		return ResetIndex();
+	}
+
+	// Using the provided index instead of reading every header
+	EntryLocations.Reset(Index->Num());
+	EntryIndicesByName.Reset();
+
+	for (const FRuntimeArchiverTarIndexedEntry& IndexedEntry : *Index)
+	{
+		AddToIndex(IndexedEntry.Entry.Name, IndexedEntry.HeaderOffset, IndexedEntry.Entry.UncompressedSize);
+	}
+
+	bIsIndexComplete = true;
+
+	UE_LOG(LogRuntimeArchiver, Verbose, TEXT("Opened tar stream with %d entries from the provided index"), EntryLocations.Num());
+
+	return Rewind();
+}
+
+bool FRuntimeArchiverTarEncapsulator::ResetIndex()
+{
+	EntryLocations.Reset();
+	EntryIndicesByName.Reset();
+
+	NextIndexedHeaderOffset = 0;
+
+	// Every written header is indexed right away
+	bIsIndexComplete = Stream->IsWrite();
+
+	if (bIsIndexComplete)
+	{
+		return true;
+	}
+
+	return Rewind();
+}
+
+bool FRuntimeArchiverTarEncapsulator::IndexEntries(int32 NumOfEntries)
+{
+	if (EntryLocations.Num() >= NumOfEntries || bIsIndexComplete || !IsValid())
+	{
+		return EntryLocations.Num() >= NumOfEntries;
+	}
+
+	const int64 PreviousPosition = Stream->Tell();
+	const int64 PreviousRemainingDataSize = RemainingDataSize;
+	const int64 PreviousLastHeaderPosition = LastHeaderPosition;
+
+	FTarHeader Header;
+
+	// Headers are read in archive order, jumping straight from one header to the next without reading the entry data
+	while (EntryLocations.Num() < NumOfEntries)
+	{
+		if (!Stream->Seek(NextIndexedHeaderOffset) || !ReadHeader(Header))
+		{
+			bIsIndexComplete = true;
+
+			UE_LOG(LogRuntimeArchiver, Verbose, TEXT("Indexed all %d tar entries"), EntryLocations.Num());
+			break;
+		}
+
+		AddToIndex(Header, NextIndexedHeaderOffset);
+		NextIndexedHeaderOffset += static_cast<int64>(sizeof(FTarHeader)) + RuntimeArchiverTarOperations::RoundUp<int64>(Header.GetSize(), 512);
+	}
+
+	RemainingDataSize = PreviousRemainingDataSize;
+	LastHeaderPosition = PreviousLastHeaderPosition;
+
+	if (!Stream->Seek(PreviousPosition))
+	{
+		return false;
+	}
+
+	return EntryLocations.Num() >= NumOfEntries;
+}
+
+bool FRuntimeArchiverTarEncapsulator::IsSequential() const
+{
+	return Stream.IsValid() && Stream->IsSequential();
+}
+
+void FRuntimeArchiverTarEncapsulator::AddToIndex(const FTarHeader& Header, int64 HeaderOffset)
+{
+	AddToIndex(StringCast<TCHAR>(Header.GetName()).Get(), HeaderOffset, Header.GetSize());
+}
+
+void FRuntimeArchiverTarEncapsulator::AddToIndex(const FString& EntryName, int64 HeaderOffset, int64 Size)
+{
+	const int32 Index = EntryLocations.Add({HeaderOffset, HeaderOffset + static_cast<int64>(sizeof(FTarHeader)), Size});
+
+	if (!EntryIndicesByName.Contains(EntryName))
+	{
+		EntryIndicesByName.Add(EntryName, Index);
+	}
+}
+
+bool FRuntimeArchiverTarEncapsulator::FindByName(const FString& EntryName, FTarHeader& Header, int32& Index, bool bRemainPosition)
+{
+	if (!Contains(EntryName))
+	{
+		return false;
+	}
+
+	const int32 FoundIndex = EntryIndicesByName.FindChecked(EntryName);
+	if (!FindByIndex(FoundIndex, Header, bRemainPosition))
+	{
+		return false;
+	}
+
+	Index = FoundIndex;
+	return true;
+}
+
+bool FRuntimeArchiverTarEncapsulator::FindByIndex(int32 Index, FTarHeader& Header, bool bRemainPosition)
+{
+	if (!IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to find tar entry because stream is invalid"));
+		return false;
+	}
+
+	const FRuntimeArchiverTarEntryLocation* Location = GetEntryLocation(Index);
+	if (!Location)
+	{
+		return false;
+	}
+
+	const int64 PreviousPosition = Stream->Tell();
+	const int64 PreviousRemainingDataSize = RemainingDataSize;
+	const int64 PreviousLastHeaderPosition = LastHeaderPosition;
+
+	// Jumping straight to the header instead of scanning the archive
+	bool bFound = Stream->Seek(Location->HeaderOffset) && ReadHeader(Header);
+
+	if (bRemainPosition)
+	{
+		RemainingDataSize = PreviousRemainingDataSize;
+		LastHeaderPosition = PreviousLastHeaderPosition;
+		bFound &= Stream->Seek(PreviousPosition);
+	}
+	else
+	{
+		// The entry data has not been read yet
+		RemainingDataSize = 0;
+	}
+
+	return bFound;
+}
+
+bool FRuntimeArchiverTarEncapsulator::Contains(const FString& EntryName)
+{
+	// Names that have not been found yet are looked for in the headers that follow the indexed ones
+	while (!EntryIndicesByName.Contains(EntryName))
+	{
+		if (!IndexEntries(EntryLocations.Num() + 1))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const FRuntimeArchiverTarEntryLocation* FRuntimeArchiverTarEncapsulator::GetEntryLocation(int32 Index)
+{
+	return Index >= 0 && IndexEntries(Index + 1) ? &EntryLocations[Index] : nullptr;
 }
 
 bool FRuntimeArchiverTarEncapsulator::FindIf(TFunctionRef<bool(const FTarHeader&, int32)> ComparePredicate, FTarHeader& Header, int32& Index, bool bRemainPosition)
@@ -494,86 +935,212 @@ bool FRuntimeArchiverTarEncapsulator::GetArchiveEntries(int32& NumOfArchiveEntri
 		return false;
 	}
 
-	// TODO: verify the validity of the last entry
+	// Counting the entries requires every header to be indexed
+	IndexEntries(MAX_int32);
 
-	// Read-only mode is supposed to have a fixed (immutable) number of entries, so if possible, return the cached number of entries in this mode to improve performance
-	if (!Stream->IsWrite() && CachedNumOfHeaders > 0)
+	NumOfArchiveEntries = EntryLocations.Num();
+	return true;
+}
+
+bool FRuntimeArchiverTarEncapsulator::GetArchiveData(TArray64<uint8>& ArchiveData)
+{
+	if (!IsValid())
 	{
-		NumOfArchiveEntries = CachedNumOfHeaders;
-		return true;
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get tar archive data because stream is invalid"));
+		return false;
 	}
 
-	const int64 PreviousPosition = Stream->Tell();
-
-	// Making sure looking from the start
-	if (!Rewind())
+	if (Stream->IsWrite() && !Finalize())
 	{
-		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to rewind read/write position of tar archive to get the number of archive entries"));
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get tar archive data because finalization failed"));
 		return false;
 	}
 
-	FTarHeader TempHeader;
-	int32 NumOfHeaders{0};
+	ArchiveData.SetNumUninitialized(Stream->Size());
 
-	// Iterate all files
-	while (ReadHeader(TempHeader))
-	{
-		NumOfHeaders++;
+	const int64 PrevRemainingDataSize = RemainingDataSize;
+	const int64 PrevLastHeaderPosition = LastHeaderPosition;
+	const int64 PrevStreamPosition = Stream->Tell();
 
-		if (!Next())
-		{
-			break;
-		}
+	Rewind();
+
+	if (!Stream->Read(ArchiveData.GetData(), ArchiveData.Num()))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read tar archive data with size '%lld'"), ArchiveData.Num());
+		return false;
 	}
 
-	Stream->Seek(PreviousPosition);
+	RemainingDataSize = PrevRemainingDataSize;
+	LastHeaderPosition = PrevLastHeaderPosition;
 
-	// Cache number of entries in read-only mode to improve performance
-	if (!Stream->IsWrite())
+	if (!Stream->Seek(PrevStreamPosition))
 	{
-		CachedNumOfHeaders = NumOfHeaders;
+		return false;
 	}
 
-	NumOfArchiveEntries = NumOfHeaders;
 	return true;
 }
 
-bool FRuntimeArchiverTarEncapsulator::GetArchiveData(TArray64<uint8>& ArchiveData)
+bool FRuntimeArchiverTarEncapsulator::MoveArchiveData(TArray64<uint8>& ArchiveData)
 {
 	if (!IsValid())
 	{
-		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get tar archive data because stream is invalid"));
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to move tar archive data because stream is invalid"));
 		return false;
 	}
 
 	if (Stream->IsWrite() && !Finalize())
 	{
-		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to get tar archive data because finalization failed"));
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to move tar archive data because finalization failed"));
 		return false;
 	}
 
-	ArchiveData.SetNumUninitialized(Stream->Size());
+	if (!Stream->MoveData(ArchiveData))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to move tar archive data because the stream does not own its data"));
+		return false;
+	}
 
-	const int64 PrevRemainingDataSize = RemainingDataSize;
-	const int64 PrevLastHeaderPosition = LastHeaderPosition;
-	const int64 PrevStreamPosition = Stream->Tell();
+	return true;
+}
 
-	Rewind();
+bool FRuntimeArchiverTarEncapsulator::TestEntries(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress)
+{
+	if (!IsValid() || Stream->IsWrite())
+	{
+		TestResult.ErrorDescription = TEXT("Tar archive is not opened for reading");
+		return false;
+	}
 
-	if (!Stream->Read(ArchiveData.GetData(), ArchiveData.Num()))
+	FRuntimeArchiverPercentageReporter ProgressReporter(OnProgress);
+
+	const auto GetEntrySize = [](const FRuntimeArchiverTarEntryLocation& Location)
 	{
-		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read tar archive data with size '%lld'"), ArchiveData.Num());
+		return static_cast<int64>(sizeof(FTarHeader)) + RuntimeArchiverTarOperations::RoundUp<int64>(Location.Size, 512);
+	};
+
+	int32 NumOfEntries = 0;
+	int32 BadEntryIndex = INDEX_NONE;
+	FTarHeader BadHeader;
+
+	const int64 StreamSize = IsSequential() ? 0 : Stream->Size();
+
+	if (const uint8* ArchiveView = StreamSize > 0 ? Stream->GetReadView(0, StreamSize) : nullptr)
+	{
+		// Reading the headers of an archive with direct access is cheap, so the whole index is built before checking them
+		IndexEntries(MAX_int32);
+		NumOfEntries = EntryLocations.Num();
+
+		std::atomic<int64> TestedBytes{0};
+
+		// Only the headers have to be read, so they are checked in parallel. Entries after an already found bad entry are skipped
+		// The index is built without checking the headers, so a damaged header shows up either as a wrong checksum or as data running past the end of the archive
+		std::atomic<int32> FirstBadEntryIndex{NumOfEntries};
+
+		ParallelFor(NumOfEntries, [&](int32 EntryIndex)
+		{
+			if (EntryIndex > FirstBadEntryIndex.load())
+			{
+				return;
+			}
+
+			const FRuntimeArchiverTarEntryLocation& Location = EntryLocations[EntryIndex];
+
+			if (!reinterpret_cast<const FTarHeader*>(ArchiveView + Location.HeaderOffset)->IsChecksumValid() || Location.Size < 0 || Location.DataOffset + Location.Size > StreamSize)
+			{
+				int32 PreviousBadEntryIndex = FirstBadEntryIndex.load();
+				while (EntryIndex < PreviousBadEntryIndex && !FirstBadEntryIndex.compare_exchange_weak(PreviousBadEntryIndex, EntryIndex))
+				{
+				}
+				return;
+			}
+
+			ProgressReporter.ReportProcessed(TestedBytes.fetch_add(GetEntrySize(Location)) + GetEntrySize(Location), StreamSize);
+		});
+
+		if (FirstBadEntryIndex.load() < NumOfEntries)
+		{
+			BadEntryIndex = FirstBadEntryIndex.load();
+			FMemory::Memcpy(&BadHeader, ArchiveView + EntryLocations[BadEntryIndex].HeaderOffset, sizeof(FTarHeader));
+		}
+	}
+	else
+	{
+		// Reading the data through the stream is what verifies compressed streams. Each header is indexed right before its data is read, so the archive is read only once, in order
+		// The size of such streams is not known up front, so a truncated entry shows up as a failed read
+		TArray64<uint8> Buffer;
+		Buffer.SetNumUninitialized(1024 * 1024);
+
+		for (int32 EntryIndex = 0; const FRuntimeArchiverTarEntryLocation* Location = GetEntryLocation(EntryIndex); ++EntryIndex)
+		{
+			NumOfEntries = EntryIndex + 1;
+
+			FTarHeader Header;
+			bool bEntryValid = Stream->Seek(Location->HeaderOffset) && Stream->Read(&Header, sizeof(FTarHeader)) && Header.IsChecksumValid() && Location->Size >= 0;
+
+			for (int64 RemainingSize = Location->Size; bEntryValid && RemainingSize > 0;)
+			{
+				const int64 ChunkSize = FMath::Min(RemainingSize, Buffer.Num());
+				bEntryValid = Stream->Read(Buffer.GetData(), ChunkSize);
+				RemainingSize -= ChunkSize;
+			}
+
+			if (!bEntryValid)
+			{
+				BadEntryIndex = EntryIndex;
+				BadHeader = Header;
+				break;
+			}
+
+			ProgressReporter.ReportPercentage(static_cast<int32>(Stream->GetReadProgress() * 100));
+		}
+	}
+
+	TestResult.NumOfTestedEntries = BadEntryIndex != INDEX_NONE ? BadEntryIndex : NumOfEntries;
+
+	if (BadEntryIndex != INDEX_NONE)
+	{
+		TestResult.BadEntryIndex = BadEntryIndex;
+		TestResult.BadEntryOffset = EntryLocations[BadEntryIndex].HeaderOffset;
+
+		// The name of a damaged header cannot be trusted
+		if (BadHeader.IsChecksumValid())
+		{
+			TestResult.BadEntryName = StringCast<TCHAR>(BadHeader.GetName()).Get();
+			TestResult.ErrorDescription = TEXT("Entry data is truncated or cannot be read");
+		}
+		else
+		{
+			TestResult.ErrorDescription = TEXT("Entry header checksum mismatch");
+		}
+
+		Rewind();
 		return false;
 	}
 
-	RemainingDataSize = PrevRemainingDataSize;
-	LastHeaderPosition = PrevLastHeaderPosition;
+	// Entries are followed by at least two empty blocks. Anything else means that the archive is cut off or that a header after the last indexed entry is damaged
+	const int64 EndOffset = NumOfEntries > 0 ? EntryLocations[NumOfEntries - 1].DataOffset + RuntimeArchiverTarOperations::RoundUp<int64>(EntryLocations[NumOfEntries - 1].Size, 512) : 0;
 
-	if (!Stream->Seek(PrevStreamPosition))
+	uint8 EndBlocks[sizeof(FTarHeader) * 2];
+	bool bEndValid = Stream->Seek(EndOffset) && Stream->Read(EndBlocks, sizeof(EndBlocks));
+
+	for (int32 ByteIndex = 0; bEndValid && ByteIndex < static_cast<int32>(sizeof(FTarHeader)); ++ByteIndex)
 	{
+		bEndValid = EndBlocks[ByteIndex] == 0;
+	}
+
+	Rewind();
+
+	if (!bEndValid)
+	{
+		TestResult.BadEntryOffset = EndOffset;
+		TestResult.ErrorDescription = TEXT("End of archive marker is missing, the archive is truncated or damaged after the last readable entry");
 		return false;
 	}
 
+	TestResult.bIsValid = true;
+	ProgressReporter.Finish();
+
 	return true;
 }
 
@@ -642,25 +1209,37 @@ bool FRuntimeArchiverTarEncapsulator::ReadHeader(FTarHeader& Header)
 	return true;
 }
 
-bool FRuntimeArchiverTarEncapsulator::ReadData(TArray64<uint8>& Data)
+bool FRuntimeArchiverTarEncapsulator::BeginReadData()
 {
-	// If there is no remaining data, then this is the first reading. Getting the size, setting the remaining data and seeking to the beginning of the data
-	if (RemainingDataSize == 0)
+	// If there is remaining data, then the data is already being read
+	if (RemainingDataSize != 0)
 	{
-		FTarHeader Header;
-		if (!ReadHeader(Header))
-		{
-			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read header for getting tar entry data"));
-			return false;
-		}
+		return true;
+	}
 
-		if (!Stream->Seek(Stream->Tell() + sizeof(FTarHeader)))
-		{
-			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to seek to next header for getting tar entry data"));
-			return false;
-		}
+	// Otherwise this is the first reading. Getting the size, setting the remaining data and seeking to the beginning of the data
+	FTarHeader Header;
+	if (!ReadHeader(Header))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read header for getting tar entry data"));
+		return false;
+	}
 
-		RemainingDataSize = Header.GetSize();
+	if (!Stream->Seek(Stream->Tell() + sizeof(FTarHeader)))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to seek to next header for getting tar entry data"));
+		return false;
+	}
+
+	RemainingDataSize = Header.GetSize();
+	return true;
+}
+
+bool FRuntimeArchiverTarEncapsulator::ReadData(TArray64<uint8>& Data)
+{
+	if (!BeginReadData())
+	{
+		return false;
 	}
 
 	if (!Stream->Read(Data.GetData(), Data.Num()))
@@ -680,13 +1259,97 @@ bool FRuntimeArchiverTarEncapsulator::ReadData(TArray64<uint8>& Data)
 	return true;
 }
 
+const uint8* FRuntimeArchiverTarEncapsulator::ReadDataView(int64 Size)
+{
+	if (!BeginReadData())
+	{
+		return nullptr;
+	}
+
+	// The position is left unchanged if the stream does not provide direct access, so the data can still be read with ReadData
+	const uint8* Data = Stream->GetReadView(Stream->Tell(), Size);
+	if (!Data || !Stream->Seek(Stream->Tell() + Size))
+	{
+		return nullptr;
+	}
+
+	RemainingDataSize -= Size;
+
+	// If there is no remaining data, then we have finished reading and seek back to the header
+	if (RemainingDataSize == 0 && !Stream->Seek(LastHeaderPosition))
+	{
+		return nullptr;
+	}
+
+	return Data;
+}
+
+bool FRuntimeArchiverTarEncapsulator::ReadDataRange(int64 Offset, TArray64<uint8>& Data)
+{
+	if (RemainingDataSize != 0)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read tar entry data range while the entry data is being read"));
+		return false;
+	}
+
+	if (!BeginReadData())
+	{
+		return false;
+	}
+
+	const int64 EntrySize = RemainingDataSize;
+
+	// The entry is not read sequentially, so the position is always moved back to the header
+	RemainingDataSize = 0;
+
+	if (Offset < 0 || Offset + Data.Num() > EntrySize)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read tar entry data range at offset %lld with size %lld because the entry size is %lld"), Offset, Data.Num(), EntrySize);
+		Stream->Seek(LastHeaderPosition);
+		return false;
+	}
+
+	if (!Stream->Seek(Stream->Tell() + Offset) || !Stream->Read(Data.GetData(), Data.Num()))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read tar entry data range at offset %lld with size %lld"), Offset, Data.Num());
+		Stream->Seek(LastHeaderPosition);
+		return false;
+	}
+
+	return Stream->Seek(LastHeaderPosition);
+}
+
 bool FRuntimeArchiverTarEncapsulator::WriteHeader(const FTarHeader& Header)
 {
+	const int64 HeaderOffset = Stream->Tell();
+
 	RemainingDataSize = Header.GetSize();
-	return Stream->Write(&Header, sizeof(Header));
+
+	if (!Stream->Write(&Header, sizeof(Header)))
+	{
+		return false;
+	}
+
+	AddToIndex(Header, HeaderOffset);
+
+	if (bRecordIndexedEntries)
+	{
+		FRuntimeArchiverTarIndexedEntry IndexedEntry;
+		IndexedEntry.HeaderOffset = HeaderOffset;
+
+		if (!FTarHeader::ToEntry(Header, EntryLocations.Num() - 1, IndexedEntry.Entry))
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to convert written tar header to entry for the index"));
+			return false;
+		}
+
+		IndexedEntries.Add(MoveTemp(IndexedEntry));
+	}
+
+	return true;
 }
 
-bool FRuntimeArchiverTarEncapsulator::WriteData(const TArray64<uint8>& DataToBeArchived)
+bool FRuntimeArchiverTarEncapsulator::WriteData(TArrayView64<const uint8> DataToBeArchived)
 {
 	if (!Stream->Write(DataToBeArchived.GetData(), DataToBeArchived.Num()))
 	{
@@ -173,6 +173,11 @@ bool FTarHeader::ToEntry(const FTarHeader& Header, int32 Index, FRuntimeArchiveE
 	return true;
 }
 
+bool FTarHeader::IsChecksumValid() const
+{
+	return *Checksum != '\0' && FTarChecksumHelper::BuildChecksum(*this) == GetChecksum();
+}
+
 bool FTarHeader::FromEntry(const FRuntimeArchiveEntry& Entry, FTarHeader& Header)
 {
 	return GenerateHeader(Entry.Name, Entry.UncompressedSize, Entry.CreationTime, Entry.bIsDirectory, Header);
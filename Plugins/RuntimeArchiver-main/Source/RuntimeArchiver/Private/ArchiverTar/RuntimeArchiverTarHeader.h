@@ -90,6 +90,13 @@ public:
 	 */
 	static bool GenerateHeader(const FString& Name, int64 Size, const FDateTime& CreationTime, bool bIsDirectory, FTarHeader& Header);
 
+	/**
+	 * Check whether the header checksum matches the header content, without logging errors
+	 *
+	 * @return Whether the checksum is valid or not
+	 */
+	bool IsChecksumValid() const;
+
 	//~ Writing and reading tar header data
 
 	const RA_UTF8CHAR* GetName() const;
@@ -5,10 +5,21 @@
 #include "RuntimeArchiverSubsystem.h"
 #include "RuntimeArchiverDefines.h"
 #include "RuntimeArchiverZipIncludes.h"
+#include "RuntimeArchiverProgressReporter.h"
+#include "RuntimeArchiverThreadPool.h"
+#include "Streams/RuntimeArchiverMappedFileStream.h"
 #include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/Async.h"
+#include "Algo/BinarySearch.h"
+#include "Misc/ScopeExit.h"
+#include <atomic>
 
 URuntimeArchiverZip::URuntimeArchiverZip()
 	: Super::URuntimeArchiverBase()
+  , MaxCompressionWorkers(0)
+  , MaxExtractionWorkers(0)
   , bAppendMode(false)
   , MinizArchiver(nullptr)
 {
@@ -65,14 +76,30 @@ bool URuntimeArchiverZip::OpenArchiveFromStorage(FString ArchivePath)
 
 	FPaths::NormalizeFilename(ArchivePath);
 
-	// Reading the archive from the file path
-	if (!mz_zip_reader_init_file(static_cast<mz_zip_archive*>(MinizArchiver), TCHAR_TO_UTF8(*ArchivePath), 0))
+	// Reading the archive through a memory mapping if possible, so that headers and stored entries are read without system calls and extra copies
+	{
+		TUniquePtr<FRuntimeArchiverBaseStream> MappedStream = MakeUnique<FRuntimeArchiverMappedFileStream>(ArchivePath);
+		const int64 MappedSize = MappedStream->IsValid() ? MappedStream->Size() : 0;
+		const uint8* MappedData = MappedSize > 0 ? MappedStream->GetReadView(0, MappedSize) : nullptr;
+
+		if (MappedData && mz_zip_reader_init_mem(static_cast<mz_zip_archive*>(MinizArchiver), MappedData, static_cast<size_t>(MappedSize), 0))
+		{
+			MappedArchiveStream = MoveTemp(MappedStream);
+			UE_LOG(LogRuntimeArchiver, Log, TEXT("Reading zip archive '%s' through a memory mapping"), *ArchivePath);
+		}
+	}
+
+	// Otherwise reading the archive from the file path
+	if (!MappedArchiveStream.IsValid() && !mz_zip_reader_init_file(static_cast<mz_zip_archive*>(MinizArchiver), TCHAR_TO_UTF8(*ArchivePath), 0))
 	{
 		ReportError(ERuntimeArchiverErrorCode::NotInitialized, FString::Printf(TEXT("An error occurred while opening zip archive '%s' to read"), *ArchivePath));
 		Reset();
 		return false;
 	}
 
+	ArchiveFilePath = ArchivePath;
+	BuildEntryNameIndex();
+
 	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully opened zip archive '%s' in '%s' to read"), *GetName(), *ArchivePath);
 
 	return true;
@@ -92,6 +119,8 @@ bool URuntimeArchiverZip::OpenArchiveFromMemory(const TArray64<uint8>& ArchiveDa
 		return false;
 	}
 
+	BuildEntryNameIndex();
+
 	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully opened in-memory zip archive '%s' to read"), *GetName());
 
 	return true;
@@ -200,8 +229,17 @@ bool URuntimeArchiverZip::GetArchiveEntryInfoByName(FString EntryName, FRuntimeA
 
 	FPaths::NormalizeFilename(EntryName);
 
-	// Looking for the entry index depending on the entry name
-	const int32 EntryIndex = mz_zip_reader_locate_file(static_cast<mz_zip_archive*>(MinizArchiver), TCHAR_TO_UTF8(*EntryName), nullptr, 0);
+	// Looking for the entry index depending on the entry name, using the name index if the archive is opened for reading
+	int32 EntryIndex;
+	if (Mode == ERuntimeArchiverMode::Read)
+	{
+		const int32* IndexedEntryIndex = EntryIndicesByName.Find(EntryName);
+		EntryIndex = IndexedEntryIndex ? *IndexedEntryIndex : -1;
+	}
+	else
+	{
+		EntryIndex = mz_zip_reader_locate_file(static_cast<mz_zip_archive*>(MinizArchiver), TCHAR_TO_UTF8(*EntryName), nullptr, 0);
+	}
 
 	if (EntryIndex == -1)
 	{
@@ -246,7 +284,7 @@ bool URuntimeArchiverZip::GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeA
 	return true;
 }
 
-bool URuntimeArchiverZip::AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
+bool URuntimeArchiverZip::AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
 {
 	if (!Super::AddEntryFromMemory(EntryName, DataToBeArchived, CompressionLevel))
 	{
@@ -255,11 +293,13 @@ bool URuntimeArchiverZip::AddEntryFromMemory(FString EntryName, const TArray64<u
 
 	FPaths::NormalizeFilename(EntryName);
 
+	const ERuntimeArchiverCompressionLevel EntryCompressionLevel = GetEntryCompressionLevel(EntryName, DataToBeArchived.GetData(), DataToBeArchived.Num(), CompressionLevel);
+
 	// Writing data to the entry from memory
 	const bool bResult = static_cast<bool>(mz_zip_writer_add_mem_ex(static_cast<mz_zip_archive*>(MinizArchiver), TCHAR_TO_UTF8(*EntryName),
 	                                                                DataToBeArchived.GetData(), static_cast<size_t>(DataToBeArchived.Num()),
 	                                                                nullptr, 0,
-	                                                                static_cast<mz_uint>(CompressionLevel), 0, 0));
+	                                                                static_cast<mz_uint>(EntryCompressionLevel), 0, 0));
 
 	if (!bResult)
 	{
@@ -272,6 +312,275 @@ bool URuntimeArchiverZip::AddEntryFromMemory(FString EntryName, const TArray64<u
 	return true;
 }
 
+namespace
+{
+	/** Files larger than this are not compressed by the workers, but streamed into the archive by the writer to keep memory usage bounded */
+	constexpr int64 MaxParallelCompressionEntrySize = 64 * 1024 * 1024;
+
+	/**
+	 * File data prepared by a compression worker, ready to be appended to the archive
+	 */
+	struct FZipCompressedEntry
+	{
+		bool bSuccess = false;
+
+		/** Whether Data holds raw deflate data. Otherwise, it holds the file data to be stored as is */
+		bool bCompressed = false;
+
+		TArray64<uint8> Data;
+		int64 UncompressedSize = 0;
+		uint32 UncompressedCrc32 = 0;
+	};
+
+	mz_bool AppendDeflatedBlock(const void* Buffer, int Size, void* User)
+	{
+		static_cast<TArray64<uint8>*>(User)->Append(static_cast<const uint8*>(Buffer), Size);
+		return MZ_TRUE;
+	}
+
+	/**
+	 * Load and deflate a file the same way miniz does when adding an entry, so that the result can be appended with MZ_ZIP_FLAG_COMPRESSED_DATA
+	 */
+	FZipCompressedEntry CompressZipEntry(const URuntimeArchiverBase& Archiver, int32 EntryIndex, const FString& EntryName, const FString& FilePath, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int32, TArrayView64<const uint8>)> OnEntryData)
+	{
+		FZipCompressedEntry CompressedEntry;
+
+		TArray64<uint8> FileData;
+		if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+		{
+			return CompressedEntry;
+		}
+
+		OnEntryData(EntryIndex, FileData);
+
+		CompressedEntry.bSuccess = true;
+		CompressedEntry.UncompressedSize = FileData.Num();
+
+		const mz_uint Level = static_cast<mz_uint>(Archiver.GetEntryCompressionLevel(EntryName, FileData.GetData(), FileData.Num(), CompressionLevel));
+		if (Level > 0 && FileData.Num() > 0)
+		{
+			CompressedEntry.UncompressedCrc32 = static_cast<uint32>(mz_crc32(MZ_CRC32_INIT, FileData.GetData(), static_cast<size_t>(FileData.Num())));
+
+			TArray64<uint8> CompressedData;
+			CompressedData.Reserve(FileData.Num());
+
+			const int Flags = static_cast<int>(tdefl_create_comp_flags_from_zip_params(static_cast<int>(Level), -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY));
+
+			// Incompressible data is stored as is instead
+			if (tdefl_compress_mem_to_output(FileData.GetData(), static_cast<size_t>(FileData.Num()), &AppendDeflatedBlock, &CompressedData, Flags) && CompressedData.Num() < FileData.Num())
+			{
+				CompressedEntry.bCompressed = true;
+				CompressedEntry.Data = MoveTemp(CompressedData);
+				return CompressedEntry;
+			}
+		}
+
+		CompressedEntry.Data = MoveTemp(FileData);
+		return CompressedEntry;
+	}
+
+	/**
+	 * Source of a zip entry being streamed from a file
+	 */
+	struct FZipEntryFileReader
+	{
+		IFileHandle* FileHandle;
+		int64 FileSize;
+		int32 EntryIndex;
+
+		/** Called with the number of bytes read after each block */
+		const TFunctionRef<void(int64)>* OnRead;
+
+		/** Called with each block read for the first time */
+		const TFunctionRef<void(int32, TArrayView64<const uint8>)>* OnData;
+
+		/** Number of bytes already passed to OnData */
+		int64 ObservedSize;
+	};
+
+	/**
+	 * Miniz read callback that reads the file data block by block
+	 */
+	size_t ReadZipEntryFromFileHandle(void* Opaque, mz_uint64 FileOffset, void* Buffer, size_t Size)
+	{
+		FZipEntryFileReader* Reader = static_cast<FZipEntryFileReader*>(Opaque);
+
+		const int64 SizeToRead = FMath::Min<int64>(static_cast<int64>(Size), Reader->FileSize - static_cast<int64>(FileOffset));
+		if (SizeToRead <= 0)
+		{
+			return 0;
+		}
+
+		if (Reader->FileHandle->Tell() != static_cast<int64>(FileOffset) && !Reader->FileHandle->Seek(static_cast<int64>(FileOffset)))
+		{
+			return 0;
+		}
+
+		if (!Reader->FileHandle->Read(static_cast<uint8*>(Buffer), SizeToRead))
+		{
+			return 0;
+		}
+
+		(*Reader->OnRead)(SizeToRead);
+
+		// Blocks are expected to be read in order, but a block read again must not be observed twice
+		if (static_cast<int64>(FileOffset) == Reader->ObservedSize)
+		{
+			(*Reader->OnData)(Reader->EntryIndex, TArrayView64<const uint8>(static_cast<const uint8*>(Buffer), SizeToRead));
+			Reader->ObservedSize += SizeToRead;
+		}
+
+		return static_cast<size_t>(SizeToRead);
+	}
+}
+
+bool URuntimeArchiverZip::AddEntriesFromStorage_Internal(const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int64)> OnProcessed, TFunctionRef<void(int32, TArrayView64<const uint8>)> OnEntryData)
+{
+	const int32 NumOfWorkers = FMath::Min(MaxCompressionWorkers > 0 ? MaxCompressionWorkers : FPlatformMisc::NumberOfCoresIncludingHyperthreads(), EntryNames.Num());
+
+	if (!IsInitialized() || Mode != ERuntimeArchiverMode::Write || NumOfWorkers <= 1)
+	{
+		return Super::AddEntriesFromStorage_Internal(EntryNames, FilePaths, CompressionLevel, OnProcessed, OnEntryData);
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	TArray<int64> FileSizes;
+	FileSizes.Reserve(FilePaths.Num());
+
+	int64 TotalBytes = 0;
+	for (const FString& FilePath : FilePaths)
+	{
+		const int64 FileSize = PlatformFile.FileSize(*FilePath);
+		if (FileSize < 0)
+		{
+			ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Path '%s' does not contain a file"), *FilePath));
+			return false;
+		}
+
+		FileSizes.Add(FileSize);
+		TotalBytes += FileSize;
+	}
+
+	// Workers compress the entries ahead of the writer, bounded both by the number of entries and by the amount of file data in flight
+	const int32 MaxInFlightJobs = NumOfWorkers * 2;
+	const int64 MaxInFlightBytes = NumOfWorkers * MaxParallelCompressionEntrySize;
+
+	TArray<TFuture<FZipCompressedEntry>> CompressionJobs;
+	CompressionJobs.SetNum(EntryNames.Num());
+
+	// The jobs refer to the observer, so the ones still running when adding an entry fails are waited for
+	ON_SCOPE_EXIT
+	{
+		for (TFuture<FZipCompressedEntry>& CompressionJob : CompressionJobs)
+		{
+			if (CompressionJob.IsValid())
+			{
+				CompressionJob.Wait();
+			}
+		}
+	};
+
+	int32 NextJobIndex = 0;
+	int32 NumOfInFlightJobs = 0;
+	int64 NumOfInFlightBytes = 0;
+
+	auto ScheduleCompressionJobs = [&]()
+	{
+		while (NextJobIndex < EntryNames.Num() && NumOfInFlightJobs < MaxInFlightJobs)
+		{
+			const int64 FileSize = FileSizes[NextJobIndex];
+
+			if (FileSize > MaxParallelCompressionEntrySize)
+			{
+				++NextJobIndex;
+				continue;
+			}
+
+			if (NumOfInFlightJobs > 0 && NumOfInFlightBytes + FileSize > MaxInFlightBytes)
+			{
+				break;
+			}
+
+			CompressionJobs[NextJobIndex] = Async(EAsyncExecution::ThreadPool, [this, EntryIndex = NextJobIndex, EntryName = EntryNames[NextJobIndex], FilePath = FilePaths[NextJobIndex], CompressionLevel, &OnEntryData]()
+			{
+				return CompressZipEntry(*this, EntryIndex, EntryName, FilePath, CompressionLevel, OnEntryData);
+			});
+
+			++NextJobIndex;
+			++NumOfInFlightJobs;
+			NumOfInFlightBytes += FileSize;
+		}
+	};
+
+	mz_zip_archive* MinizArchiverReal = static_cast<mz_zip_archive*>(MinizArchiver);
+
+	// Appending the entries in their original order from this thread only, as miniz does not support concurrent writes
+	for (int32 EntryIndex = 0; EntryIndex < EntryNames.Num(); ++EntryIndex)
+	{
+		ScheduleCompressionJobs();
+
+		FString EntryName = EntryNames[EntryIndex];
+		FPaths::NormalizeFilename(EntryName);
+
+		const FString& FilePath = FilePaths[EntryIndex];
+		bool bResult;
+
+		if (CompressionJobs[EntryIndex].IsValid())
+		{
+			const FZipCompressedEntry& CompressedEntry = CompressionJobs[EntryIndex].Get();
+
+			if (!CompressedEntry.bSuccess)
+			{
+				ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Unable to load file '%s' for entry '%s'"), *FilePath, *EntryName));
+				return false;
+			}
+
+			bResult = static_cast<bool>(mz_zip_writer_add_mem_ex(MinizArchiverReal, TCHAR_TO_UTF8(*EntryName),
+			                                                     CompressedEntry.Data.GetData(), static_cast<size_t>(CompressedEntry.Data.Num()),
+			                                                     nullptr, 0,
+			                                                     CompressedEntry.bCompressed ? (static_cast<mz_uint>(CompressionLevel) | MZ_ZIP_FLAG_COMPRESSED_DATA) : 0,
+			                                                     static_cast<mz_uint64>(CompressedEntry.UncompressedSize), CompressedEntry.UncompressedCrc32));
+
+			OnProcessed(CompressedEntry.UncompressedSize);
+
+			CompressionJobs[EntryIndex].Reset();
+			--NumOfInFlightJobs;
+			NumOfInFlightBytes -= FileSizes[EntryIndex];
+		}
+		else
+		{
+			TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenRead(*FilePath));
+			if (!FileHandle.IsValid())
+			{
+				ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Unable to open file '%s' for entry '%s'"), *FilePath, *EntryName));
+				return false;
+			}
+
+			const ERuntimeArchiverCompressionLevel EntryCompressionLevel = GetEntryCompressionLevel(EntryName, *FileHandle, FileSizes[EntryIndex], CompressionLevel);
+
+			FZipEntryFileReader Reader{FileHandle.Get(), FileSizes[EntryIndex], EntryIndex, &OnProcessed, &OnEntryData, 0};
+
+			bResult = static_cast<bool>(mz_zip_writer_add_read_buf_callback(MinizArchiverReal, TCHAR_TO_UTF8(*EntryName),
+			                                                                &ReadZipEntryFromFileHandle, &Reader, static_cast<mz_uint64>(FileSizes[EntryIndex]),
+			                                                                nullptr, nullptr, 0,
+			                                                                static_cast<mz_uint>(EntryCompressionLevel), nullptr, 0, nullptr, 0));
+		}
+
+		if (!bResult)
+		{
+			ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Unable to add zip entry '%s' from file '%s'"), *EntryName, *FilePath));
+			return false;
+		}
+
+		UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully added zip entry '%s' from '%s'"), *EntryName, *FilePath);
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully added %d zip entries (%lld bytes) using %d compression workers"), EntryNames.Num(), TotalBytes, NumOfWorkers);
+
+	return true;
+}
+
 bool URuntimeArchiverZip::ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData)
 {
 	if (!Super::ExtractEntryToMemory(EntryInfo, UnarchivedData))
@@ -311,6 +620,480 @@ bool URuntimeArchiverZip::ExtractEntryToMemory(const FRuntimeArchiveEntry& Entry
 	return true;
 }
 
+namespace
+{
+	/**
+	 * Destination of a zip entry being decompressed to a file
+	 */
+	struct FZipEntryFileWriter
+	{
+		IFileHandle* FileHandle;
+
+		/** Optionally called with the number of bytes written after each block */
+		const TFunction<void(int64)>* OnWritten;
+	};
+
+	/**
+	 * Miniz write callback that appends decompressed data to a file handle. Miniz calls it sequentially with small blocks, so only its internal buffers are ever held in memory
+	 */
+	size_t WriteZipEntryToFileHandle(void* Opaque, mz_uint64 FileOffset, const void* Buffer, size_t Size)
+	{
+		const FZipEntryFileWriter* Writer = static_cast<const FZipEntryFileWriter*>(Opaque);
+
+		if (Writer->FileHandle->Tell() != static_cast<int64>(FileOffset) && !Writer->FileHandle->Seek(static_cast<int64>(FileOffset)))
+		{
+			return 0;
+		}
+
+		if (!Writer->FileHandle->Write(static_cast<const uint8*>(Buffer), static_cast<int64>(Size)))
+		{
+			return 0;
+		}
+
+		if (Writer->OnWritten && *Writer->OnWritten)
+		{
+			(*Writer->OnWritten)(static_cast<int64>(Size));
+		}
+
+		return Size;
+	}
+
+	/**
+	 * Decompress a zip entry into a file. The file is deleted if the extraction fails
+	 */
+	bool ExtractZipEntryToFile(mz_zip_archive* MinizArchiverReal, mz_uint EntryIndex, const FString& FilePath, const TFunction<void(int64)>& OnWritten = nullptr)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+		bool bExtracted;
+		{
+			TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*FilePath));
+			if (!FileHandle.IsValid())
+			{
+				return false;
+			}
+
+			FZipEntryFileWriter Writer{FileHandle.Get(), &OnWritten};
+
+			// Decompressing directly into the file instead of allocating the whole entry on the heap
+			bExtracted = mz_zip_reader_extract_to_callback(MinizArchiverReal, EntryIndex, &WriteZipEntryToFileHandle, &Writer, 0) && FileHandle->Flush();
+		}
+
+		if (!bExtracted)
+		{
+			// Do not leave a truncated file behind
+			PlatformFile.DeleteFile(*FilePath);
+		}
+
+		return bExtracted;
+	}
+}
+
+bool URuntimeArchiverZip::ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed)
+{
+	if (Mode != ERuntimeArchiverMode::Read)
+	{
+		ReportError(ERuntimeArchiverErrorCode::UnsupportedMode, FString::Printf(TEXT("Only '%s' mode is supported for extracting zip entries (using mode: '%s')"), *UEnum::GetValueAsName(ERuntimeArchiverMode::Read).ToString(), *UEnum::GetValueAsName(Mode).ToString()));
+		return false;
+	}
+
+	int32 NumOfArchiveEntries;
+	if (!GetArchiveEntries(NumOfArchiveEntries) || EntryInfo.Index < 0 || EntryInfo.Index > (NumOfArchiveEntries - 1))
+	{
+		ReportError(ERuntimeArchiverErrorCode::InvalidArgument, FString::Printf(TEXT("Zip entry index %d is invalid. Min index: 0, Max index: %d"), EntryInfo.Index, (NumOfArchiveEntries - 1)));
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Ensure we have a valid directory to extract entry to
+	{
+		const FString DirectoryPath = FPaths::GetPath(FilePath);
+		if (!DirectoryPath.IsEmpty() && !PlatformFile.CreateDirectoryTree(*DirectoryPath))
+		{
+			ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to create subdirectory '%s' to extract zip entry '%s'"), *DirectoryPath, *EntryInfo.Name));
+			return false;
+		}
+	}
+
+	if (!ExtractZipEntryToFile(static_cast<mz_zip_archive*>(MinizArchiver), static_cast<mz_uint>(EntryInfo.Index), FilePath))
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to extract zip entry '%s' to file '%s'"), *EntryInfo.Name, *FilePath));
+		return false;
+	}
+
+	OnProcessed(EntryInfo.UncompressedSize);
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully streamed zip entry '%s' to file '%s'"), *EntryInfo.Name, *FilePath);
+
+	return true;
+}
+
+bool URuntimeArchiverZip::ExtractEntriesToStorage_Internal(const TArray<FRuntimeArchiveEntry>& EntryInfo, const TArray<FString>& FilePaths, bool bForceOverwrite, TFunctionRef<void(int64)> OnProcessed)
+{
+	const int32 NumOfWorkers = FMath::Min(MaxExtractionWorkers > 0 ? MaxExtractionWorkers : RuntimeArchiverThreadPool::GetNumOfThreads(), EntryInfo.Num());
+
+	if (!IsInitialized() || Mode != ERuntimeArchiverMode::Read || NumOfWorkers <= 1)
+	{
+		return Super::ExtractEntriesToStorage_Internal(EntryInfo, FilePaths, bForceOverwrite, OnProcessed);
+	}
+
+	// Each worker opens its own reader over the same source, since a miniz archive cannot be read from several threads at once
+	mz_zip_archive* MinizArchiverReal = static_cast<mz_zip_archive*>(MinizArchiver);
+	// Archives in memory and memory-mapped archives are shared by all workers
+	const void* ArchiveMemory = MinizArchiverReal->m_zip_type == MZ_ZIP_TYPE_MEMORY ? MinizArchiverReal->m_pState->m_pMem : nullptr;
+	const size_t ArchiveMemorySize = static_cast<size_t>(MinizArchiverReal->m_archive_size);
+
+	if (!ArchiveMemory && ArchiveFilePath.IsEmpty())
+	{
+		return Super::ExtractEntriesToStorage_Internal(EntryInfo, FilePaths, bForceOverwrite, OnProcessed);
+	}
+
+	struct FExtractionJob
+	{
+		const FRuntimeArchiveEntry* Entry;
+		FString FilePath;
+	};
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	TArray<FExtractionJob> Jobs;
+	Jobs.Reserve(EntryInfo.Num());
+
+	TSet<FString> DirectoriesToCreate;
+	int64 TotalBytes = 0;
+	int32 NumOfOverwrittenFiles = 0;
+
+	// Validating the destinations and collecting all directories up front, so that workers never race to create the same directory tree
+	for (int32 EntryIndex = 0; EntryIndex < EntryInfo.Num(); ++EntryIndex)
+	{
+		const FRuntimeArchiveEntry& Entry = EntryInfo[EntryIndex];
+		FString FilePath = FilePaths[EntryIndex];
+
+		if (Entry.bIsDirectory)
+		{
+			FPaths::NormalizeDirectoryName(FilePath);
+
+			if (!bForceOverwrite && PlatformFile.DirectoryExists(*FilePath))
+			{
+				ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Directory '%s' already exists"), *FilePath));
+				return false;
+			}
+
+			DirectoriesToCreate.Add(MoveTemp(FilePath));
+			continue;
+		}
+
+		FPaths::NormalizeFilename(FilePath);
+
+		if (PlatformFile.FileExists(*FilePath))
+		{
+			if (!bForceOverwrite)
+			{
+				ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("File '%s' already exists"), *FilePath));
+				return false;
+			}
+
+			++NumOfOverwrittenFiles;
+		}
+
+		DirectoriesToCreate.Add(FPaths::GetPath(FilePath));
+		TotalBytes += Entry.UncompressedSize;
+		Jobs.Add({&Entry, MoveTemp(FilePath)});
+	}
+
+	for (const FString& DirectoryPath : DirectoriesToCreate)
+	{
+		if (!DirectoryPath.IsEmpty() && !PlatformFile.CreateDirectoryTree(*DirectoryPath))
+		{
+			ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to create directory '%s' to extract zip entries"), *DirectoryPath));
+			return false;
+		}
+	}
+
+	if (NumOfOverwrittenFiles > 0)
+	{
+		UE_LOG(LogRuntimeArchiver, Warning, TEXT("%d files already exist and will be overwritten"), NumOfOverwrittenFiles);
+	}
+
+	// Partitioning the entries between the workers by compressed size: the largest entries are handed out first, each to the least loaded worker
+	Jobs.Sort([](const FExtractionJob& A, const FExtractionJob& B)
+	{
+		return A.Entry->CompressedSize > B.Entry->CompressedSize;
+	});
+
+	TArray<TArray<int32>> WorkerJobs;
+	WorkerJobs.SetNum(NumOfWorkers);
+	{
+		TArray<int64> WorkerLoads;
+		WorkerLoads.SetNumZeroed(NumOfWorkers);
+
+		for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+		{
+			int32 LeastLoadedWorker = 0;
+			for (int32 WorkerIndex = 1; WorkerIndex < NumOfWorkers; ++WorkerIndex)
+			{
+				if (WorkerLoads[WorkerIndex] < WorkerLoads[LeastLoadedWorker])
+				{
+					LeastLoadedWorker = WorkerIndex;
+				}
+			}
+
+			WorkerJobs[LeastLoadedWorker].Add(JobIndex);
+
+			// Empty entries still cost a file creation, so they are spread out as well
+			WorkerLoads[LeastLoadedWorker] += FMath::Max<int64>(Jobs[JobIndex].Entry->CompressedSize, 1);
+		}
+	}
+
+	std::atomic<bool> bFailed{false};
+
+	// Progress is reported by uncompressed bytes as each block is written
+	const TFunction<void(int64)> OnWritten = [&OnProcessed](int64 NumOfBytes)
+	{
+		OnProcessed(NumOfBytes);
+	};
+
+	// The workers mostly wait on file I/O, so they run on the archiver thread pool to leave the task graph workers to latency sensitive work
+	RuntimeArchiverThreadPool::ParallelFor(NumOfWorkers, [this, &Jobs, &WorkerJobs, &bFailed, &OnWritten, ArchiveMemory, ArchiveMemorySize](int32 WorkerIndex)
+	{
+		mz_zip_archive WorkerArchiver;
+		mz_zip_zero_struct(&WorkerArchiver);
+
+		// Entries are accessed by index only, so there is no need to sort the central directory for each worker
+		const mz_uint WorkerFlags = MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY;
+		const bool bOpened = ArchiveMemory
+			                     ? static_cast<bool>(mz_zip_reader_init_mem(&WorkerArchiver, ArchiveMemory, ArchiveMemorySize, WorkerFlags))
+			                     : static_cast<bool>(mz_zip_reader_init_file(&WorkerArchiver, TCHAR_TO_UTF8(*ArchiveFilePath), WorkerFlags));
+
+		if (!bOpened)
+		{
+			bFailed = true;
+			ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to open zip archive for extraction worker %d. Miniz error details: '%s'"), WorkerIndex, UTF8_TO_TCHAR(mz_zip_get_error_string(mz_zip_get_last_error(&WorkerArchiver)))));
+			return;
+		}
+
+		for (const int32 JobIndex : WorkerJobs[WorkerIndex])
+		{
+			if (bFailed)
+			{
+				break;
+			}
+
+			const FExtractionJob& Job = Jobs[JobIndex];
+
+			if (!ExtractZipEntryToFile(&WorkerArchiver, static_cast<mz_uint>(Job.Entry->Index), Job.FilePath, OnWritten))
+			{
+				bFailed = true;
+				ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to extract zip entry '%s' to file '%s'. Miniz error details: '%s'"), *Job.Entry->Name, *Job.FilePath, UTF8_TO_TCHAR(mz_zip_get_error_string(mz_zip_get_last_error(&WorkerArchiver)))));
+				break;
+			}
+		}
+
+		mz_zip_reader_end(&WorkerArchiver);
+	});
+
+	if (bFailed)
+	{
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted %d zip entries (%lld bytes) using %d workers"), EntryInfo.Num(), TotalBytes, NumOfWorkers);
+
+	return true;
+}
+
+bool URuntimeArchiverZip::TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress)
+{
+	mz_zip_archive* MinizArchiverReal = static_cast<mz_zip_archive*>(MinizArchiver);
+	const int32 NumOfEntries = static_cast<int32>(mz_zip_reader_get_num_files(MinizArchiverReal));
+
+	// Archives in memory and memory-mapped archives are shared by all workers, archives in storage are opened by each worker
+	const void* ArchiveMemory = MinizArchiverReal->m_zip_type == MZ_ZIP_TYPE_MEMORY ? MinizArchiverReal->m_pState->m_pMem : nullptr;
+	const size_t ArchiveMemorySize = static_cast<size_t>(MinizArchiverReal->m_archive_size);
+	const bool bCanOpenWorkers = ArchiveMemory || !ArchiveFilePath.IsEmpty();
+
+	const int32 NumOfWorkers = bCanOpenWorkers ? FMath::Clamp(MaxExtractionWorkers > 0 ? MaxExtractionWorkers : RuntimeArchiverThreadPool::GetNumOfThreads(), 1, FMath::Max(NumOfEntries, 1)) : 1;
+	const int64 TotalBytes = static_cast<int64>(MinizArchiverReal->m_archive_size);
+
+	std::atomic<int32> NextEntryIndex{0};
+	std::atomic<int32> FirstBadEntryIndex{NumOfEntries};
+	std::atomic<int64> TestedBytes{0};
+	FRuntimeArchiverPercentageReporter ProgressReporter(OnProgress);
+
+	// Details of the bad entry with the lowest index, since several workers may fail at the same time
+	FCriticalSection BadEntryCriticalSection;
+
+	// Progress is aggregated by compressed bytes and only reported when the percentage grows
+	const auto OnTested = [&TestedBytes, &ProgressReporter, TotalBytes](int64 NumOfBytes)
+	{
+		ProgressReporter.ReportProcessed(TestedBytes.fetch_add(NumOfBytes) + NumOfBytes, TotalBytes);
+	};
+
+	// Entries are handed out in archive order, so that the first bad entry is found as early as possible and later entries can be skipped
+	const auto TestEntries = [&](mz_zip_archive* WorkerArchiver)
+	{
+		for (int32 EntryIndex = NextEntryIndex++; EntryIndex < NumOfEntries && EntryIndex < FirstBadEntryIndex.load(); EntryIndex = NextEntryIndex++)
+		{
+			mz_zip_archive_file_stat ArchiveFileStat;
+			const bool bStatValid = static_cast<bool>(mz_zip_reader_file_stat(WorkerArchiver, static_cast<mz_uint>(EntryIndex), &ArchiveFileStat));
+
+			// Decompresses the entry without writing it anywhere and compares its CRC-32 with the one stored in the archive
+			if (bStatValid && mz_zip_validate_file(WorkerArchiver, static_cast<mz_uint>(EntryIndex), 0))
+			{
+				OnTested(static_cast<int64>(ArchiveFileStat.m_comp_size));
+				continue;
+			}
+
+			FScopeLock Lock(&BadEntryCriticalSection);
+
+			if (EntryIndex < FirstBadEntryIndex.load())
+			{
+				FirstBadEntryIndex = EntryIndex;
+				TestResult.BadEntryIndex = EntryIndex;
+				TestResult.BadEntryName = bStatValid ? UTF8_TO_TCHAR(ArchiveFileStat.m_filename) : FString();
+				TestResult.BadEntryOffset = bStatValid ? static_cast<int64>(ArchiveFileStat.m_local_header_ofs) : -1;
+				TestResult.ErrorDescription = UTF8_TO_TCHAR(mz_zip_get_error_string(mz_zip_get_last_error(WorkerArchiver)));
+			}
+			return;
+		}
+	};
+
+	if (NumOfWorkers <= 1)
+	{
+		TestEntries(MinizArchiverReal);
+	}
+	else
+	{
+		std::atomic<bool> bOpenFailed{false};
+
+		RuntimeArchiverThreadPool::ParallelFor(NumOfWorkers, [this, &TestEntries, &bOpenFailed, ArchiveMemory, ArchiveMemorySize](int32 WorkerIndex)
+		{
+			mz_zip_archive WorkerArchiver;
+			mz_zip_zero_struct(&WorkerArchiver);
+
+			const mz_uint WorkerFlags = MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY;
+			const bool bOpened = ArchiveMemory
+				                     ? static_cast<bool>(mz_zip_reader_init_mem(&WorkerArchiver, ArchiveMemory, ArchiveMemorySize, WorkerFlags))
+				                     : static_cast<bool>(mz_zip_reader_init_file(&WorkerArchiver, TCHAR_TO_UTF8(*ArchiveFilePath), WorkerFlags));
+
+			if (!bOpened)
+			{
+				bOpenFailed = true;
+				UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open zip archive for test worker %d. Miniz error details: '%s'"), WorkerIndex, UTF8_TO_TCHAR(mz_zip_get_error_string(mz_zip_get_last_error(&WorkerArchiver))));
+				return;
+			}
+
+			TestEntries(&WorkerArchiver);
+
+			mz_zip_reader_end(&WorkerArchiver);
+		});
+
+		// Entries left over by workers that could not open the archive are tested on the main archiver
+		if (bOpenFailed)
+		{
+			TestEntries(MinizArchiverReal);
+		}
+	}
+
+	const int32 BadEntryIndex = FirstBadEntryIndex.load();
+	TestResult.NumOfTestedEntries = BadEntryIndex;
+
+	if (BadEntryIndex < NumOfEntries)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Zip archive test failed at entry %d '%s' (offset %lld): %s"), BadEntryIndex, *TestResult.BadEntryName, TestResult.BadEntryOffset, *TestResult.ErrorDescription);
+		return false;
+	}
+
+	TestResult.bIsValid = true;
+
+	ProgressReporter.Finish();
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully tested %d zip entries using %d workers"), NumOfEntries, NumOfWorkers);
+
+	return true;
+}
+
+bool URuntimeArchiverZip::GetArchiveEntriesByBaseName(const FString& BaseName, TArray<FRuntimeArchiveEntry>& EntryInfo)
+{
+	if (Mode != ERuntimeArchiverMode::Read || BaseName.IsEmpty())
+	{
+		return Super::GetArchiveEntriesByBaseName(BaseName, EntryInfo);
+	}
+
+	// All entries under the directory start with its name followed by a slash, which is a contiguous range of the sorted names
+	const FString Prefix = BaseName + TEXT("/");
+	const auto CompareNames = [](const FString& A, const FString& B) { return A.Compare(B, ESearchCase::CaseSensitive) < 0; };
+
+	TArray<int32> EntryIndices;
+	for (int32 SortedIndex = Algo::LowerBoundBy(SortedEntryNames, Prefix, [](const TPair<FString, int32>& Entry) -> const FString& { return Entry.Key; }, CompareNames);
+	     SortedIndex < SortedEntryNames.Num() && SortedEntryNames[SortedIndex].Key.StartsWith(Prefix, ESearchCase::CaseSensitive); ++SortedIndex)
+	{
+		EntryIndices.Add(SortedEntryNames[SortedIndex].Value);
+	}
+
+	// Keeping the order of the archive, so that directories are extracted before their content
+	EntryIndices.Sort();
+	EntryInfo.Reserve(EntryInfo.Num() + EntryIndices.Num());
+
+	for (const int32 EntryIndex : EntryIndices)
+	{
+		FRuntimeArchiveEntry ArchiveEntry;
+
+		if (!GetArchiveEntryInfoByIndex(EntryIndex, ArchiveEntry))
+		{
+			ReportError(ERuntimeArchiverErrorCode::GetError, FString::Printf(TEXT("Cannot get '%d' entry to extract. Aborting recursive extracting entries"), EntryIndex));
+			return false;
+		}
+
+		EntryInfo.Add(MoveTemp(ArchiveEntry));
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Found %d zip entries under '%s'"), EntryIndices.Num(), *BaseName);
+
+	return true;
+}
+
+void URuntimeArchiverZip::BuildEntryNameIndex()
+{
+	mz_zip_archive* MinizArchiverReal = static_cast<mz_zip_archive*>(MinizArchiver);
+	const int32 NumOfEntries = static_cast<int32>(mz_zip_reader_get_num_files(MinizArchiverReal));
+
+	EntryIndicesByName.Empty(NumOfEntries);
+	SortedEntryNames.Empty(NumOfEntries);
+
+	TArray<ANSICHAR> NameBuffer;
+
+	for (int32 EntryIndex = 0; EntryIndex < NumOfEntries; ++EntryIndex)
+	{
+		const mz_uint NameBufferSize = mz_zip_reader_get_filename(MinizArchiverReal, static_cast<mz_uint>(EntryIndex), nullptr, 0);
+		if (NameBufferSize == 0)
+		{
+			continue;
+		}
+
+		NameBuffer.SetNumUninitialized(static_cast<int32>(NameBufferSize));
+		mz_zip_reader_get_filename(MinizArchiverReal, static_cast<mz_uint>(EntryIndex), NameBuffer.GetData(), NameBufferSize);
+
+		FString EntryName = UTF8_TO_TCHAR(NameBuffer.GetData());
+
+		// Duplicated names resolve to the first entry with that name
+		if (!EntryIndicesByName.Contains(EntryName))
+		{
+			EntryIndicesByName.Add(EntryName, EntryIndex);
+		}
+
+		SortedEntryNames.Emplace(MoveTemp(EntryName), EntryIndex);
+	}
+
+	SortedEntryNames.Sort([](const TPair<FString, int32>& A, const TPair<FString, int32>& B)
+	{
+		return A.Key.Compare(B.Key, ESearchCase::CaseSensitive) < 0;
+	});
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Indexed %d zip entry names"), NumOfEntries);
+}
+
 bool URuntimeArchiverZip::Initialize()
 {
 	if (!Super::Initialize())
@@ -345,6 +1128,12 @@ void URuntimeArchiverZip::Reset()
 		MinizArchiver = nullptr;
 	}
 
+	// The mapping must outlive the reader, so it is released only afterwards
+	MappedArchiveStream.Reset();
+	ArchiveFilePath.Empty();
+	EntryIndicesByName.Empty();
+	SortedEntryNames.Empty();
+
 	Super::Reset();
 
 	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully uninitialized zip archiver '%s'"), *GetName());
@@ -4,25 +4,7 @@
 
 #include "CoreTypes.h"
 
-#ifndef __ORDER_LITTLE_ENDIAN__
-#define __ORDER_LITTLE_ENDIAN__ PLATFORM_LITTLE_ENDIAN
-#endif
-
-#ifndef MINIZ_USE_UNALIGNED_LOADS_AND_STORES
-#define MINIZ_USE_UNALIGNED_LOADS_AND_STORES PLATFORM_SUPPORTS_UNALIGNED_LOADS
-#endif
-
-#ifndef MINIZ_LITTLE_ENDIAN
-#define MINIZ_LITTLE_ENDIAN PLATFORM_LITTLE_ENDIAN
-#endif
-
-#ifndef MINIZ_HAS_64BIT_REGISTERS
-#define MINIZ_HAS_64BIT_REGISTERS PLATFORM_64BITS
-#endif
-
-#ifndef _LARGEFILE64_SOURCE
-#define _LARGEFILE64_SOURCE
-#endif
+#include "RuntimeArchiverMinizDeclarations.h"
 
 #pragma warning( push )
 #pragma warning( disable : 4334)
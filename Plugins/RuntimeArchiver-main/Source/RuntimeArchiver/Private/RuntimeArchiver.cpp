@@ -2,6 +2,7 @@
 
 #include "RuntimeArchiver.h"
 #include "RuntimeArchiverDefines.h"
+#include "RuntimeArchiverThreadPool.h"
 
 #define LOCTEXT_NAMESPACE "FRuntimeArchiverModule"
 
@@ -11,6 +12,7 @@ void FRuntimeArchiverModule::StartupModule()
 
 void FRuntimeArchiverModule::ShutdownModule()
 {
+	RuntimeArchiverThreadPool::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -4,13 +4,41 @@
 
 #include "RuntimeArchiverSubsystem.h"
 #include "RuntimeArchiverDefines.h"
+#include "RuntimeArchiverUtilities.h"
+#include "RuntimeArchiverProgressReporter.h"
+#include "RuntimeArchiverThreadPool.h"
+#include "Streams/RuntimeArchiverMemoryStream.h"
 #include "Async/Async.h"
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
 #include "HAL/PlatformFileManager.h"
 
+namespace
+{
+	/** Number of blocks sampled from an entry to estimate its compressibility */
+	constexpr int32 NumOfEntrySamples = 4;
+
+	/** Size of each sampled block. Large enough for the byte histogram to be meaningful */
+	constexpr int64 EntrySampleSize = 16 * 1024;
+
+	/**
+	 * Get the offset of a sampled block, spreading the samples evenly from the beginning to the end of the entry
+	 */
+	int64 GetEntrySampleOffset(int64 Size, int32 SampleIndex)
+	{
+		return (Size - EntrySampleSize) * SampleIndex / (NumOfEntrySamples - 1);
+	}
+}
+
 URuntimeArchiverBase::URuntimeArchiverBase()
-	: Mode(ERuntimeArchiverMode::Undefined)
+	: bStoreIncompressibleEntries(true)
+  , IncompressibleExtensions({TEXT("pak"), TEXT("ucas"), TEXT("bk2"), TEXT("ogg"), TEXT("opus"), TEXT("mp3"), TEXT("mp4"), TEXT("webm"), TEXT("png"), TEXT("jpg"), TEXT("jpeg"), TEXT("zip"), TEXT("7z"), TEXT("gz"), TEXT("zst"), TEXT("lz4")})
+  , MinSampledEntrySize(64 * 1024)
+  , IncompressibleEntropyThreshold(7.9f)
+  , bDurableExtraction(false)
+  , ExtractionCompletionMarkerName(TEXT(".extraction_complete"))
+  , ProgressReportInterval(0.1f)
+  , Mode(ERuntimeArchiverMode::Undefined)
   , Location(ERuntimeArchiverLocation::Undefined)
 {
 }
@@ -98,8 +126,28 @@ bool URuntimeArchiverBase::OpenArchiveFromStorage(FString ArchivePath)
 
 bool URuntimeArchiverBase::OpenArchiveFromMemory(TArray<uint8> ArchiveData)
 {
-	TArray64<uint8> ArchiveData64 = TArray64<uint8>(MoveTemp(ArchiveData));
-	return OpenArchiveFromMemory(ArchiveData64);
+	// Some archivers read the data in place, so the archiver has to keep it
+	return OpenArchiveFromMemory(TArray64<uint8>(MoveTemp(ArchiveData)));
+}
+
+bool URuntimeArchiverBase::OpenArchiveFromMemory(TArray64<uint8>&& ArchiveData)
+{
+	// The currently opened archive may still be reading the owned data
+	if (IsInitialized())
+	{
+		ReportError(ERuntimeArchiverErrorCode::UnsupportedMode, TEXT("Unable to open archive from memory because the archiver is already in use"));
+		return false;
+	}
+
+	OwnedArchiveData = MoveTemp(ArchiveData);
+
+	if (!OpenArchiveFromMemory(static_cast<const TArray64<uint8>&>(OwnedArchiveData)))
+	{
+		OwnedArchiveData.Empty();
+		return false;
+	}
+
+	return true;
 }
 
 bool URuntimeArchiverBase::OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData)
@@ -159,6 +207,12 @@ bool URuntimeArchiverBase::GetArchiveData(TArray64<uint8>& ArchiveData)
 	return true;
 }
 
+bool URuntimeArchiverBase::MoveArchiveData(TArray64<uint8>& ArchiveData)
+{
+	// By default, the data is copied out of the archiver before it is closed
+	return GetArchiveData(ArchiveData) && CloseArchive();
+}
+
 bool URuntimeArchiverBase::GetArchiveEntries(int32& NumOfArchiveEntries)
 {
 	if (!IsInitialized())
@@ -251,6 +305,11 @@ bool URuntimeArchiverBase::AddEntryFromStorage(FString EntryName, FString FilePa
 }
 
 void URuntimeArchiverBase::AddEntriesFromStorage(const FRuntimeArchiverAsyncOperationResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress, TArray<FString> FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel)
+{
+	AddEntriesFromStorageWithDetailedProgress(OnResult, OnProgress, FRuntimeArchiverAsyncOperationDetailedProgress(), MoveTemp(FilePaths), CompressionLevel);
+}
+
+void URuntimeArchiverBase::AddEntriesFromStorageWithDetailedProgress(const FRuntimeArchiverAsyncOperationResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress, const FRuntimeArchiverAsyncOperationDetailedProgress& OnDetailedProgress, TArray<FString> FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel)
 {
 	if (!IsInitialized())
 	{
@@ -259,7 +318,7 @@ void URuntimeArchiverBase::AddEntriesFromStorage(const FRuntimeArchiverAsyncOper
 		return;
 	}
 
-	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [WeakThis = MakeWeakObjectPtr(this), OnResult, OnProgress, FilePaths = MoveTemp(FilePaths), CompressionLevel]()
+	RuntimeArchiverThreadPool::Launch([WeakThis = MakeWeakObjectPtr(this), OnResult, OnProgress, OnDetailedProgress, FilePaths = MoveTemp(FilePaths), CompressionLevel]()
 	{
 		if (!WeakThis.IsValid())
 		{
@@ -275,32 +334,34 @@ void URuntimeArchiverBase::AddEntriesFromStorage(const FRuntimeArchiverAsyncOper
 			});
 		};
 
-		auto ExecuteProgress = [OnProgress](int32 Percentage)
-		{
-			AsyncTask(ENamedThreads::GameThread, [OnProgress, Percentage]()
-			{
-				OnProgress.ExecuteIfBound(Percentage);
-			});
-		};
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 
-		for (TArray<FString>::SizeType FilePathsIndex = 0; FilePathsIndex < FilePaths.Num(); ++FilePathsIndex)
-		{
-			FString FilePath = FilePaths[FilePathsIndex];
+		TArray<FString> EntryNames;
+		TArray<FString> NormalizedFilePaths;
+		EntryNames.Reserve(FilePaths.Num());
+		NormalizedFilePaths.Reserve(FilePaths.Num());
 
+		int64 TotalBytes = 0;
+
+		for (FString FilePath : FilePaths)
+		{
 			FPaths::NormalizeFilename(FilePath);
 
-			const FString EntryName = FPaths::GetCleanFilename(FilePath);
+			TotalBytes += FMath::Max<int64>(PlatformFile.FileSize(*FilePath), 0);
+			EntryNames.Add(FPaths::GetCleanFilename(FilePath));
+			NormalizedFilePaths.Add(MoveTemp(FilePath));
+		}
 
-			if (!WeakThis->AddEntryFromStorage(EntryName, FilePath, CompressionLevel))
-			{
-				WeakThis->ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Cannot add '%s' entry. Aborting async adding entries"), *EntryName));
-				ExecuteResult(false);
-				return;
-			}
+		FRuntimeArchiverProgressReporter ProgressReporter(TotalBytes, WeakThis->ProgressReportInterval, OnProgress, OnDetailedProgress);
 
-			ExecuteProgress(static_cast<float>(FilePathsIndex + 1) / FilePaths.Num() * 100);
+		if (!WeakThis->AddEntriesFromStorage_Internal(EntryNames, NormalizedFilePaths, CompressionLevel, [&ProgressReporter](int64 NumOfBytes) { ProgressReporter.AddProcessedBytes(NumOfBytes); }, [](int32 EntryIndex, TArrayView64<const uint8> Data) {}))
+		{
+			ExecuteResult(false);
+			return;
 		}
 
+		ProgressReporter.Finish();
+
 		UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully added '%d' entries"), FilePaths.Num());
 
 		ExecuteResult(true);
@@ -345,7 +406,7 @@ void URuntimeArchiverBase::AddEntriesFromStorage_Directory(const FRuntimeArchive
 		return BasePath;
 	}();
 
-	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [WeakThis = MakeWeakObjectPtr(this), OnResult, BaseDirectoryPathToExclude, DirectoryPath = MoveTemp(DirectoryPath), CompressionLevel]()
+	RuntimeArchiverThreadPool::Launch([WeakThis = MakeWeakObjectPtr(this), OnResult, BaseDirectoryPathToExclude, DirectoryPath = MoveTemp(DirectoryPath), CompressionLevel]()
 	{
 		if (!WeakThis.IsValid())
 		{
@@ -368,17 +429,16 @@ void URuntimeArchiverBase::AddEntriesFromStorage_Directory(const FRuntimeArchive
 
 bool URuntimeArchiverBase::AddEntriesFromStorage_Directory_Internal(FString BaseDirectoryPathToExclude, FString DirectoryPath, ERuntimeArchiverCompressionLevel CompressionLevel)
 {
-	class FDirectoryVisitor_EntryAppender : public IPlatformFile::FDirectoryVisitor
+	class FDirectoryVisitor_EntryCollector : public IPlatformFile::FDirectoryVisitor
 	{
-		URuntimeArchiverBase* RuntimeArchiver;
 		const FString BaseDirectoryPathToExclude;
-		const ERuntimeArchiverCompressionLevel CompressionLevel;
 
 	public:
-		FDirectoryVisitor_EntryAppender(URuntimeArchiverBase* RuntimeArchiver, const FString& BaseDirectoryPathToExclude, ERuntimeArchiverCompressionLevel CompressionLevel)
-			: RuntimeArchiver(RuntimeArchiver)
-		  , BaseDirectoryPathToExclude(BaseDirectoryPathToExclude)
-		  , CompressionLevel(CompressionLevel)
+		TArray<FString> EntryNames;
+		TArray<FString> FilePaths;
+
+		FDirectoryVisitor_EntryCollector(const FString& BaseDirectoryPathToExclude)
+			: BaseDirectoryPathToExclude(BaseDirectoryPathToExclude)
 		{
 		}
 
@@ -391,29 +451,84 @@ bool URuntimeArchiverBase::AddEntriesFromStorage_Directory_Internal(FString Base
 			}
 
 			// Get the entry name by truncating the base directory from the found file
-			const FString EntryName = FString(FilenameOrDirectory).RightChop(BaseDirectoryPathToExclude.Len());
-
-			if (!RuntimeArchiver->AddEntryFromStorage(EntryName, FilenameOrDirectory, CompressionLevel))
-			{
-				RuntimeArchiver->ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Cannot add '%s' entry. Aborting recursive adding entries"), *EntryName));
-				return false;
-			}
+			EntryNames.Add(FString(FilenameOrDirectory).RightChop(BaseDirectoryPathToExclude.Len()));
+			FilePaths.Add(FilenameOrDirectory);
 
 			return true;
 		}
 	};
 
-	FDirectoryVisitor_EntryAppender DirectoryVisitor_EntryAppender(this, BaseDirectoryPathToExclude, CompressionLevel);
+	FDirectoryVisitor_EntryCollector DirectoryVisitor_EntryCollector(BaseDirectoryPathToExclude);
+
+	if (!FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryRecursively(*DirectoryPath, DirectoryVisitor_EntryCollector))
+	{
+		ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Unable to scan directory '%s'"), *DirectoryPath));
+		return false;
+	}
 
-	return FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryRecursively(*DirectoryPath, DirectoryVisitor_EntryAppender);
+	return AddEntriesFromStorage_Internal(DirectoryVisitor_EntryCollector.EntryNames, DirectoryVisitor_EntryCollector.FilePaths, CompressionLevel, [](int64 NumOfBytes) {}, [](int32 EntryIndex, TArrayView64<const uint8> Data) {});
+}
+
+bool URuntimeArchiverBase::AddNamedEntriesFromStorage(const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int64)> OnProcessed)
+{
+	return AddNamedEntriesFromStorage(EntryNames, FilePaths, CompressionLevel, OnProcessed, [](int32 EntryIndex, TArrayView64<const uint8> Data) {});
+}
+
+bool URuntimeArchiverBase::AddNamedEntriesFromStorage(const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int64)> OnProcessed, TFunctionRef<void(int32, TArrayView64<const uint8>)> OnEntryData)
+{
+	if (!IsInitialized())
+	{
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TEXT("Archiver is not initialized"));
+		return false;
+	}
+
+	if (EntryNames.Num() != FilePaths.Num())
+	{
+		ReportError(ERuntimeArchiverErrorCode::InvalidArgument, FString::Printf(TEXT("The number of entry names (%d) does not match the number of file paths (%d)"), EntryNames.Num(), FilePaths.Num()));
+		return false;
+	}
+
+	if (!AddEntriesFromStorage_Internal(EntryNames, FilePaths, CompressionLevel, OnProcessed, OnEntryData))
+	{
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully added '%d' entries"), EntryNames.Num());
+	return true;
+}
+
+bool URuntimeArchiverBase::AddEntriesFromStorage_Internal(const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int64)> OnProcessed, TFunctionRef<void(int32, TArrayView64<const uint8>)> OnEntryData)
+{
+	for (int32 EntryIndex = 0; EntryIndex < EntryNames.Num(); ++EntryIndex)
+	{
+		// Loading the file here rather than in AddEntryFromStorage, so that the observer sees the same data that is archived
+		TArray64<uint8> FileData;
+		if (!FFileHelper::LoadFileToArray(FileData, *FilePaths[EntryIndex]))
+		{
+			ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Unable to load file '%s' for entry '%s'. Aborting adding entries"), *FilePaths[EntryIndex], *EntryNames[EntryIndex]));
+			return false;
+		}
+
+		OnEntryData(EntryIndex, FileData);
+
+		if (!AddEntryFromMemory(EntryNames[EntryIndex], FileData, CompressionLevel))
+		{
+			ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Cannot add '%s' entry. Aborting adding entries"), *EntryNames[EntryIndex]));
+			return false;
+		}
+
+		OnProcessed(FileData.Num());
+	}
+
+	return true;
 }
 
 bool URuntimeArchiverBase::AddEntryFromMemory(FString EntryName, TArray<uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
 {
-	return AddEntryFromMemory(MoveTemp(EntryName), TArray64<uint8>(MoveTemp(DataToBeArchived)), CompressionLevel);
+	return AddEntryFromMemory(MoveTemp(EntryName), TArrayView64<const uint8>(DataToBeArchived), CompressionLevel);
 }
 
-bool URuntimeArchiverBase::AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
+bool URuntimeArchiverBase::AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel)
 {
 	if (!IsInitialized())
 	{
@@ -436,7 +551,118 @@ bool URuntimeArchiverBase::AddEntryFromMemory(FString EntryName, const TArray64<
 	return true;
 }
 
+ERuntimeArchiverCompressionLevel URuntimeArchiverBase::GetEntryCompressionLevel(const FString& EntryName, const uint8* Data, int64 Size, ERuntimeArchiverCompressionLevel CompressionLevel) const
+{
+	if (!bStoreIncompressibleEntries || CompressionLevel == ERuntimeArchiverCompressionLevel::Compression0 || Size < MinSampledEntrySize)
+	{
+		return CompressionLevel;
+	}
+
+	TArray64<uint8> Samples;
+
+	if (Size <= NumOfEntrySamples * EntrySampleSize)
+	{
+		Samples.Append(Data, Size);
+	}
+	else
+	{
+		Samples.Reserve(NumOfEntrySamples * EntrySampleSize);
+
+		for (int32 SampleIndex = 0; SampleIndex < NumOfEntrySamples; ++SampleIndex)
+		{
+			Samples.Append(Data + GetEntrySampleOffset(Size, SampleIndex), EntrySampleSize);
+		}
+	}
+
+	if (!ShouldStoreEntry(EntryName, Size, Samples))
+	{
+		return CompressionLevel;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Entry '%s' (%lld bytes) is unlikely to compress and will be stored as is"), *EntryName, Size);
+	return ERuntimeArchiverCompressionLevel::Compression0;
+}
+
+ERuntimeArchiverCompressionLevel URuntimeArchiverBase::GetEntryCompressionLevel(const FString& EntryName, IFileHandle& FileHandle, int64 Size, ERuntimeArchiverCompressionLevel CompressionLevel) const
+{
+	if (!bStoreIncompressibleEntries || CompressionLevel == ERuntimeArchiverCompressionLevel::Compression0 || Size < MinSampledEntrySize)
+	{
+		return CompressionLevel;
+	}
+
+	const int32 NumOfSamples = Size <= NumOfEntrySamples * EntrySampleSize ? 1 : NumOfEntrySamples;
+	const int64 SampleSize = NumOfSamples == 1 ? Size : EntrySampleSize;
+
+	TArray64<uint8> Samples;
+	Samples.SetNumUninitialized(NumOfSamples * SampleSize);
+
+	for (int32 SampleIndex = 0; SampleIndex < NumOfSamples; ++SampleIndex)
+	{
+		const int64 Offset = NumOfSamples == 1 ? 0 : GetEntrySampleOffset(Size, SampleIndex);
+
+		// Unreadable entries are left to the archiver to report
+		if (!FileHandle.Seek(Offset) || !FileHandle.Read(Samples.GetData() + SampleIndex * SampleSize, SampleSize))
+		{
+			return CompressionLevel;
+		}
+	}
+
+	if (!ShouldStoreEntry(EntryName, Size, Samples))
+	{
+		return CompressionLevel;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Entry '%s' (%lld bytes) is unlikely to compress and will be stored as is"), *EntryName, Size);
+	return ERuntimeArchiverCompressionLevel::Compression0;
+}
+
+bool URuntimeArchiverBase::ShouldStoreEntry(const FString& EntryName, int64 Size, TArrayView64<const uint8> Samples) const
+{
+	const FString Extension = FPaths::GetExtension(EntryName);
+	if (!Extension.IsEmpty() && IncompressibleExtensions.ContainsByPredicate([&Extension](const FString& IncompressibleExtension) { return IncompressibleExtension.Equals(Extension, ESearchCase::IgnoreCase); }))
+	{
+		UE_LOG(LogRuntimeArchiver, Verbose, TEXT("Entry '%s' has an incompressible extension '%s'"), *EntryName, *Extension);
+		return true;
+	}
+
+	const float Entropy = EstimateEntropy(Samples);
+	UE_LOG(LogRuntimeArchiver, Verbose, TEXT("Entry '%s' has an estimated entropy of %.3f bits per byte (threshold: %.3f)"), *EntryName, Entropy, IncompressibleEntropyThreshold);
+
+	return Entropy > IncompressibleEntropyThreshold;
+}
+
+float URuntimeArchiverBase::EstimateEntropy(TArrayView64<const uint8> Data)
+{
+	if (Data.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	int64 Histogram[256] = {};
+	for (const uint8 Byte : Data)
+	{
+		++Histogram[Byte];
+	}
+
+	double Entropy = 0.;
+	for (const int64 Count : Histogram)
+	{
+		if (Count > 0)
+		{
+			const double Probability = static_cast<double>(Count) / Data.Num();
+			Entropy -= Probability * FMath::Log2(Probability);
+		}
+	}
+
+	return static_cast<float>(Entropy);
+}
+
 bool URuntimeArchiverBase::ExtractEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, FString FilePath, bool bForceOverwrite)
+{
+	return ExtractEntryToStorage_Internal(EntryInfo, MoveTemp(FilePath), bForceOverwrite, [](int64 NumOfBytes) {});
+}
+
+bool URuntimeArchiverBase::ExtractEntryToStorage_Internal(const FRuntimeArchiveEntry& EntryInfo, FString FilePath, bool bForceOverwrite, TFunctionRef<void(int64)> OnProcessed)
 {
 	if (!IsInitialized())
 	{
@@ -500,16 +726,8 @@ bool URuntimeArchiverBase::ExtractEntryToStorage(const FRuntimeArchiveEntry& Ent
 			UE_LOG(LogRuntimeArchiver, Warning, TEXT("File '%s' already exists. It will be overwritten"), *FilePath);
 		}
 
-		TArray64<uint8> EntryData;
-		if (!ExtractEntryToMemory(EntryInfo, EntryData))
+		if (!ExtractFileEntryToStorage(EntryInfo, FilePath, OnProcessed))
 		{
-			ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to extract the entry '%s' from archive to memory for file '%s'"), *EntryInfo.Name, *FilePath));
-			return false;
-		}
-
-		if (!FFileHelper::SaveArrayToFile(EntryData, *FilePath))
-		{
-			ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to save the entry '%s' from memory to file '%s'"), *EntryInfo.Name, *FilePath));
 			return false;
 		}
 
@@ -519,7 +737,32 @@ bool URuntimeArchiverBase::ExtractEntryToStorage(const FRuntimeArchiveEntry& Ent
 	return true;
 }
 
+bool URuntimeArchiverBase::ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed)
+{
+	TArray64<uint8> EntryData;
+	if (!ExtractEntryToMemory(EntryInfo, EntryData))
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to extract the entry '%s' from archive to memory for file '%s'"), *EntryInfo.Name, *FilePath));
+		return false;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(EntryData, *FilePath))
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to save the entry '%s' from memory to file '%s'"), *EntryInfo.Name, *FilePath));
+		return false;
+	}
+
+	OnProcessed(EntryData.Num());
+
+	return true;
+}
+
 void URuntimeArchiverBase::ExtractEntriesToStorage(const FRuntimeArchiverAsyncOperationResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress, TArray<FRuntimeArchiveEntry> EntryInfo, FString DirectoryPath, bool bForceOverwrite)
+{
+	ExtractEntriesToStorageWithDetailedProgress(OnResult, OnProgress, FRuntimeArchiverAsyncOperationDetailedProgress(), MoveTemp(EntryInfo), MoveTemp(DirectoryPath), bForceOverwrite);
+}
+
+void URuntimeArchiverBase::ExtractEntriesToStorageWithDetailedProgress(const FRuntimeArchiverAsyncOperationResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress, const FRuntimeArchiverAsyncOperationDetailedProgress& OnDetailedProgress, TArray<FRuntimeArchiveEntry> EntryInfo, FString DirectoryPath, bool bForceOverwrite)
 {
 	if (!IsInitialized())
 	{
@@ -530,7 +773,7 @@ void URuntimeArchiverBase::ExtractEntriesToStorage(const FRuntimeArchiverAsyncOp
 
 	FPaths::NormalizeDirectoryName(DirectoryPath);
 
-	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [WeakThis = MakeWeakObjectPtr(this), OnResult, OnProgress, EntryInfo = MoveTemp(EntryInfo), DirectoryPath = MoveTemp(DirectoryPath), bForceOverwrite]()
+	RuntimeArchiverThreadPool::Launch([WeakThis = MakeWeakObjectPtr(this), OnResult, OnProgress, OnDetailedProgress, EntryInfo = MoveTemp(EntryInfo), DirectoryPath = MoveTemp(DirectoryPath), bForceOverwrite]()
 	{
 		if (!WeakThis.IsValid())
 		{
@@ -546,69 +789,108 @@ void URuntimeArchiverBase::ExtractEntriesToStorage(const FRuntimeArchiverAsyncOp
 			});
 		};
 
-		auto ExecuteProgress = [OnProgress](int32 Percentage)
-		{
-			AsyncTask(ENamedThreads::GameThread, [OnProgress, Percentage]()
-			{
-				OnProgress.ExecuteIfBound(Percentage);
-			});
-		};
+		TArray<FString> FilePaths;
+		FilePaths.Reserve(EntryInfo.Num());
 
-		for (int32 EntryIndex = 0; EntryIndex < EntryInfo.Num(); ++EntryIndex)
+		int64 TotalBytes = 0;
+
+		for (const FRuntimeArchiveEntry& Entry : EntryInfo)
 		{
-			const FRuntimeArchiveEntry& Entry = EntryInfo[EntryIndex];
+			FString ExtractFilePath = Entry.Name;
+			FPaths::NormalizeDirectoryName(ExtractFilePath);
+			FilePaths.Add(FPaths::Combine(DirectoryPath, TEXT("/"), ExtractFilePath));
 
-			const FString ExtractFilePath = [&Entry]()
-			{
-				FString FilePath = Entry.Name;
-				FPaths::NormalizeDirectoryName(FilePath);
-				return FilePath;
-			}();
+			TotalBytes += Entry.bIsDirectory ? 0 : Entry.UncompressedSize;
+		}
 
-			if (!WeakThis->ExtractEntryToStorage(Entry, FPaths::Combine(DirectoryPath, TEXT("/"), ExtractFilePath), bForceOverwrite))
-			{
-				WeakThis->ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Cannot extract '%s' entry. Aborting async extracting entries"), *Entry.Name));
-				ExecuteResult(false);
-				return;
-			}
+		FRuntimeArchiverProgressReporter ProgressReporter(TotalBytes, WeakThis->ProgressReportInterval, OnProgress, OnDetailedProgress);
+
+		if (WeakThis->bDurableExtraction && !WeakThis->BeginDurableExtraction(DirectoryPath))
+		{
+			ExecuteResult(false);
+			return;
+		}
+
+		if (!WeakThis->ExtractEntriesToStorage_Internal(EntryInfo, FilePaths, bForceOverwrite, [&ProgressReporter](int64 NumOfBytes) { ProgressReporter.AddProcessedBytes(NumOfBytes); }))
+		{
+			ExecuteResult(false);
+			return;
+		}
 
-			ExecuteProgress(static_cast<float>(EntryIndex + 1) / EntryInfo.Num() * 100);
+		if (WeakThis->bDurableExtraction && !WeakThis->FinishDurableExtraction(DirectoryPath, FilePaths))
+		{
+			ExecuteResult(false);
+			return;
 		}
 
+		ProgressReporter.Finish();
+
 		UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully extracted '%d' entries"), EntryInfo.Num());
 
 		ExecuteResult(true);
 	});
 }
 
-namespace
+bool URuntimeArchiverBase::FinishDurableExtraction(const FString& DirectoryPath, const TArray<FString>& FilePaths)
 {
-	/**
-	 * Check whether the entry name belongs to the base name. For example, the entry name "SubFolder/File.txt" belongs to the base name "SubFolder", but the entry name "SubFolderNew/File.txt" does not belong to the base name "SubFolder"
-	 */
-	bool CheckEntryNameBelongsToBaseName(const FString& BaseName, const FString& EntryName)
+	FString NormalizedDirectoryPath = DirectoryPath;
+	FPaths::NormalizeDirectoryName(NormalizedDirectoryPath);
+
+	if (!URuntimeArchiverUtilities::SyncFilesToStorage(NormalizedDirectoryPath, FilePaths))
 	{
-		int32 BaseNameIndex, EntryNameIndex;
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to sync the entries extracted to '%s' to storage"), *NormalizedDirectoryPath));
+		return false;
+	}
 
-		for (BaseNameIndex = EntryNameIndex = 0; BaseNameIndex < BaseName.Len() && EntryNameIndex < EntryName.Len(); ++BaseNameIndex, ++EntryNameIndex)
-		{
-			const TCHAR& BaseNameCharacter = BaseName[BaseNameIndex];
-			const TCHAR& EntryNameCharacter = EntryName[EntryNameIndex];
+	const FString MarkerPath = GetExtractionCompletionMarkerPath(NormalizedDirectoryPath);
+	if (MarkerPath.IsEmpty())
+	{
+		return true;
+	}
 
-			if (BaseNameCharacter != EntryNameCharacter)
-			{
-				return false;
-			}
+	// The marker is only written once everything else is durable, so its presence means that the whole extraction is
+	const FString MarkerContent = FString::Printf(TEXT("Entries: %d\nCompleted: %s\n"), FilePaths.Num(), *FDateTime::UtcNow().ToIso8601());
 
-			if (BaseNameIndex == BaseName.Len() - 1 &&
-				EntryNameIndex + 1 < EntryName.Len() && EntryName[EntryNameIndex + 1] == TEXT('/'))
-			{
-				return true;
-			}
-		}
+	if (!URuntimeArchiverUtilities::SaveStringToFileAtomically(MarkerPath, MarkerContent))
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to write the extraction completion marker '%s'"), *MarkerPath));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully completed durable extraction of %d entries to '%s'"), FilePaths.Num(), *NormalizedDirectoryPath);
+
+	return true;
+}
+
+bool URuntimeArchiverBase::IsExtractionComplete(FString DirectoryPath) const
+{
+	FPaths::NormalizeDirectoryName(DirectoryPath);
+
+	const FString MarkerPath = GetExtractionCompletionMarkerPath(DirectoryPath);
+	return !MarkerPath.IsEmpty() && FPaths::FileExists(MarkerPath);
+}
 
+bool URuntimeArchiverBase::BeginDurableExtraction(const FString& DirectoryPath) const
+{
+	const FString MarkerPath = GetExtractionCompletionMarkerPath(DirectoryPath);
+	if (MarkerPath.IsEmpty() || !FPaths::FileExists(MarkerPath))
+	{
+		return true;
+	}
+
+	// The removal has to be durable too, otherwise the old marker could reappear next to partially written files after a power loss
+	if (!FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*MarkerPath) || !URuntimeArchiverUtilities::SyncFilesToStorage(DirectoryPath, {}))
+	{
+		ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Unable to remove the extraction completion marker '%s'"), *MarkerPath));
 		return false;
 	}
+
+	return true;
+}
+
+FString URuntimeArchiverBase::GetExtractionCompletionMarkerPath(const FString& DirectoryPath) const
+{
+	return ExtractionCompletionMarkerName.IsEmpty() ? FString() : FPaths::Combine(DirectoryPath, ExtractionCompletionMarkerName);
 }
 
 void URuntimeArchiverBase::ExtractEntriesToStorage_Directory(const FRuntimeArchiverAsyncOperationResult& OnResult, FString EntryName, FString DirectoryPath, bool bAddParentDirectory, bool bForceOverwrite)
@@ -620,14 +902,6 @@ void URuntimeArchiverBase::ExtractEntriesToStorage_Directory(const FRuntimeArchi
 		return;
 	}
 
-	int32 NumOfEntries;
-	if (!GetArchiveEntries(NumOfEntries))
-	{
-		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Cannot get the number of archive entries. Aborting recursive extracting entries"));
-		OnResult.ExecuteIfBound(false);
-		return;
-	}
-
 	FPaths::NormalizeDirectoryName(EntryName);
 	FPaths::NormalizeDirectoryName(DirectoryPath);
 
@@ -648,7 +922,7 @@ void URuntimeArchiverBase::ExtractEntriesToStorage_Directory(const FRuntimeArchi
 		return BasePath;
 	}();
 
-	AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [WeakThis = MakeWeakObjectPtr(this), OnResult, NumOfEntries, EntryName, DirectoryPath, BaseDirectoryPathToExclude, bForceOverwrite]()
+	RuntimeArchiverThreadPool::Launch([WeakThis = MakeWeakObjectPtr(this), OnResult, EntryName, DirectoryPath, BaseDirectoryPathToExclude, bForceOverwrite]()
 	{
 		if (!WeakThis.IsValid())
 		{
@@ -656,30 +930,23 @@ void URuntimeArchiverBase::ExtractEntriesToStorage_Directory(const FRuntimeArchi
 			return;
 		}
 
+		TArray<FString> FilePaths;
+
 		bool bResult = true;
 
-		for (int32 EntryIndex = 0; EntryIndex < NumOfEntries; ++EntryIndex)
+		if (WeakThis->bDurableExtraction)
 		{
-			FRuntimeArchiveEntry ArchiveEntry;
+			bResult = WeakThis->BeginDurableExtraction(DirectoryPath);
+		}
 
-			if (!WeakThis->GetArchiveEntryInfoByIndex(EntryIndex, ArchiveEntry))
-			{
-				WeakThis->ReportError(ERuntimeArchiverErrorCode::AddError, FString::Printf(TEXT("Cannot get '%d' entry to extract. Aborting recursive extracting entries"), EntryIndex));
-				bResult = false;
-				break;
-			}
+		if (bResult)
+		{
+			bResult = WeakThis->ExtractEntriesToStorage_Directory_Internal(EntryName, DirectoryPath, BaseDirectoryPathToExclude, bForceOverwrite, FilePaths);
+		}
 
-			if (EntryName.IsEmpty() || CheckEntryNameBelongsToBaseName(EntryName, ArchiveEntry.Name))
-			{
-				// Get the file path by truncating the base directory from the found entry
-				const FString SpecificFilePath = FPaths::Combine(DirectoryPath, ArchiveEntry.Name.RightChop(BaseDirectoryPathToExclude.Len()));
-
-				if (!WeakThis->ExtractEntryToStorage(ArchiveEntry, SpecificFilePath, bForceOverwrite))
-				{
-					bResult = false;
-					break;
-				}
-			}
+		if (bResult && WeakThis->bDurableExtraction)
+		{
+			bResult = WeakThis->FinishDurableExtraction(DirectoryPath, FilePaths);
 		}
 
 		if (bResult)
@@ -694,6 +961,93 @@ void URuntimeArchiverBase::ExtractEntriesToStorage_Directory(const FRuntimeArchi
 	});
 }
 
+bool URuntimeArchiverBase::GetArchiveEntriesByBaseName(const FString& BaseName, TArray<FRuntimeArchiveEntry>& EntryInfo)
+{
+	int32 NumOfEntries;
+	if (!GetArchiveEntries(NumOfEntries))
+	{
+		ReportError(ERuntimeArchiverErrorCode::GetError, TEXT("Cannot get the number of archive entries. Aborting recursive extracting entries"));
+		return false;
+	}
+
+	for (int32 EntryIndex = 0; EntryIndex < NumOfEntries; ++EntryIndex)
+	{
+		FRuntimeArchiveEntry ArchiveEntry;
+
+		if (!GetArchiveEntryInfoByIndex(EntryIndex, ArchiveEntry))
+		{
+			ReportError(ERuntimeArchiverErrorCode::GetError, FString::Printf(TEXT("Cannot get '%d' entry to extract. Aborting recursive extracting entries"), EntryIndex));
+			return false;
+		}
+
+		if (BaseName.IsEmpty() || CheckEntryNameBelongsToBaseName(BaseName, ArchiveEntry.Name))
+		{
+			EntryInfo.Add(MoveTemp(ArchiveEntry));
+		}
+	}
+
+	return true;
+}
+
+bool URuntimeArchiverBase::ExtractEntriesToStorage_Directory_Internal(const FString& BaseName, const FString& DirectoryPath, const FString& BaseDirectoryPathToExclude, bool bForceOverwrite, TArray<FString>& FilePaths)
+{
+	TArray<FRuntimeArchiveEntry> ArchiveEntries;
+	if (!GetArchiveEntriesByBaseName(BaseName, ArchiveEntries))
+	{
+		return false;
+	}
+
+	FilePaths.Reserve(ArchiveEntries.Num());
+
+	// Get the file paths by truncating the base directory from the found entries
+	for (const FRuntimeArchiveEntry& ArchiveEntry : ArchiveEntries)
+	{
+		FilePaths.Add(FPaths::Combine(DirectoryPath, ArchiveEntry.Name.RightChop(BaseDirectoryPathToExclude.Len())));
+	}
+
+	return ExtractEntriesToStorage_Internal(ArchiveEntries, FilePaths, bForceOverwrite, [](int64 NumOfBytes) {});
+}
+
+bool URuntimeArchiverBase::CheckEntryNameBelongsToBaseName(const FString& BaseName, const FString& EntryName)
+{
+	int32 BaseNameIndex, EntryNameIndex;
+
+	for (BaseNameIndex = EntryNameIndex = 0; BaseNameIndex < BaseName.Len() && EntryNameIndex < EntryName.Len(); ++BaseNameIndex, ++EntryNameIndex)
+	{
+		const TCHAR& BaseNameCharacter = BaseName[BaseNameIndex];
+		const TCHAR& EntryNameCharacter = EntryName[EntryNameIndex];
+
+		if (BaseNameCharacter != EntryNameCharacter)
+		{
+			return false;
+		}
+
+		if (BaseNameIndex == BaseName.Len() - 1 &&
+			EntryNameIndex + 1 < EntryName.Len() && EntryName[EntryNameIndex + 1] == TEXT('/'))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool URuntimeArchiverBase::ExtractEntriesToStorage_Internal(const TArray<FRuntimeArchiveEntry>& EntryInfo, const TArray<FString>& FilePaths, bool bForceOverwrite, TFunctionRef<void(int64)> OnProcessed)
+{
+	for (int32 EntryIndex = 0; EntryIndex < EntryInfo.Num(); ++EntryIndex)
+	{
+		const FRuntimeArchiveEntry& Entry = EntryInfo[EntryIndex];
+
+		if (!ExtractEntryToStorage_Internal(Entry, FilePaths[EntryIndex], bForceOverwrite, OnProcessed))
+		{
+			ReportError(ERuntimeArchiverErrorCode::ExtractError, FString::Printf(TEXT("Cannot extract '%s' entry. Aborting extracting entries"), *Entry.Name));
+			return false;
+		}
+	}
+
+	return true;
+}
+
 bool URuntimeArchiverBase::ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray<uint8>& UnarchivedData)
 {
 	TArray64<uint8> UnarchivedData64;
@@ -737,6 +1091,101 @@ bool URuntimeArchiverBase::ExtractEntryToMemory(const FRuntimeArchiveEntry& Entr
 	return true;
 }
 
+void URuntimeArchiverBase::TestArchive(const FRuntimeArchiverAsyncTestResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress)
+{
+	if (!IsInitialized() || Mode != ERuntimeArchiverMode::Read)
+	{
+		FRuntimeArchiverTestResult TestResult;
+		TestArchive(TestResult);
+		OnResult.ExecuteIfBound(TestResult);
+		return;
+	}
+
+	RuntimeArchiverThreadPool::Launch([WeakThis = MakeWeakObjectPtr(this), OnResult, OnProgress]()
+	{
+		if (!WeakThis.IsValid())
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Failed to test archive: archiver is no longer valid"));
+			return;
+		}
+
+		auto ExecuteProgress = [OnProgress](int32 Percentage)
+		{
+			AsyncTask(ENamedThreads::GameThread, [OnProgress, Percentage]()
+			{
+				OnProgress.ExecuteIfBound(Percentage);
+			});
+		};
+
+		FRuntimeArchiverTestResult TestResult;
+		WeakThis->TestArchive_Internal(TestResult, ExecuteProgress);
+
+		AsyncTask(ENamedThreads::GameThread, [OnResult, TestResult = MoveTemp(TestResult)]()
+		{
+			OnResult.ExecuteIfBound(TestResult);
+		});
+	});
+}
+
+bool URuntimeArchiverBase::TestArchive(FRuntimeArchiverTestResult& TestResult)
+{
+	TestResult = FRuntimeArchiverTestResult();
+
+	if (!IsInitialized())
+	{
+		TestResult.ErrorDescription = TEXT("Archiver is not initialized");
+		ReportError(ERuntimeArchiverErrorCode::NotInitialized, TestResult.ErrorDescription);
+		return false;
+	}
+
+	if (Mode != ERuntimeArchiverMode::Read)
+	{
+		TestResult.ErrorDescription = FString::Printf(TEXT("Only '%s' mode is supported for testing the archive (using mode: '%s')"), *UEnum::GetValueAsName(ERuntimeArchiverMode::Read).ToString(), *UEnum::GetValueAsName(Mode).ToString());
+		ReportError(ERuntimeArchiverErrorCode::UnsupportedMode, TestResult.ErrorDescription);
+		return false;
+	}
+
+	return TestArchive_Internal(TestResult, [](int32) {});
+}
+
+bool URuntimeArchiverBase::TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress)
+{
+	int32 NumOfEntries;
+	if (!GetArchiveEntries(NumOfEntries))
+	{
+		TestResult.ErrorDescription = TEXT("Unable to get the number of archive entries");
+		return false;
+	}
+
+	TArray64<uint8> UnarchivedData;
+	FRuntimeArchiverPercentageReporter ProgressReporter(OnProgress);
+
+	for (int32 EntryIndex = 0; EntryIndex < NumOfEntries; ++EntryIndex)
+	{
+		FRuntimeArchiveEntry Entry;
+		const bool bEntryValid = GetArchiveEntryInfoByIndex(EntryIndex, Entry) && (Entry.bIsDirectory || ExtractEntryToMemory(Entry, UnarchivedData));
+
+		if (!bEntryValid)
+		{
+			TestResult.BadEntryIndex = EntryIndex;
+			TestResult.BadEntryName = Entry.Name;
+			TestResult.ErrorDescription = FString::Printf(TEXT("Unable to read entry '%d'"), EntryIndex);
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Archive test failed: %s"), *TestResult.ErrorDescription);
+			return false;
+		}
+
+		++TestResult.NumOfTestedEntries;
+		ProgressReporter.ReportProcessed(EntryIndex + 1, NumOfEntries);
+	}
+
+	TestResult.bIsValid = true;
+	ProgressReporter.Finish();
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully tested %d archive entries"), TestResult.NumOfTestedEntries);
+
+	return true;
+}
+
 bool URuntimeArchiverBase::Initialize()
 {
 	return true;
@@ -751,6 +1200,18 @@ void URuntimeArchiverBase::Reset()
 {
 	Mode = ERuntimeArchiverMode::Undefined;
 	Location = ERuntimeArchiverLocation::Undefined;
+	OwnedArchiveData.Empty();
+}
+
+FRuntimeArchiverBaseStream* URuntimeArchiverBase::CreateMemoryReadStream(const TArray64<uint8>& ArchiveData) const
+{
+	// Owned data outlives the stream, as derived archivers release their streams before the base archiver is reset
+	if (&ArchiveData == &OwnedArchiveData)
+	{
+		return new FRuntimeArchiverMemoryStream(TArrayView64<const uint8>(ArchiveData));
+	}
+
+	return new FRuntimeArchiverMemoryStream(ArchiveData);
 }
 
 void URuntimeArchiverBase::ReportError(ERuntimeArchiverErrorCode ErrorCode, const FString& ErrorString) const
@@ -0,0 +1,130 @@
+﻿// Georgy Treshchev 2024.
+
+#include "RuntimeArchiverProgressReporter.h"
+#include "Async/Async.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+	/** Weight of the latest measurement in the smoothed throughput. Lower values give a steadier but slower reacting estimate */
+	constexpr double ThroughputSmoothingFactor = 0.3;
+}
+
+FRuntimeArchiverProgressReporter::FRuntimeArchiverProgressReporter(int64 TotalBytes, float ReportInterval, const FRuntimeArchiverAsyncOperationProgress& OnProgress, const FRuntimeArchiverAsyncOperationDetailedProgress& OnDetailedProgress)
+	: TotalBytes(TotalBytes)
+  , ReportInterval(FMath::Max(ReportInterval, 0.f))
+  , OnProgress(OnProgress)
+  , OnDetailedProgress(OnDetailedProgress)
+  , ProcessedBytes(0)
+  , StartTime(FPlatformTime::Seconds())
+  , LastReportTime(StartTime)
+  , LastReportedBytes(0)
+  , BytesPerSecond(-1)
+  , LastReportedPercentage(0)
+{
+	NextReportTime = StartTime + this->ReportInterval;
+}
+
+void FRuntimeArchiverProgressReporter::AddProcessedBytes(int64 NumOfBytes)
+{
+	const int64 CurrentProcessedBytes = ProcessedBytes.fetch_add(NumOfBytes) + NumOfBytes;
+	const double CurrentTime = FPlatformTime::Seconds();
+
+	// Only the thread claiming the next report time makes the report, all others just add their bytes
+	double ExpectedReportTime = NextReportTime.load();
+	if (CurrentTime < ExpectedReportTime || !NextReportTime.compare_exchange_strong(ExpectedReportTime, CurrentTime + ReportInterval))
+	{
+		return;
+	}
+
+	Report(CurrentProcessedBytes, CurrentTime, false);
+}
+
+void FRuntimeArchiverProgressReporter::Finish()
+{
+	Report(ProcessedBytes.load(), FPlatformTime::Seconds(), true);
+}
+
+void FRuntimeArchiverProgressReporter::Report(int64 CurrentProcessedBytes, double CurrentTime, bool bFinished)
+{
+	FScopeLock Lock(&ReportCriticalSection);
+
+	// Reports may be made out of order when several are due at once
+	if (CurrentProcessedBytes < LastReportedBytes && !bFinished)
+	{
+		return;
+	}
+
+	const double ElapsedTime = CurrentTime - LastReportTime;
+	if (ElapsedTime > 0)
+	{
+		const double CurrentBytesPerSecond = (CurrentProcessedBytes - LastReportedBytes) / ElapsedTime;
+		BytesPerSecond = BytesPerSecond < 0 ? CurrentBytesPerSecond : FMath::Lerp(BytesPerSecond, CurrentBytesPerSecond, ThroughputSmoothingFactor);
+	}
+
+	LastReportTime = CurrentTime;
+	LastReportedBytes = CurrentProcessedBytes;
+
+	FRuntimeArchiverProgress Progress;
+	Progress.ProcessedBytes = CurrentProcessedBytes;
+	Progress.TotalBytes = TotalBytes;
+	Progress.Percentage = bFinished ? 100.f : TotalBytes > 0 ? static_cast<float>(FMath::Min<double>(static_cast<double>(CurrentProcessedBytes) / TotalBytes * 100, 100)) : 0.f;
+
+	if (bFinished)
+	{
+		const double TotalTime = CurrentTime - StartTime;
+		Progress.MegabytesPerSecond = TotalTime > 0 ? static_cast<float>(CurrentProcessedBytes / TotalTime / (1024 * 1024)) : 0.f;
+		Progress.RemainingSeconds = 0;
+	}
+	else if (BytesPerSecond > 0)
+	{
+		Progress.MegabytesPerSecond = static_cast<float>(BytesPerSecond / (1024 * 1024));
+		Progress.RemainingSeconds = static_cast<float>(FMath::Max<int64>(TotalBytes - CurrentProcessedBytes, 0) / BytesPerSecond);
+	}
+
+	const int32 Percentage = static_cast<int32>(Progress.Percentage);
+	const bool bPercentageChanged = Percentage > LastReportedPercentage;
+	LastReportedPercentage = FMath::Max(LastReportedPercentage, Percentage);
+
+	AsyncTask(ENamedThreads::GameThread, [OnProgress = OnProgress, OnDetailedProgress = OnDetailedProgress, Progress, Percentage, bPercentageChanged]()
+	{
+		if (bPercentageChanged)
+		{
+			OnProgress.ExecuteIfBound(Percentage);
+		}
+
+		OnDetailedProgress.ExecuteIfBound(Progress);
+	});
+}
+
+FRuntimeArchiverPercentageReporter::FRuntimeArchiverPercentageReporter(TFunctionRef<void(int32)> OnProgress)
+	: OnProgress(OnProgress)
+  , LastReportedPercentage(0)
+{
+}
+
+void FRuntimeArchiverPercentageReporter::ReportPercentage(int32 Percentage)
+{
+	Percentage = FMath::Clamp(Percentage, 0, 100);
+
+	// Only the thread raising the last reported percentage makes the report
+	int32 PreviousPercentage = LastReportedPercentage.load();
+	while (Percentage > PreviousPercentage)
+	{
+		if (LastReportedPercentage.compare_exchange_weak(PreviousPercentage, Percentage))
+		{
+			OnProgress(Percentage);
+			break;
+		}
+	}
+}
+
+void FRuntimeArchiverPercentageReporter::ReportProcessed(int64 Processed, int64 Total)
+{
+	ReportPercentage(Total > 0 ? static_cast<int32>(FMath::Min<int64>(Processed * 100 / Total, 100)) : 100);
+}
+
+void FRuntimeArchiverPercentageReporter::Finish()
+{
+	ReportPercentage(100);
+}
@@ -0,0 +1,111 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RuntimeArchiverTypes.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+/**
+ * Aggregates the number of bytes processed by an archive operation from any thread and reports the progress to the game thread at a limited rate
+ * Along with the percentage, the throughput and the remaining time are reported to the detailed progress delegate
+ */
+class FRuntimeArchiverProgressReporter
+{
+public:
+	/**
+	 * @param TotalBytes Total number of uncompressed bytes the operation is going to process
+	 * @param ReportInterval Minimum time in seconds between two reports
+	 * @param OnProgress Delegate broadcasting the percentage. Only called when the percentage grows
+	 * @param OnDetailedProgress Delegate broadcasting the detailed progress
+	 */
+	FRuntimeArchiverProgressReporter(int64 TotalBytes, float ReportInterval, const FRuntimeArchiverAsyncOperationProgress& OnProgress, const FRuntimeArchiverAsyncOperationDetailedProgress& OnDetailedProgress);
+
+	/**
+	 * Add processed bytes and report the progress if the report interval has elapsed. Thread-safe
+	 *
+	 * @param NumOfBytes Number of uncompressed bytes processed since the previous call
+	 */
+	void AddProcessedBytes(int64 NumOfBytes);
+
+	/**
+	 * Report the completion of the operation, regardless of the report interval
+	 */
+	void Finish();
+
+private:
+	/**
+	 * Compute the throughput and the remaining time, and dispatch the progress to the game thread
+	 */
+	void Report(int64 CurrentProcessedBytes, double CurrentTime, bool bFinished);
+
+	/** Total number of uncompressed bytes to process */
+	const int64 TotalBytes;
+
+	/** Minimum time in seconds between two reports */
+	const double ReportInterval;
+
+	/** Delegate broadcasting the percentage */
+	FRuntimeArchiverAsyncOperationProgress OnProgress;
+
+	/** Delegate broadcasting the detailed progress */
+	FRuntimeArchiverAsyncOperationDetailedProgress OnDetailedProgress;
+
+	/** Number of uncompressed bytes processed so far */
+	std::atomic<int64> ProcessedBytes;
+
+	/** Time before which no report is made. Claimed by the thread making the next report */
+	std::atomic<double> NextReportTime;
+
+	/** Guards the state below, in case a report is still being made when the next one is due */
+	FCriticalSection ReportCriticalSection;
+
+	/** Time the operation started at */
+	double StartTime;
+
+	/** Time and number of processed bytes of the last report */
+	double LastReportTime;
+	int64 LastReportedBytes;
+
+	/** Smoothed throughput in bytes per second. Negative until the first measurement */
+	double BytesPerSecond;
+
+	/** Last percentage broadcast to OnProgress */
+	int32 LastReportedPercentage;
+};
+
+/**
+ * Forwards the percentage of an operation measured from any thread, only when it grows, so it is reported at most once per percent
+ * Used by archive tests, whose amount of work is not always known in bytes up front
+ */
+class FRuntimeArchiverPercentageReporter
+{
+public:
+	/**
+	 * @param OnProgress Called with the percentage of the operation completed. Must outlive the reporter
+	 */
+	explicit FRuntimeArchiverPercentageReporter(TFunctionRef<void(int32)> OnProgress);
+
+	/**
+	 * Report the percentage if it grew since the last report. Thread-safe
+	 */
+	void ReportPercentage(int32 Percentage);
+
+	/**
+	 * Report the percentage of the processed amount out of the total amount if it grew since the last report. Thread-safe
+	 */
+	void ReportProcessed(int64 Processed, int64 Total);
+
+	/**
+	 * Report the completion of the operation, unless it has already been reported
+	 */
+	void Finish();
+
+private:
+	/** Called with the percentage of the operation completed */
+	TFunctionRef<void(int32)> OnProgress;
+
+	/** Last reported percentage */
+	std::atomic<int32> LastReportedPercentage;
+};
@@ -0,0 +1,213 @@
+﻿// Georgy Treshchev 2024.
+
+#include "RuntimeArchiverThreadPool.h"
+#include "RuntimeArchiverDefines.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/Event.h"
+#include <atomic>
+
+#if PLATFORM_LINUX || PLATFORM_ANDROID
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <Windows.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+namespace
+{
+	TAutoConsoleVariable<int32> CVarNumWorkerThreads(
+		TEXT("RuntimeArchiver.NumWorkerThreads"),
+		0,
+		TEXT("Number of threads running asynchronous archiver operations and parallel extraction. 0 uses the number of logical cores minus one. Applied when the archiver thread pool is created, i.e. on the first operation"),
+		ECVF_Default);
+
+	TAutoConsoleVariable<bool> CVarLowIOPriority(
+		TEXT("RuntimeArchiver.LowIOPriority"),
+		true,
+		TEXT("Whether the archiver threads use a low I/O priority, so that other file accesses of the application are served first. Applied when a thread runs its first operation"),
+		ECVF_Default);
+
+	/** Stack size of the pool threads. Decompressors keep sizeable state on the stack */
+	constexpr uint32 ThreadStackSize = 512 * 1024;
+
+	FCriticalSection ThreadPoolCriticalSection;
+	FQueuedThreadPool* ThreadPool = nullptr;
+
+	/**
+	 * Lower the I/O priority of the calling thread. Only done once per thread
+	 */
+	void ApplyLowIOPriority()
+	{
+		static thread_local bool bApplied = false;
+
+		if (bApplied || !CVarLowIOPriority.GetValueOnAnyThread())
+		{
+			return;
+		}
+
+		bApplied = true;
+
+#if PLATFORM_LINUX || PLATFORM_ANDROID
+		// Lowest level of the best-effort class rather than the idle class, which may not be served at all while other processes use the disk
+		constexpr int32 IOPriorityWhoProcess = 1;
+		constexpr int32 IOPriorityClassBestEffort = 2;
+		constexpr int32 IOPriorityClassShift = 13;
+		constexpr int32 IOPriorityLowestLevel = 7;
+
+		// The process identifier 0 refers to the calling thread
+		if (syscall(SYS_ioprio_set, IOPriorityWhoProcess, 0, (IOPriorityClassBestEffort << IOPriorityClassShift) | IOPriorityLowestLevel) != 0)
+		{
+			UE_LOG(LogRuntimeArchiver, Warning, TEXT("Unable to lower the I/O priority of the archiver thread"));
+		}
+#elif PLATFORM_WINDOWS
+		// Background mode lowers the I/O and memory priorities of the thread
+		if (!SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN))
+		{
+			UE_LOG(LogRuntimeArchiver, Warning, TEXT("Unable to lower the I/O priority of the archiver thread"));
+		}
+#endif
+	}
+
+	/**
+	 * Get the archiver thread pool, creating it if needed
+	 */
+	FQueuedThreadPool* GetThreadPool()
+	{
+		FScopeLock Lock(&ThreadPoolCriticalSection);
+
+		if (!ThreadPool)
+		{
+			// Parallel extraction is sized to the pool, so by default it spans every core except the one left to the rest of the application
+			const int32 ConfiguredNumOfThreads = CVarNumWorkerThreads.GetValueOnAnyThread();
+			const int32 NumOfThreads = ConfiguredNumOfThreads > 0 ? ConfiguredNumOfThreads : FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 1, 1);
+
+			FQueuedThreadPool* NewThreadPool = FQueuedThreadPool::Allocate();
+			if (!NewThreadPool->Create(NumOfThreads, ThreadStackSize, TPri_BelowNormal, TEXT("RuntimeArchiverThreadPool")))
+			{
+				UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to create the archiver thread pool with %d threads"), NumOfThreads);
+				delete NewThreadPool;
+				return nullptr;
+			}
+
+			ThreadPool = NewThreadPool;
+
+			UE_LOG(LogRuntimeArchiver, Log, TEXT("Created the archiver thread pool with %d threads"), NumOfThreads);
+		}
+
+		return ThreadPool;
+	}
+
+	/**
+	 * State of a parallel loop, shared between the calling thread and the pool tasks helping it
+	 * A pool task may start only after the loop is over, so the state is reference counted and the body is only called for indices taken while the caller still waits
+	 */
+	struct FParallelForState
+	{
+		FParallelForState(int32 InNum, TFunctionRef<void(int32)> InBody)
+			: Num(InNum)
+		  , Body(InBody)
+		  , NextIndex(0)
+		  , NumOfCompleted(0)
+		  , CompletedEvent(FPlatformProcess::GetSynchEventFromPool(true))
+		{
+		}
+
+		~FParallelForState()
+		{
+			FPlatformProcess::ReturnSynchEventToPool(CompletedEvent);
+		}
+
+		/**
+		 * Run the iterations until none are left
+		 */
+		void Run()
+		{
+			for (int32 Index = NextIndex++; Index < Num; Index = NextIndex++)
+			{
+				Body(Index);
+
+				if (++NumOfCompleted == Num)
+				{
+					CompletedEvent->Trigger();
+				}
+			}
+		}
+
+		const int32 Num;
+		TFunctionRef<void(int32)> Body;
+		std::atomic<int32> NextIndex;
+		std::atomic<int32> NumOfCompleted;
+		FEvent* CompletedEvent;
+	};
+}
+
+void RuntimeArchiverThreadPool::Launch(TUniqueFunction<void()> Task)
+{
+	FQueuedThreadPool* Pool = FPlatformProcess::SupportsMultithreading() ? GetThreadPool() : nullptr;
+
+	if (!Pool)
+	{
+		AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, MoveTemp(Task));
+		return;
+	}
+
+	AsyncPool(*Pool, [Task = MoveTemp(Task)]()
+	{
+		ApplyLowIOPriority();
+		Task();
+	});
+}
+
+void RuntimeArchiverThreadPool::ParallelFor(int32 Num, TFunctionRef<void(int32)> Body)
+{
+	FQueuedThreadPool* Pool = Num > 1 && FPlatformProcess::SupportsMultithreading() ? GetThreadPool() : nullptr;
+
+	if (!Pool)
+	{
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			Body(Index);
+		}
+		return;
+	}
+
+	const TSharedRef<FParallelForState, ESPMode::ThreadSafe> State = MakeShared<FParallelForState, ESPMode::ThreadSafe>(Num, Body);
+
+	for (int32 HelperIndex = 0, NumOfHelpers = FMath::Min(Num - 1, Pool->GetNumThreads()); HelperIndex < NumOfHelpers; ++HelperIndex)
+	{
+		AsyncPool(*Pool, [State]()
+		{
+			ApplyLowIOPriority();
+			State->Run();
+		});
+	}
+
+	State->Run();
+
+	// Only the iterations already taken by the pool threads are waited for, the helpers that have not started yet find nothing left to run
+	State->CompletedEvent->Wait();
+}
+
+int32 RuntimeArchiverThreadPool::GetNumOfThreads()
+{
+	FQueuedThreadPool* Pool = FPlatformProcess::SupportsMultithreading() ? GetThreadPool() : nullptr;
+	return Pool ? Pool->GetNumThreads() : 1;
+}
+
+void RuntimeArchiverThreadPool::Shutdown()
+{
+	FScopeLock Lock(&ThreadPoolCriticalSection);
+
+	if (ThreadPool)
+	{
+		ThreadPool->Destroy();
+		delete ThreadPool;
+		ThreadPool = nullptr;
+	}
+}
\ No newline at end of file
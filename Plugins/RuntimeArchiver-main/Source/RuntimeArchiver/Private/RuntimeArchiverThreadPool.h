@@ -0,0 +1,43 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+
+/**
+ * Dedicated thread pool running asynchronous archiver operations
+ * The operations block on file I/O for a long time, so they are kept off the task graph workers, which other background work (e.g. texture decoding) relies on
+ * The pool threads run with a below normal priority and, where supported, a low I/O priority. Configured with the RuntimeArchiver.* console variables
+ */
+namespace RuntimeArchiverThreadPool
+{
+	/**
+	 * Run the task on the archiver thread pool. The pool is created on first use
+	 * If multithreading is not supported or the pool cannot be created, the task runs on the task graph instead
+	 *
+	 * @param Task Task to run
+	 */
+	void Launch(TUniqueFunction<void()> Task);
+
+	/**
+	 * Run the body for each index from 0 to Num - 1 on the archiver thread pool and wait for all of them to complete
+	 * The calling thread runs iterations as well, so that the loop completes even if it is called from a busy pool thread
+	 *
+	 * @param Num Number of iterations
+	 * @param Body Body to run for each index. May be called from several threads at once
+	 */
+	void ParallelFor(int32 Num, TFunctionRef<void(int32)> Body);
+
+	/**
+	 * Get the number of threads of the archiver thread pool, creating it if needed. Used to size the parallel work
+	 *
+	 * @return The number of pool threads, or 1 if the pool is not available
+	 */
+	int32 GetNumOfThreads();
+
+	/**
+	 * Wait for the running tasks and destroy the pool. Called when the module is shut down
+	 */
+	void Shutdown();
+}
@@ -1,6 +1,123 @@
 ﻿// Georgy Treshchev 2024.
 
 #include "RuntimeArchiverUtilities.h"
+#include "RuntimeArchiverDefines.h"
+#include "RuntimeArchiverThreadPool.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <atomic>
+
+#if PLATFORM_LINUX || PLATFORM_ANDROID || PLATFORM_MAC
+#define RUNTIMEARCHIVER_POSIX_SYNC 1
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#else
+#define RUNTIMEARCHIVER_POSIX_SYNC 0
+#endif
+
+namespace
+{
+	/** Number of files from which syncing the whole file system is cheaper than syncing the files one by one */
+	constexpr int32 MinNumOfFilesToSyncFileSystem = 256;
+
+	/**
+	 * Flush the data of a file, or the entries of a directory, to the storage device
+	 */
+	bool SyncPath(const FString& Path, bool bIsDirectory)
+	{
+#if RUNTIMEARCHIVER_POSIX_SYNC
+		const int32 FileDescriptor = open(TCHAR_TO_UTF8(*Path), O_RDONLY | O_CLOEXEC | (bIsDirectory ? O_DIRECTORY : 0));
+		if (FileDescriptor < 0)
+		{
+			return false;
+		}
+
+#if PLATFORM_MAC
+		const bool bSynced = fsync(FileDescriptor) == 0;
+#else
+		// Directory entries are metadata, which fdatasync does not flush
+		const bool bSynced = (bIsDirectory ? fsync(FileDescriptor) : fdatasync(FileDescriptor)) == 0;
+#endif
+
+		close(FileDescriptor);
+		return bSynced;
+#else
+		// Directory entries are recorded in the file system journal on other platforms
+		if (bIsDirectory)
+		{
+			return true;
+		}
+
+		TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Path, true, true));
+		return FileHandle.IsValid() && FileHandle->Flush(true);
+#endif
+	}
+
+	/**
+	 * Sync the paths in parallel. Syncing is bound by the storage device, which handles many requests at once better than one after another
+	 */
+	bool SyncPathsInParallel(const TArray<FString>& Paths, bool bAreDirectories)
+	{
+		std::atomic<bool> bFailed{false};
+
+		RuntimeArchiverThreadPool::ParallelFor(Paths.Num(), [&Paths, bAreDirectories, &bFailed](int32 PathIndex)
+		{
+			if (!SyncPath(Paths[PathIndex], bAreDirectories))
+			{
+				UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to sync '%s' to storage"), *Paths[PathIndex]);
+				bFailed = true;
+			}
+		});
+
+		return !bFailed;
+	}
+
+#if PLATFORM_LINUX
+	/**
+	 * Sync every file system holding one of the directories with a single syncfs call each
+	 */
+	bool SyncFileSystems(const TArray<FString>& Directories)
+	{
+		TSet<uint64> SyncedDevices;
+
+		for (const FString& Directory : Directories)
+		{
+			struct stat DirectoryStat;
+			if (stat(TCHAR_TO_UTF8(*Directory), &DirectoryStat) != 0)
+			{
+				return false;
+			}
+
+			bool bAlreadySynced = false;
+			SyncedDevices.Add(static_cast<uint64>(DirectoryStat.st_dev), &bAlreadySynced);
+
+			if (bAlreadySynced)
+			{
+				continue;
+			}
+
+			const int32 FileDescriptor = open(TCHAR_TO_UTF8(*Directory), O_RDONLY | O_CLOEXEC | O_DIRECTORY);
+			if (FileDescriptor < 0)
+			{
+				return false;
+			}
+
+			const bool bSynced = syncfs(FileDescriptor) == 0;
+			close(FileDescriptor);
+
+			if (!bSynced)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+#endif
+}
 
 TArray<FString> URuntimeArchiverUtilities::ParseDirectories(const FString& FilePath)
 {
@@ -32,4 +149,107 @@ TArray<FString> URuntimeArchiverUtilities::ParseDirectories(const FString& FileP
 	}
 
 	return MoveTemp(Directories);
+}
+
+bool URuntimeArchiverUtilities::SyncFilesToStorage(const FString& RootDirectory, const TArray<FString>& FilePaths)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	FString NormalizedRootDirectory = RootDirectory;
+	FPaths::NormalizeDirectoryName(NormalizedRootDirectory);
+
+	TArray<FString> Files;
+	Files.Reserve(FilePaths.Num());
+
+	// The root directory may have been created along with the files, in which case its own entry is in the parent directory
+	TSet<FString> Directories;
+	Directories.Add(NormalizedRootDirectory);
+
+	const FString ParentDirectory = FPaths::GetPath(NormalizedRootDirectory);
+	if (!ParentDirectory.IsEmpty())
+	{
+		Directories.Add(ParentDirectory);
+	}
+
+	for (const FString& FilePath : FilePaths)
+	{
+		FString Path = FilePath;
+		FPaths::NormalizeDirectoryName(Path);
+		FPaths::RemoveDuplicateSlashes(Path);
+
+		FString Directory;
+		if (PlatformFile.DirectoryExists(*Path))
+		{
+			Directory = MoveTemp(Path);
+		}
+		else
+		{
+			Directory = FPaths::GetPath(Path);
+			Files.Add(MoveTemp(Path));
+		}
+
+		// Each new directory is an entry of its parent, so every directory on the way to the root has to be synced
+		while (Directory.Len() > NormalizedRootDirectory.Len() && !Directories.Contains(Directory))
+		{
+			FString NextDirectory = FPaths::GetPath(Directory);
+			Directories.Add(MoveTemp(Directory));
+			Directory = MoveTemp(NextDirectory);
+		}
+	}
+
+	const TArray<FString> DirectoriesToSync = Directories.Array();
+
+#if PLATFORM_LINUX
+	if (Files.Num() >= MinNumOfFilesToSyncFileSystem)
+	{
+		if (SyncFileSystems(DirectoriesToSync))
+		{
+			UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully synced %d files to storage by syncing their file systems"), Files.Num());
+			return true;
+		}
+
+		UE_LOG(LogRuntimeArchiver, Warning, TEXT("Unable to sync the file systems under '%s', syncing the files one by one instead"), *NormalizedRootDirectory);
+	}
+#endif
+
+	// The directories are synced last, so that their entries point to files whose data is already on the storage device
+	if (!SyncPathsInParallel(Files, false) || !SyncPathsInParallel(DirectoriesToSync, true))
+	{
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully synced %d files and %d directories to storage"), Files.Num(), DirectoriesToSync.Num());
+
+	return true;
+}
+
+bool URuntimeArchiverUtilities::SaveStringToFileAtomically(const FString& FilePath, const FString& Content)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString TempFilePath = FilePath + TEXT(".tmp");
+
+	if (!FFileHelper::SaveStringToFile(Content, *TempFilePath) || !SyncPath(TempFilePath, false))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to write temporary file '%s'"), *TempFilePath);
+		PlatformFile.DeleteFile(*TempFilePath);
+		return false;
+	}
+
+#if RUNTIMEARCHIVER_POSIX_SYNC
+	// Renaming replaces an existing file atomically
+	const bool bRenamed = rename(TCHAR_TO_UTF8(*TempFilePath), TCHAR_TO_UTF8(*FilePath)) == 0;
+#else
+	// Moving does not replace an existing file on every platform
+	PlatformFile.DeleteFile(*FilePath);
+	const bool bRenamed = PlatformFile.MoveFile(*FilePath, *TempFilePath);
+#endif
+
+	if (!bRenamed)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to rename temporary file '%s' to '%s'"), *TempFilePath, *FilePath);
+		PlatformFile.DeleteFile(*TempFilePath);
+		return false;
+	}
+
+	return SyncPath(FPaths::GetPath(FilePath), true);
 }
\ No newline at end of file
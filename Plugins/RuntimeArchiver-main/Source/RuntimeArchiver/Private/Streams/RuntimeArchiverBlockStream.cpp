@@ -0,0 +1,629 @@
+﻿// Georgy Treshchev 2024.
+
+#include "Streams/RuntimeArchiverBlockStream.h"
+
+#include "RuntimeArchiverDefines.h"
+#include "Streams/RuntimeArchiverLZ4Stream.h"
+#include "Streams/RuntimeArchiverOodleStream.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+namespace
+{
+	/** Size of the data decompressed ahead of the current position when querying the size, if some block sizes are not known yet */
+	constexpr int64 BlockStreamSizeLookahead = 64 * 1024;
+}
+
+FRuntimeArchiverBlockStream::FRuntimeArchiverBlockStream(FRuntimeArchiverBaseStream& InCompressedStream, bool bWrite, int64 InBlockSize, int32 MaxWorkers)
+	: FRuntimeArchiverBaseStream(bWrite)
+  , CompressedStream(InCompressedStream)
+  , CompressedSize(!bWrite && InCompressedStream.IsValid() ? InCompressedStream.Size() : 0)
+  , CompressedPosition(bWrite && InCompressedStream.IsValid() ? InCompressedStream.Tell() : 0)
+  , BlockSize(InBlockSize)
+  , CompressionLevel(ERuntimeArchiverCompressionLevel::Compression6)
+  , MaxBlockUncompressedSize(0)
+  , bBlockChecksums(false)
+  , NumOfWorkers(FMath::Max(MaxWorkers > 0 ? MaxWorkers : FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1))
+  , BufferNum(0)
+  , WindowFirstBlock(0)
+  , WindowNumOfBlocks(0)
+  , WindowStart(0)
+  , UncompressedSize(0)
+  , NumOfSizedBlocks(0)
+  , bFinished(false)
+  , bFailed(false)
+{
+}
+
+FRuntimeArchiverBlockStream::~FRuntimeArchiverBlockStream()
+{
+	if (bWrite && !bFinished)
+	{
+		UE_LOG(LogRuntimeArchiver, Warning, TEXT("Block stream was destroyed before being finished, the compressed data is incomplete"));
+	}
+}
+
+void FRuntimeArchiverBlockStream::Initialize()
+{
+	if (!CompressedStream.IsValid())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to initialize block stream because the compressed stream is not valid"));
+		bFailed = true;
+		return;
+	}
+
+	Payloads.SetNum(NumOfWorkers);
+
+	if (bWrite)
+	{
+		Buffer.SetNumUninitialized(BlockSize * NumOfWorkers);
+		bFailed = !WriteStreamHeader();
+		return;
+	}
+
+	if (!ReadBlockTable(Blocks))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read the block table of the compressed data"));
+		bFailed = true;
+		return;
+	}
+
+	int64 MaxBlockSize = MaxBlockUncompressedSize;
+	for (int32 BlockIndex = 0; BlockIndex < Blocks.Num(); ++BlockIndex)
+	{
+		FRuntimeArchiverBlockInfo& Block = Blocks[BlockIndex];
+		MaxBlockSize = FMath::Max(MaxBlockSize, Block.UncompressedSize);
+
+		// The offsets are only known up to the first block whose size is not stored
+		if (Block.UncompressedSize >= 0 && NumOfSizedBlocks == BlockIndex)
+		{
+			Block.UncompressedOffset = UncompressedSize;
+			UncompressedSize += Block.UncompressedSize;
+			++NumOfSizedBlocks;
+		}
+	}
+
+	// One more block than processed at once, to keep the last block of the window when moving on
+	Buffer.SetNumUninitialized(MaxBlockSize * (NumOfWorkers + 1));
+
+	if (NumOfSizedBlocks == Blocks.Num())
+	{
+		UE_LOG(LogRuntimeArchiver, Log, TEXT("Block stream opened with %d blocks, %lld bytes compressed to %lld bytes"), Blocks.Num(), UncompressedSize, CompressedSize);
+	}
+	else
+	{
+		UE_LOG(LogRuntimeArchiver, Log, TEXT("Block stream opened with %d blocks compressed to %lld bytes, the sizes of %d blocks are known once they are decompressed"), Blocks.Num(), CompressedSize, Blocks.Num() - NumOfSizedBlocks);
+	}
+}
+
+bool FRuntimeArchiverBlockStream::IsValid() const
+{
+	return CompressedStream.IsValid() && !bFailed;
+}
+
+bool FRuntimeArchiverBlockStream::Read(void* Data, int64 Size)
+{
+	if (!IsValid() || bWrite)
+	{
+		return false;
+	}
+
+	if (Size < 0 || !DecompressBlocksUpTo(Position + Size) || Position + Size > UncompressedSize)
+	{
+		return false;
+	}
+
+	uint8* Destination = static_cast<uint8*>(Data);
+
+	while (Size > 0)
+	{
+		const int64 WindowEnd = WindowStart + BufferNum;
+
+		if (Position >= WindowStart && Position < WindowEnd)
+		{
+			const int64 NumToCopy = FMath::Min(Size, WindowEnd - Position);
+			FMemory::Memcpy(Destination, Buffer.GetData() + (Position - WindowStart), NumToCopy);
+
+			Destination += NumToCopy;
+			Size -= NumToCopy;
+			Position += NumToCopy;
+			continue;
+		}
+
+		if (!DecompressBatch(Position))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FRuntimeArchiverBlockStream::Write(const void* Data, int64 Size)
+{
+	ensureMsgf(bWrite, TEXT("Cannot write data to the stream because it is in read-only mode"));
+
+	if (!IsValid() || !bWrite || bFinished || Size < 0)
+	{
+		return false;
+	}
+
+	const uint8* Source = static_cast<const uint8*>(Data);
+
+	while (Size > 0)
+	{
+		const int64 NumToCopy = FMath::Min(Size, Buffer.Num() - BufferNum);
+		FMemory::Memcpy(Buffer.GetData() + BufferNum, Source, NumToCopy);
+
+		BufferNum += NumToCopy;
+		Source += NumToCopy;
+		Size -= NumToCopy;
+		Position += NumToCopy;
+
+		if (BufferNum == Buffer.Num() && !WritePendingBlocks(false))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FRuntimeArchiverBlockStream::Seek(int64 NewPosition)
+{
+	if (!IsValid() || NewPosition < 0)
+	{
+		return false;
+	}
+
+	// Written data is compressed as it comes, so it can only be appended
+	if (bWrite)
+	{
+		if (NewPosition != Position)
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to seek block stream from %lld to %lld because it is write-only"), Position, NewPosition);
+			return false;
+		}
+
+		return true;
+	}
+
+	Position = NewPosition;
+	return true;
+}
+
+int64 FRuntimeArchiverBlockStream::Size()
+{
+	if (!IsValid())
+	{
+		return -1;
+	}
+
+	if (bWrite)
+	{
+		return Position;
+	}
+
+	// Decompressing a bit ahead of the current position guarantees that the size is never behind it while some block sizes are not known yet
+	if (!DecompressBlocksUpTo(Position + BlockStreamSizeLookahead))
+	{
+		return -1;
+	}
+
+	return UncompressedSize;
+}
+
+bool FRuntimeArchiverBlockStream::IsSequential() const
+{
+	return !bWrite && NumOfSizedBlocks < Blocks.Num();
+}
+
+bool FRuntimeArchiverBlockStream::Finish()
+{
+	if (!bWrite || bFinished)
+	{
+		return IsValid();
+	}
+
+	bFinished = true;
+
+	if (!IsValid())
+	{
+		return false;
+	}
+
+	if (!WritePendingBlocks(true) || !WriteStreamFooter())
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to finish block stream"));
+		bFailed = true;
+		return false;
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Block stream finished with %d blocks, %lld bytes compressed to %lld bytes"), Blocks.Num(), UncompressedSize, CompressedPosition);
+	return true;
+}
+
+void FRuntimeArchiverBlockStream::SetCompressionLevel(ERuntimeArchiverCompressionLevel InCompressionLevel)
+{
+	if (bWrite && !bFinished && IsValid() && InCompressionLevel != CompressionLevel)
+	{
+		WritePendingBlocks(false);
+	}
+
+	CompressionLevel = InCompressionLevel;
+}
+
+bool FRuntimeArchiverBlockStream::Verify(int32& FirstCorruptedBlock)
+{
+	FirstCorruptedBlock = INDEX_NONE;
+
+	if (!IsValid() || bWrite)
+	{
+		return false;
+	}
+
+	TArray<TArray64<uint8>> BlockData;
+	BlockData.SetNum(NumOfWorkers);
+
+	TArray<bool> BlockResults;
+
+	// Blocks are checked in batches of the number of workers, so memory usage does not depend on the data size
+	for (int32 BatchStart = 0; BatchStart < Blocks.Num(); BatchStart += NumOfWorkers)
+	{
+		const int32 NumOfBlocks = FMath::Min(NumOfWorkers, Blocks.Num() - BatchStart);
+
+		for (int32 Index = 0; Index < NumOfBlocks; ++Index)
+		{
+			const FRuntimeArchiverBlockInfo& Block = Blocks[BatchStart + Index];
+			Payloads[Index].SetNumUninitialized(Block.CompressedSize);
+
+			if (!ReadCompressed(Block.CompressedOffset, Payloads[Index].GetData(), Block.CompressedSize))
+			{
+				UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read payload of block %d at offset %lld with size %lld"), BatchStart + Index, Block.CompressedOffset, Block.CompressedSize);
+				FirstCorruptedBlock = BatchStart + Index;
+				return false;
+			}
+		}
+
+		BlockResults.Init(true, NumOfBlocks);
+
+		ParallelFor(NumOfBlocks, [this, &BlockData, &BlockResults, BatchStart](int32 Index)
+		{
+			const FRuntimeArchiverBlockInfo& Block = Blocks[BatchStart + Index];
+
+			if (!Block.bCompressed)
+			{
+				BlockResults[Index] = IsBlockDataValid(Block, Payloads[Index].GetData(), Block.CompressedSize);
+				return;
+			}
+
+			int64 DecompressedSize = 0;
+			BlockData[Index].SetNumUninitialized(Block.UncompressedSize >= 0 ? Block.UncompressedSize : MaxBlockUncompressedSize);
+			BlockResults[Index] = DecompressBlock(Block, Payloads[Index].GetData(), BlockData[Index].GetData(), DecompressedSize)
+				&& (Block.UncompressedSize < 0 || DecompressedSize == Block.UncompressedSize)
+				&& IsBlockDataValid(Block, BlockData[Index].GetData(), DecompressedSize);
+		});
+
+		const int32 FailedIndex = BlockResults.Find(false);
+		if (FailedIndex != INDEX_NONE)
+		{
+			FirstCorruptedBlock = BatchStart + FailedIndex;
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Block %d at compressed offset %lld is corrupted"), FirstCorruptedBlock, Blocks[FirstCorruptedBlock].CompressedOffset);
+			return false;
+		}
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("Successfully verified %d blocks"), Blocks.Num());
+	return true;
+}
+
+FRuntimeArchiverBlockStream* FRuntimeArchiverBlockStream::Create(ERuntimeArchiverRawFormat Format, FRuntimeArchiverBaseStream& CompressedStream, bool bWrite, int32 MaxWorkers)
+{
+	switch (Format)
+	{
+	case ERuntimeArchiverRawFormat::LZ4:
+		return new FRuntimeArchiverLZ4Stream(CompressedStream, bWrite, MaxWorkers);
+	case ERuntimeArchiverRawFormat::Oodle:
+#if UE_VERSION_NEWER_THAN(5, 0, 0)
+		return new FRuntimeArchiverOodleStream(CompressedStream, bWrite, MaxWorkers);
+#else
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Oodle block streams are supported only in UE 5.0 and newer"));
+		return nullptr;
+#endif
+	default:
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to create block stream because the format %s is not split into blocks"), *UEnum::GetValueAsString(Format));
+		return nullptr;
+	}
+}
+
+bool FRuntimeArchiverBlockStream::IsBlockFormat(ERuntimeArchiverRawFormat Format, FRuntimeArchiverBaseStream& CompressedStream)
+{
+	switch (Format)
+	{
+	case ERuntimeArchiverRawFormat::LZ4:
+		return FRuntimeArchiverLZ4Stream::IsLZ4Frame(CompressedStream);
+#if UE_VERSION_NEWER_THAN(5, 0, 0)
+	case ERuntimeArchiverRawFormat::Oodle:
+		return FRuntimeArchiverOodleStream::IsOodleBlockFormat(CompressedStream);
+#endif
+	default:
+		return false;
+	}
+}
+
+bool FRuntimeArchiverBlockStream::WriteStreamHeader()
+{
+	ensureMsgf(false, TEXT("WriteStreamHeader cannot be called from runtime archiver block stream"));
+	return false;
+}
+
+bool FRuntimeArchiverBlockStream::WriteStreamFooter()
+{
+	ensureMsgf(false, TEXT("WriteStreamFooter cannot be called from runtime archiver block stream"));
+	return false;
+}
+
+bool FRuntimeArchiverBlockStream::WriteBlock(FRuntimeArchiverBlockInfo& Block, const uint8* Payload)
+{
+	ensureMsgf(false, TEXT("WriteBlock cannot be called from runtime archiver block stream"));
+	return false;
+}
+
+bool FRuntimeArchiverBlockStream::ReadBlockTable(TArray<FRuntimeArchiverBlockInfo>& OutBlocks)
+{
+	ensureMsgf(false, TEXT("ReadBlockTable cannot be called from runtime archiver block stream"));
+	return false;
+}
+
+bool FRuntimeArchiverBlockStream::CompressBlock(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData) const
+{
+	ensureMsgf(false, TEXT("CompressBlock cannot be called from runtime archiver block stream"));
+	return false;
+}
+
+bool FRuntimeArchiverBlockStream::DecompressBlock(const FRuntimeArchiverBlockInfo& Block, const uint8* Payload, uint8* Data, int64& DecompressedSize) const
+{
+	ensureMsgf(false, TEXT("DecompressBlock cannot be called from runtime archiver block stream"));
+	return false;
+}
+
+bool FRuntimeArchiverBlockStream::ReadCompressed(int64 Offset, void* Data, int64 Size)
+{
+	if (Offset < 0 || Size < 0 || Offset + Size > CompressedSize)
+	{
+		return false;
+	}
+
+	return CompressedStream.Seek(Offset) && CompressedStream.Read(Data, Size);
+}
+
+bool FRuntimeArchiverBlockStream::WriteCompressed(const void* Data, int64 Size)
+{
+	if (!CompressedStream.Seek(CompressedPosition) || !CompressedStream.Write(Data, Size))
+	{
+		return false;
+	}
+
+	CompressedPosition += Size;
+	return true;
+}
+
+uint32 FRuntimeArchiverBlockStream::ReadUInt32(const uint8* Data)
+{
+	return static_cast<uint32>(Data[0]) | (static_cast<uint32>(Data[1]) << 8) | (static_cast<uint32>(Data[2]) << 16) | (static_cast<uint32>(Data[3]) << 24);
+}
+
+uint64 FRuntimeArchiverBlockStream::ReadUInt64(const uint8* Data)
+{
+	return static_cast<uint64>(ReadUInt32(Data)) | (static_cast<uint64>(ReadUInt32(Data + 4)) << 32);
+}
+
+void FRuntimeArchiverBlockStream::WriteUInt32(uint8* Data, uint32 Value)
+{
+	for (int32 ByteIndex = 0; ByteIndex < 4; ++ByteIndex)
+	{
+		Data[ByteIndex] = static_cast<uint8>(Value >> (ByteIndex * 8));
+	}
+}
+
+void FRuntimeArchiverBlockStream::WriteUInt64(uint8* Data, uint64 Value)
+{
+	WriteUInt32(Data, static_cast<uint32>(Value));
+	WriteUInt32(Data + 4, static_cast<uint32>(Value >> 32));
+}
+
+bool FRuntimeArchiverBlockStream::WritePendingBlocks(bool bFinal)
+{
+	const int32 NumOfBlocks = static_cast<int32>(bFinal ? FMath::DivideAndRoundUp(BufferNum, BlockSize) : BufferNum / BlockSize);
+	if (NumOfBlocks == 0)
+	{
+		return true;
+	}
+
+	std::atomic<bool> bCompressionFailed{false};
+
+	TArray<uint32> Checksums;
+	Checksums.SetNumZeroed(NumOfBlocks);
+
+	const bool bStoreBlocks = CompressionLevel == ERuntimeArchiverCompressionLevel::Compression0;
+
+	ParallelFor(NumOfBlocks, [this, &bCompressionFailed, &Checksums, bStoreBlocks](int32 BlockIndex)
+	{
+		const int64 Offset = BlockIndex * BlockSize;
+		const int64 Size = FMath::Min(BlockSize, BufferNum - Offset);
+
+		if (bStoreBlocks)
+		{
+			Payloads[BlockIndex].Reset();
+		}
+		else if (!CompressBlock(Buffer.GetData() + Offset, Size, Payloads[BlockIndex]))
+		{
+			bCompressionFailed = true;
+		}
+
+		if (bBlockChecksums)
+		{
+			Checksums[BlockIndex] = FCrc::MemCrc32(Buffer.GetData() + Offset, static_cast<int32>(Size));
+		}
+	});
+
+	if (bCompressionFailed)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to compress block data"));
+		bFailed = true;
+		return false;
+	}
+
+	// Blocks are written in order, storing the data as is if compression does not make it smaller
+	for (int32 BlockIndex = 0; BlockIndex < NumOfBlocks; ++BlockIndex)
+	{
+		const int64 Offset = BlockIndex * BlockSize;
+		const int64 Size = FMath::Min(BlockSize, BufferNum - Offset);
+		const bool bCompressed = !bStoreBlocks && Payloads[BlockIndex].Num() < Size;
+
+		FRuntimeArchiverBlockInfo Block{0, bCompressed ? Payloads[BlockIndex].Num() : Size, UncompressedSize, Size, bCompressed, Checksums[BlockIndex]};
+		if (!WriteBlock(Block, bCompressed ? Payloads[BlockIndex].GetData() : Buffer.GetData() + Offset))
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to write block at uncompressed offset %lld"), UncompressedSize);
+			bFailed = true;
+			return false;
+		}
+
+		Blocks.Add(Block);
+		UncompressedSize += Size;
+		++NumOfSizedBlocks;
+	}
+
+	const int64 NumWritten = FMath::Min(NumOfBlocks * BlockSize, BufferNum);
+	FMemory::Memmove(Buffer.GetData(), Buffer.GetData() + NumWritten, BufferNum - NumWritten);
+	BufferNum -= NumWritten;
+
+	return true;
+}
+
+bool FRuntimeArchiverBlockStream::DecompressBatch(int64 Offset)
+{
+	// Offsets past the blocks with known sizes can only be reached by decompressing the following blocks in order
+	const bool bSizingBlocks = Offset >= UncompressedSize && NumOfSizedBlocks < Blocks.Num();
+
+	const int32 BlockIndex = bSizingBlocks ? NumOfSizedBlocks : Algo::UpperBoundBy(MakeArrayView(Blocks.GetData(), NumOfSizedBlocks), Offset, [](const FRuntimeArchiverBlockInfo& Block) { return Block.UncompressedOffset; }) - 1;
+	if (!Blocks.IsValidIndex(BlockIndex))
+	{
+		return false;
+	}
+
+	int32 FirstBlock = BlockIndex;
+	int64 KeptSize = 0;
+
+	// Keeping the last block of the window when moving on sequentially, so that going slightly back across the window boundary (such as re-reading a tar header) does not decompress the previous blocks again
+	if (WindowNumOfBlocks > 0 && BlockIndex == WindowFirstBlock + WindowNumOfBlocks)
+	{
+		const FRuntimeArchiverBlockInfo& LastBlock = Blocks[BlockIndex - 1];
+		FMemory::Memmove(Buffer.GetData(), Buffer.GetData() + (LastBlock.UncompressedOffset - WindowStart), LastBlock.UncompressedSize);
+
+		FirstBlock = BlockIndex - 1;
+		KeptSize = LastBlock.UncompressedSize;
+	}
+
+	WindowNumOfBlocks = 0;
+	BufferNum = 0;
+
+	const int32 NumOfBlocks = FMath::Min(NumOfWorkers, (bSizingBlocks ? Blocks.Num() : NumOfSizedBlocks) - BlockIndex);
+
+	// The payloads are stored one after another, so they are read sequentially before decompressing them in parallel
+	for (int32 Index = 0; Index < NumOfBlocks; ++Index)
+	{
+		const FRuntimeArchiverBlockInfo& Block = Blocks[BlockIndex + Index];
+		Payloads[Index].SetNumUninitialized(Block.CompressedSize);
+
+		if (!ReadCompressed(Block.CompressedOffset, Payloads[Index].GetData(), Block.CompressedSize))
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read block payload at offset %lld with size %lld"), Block.CompressedOffset, Block.CompressedSize);
+			bFailed = true;
+			return false;
+		}
+	}
+
+	std::atomic<bool> bDecompressionFailed{false};
+	uint8* BatchData = Buffer.GetData() + KeptSize;
+	const int64 BatchStart = bSizingBlocks ? UncompressedSize : Blocks[BlockIndex].UncompressedOffset;
+	const int64 SlotSize = (Buffer.Num() - KeptSize) / NumOfWorkers;
+
+	TArray<int64> DecompressedSizes;
+	DecompressedSizes.SetNumZeroed(NumOfBlocks);
+
+	ParallelFor(NumOfBlocks, [this, &bDecompressionFailed, &DecompressedSizes, BatchData, BatchStart, BlockIndex, SlotSize, bSizingBlocks](int32 Index)
+	{
+		const FRuntimeArchiverBlockInfo& Block = Blocks[BlockIndex + Index];
+
+		// Blocks with unknown sizes are decompressed into slots of the maximum block size and moved into place afterwards
+		uint8* Data = bSizingBlocks ? BatchData + Index * SlotSize : BatchData + (Block.UncompressedOffset - BatchStart);
+
+		if (!Block.bCompressed)
+		{
+			FMemory::Memcpy(Data, Payloads[Index].GetData(), Block.CompressedSize);
+			DecompressedSizes[Index] = Block.CompressedSize;
+		}
+		else if (!DecompressBlock(Block, Payloads[Index].GetData(), Data, DecompressedSizes[Index]))
+		{
+			bDecompressionFailed = true;
+			return;
+		}
+
+		if ((Block.UncompressedSize >= 0 && DecompressedSizes[Index] != Block.UncompressedSize) || !IsBlockDataValid(Block, Data, DecompressedSizes[Index]))
+		{
+			bDecompressionFailed = true;
+		}
+	});
+
+	if (bDecompressionFailed)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to decompress blocks starting at uncompressed offset %lld, the data is probably corrupted"), BatchStart);
+		bFailed = true;
+		return false;
+	}
+
+	if (bSizingBlocks)
+	{
+		// Each block ends before the slot of the next one starts, so moving them one after another does not overwrite anything not yet moved
+		for (int32 Index = 0; Index < NumOfBlocks; ++Index)
+		{
+			FRuntimeArchiverBlockInfo& Block = Blocks[BlockIndex + Index];
+			Block.UncompressedOffset = UncompressedSize;
+			Block.UncompressedSize = DecompressedSizes[Index];
+
+			FMemory::Memmove(BatchData + (Block.UncompressedOffset - BatchStart), BatchData + Index * SlotSize, Block.UncompressedSize);
+
+			UncompressedSize += Block.UncompressedSize;
+			++NumOfSizedBlocks;
+		}
+	}
+
+	const FRuntimeArchiverBlockInfo& LastBlock = Blocks[BlockIndex + NumOfBlocks - 1];
+
+	WindowFirstBlock = FirstBlock;
+	WindowNumOfBlocks = BlockIndex + NumOfBlocks - FirstBlock;
+	WindowStart = Blocks[FirstBlock].UncompressedOffset;
+	BufferNum = LastBlock.UncompressedOffset + LastBlock.UncompressedSize - WindowStart;
+
+	return true;
+}
+
+bool FRuntimeArchiverBlockStream::DecompressBlocksUpTo(int64 Offset)
+{
+	while (UncompressedSize < Offset && NumOfSizedBlocks < Blocks.Num())
+	{
+		if (!DecompressBatch(UncompressedSize))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FRuntimeArchiverBlockStream::IsBlockDataValid(const FRuntimeArchiverBlockInfo& Block, const uint8* Data, int64 Size) const
+{
+	return !bBlockChecksums || FCrc::MemCrc32(Data, static_cast<int32>(Size)) == Block.Checksum;
+}
@@ -0,0 +1,355 @@
+﻿// Georgy Treshchev 2024.
+
+#include "Streams/RuntimeArchiverGZipStream.h"
+
+#include "RuntimeArchiverDefines.h"
+#include "ArchiverZip/RuntimeArchiverMinizDeclarations.h"
+
+namespace
+{
+	/** Size of the compressed data chunk read at once */
+	constexpr int64 GZipInputBufferSize = 256 * 1024;
+
+	/** Size of the window holding recently inflated data */
+	constexpr int64 GZipWindowSize = 1024 * 1024;
+
+	/** Size of the inflated data kept before the current position when the window is full, so that short backward seeks (such as re-reading a tar header) do not restart inflation */
+	constexpr int64 GZipWindowRetainSize = 64 * 1024;
+
+	/** Size of the data inflated ahead of the current position when querying the size */
+	constexpr int64 GZipSizeLookahead = 64 * 1024;
+
+	/** Size of the fixed part of the gzip member header */
+	constexpr int64 GZipMemberHeaderSize = 10;
+
+	/** Size of the gzip member trailer containing CRC-32 and the uncompressed size */
+	constexpr int64 GZipMemberTrailerSize = 8;
+
+	/** gzip member header flags as defined in RFC 1952 */
+	constexpr uint8 GZipFlagHeaderCrc = 0x02;
+	constexpr uint8 GZipFlagExtra = 0x04;
+	constexpr uint8 GZipFlagName = 0x08;
+	constexpr uint8 GZipFlagComment = 0x10;
+
+	uint32 ReadLittleEndianUInt32(const uint8* Data)
+	{
+		return static_cast<uint32>(Data[0]) | (static_cast<uint32>(Data[1]) << 8) | (static_cast<uint32>(Data[2]) << 16) | (static_cast<uint32>(Data[3]) << 24);
+	}
+}
+
+FRuntimeArchiverGZipStream::FRuntimeArchiverGZipStream(FRuntimeArchiverBaseStream& InCompressedStream)
+	: FRuntimeArchiverBaseStream(false)
+  , CompressedStream(InCompressedStream)
+  , CompressedSize(InCompressedStream.IsValid() ? InCompressedStream.Size() : 0)
+  , CompressedPosition(0)
+  , InflateStream(MakeUnique<mz_stream>())
+  , WindowStart(0)
+  , WindowNum(0)
+  , MemberCrc(MZ_CRC32_INIT)
+  , bFinished(false)
+  , bCorrupted(false)
+{
+	FMemory::Memzero(*InflateStream);
+	InputBuffer.SetNumUninitialized(GZipInputBufferSize);
+	Window.SetNumUninitialized(GZipWindowSize);
+
+	if (CompressedSize < GZipMemberHeaderSize + GZipMemberTrailerSize)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to open gzip inflate stream because compressed data is too small or not readable (%lld bytes)"), CompressedSize);
+		bCorrupted = true;
+	}
+	else
+	{
+		bCorrupted = !Restart();
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("GZip inflate stream opened over %lld compressed bytes. Validity: %s"),
+	       CompressedSize, FRuntimeArchiverGZipStream::IsValid() ? TEXT("true") : TEXT("false"));
+}
+
+FRuntimeArchiverGZipStream::~FRuntimeArchiverGZipStream()
+{
+	mz_inflateEnd(InflateStream.Get());
+}
+
+bool FRuntimeArchiverGZipStream::IsValid() const
+{
+	return CompressedStream.IsValid() && !bCorrupted;
+}
+
+bool FRuntimeArchiverGZipStream::Read(void* Data, int64 Size)
+{
+	if (!IsValid() || Size < 0)
+	{
+		return false;
+	}
+
+	// The data is no longer in the window, so it has to be inflated again
+	if (Position < WindowStart)
+	{
+		UE_LOG(LogRuntimeArchiver, Verbose, TEXT("Restarting gzip inflation to seek back from %lld to %lld"), WindowStart, Position);
+
+		if (!Restart())
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to restart gzip inflation to read at position %lld"), Position);
+			bCorrupted = true;
+			return false;
+		}
+	}
+
+	uint8* Destination = static_cast<uint8*>(Data);
+
+	while (Size > 0)
+	{
+		const int64 WindowEnd = WindowStart + WindowNum;
+
+		if (Position >= WindowStart && Position < WindowEnd)
+		{
+			const int64 NumToCopy = FMath::Min(Size, WindowEnd - Position);
+			FMemory::Memcpy(Destination, Window.GetData() + (Position - WindowStart), NumToCopy);
+
+			Destination += NumToCopy;
+			Size -= NumToCopy;
+			Position += NumToCopy;
+			continue;
+		}
+
+		if (bFinished)
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read gzip data at position %lld because the uncompressed size is %lld"), Position, WindowEnd);
+			return false;
+		}
+
+		if (!FillWindow(Position + 1))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FRuntimeArchiverGZipStream::Seek(int64 NewPosition)
+{
+	if (!IsValid() || NewPosition < 0)
+	{
+		return false;
+	}
+
+	// Seeking is deferred until the next read, since tar reading often seeks back and then forward again without reading in between
+	Position = NewPosition;
+	return true;
+}
+
+int64 FRuntimeArchiverGZipStream::Size()
+{
+	if (!IsValid())
+	{
+		return -1;
+	}
+
+	// Inflating a bit ahead of the current position guarantees that the returned size is never behind it
+	if (!FillWindow(Position + GZipSizeLookahead))
+	{
+		return -1;
+	}
+
+	// Concatenated gzip members only store their own sizes, so the total size is not known before everything is inflated. Until then this is the inflated size, which is enough for bounds checks near the current position
+	return WindowStart + WindowNum;
+}
+
+bool FRuntimeArchiverGZipStream::IsSequential() const
+{
+	return true;
+}
+
+float FRuntimeArchiverGZipStream::GetReadProgress()
+{
+	return CompressedSize > 0 ? static_cast<float>(static_cast<double>(CompressedPosition) / CompressedSize) : 1.f;
+}
+
+bool FRuntimeArchiverGZipStream::Restart()
+{
+	mz_inflateEnd(InflateStream.Get());
+	FMemory::Memzero(*InflateStream);
+
+	CompressedPosition = 0;
+	WindowStart = 0;
+	WindowNum = 0;
+	MemberCrc = MZ_CRC32_INIT;
+	bFinished = false;
+
+	if (!ReadMemberHeader())
+	{
+		return false;
+	}
+
+	return mz_inflateInit2(InflateStream.Get(), -MZ_DEFAULT_WINDOW_BITS) == MZ_OK;
+}
+
+bool FRuntimeArchiverGZipStream::ReadMemberHeader()
+{
+	uint8 Header[GZipMemberHeaderSize];
+	if (!ReadCompressed(Header, GZipMemberHeaderSize))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read gzip member header at offset %lld"), CompressedPosition);
+		return false;
+	}
+
+	// Magic number and the deflate compression method
+	if (Header[0] != 0x1F || Header[1] != 0x8B || Header[2] != 8)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to parse gzip member header at offset %lld because it has an invalid signature"), CompressedPosition - GZipMemberHeaderSize);
+		return false;
+	}
+
+	const uint8 Flags = Header[3];
+
+	if (Flags & GZipFlagExtra)
+	{
+		uint8 ExtraSize[2];
+		if (!ReadCompressed(ExtraSize, 2))
+		{
+			return false;
+		}
+
+		CompressedPosition += static_cast<int64>(ExtraSize[0]) | (static_cast<int64>(ExtraSize[1]) << 8);
+	}
+
+	// The file name and the comment are null-terminated strings
+	for (const uint8 StringFlag : {GZipFlagName, GZipFlagComment})
+	{
+		if (Flags & StringFlag)
+		{
+			uint8 Character;
+			do
+			{
+				if (!ReadCompressed(&Character, 1))
+				{
+					return false;
+				}
+			}
+			while (Character != 0);
+		}
+	}
+
+	if (Flags & GZipFlagHeaderCrc)
+	{
+		CompressedPosition += 2;
+	}
+
+	return CompressedPosition <= CompressedSize;
+}
+
+bool FRuntimeArchiverGZipStream::FillWindow(int64 TargetOffset)
+{
+	while (WindowStart + WindowNum < TargetOffset && !bFinished)
+	{
+		if (bCorrupted)
+		{
+			return false;
+		}
+
+		if (WindowNum == Window.Num())
+		{
+			// Drop the data before the current position, retaining a small part of it
+			const int64 WindowEnd = WindowStart + WindowNum;
+			const int64 KeepStart = FMath::Clamp(FMath::Min(Position, WindowEnd) - GZipWindowRetainSize, WindowStart, WindowEnd);
+			if (KeepStart == WindowStart)
+			{
+				// Nothing can be dropped without losing data at the current position
+				return true;
+			}
+
+			const int64 NumDropped = KeepStart - WindowStart;
+			FMemory::Memmove(Window.GetData(), Window.GetData() + NumDropped, WindowNum - NumDropped);
+			WindowStart = KeepStart;
+			WindowNum -= NumDropped;
+		}
+
+		if (InflateStream->avail_in == 0)
+		{
+			const int64 ChunkSize = FMath::Min(InputBuffer.Num(), CompressedSize - CompressedPosition);
+			if (ChunkSize <= 0 || !ReadCompressed(InputBuffer.GetData(), ChunkSize))
+			{
+				UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read gzip compressed data at offset %lld, the data is probably truncated"), CompressedPosition);
+				bCorrupted = true;
+				return false;
+			}
+
+			InflateStream->next_in = InputBuffer.GetData();
+			InflateStream->avail_in = static_cast<unsigned int>(ChunkSize);
+		}
+
+		uint8* OutputStart = Window.GetData() + WindowNum;
+		InflateStream->next_out = OutputStart;
+		InflateStream->avail_out = static_cast<unsigned int>(Window.Num() - WindowNum);
+
+		const int Status = mz_inflate(InflateStream.Get(), MZ_NO_FLUSH);
+
+		const int64 NumInflated = InflateStream->next_out - OutputStart;
+		MemberCrc = mz_crc32(MemberCrc, OutputStart, NumInflated);
+		WindowNum += NumInflated;
+
+		if (Status == MZ_STREAM_END)
+		{
+			// The trailer follows the deflate data right away
+			CompressedPosition -= InflateStream->avail_in;
+
+			uint8 Trailer[GZipMemberTrailerSize];
+			if (!ReadCompressed(Trailer, GZipMemberTrailerSize))
+			{
+				UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read gzip member trailer at offset %lld"), CompressedPosition);
+				bCorrupted = true;
+				return false;
+			}
+
+			if (ReadLittleEndianUInt32(Trailer) != MemberCrc)
+			{
+				UE_LOG(LogRuntimeArchiver, Error, TEXT("GZip member ending at offset %lld has an invalid checksum"), CompressedPosition);
+				bCorrupted = true;
+				return false;
+			}
+
+			mz_inflateEnd(InflateStream.Get());
+			FMemory::Memzero(*InflateStream);
+			MemberCrc = MZ_CRC32_INIT;
+
+			// Concatenated gzip members are read as a single stream
+			if (CompressedSize - CompressedPosition < GZipMemberHeaderSize + GZipMemberTrailerSize)
+			{
+				bFinished = true;
+			}
+			else if (!ReadMemberHeader() || mz_inflateInit2(InflateStream.Get(), -MZ_DEFAULT_WINDOW_BITS) != MZ_OK)
+			{
+				UE_LOG(LogRuntimeArchiver, Warning, TEXT("Ignoring trailing data after the last gzip member"));
+				bFinished = true;
+			}
+		}
+		else if (Status != MZ_OK && !(Status == MZ_BUF_ERROR && InflateStream->avail_in == 0))
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to inflate gzip data at offset %lld: %hs"), CompressedPosition, mz_error(Status));
+			bCorrupted = true;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FRuntimeArchiverGZipStream::ReadCompressed(void* Data, int64 Size)
+{
+	if (CompressedPosition + Size > CompressedSize)
+	{
+		return false;
+	}
+
+	// The compressed stream may be shared, so the position is always set explicitly
+	if (!CompressedStream.Seek(CompressedPosition) || !CompressedStream.Read(Data, Size))
+	{
+		return false;
+	}
+
+	CompressedPosition += Size;
+	return true;
+}
@@ -0,0 +1,462 @@
+﻿// Georgy Treshchev 2024.
+
+#include "Streams/RuntimeArchiverLZ4Stream.h"
+
+#include "RuntimeArchiverDefines.h"
+#include "Misc/Compression.h"
+#include "Misc/EngineVersionComparison.h"
+
+namespace
+{
+	/** Magic numbers as defined in the LZ4 frame format specification */
+	constexpr uint32 LZ4FrameMagic = 0x184D2204;
+	constexpr uint32 LZ4SkippableFrameMagic = 0x184D2A50;
+	constexpr uint32 LZ4SkippableFrameMagicMask = 0xFFFFFFF0;
+
+	/** Block maximum size identifier of the written frames (1 MB) */
+	constexpr int32 LZ4BlockSizeId = 6;
+	constexpr int64 LZ4BlockSize = static_cast<int64>(1) << (2 * LZ4BlockSizeId + 8);
+
+	/** Frame descriptor flags */
+	constexpr uint8 LZ4FlagVersion = 0x40;
+	constexpr uint8 LZ4FlagVersionMask = 0xC0;
+	constexpr uint8 LZ4FlagBlockIndependence = 0x20;
+	constexpr uint8 LZ4FlagBlockChecksum = 0x10;
+	constexpr uint8 LZ4FlagContentSize = 0x08;
+	constexpr uint8 LZ4FlagContentChecksum = 0x04;
+	constexpr uint8 LZ4FlagDictionaryId = 0x01;
+
+	/** Block size flag marking the block as stored uncompressed */
+	constexpr uint32 LZ4BlockUncompressedFlag = 0x80000000;
+
+	/** Size of the written frame header: magic number, flags, block descriptor, content size and header checksum */
+	constexpr int64 LZ4FrameHeaderSize = 4 + 1 + 1 + 8 + 1;
+
+	/**
+	 * Calculate the xxHash32 of the data, used for the frame header checksum
+	 */
+	uint32 XXHash32(const uint8* Data, int64 Size, uint32 Seed)
+	{
+		constexpr uint32 Prime1 = 2654435761U;
+		constexpr uint32 Prime2 = 2246822519U;
+		constexpr uint32 Prime3 = 3266489917U;
+		constexpr uint32 Prime4 = 668265263U;
+		constexpr uint32 Prime5 = 374761393U;
+
+		auto RotateLeft = [](uint32 Value, int32 Count) { return (Value << Count) | (Value >> (32 - Count)); };
+		auto ReadUInt32 = [](const uint8* Bytes) { return static_cast<uint32>(Bytes[0]) | (static_cast<uint32>(Bytes[1]) << 8) | (static_cast<uint32>(Bytes[2]) << 16) | (static_cast<uint32>(Bytes[3]) << 24); };
+		auto Round = [&RotateLeft](uint32 Accumulator, uint32 Input) { return RotateLeft(Accumulator + Input * Prime2, 13) * Prime1; };
+
+		const uint8* End = Data + Size;
+		uint32 Hash;
+
+		if (Size >= 16)
+		{
+			uint32 Accumulators[4] = {Seed + Prime1 + Prime2, Seed + Prime2, Seed, Seed - Prime1};
+			do
+			{
+				for (uint32& Accumulator : Accumulators)
+				{
+					Accumulator = Round(Accumulator, ReadUInt32(Data));
+					Data += 4;
+				}
+			}
+			while (Data + 16 <= End);
+
+			Hash = RotateLeft(Accumulators[0], 1) + RotateLeft(Accumulators[1], 7) + RotateLeft(Accumulators[2], 12) + RotateLeft(Accumulators[3], 18);
+		}
+		else
+		{
+			Hash = Seed + Prime5;
+		}
+
+		Hash += static_cast<uint32>(Size);
+
+		for (; Data + 4 <= End; Data += 4)
+		{
+			Hash = RotateLeft(Hash + ReadUInt32(Data) * Prime3, 17) * Prime4;
+		}
+
+		for (; Data < End; ++Data)
+		{
+			Hash = RotateLeft(Hash + *Data * Prime5, 11) * Prime1;
+		}
+
+		Hash ^= Hash >> 15;
+		Hash *= Prime2;
+		Hash ^= Hash >> 13;
+		Hash *= Prime3;
+		Hash ^= Hash >> 16;
+		return Hash;
+	}
+
+	/**
+	 * Get the uncompressed size of an LZ4 block by walking its sequences without decompressing it
+	 *
+	 * @return The uncompressed size, or -1 if the block is malformed
+	 */
+	int64 GetLZ4BlockUncompressedSize(const uint8* Data, int64 Size)
+	{
+		auto ReadLength = [Data, Size](int64& Position, int64& Length)
+		{
+			uint8 Byte;
+			do
+			{
+				if (Position >= Size)
+				{
+					return false;
+				}
+				Byte = Data[Position++];
+				Length += Byte;
+			}
+			while (Byte == 255);
+			return true;
+		};
+
+		int64 UncompressedSize = 0;
+		int64 Position = 0;
+
+		while (Position < Size)
+		{
+			const uint8 Token = Data[Position++];
+
+			int64 LiteralLength = Token >> 4;
+			if (LiteralLength == 15 && !ReadLength(Position, LiteralLength))
+			{
+				return -1;
+			}
+
+			Position += LiteralLength;
+			UncompressedSize += LiteralLength;
+
+			// The last sequence consists of literals only
+			if (Position >= Size)
+			{
+				return Position == Size ? UncompressedSize : -1;
+			}
+
+			// Skipping the match offset
+			Position += 2;
+
+			int64 MatchLength = Token & 15;
+			if (MatchLength == 15 && !ReadLength(Position, MatchLength))
+			{
+				return -1;
+			}
+
+			UncompressedSize += MatchLength + 4;
+		}
+
+		return -1;
+	}
+}
+
+FRuntimeArchiverLZ4Stream::FRuntimeArchiverLZ4Stream(FRuntimeArchiverBaseStream& InCompressedStream, bool bWrite, int32 MaxWorkers)
+	: FRuntimeArchiverBlockStream(InCompressedStream, bWrite, LZ4BlockSize, MaxWorkers)
+  , FrameHeaderOffset(0)
+{
+	Initialize();
+}
+
+FRuntimeArchiverLZ4Stream::~FRuntimeArchiverLZ4Stream()
+{
+	if (bWrite)
+	{
+		Finish();
+	}
+}
+
+bool FRuntimeArchiverLZ4Stream::IsLZ4Frame(FRuntimeArchiverBaseStream& Stream)
+{
+	uint8 MagicData[4];
+	if (!Stream.IsValid() || Stream.Size() < 4 || !Stream.Seek(0) || !Stream.Read(MagicData, 4))
+	{
+		return false;
+	}
+
+	const uint32 Magic = ReadUInt32(MagicData);
+	return Magic == LZ4FrameMagic || (Magic & LZ4SkippableFrameMagicMask) == LZ4SkippableFrameMagic;
+}
+
+bool FRuntimeArchiverLZ4Stream::WriteStreamHeader()
+{
+	// The content size is not known yet, so it is filled in once finished
+	FrameHeaderOffset = CompressedPosition;
+
+	uint8 Header[LZ4FrameHeaderSize];
+	MakeFrameHeader(Header, 0);
+	return WriteCompressed(Header, LZ4FrameHeaderSize);
+}
+
+bool FRuntimeArchiverLZ4Stream::WriteStreamFooter()
+{
+	const uint8 EndMark[4] = {0, 0, 0, 0};
+	if (!WriteCompressed(EndMark, sizeof(EndMark)))
+	{
+		return false;
+	}
+
+	const int64 EndPosition = CompressedPosition;
+
+	uint8 Header[LZ4FrameHeaderSize];
+	MakeFrameHeader(Header, UncompressedSize);
+
+	CompressedPosition = FrameHeaderOffset;
+	const bool bSuccess = WriteCompressed(Header, LZ4FrameHeaderSize);
+	CompressedPosition = EndPosition;
+
+	return bSuccess && CompressedStream.Seek(EndPosition);
+}
+
+bool FRuntimeArchiverLZ4Stream::WriteBlock(FRuntimeArchiverBlockInfo& Block, const uint8* Payload)
+{
+	uint8 BlockSizeData[4];
+	WriteUInt32(BlockSizeData, static_cast<uint32>(Block.CompressedSize) | (Block.bCompressed ? 0 : LZ4BlockUncompressedFlag));
+
+	if (!WriteCompressed(BlockSizeData, sizeof(BlockSizeData)))
+	{
+		return false;
+	}
+
+	Block.CompressedOffset = CompressedPosition;
+	return WriteCompressed(Payload, Block.CompressedSize);
+}
+
+bool FRuntimeArchiverLZ4Stream::ReadBlockTable(TArray<FRuntimeArchiverBlockInfo>& OutBlocks)
+{
+	int64 Offset = 0;
+
+	while (Offset + 4 <= CompressedSize)
+	{
+		uint8 MagicData[4];
+		if (!ReadCompressed(Offset, MagicData, sizeof(MagicData)))
+		{
+			return false;
+		}
+
+		const uint32 Magic = ReadUInt32(MagicData);
+
+		if ((Magic & LZ4SkippableFrameMagicMask) == LZ4SkippableFrameMagic)
+		{
+			uint8 FrameSizeData[4];
+			if (!ReadCompressed(Offset + 4, FrameSizeData, sizeof(FrameSizeData)))
+			{
+				return false;
+			}
+
+			Offset += 8 + ReadUInt32(FrameSizeData);
+			continue;
+		}
+
+		if (Magic != LZ4FrameMagic)
+		{
+			if (Offset == 0)
+			{
+				UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read LZ4 data because it does not start with an LZ4 frame"));
+				return false;
+			}
+
+			UE_LOG(LogRuntimeArchiver, Warning, TEXT("Ignoring trailing data after the last LZ4 frame at offset %lld"), Offset);
+			break;
+		}
+
+		if (!ReadFrame(Offset, OutBlocks))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FRuntimeArchiverLZ4Stream::ReadFrame(int64& Offset, TArray<FRuntimeArchiverBlockInfo>& OutBlocks)
+{
+	// Flags, block descriptor, optional content size and header checksum
+	uint8 Descriptor[1 + 1 + 8 + 1];
+	const int64 DescriptorOffset = Offset + 4;
+
+	if (!ReadCompressed(DescriptorOffset, Descriptor, 2))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read LZ4 frame descriptor at offset %lld"), DescriptorOffset);
+		return false;
+	}
+
+	const uint8 Flags = Descriptor[0];
+
+	if ((Flags & LZ4FlagVersionMask) != LZ4FlagVersion)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read LZ4 frame at offset %lld because its version is not supported"), Offset);
+		return false;
+	}
+
+	// Linked blocks reference the previous blocks and cannot be decompressed independently
+	if (!(Flags & LZ4FlagBlockIndependence) || (Flags & LZ4FlagDictionaryId))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read LZ4 frame at offset %lld because only frames with independent blocks and no dictionary are supported"), Offset);
+		return false;
+	}
+
+	const int32 BlockSizeId = (Descriptor[1] >> 4) & 7;
+	if (BlockSizeId < 4)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read LZ4 frame at offset %lld because its block size is invalid"), Offset);
+		return false;
+	}
+
+	const int64 MaxBlockSize = static_cast<int64>(1) << (2 * BlockSizeId + 8);
+	const bool bContentSize = (Flags & LZ4FlagContentSize) != 0;
+	const int64 DescriptorSize = 2 + (bContentSize ? 8 : 0);
+
+	if (!ReadCompressed(DescriptorOffset, Descriptor, DescriptorSize + 1))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read LZ4 frame descriptor at offset %lld"), DescriptorOffset);
+		return false;
+	}
+
+	if (static_cast<uint8>(XXHash32(Descriptor, DescriptorSize, 0) >> 8) != Descriptor[DescriptorSize])
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("LZ4 frame descriptor at offset %lld has an invalid checksum"), DescriptorOffset);
+		return false;
+	}
+
+	const int64 ContentSize = bContentSize ? static_cast<int64>(ReadUInt64(Descriptor + 2)) : 0;
+	const int64 BlockChecksumSize = (Flags & LZ4FlagBlockChecksum) ? 4 : 0;
+	const int32 FirstBlock = OutBlocks.Num();
+
+	Offset = DescriptorOffset + DescriptorSize + 1;
+
+	while (true)
+	{
+		uint8 BlockSizeData[4];
+		if (!ReadCompressed(Offset, BlockSizeData, sizeof(BlockSizeData)))
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read LZ4 block size at offset %lld, the data is probably truncated"), Offset);
+			return false;
+		}
+
+		Offset += sizeof(BlockSizeData);
+
+		const uint32 BlockSizeValue = ReadUInt32(BlockSizeData);
+		if (BlockSizeValue == 0)
+		{
+			break;
+		}
+
+		const bool bCompressed = !(BlockSizeValue & LZ4BlockUncompressedFlag);
+		const int64 PayloadSize = BlockSizeValue & ~LZ4BlockUncompressedFlag;
+
+		if (PayloadSize > MaxBlockSize || Offset + PayloadSize > CompressedSize)
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("LZ4 block at offset %lld has an invalid size %lld"), Offset, PayloadSize);
+			return false;
+		}
+
+		// The uncompressed size of compressed blocks is not stored, so it is only known once the block is decompressed
+		OutBlocks.Add({Offset, PayloadSize, 0, bCompressed ? -1 : PayloadSize, bCompressed});
+		Offset += PayloadSize + BlockChecksumSize;
+	}
+
+	if (Flags & LZ4FlagContentChecksum)
+	{
+		Offset += 4;
+	}
+
+	MaxBlockUncompressedSize = FMath::Max(MaxBlockUncompressedSize, MaxBlockSize);
+
+	if (!bContentSize || OutBlocks.Num() == FirstBlock)
+	{
+		return true;
+	}
+
+	// Compressed blocks other than the last one are usually full. That is only relied on if the content size confirms it, otherwise the sizes are left unknown
+	int64 KnownSize = 0;
+	int32 NumOfUnknownBlocks = 0;
+
+	for (int32 BlockIndex = FirstBlock; BlockIndex < OutBlocks.Num() - 1; ++BlockIndex)
+	{
+		const FRuntimeArchiverBlockInfo& Block = OutBlocks[BlockIndex];
+		if (Block.UncompressedSize >= 0)
+		{
+			KnownSize += Block.UncompressedSize;
+		}
+		else
+		{
+			++NumOfUnknownBlocks;
+		}
+	}
+
+	FRuntimeArchiverBlockInfo& LastBlock = OutBlocks.Last();
+	int64 LastBlockSize = LastBlock.UncompressedSize;
+
+	if (LastBlockSize < 0)
+	{
+		TArray64<uint8> Payload;
+		Payload.SetNumUninitialized(LastBlock.CompressedSize);
+
+		LastBlockSize = ReadCompressed(LastBlock.CompressedOffset, Payload.GetData(), Payload.Num()) ? GetLZ4BlockUncompressedSize(Payload.GetData(), Payload.Num()) : -1;
+		if (LastBlockSize <= 0 || LastBlockSize > MaxBlockSize)
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("LZ4 block at offset %lld is malformed"), LastBlock.CompressedOffset);
+			return false;
+		}
+	}
+
+	if (KnownSize + LastBlockSize + NumOfUnknownBlocks * MaxBlockSize != ContentSize)
+	{
+		return true;
+	}
+
+	LastBlock.UncompressedSize = LastBlockSize;
+
+	for (int32 BlockIndex = FirstBlock; BlockIndex < OutBlocks.Num() - 1; ++BlockIndex)
+	{
+		if (OutBlocks[BlockIndex].UncompressedSize < 0)
+		{
+			OutBlocks[BlockIndex].UncompressedSize = MaxBlockSize;
+		}
+	}
+
+	return true;
+}
+
+bool FRuntimeArchiverLZ4Stream::CompressBlock(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData) const
+{
+#if UE_VERSION_NEWER_THAN(5, 0, 0)
+	int32 NumOfCompressedBytes = static_cast<int32>(FCompression::GetMaximumCompressedSize(NAME_LZ4, Size));
+#else
+	int32 NumOfCompressedBytes = FCompression::CompressMemoryBound(NAME_LZ4, static_cast<int32>(Size));
+#endif
+
+	CompressedData.SetNumUninitialized(NumOfCompressedBytes);
+
+	if (!FCompression::CompressMemory(NAME_LZ4, CompressedData.GetData(), NumOfCompressedBytes, Data, static_cast<int32>(Size)))
+	{
+		return false;
+	}
+
+	CompressedData.SetNumUninitialized(NumOfCompressedBytes);
+	return true;
+}
+
+bool FRuntimeArchiverLZ4Stream::DecompressBlock(const FRuntimeArchiverBlockInfo& Block, const uint8* Payload, uint8* Data, int64& DecompressedSize) const
+{
+	// The block sizes are not stored or partly derived from the content size, so they are taken from the block data itself
+	DecompressedSize = GetLZ4BlockUncompressedSize(Payload, Block.CompressedSize);
+	if (DecompressedSize <= 0 || (Block.UncompressedSize >= 0 ? DecompressedSize != Block.UncompressedSize : DecompressedSize > MaxBlockUncompressedSize))
+	{
+		return false;
+	}
+
+	return FCompression::UncompressMemory(NAME_LZ4, Data, static_cast<int32>(DecompressedSize), Payload, static_cast<int32>(Block.CompressedSize));
+}
+
+void FRuntimeArchiverLZ4Stream::MakeFrameHeader(uint8* Header, uint64 ContentSize)
+{
+	WriteUInt32(Header, LZ4FrameMagic);
+	Header[4] = LZ4FlagVersion | LZ4FlagBlockIndependence | LZ4FlagContentSize;
+	Header[5] = static_cast<uint8>(LZ4BlockSizeId << 4);
+	WriteUInt64(Header + 6, ContentSize);
+
+	// The checksum covers the descriptor without the magic number
+	Header[14] = static_cast<uint8>(XXHash32(Header + 4, 10, 0) >> 8);
+}
@@ -0,0 +1,95 @@
+﻿// Georgy Treshchev 2024.
+
+#include "Streams/RuntimeArchiverMappedFileStream.h"
+
+#include "RuntimeArchiverDefines.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/EngineVersionComparison.h"
+
+FRuntimeArchiverMappedFileStream::FRuntimeArchiverMappedFileStream(const FString& ArchivePath)
+	: FRuntimeArchiverBaseStream(false)
+  , MappedData(nullptr)
+  , MappedSize(0)
+{
+	IPlatformFile& PlatformFile{FPlatformFileManager::Get().GetPlatformFile()};
+
+#if UE_VERSION_NEWER_THAN(5, 3, 0)
+	FOpenMappedResult OpenResult = PlatformFile.OpenMappedEx(*ArchivePath);
+	if (OpenResult.HasValue())
+	{
+		MappedFileHandle = OpenResult.StealValue();
+	}
+#else
+	MappedFileHandle.Reset(PlatformFile.OpenMapped(*ArchivePath));
+#endif
+
+	// Empty files cannot be mapped, and there is nothing to gain from mapping them anyway
+	if (MappedFileHandle.IsValid() && MappedFileHandle->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFileHandle->MapRegion(0, MappedFileHandle->GetFileSize()));
+		if (MappedRegion.IsValid())
+		{
+			MappedData = MappedRegion->GetMappedPtr();
+			MappedSize = MappedRegion->GetMappedSize();
+		}
+	}
+
+	UE_LOG(LogRuntimeArchiver, Log, TEXT("File mapped at '%s' with size %lld. Validity: %s"),
+	       *ArchivePath, MappedSize, FRuntimeArchiverMappedFileStream::IsValid() ? TEXT("true") : TEXT("false"));
+}
+
+FRuntimeArchiverMappedFileStream::~FRuntimeArchiverMappedFileStream()
+{
+	// The region has to be unmapped before the handle is closed
+	MappedRegion.Reset();
+	MappedFileHandle.Reset();
+}
+
+bool FRuntimeArchiverMappedFileStream::IsValid() const
+{
+	return MappedData != nullptr;
+}
+
+bool FRuntimeArchiverMappedFileStream::Read(void* Data, int64 Size)
+{
+	if (!IsValid() || Size < 0 || Position + Size > MappedSize)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(Data, MappedData + Position, Size);
+	Position += Size;
+	return true;
+}
+
+bool FRuntimeArchiverMappedFileStream::Seek(int64 NewPosition)
+{
+	if (!IsValid() || NewPosition < 0 || NewPosition > MappedSize)
+	{
+		return false;
+	}
+
+	Position = NewPosition;
+	return true;
+}
+
+int64 FRuntimeArchiverMappedFileStream::Size()
+{
+	if (!IsValid())
+	{
+		return -1;
+	}
+
+	return MappedSize;
+}
+
+const uint8* FRuntimeArchiverMappedFileStream::GetReadView(int64 Offset, int64 Size)
+{
+	if (!IsValid() || Offset < 0 || Size < 0 || Offset + Size > MappedSize)
+	{
+		return nullptr;
+	}
+
+	return MappedData + Offset;
+}
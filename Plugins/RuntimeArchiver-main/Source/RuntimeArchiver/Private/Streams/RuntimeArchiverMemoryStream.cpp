@@ -3,15 +3,36 @@
 FRuntimeArchiverMemoryStream::FRuntimeArchiverMemoryStream(const TArray64<uint8>& ArchiveData)
 	: FRuntimeArchiverBaseStream(false)
   , ArchiveData(ArchiveData)
+  , bReferencesData(false)
+{
+}
+
+FRuntimeArchiverMemoryStream::FRuntimeArchiverMemoryStream(TArray64<uint8>&& ArchiveData)
+	: FRuntimeArchiverBaseStream(false)
+  , ArchiveData(MoveTemp(ArchiveData))
+  , bReferencesData(false)
+{
+}
+
+FRuntimeArchiverMemoryStream::FRuntimeArchiverMemoryStream(TArrayView64<const uint8> ArchiveDataView)
+	: FRuntimeArchiverBaseStream(false)
+  , ArchiveDataView(ArchiveDataView)
+  , bReferencesData(true)
 {
 }
 
 FRuntimeArchiverMemoryStream::FRuntimeArchiverMemoryStream(int32 InitialAllocationSize)
 	: FRuntimeArchiverBaseStream(true)
+  , bReferencesData(false)
 {
 	ArchiveData.SetNum(InitialAllocationSize);
 }
 
+TArrayView64<const uint8> FRuntimeArchiverMemoryStream::GetDataView() const
+{
+	return bReferencesData ? ArchiveDataView : TArrayView64<const uint8>(ArchiveData);
+}
+
 bool FRuntimeArchiverMemoryStream::IsValid() const
 {
 	return true;
@@ -24,12 +45,14 @@ bool FRuntimeArchiverMemoryStream::Read(void* Data, int64 Size)
 		return false;
 	}
 
-	if (Position + Size > ArchiveData.Num())
+	const TArrayView64<const uint8> DataView = GetDataView();
+
+	if (Position + Size > DataView.Num())
 	{
 		return false;
 	}
 
-	const bool bSuccess{FMemory::Memcpy(Data, ArchiveData.GetData() + Position, Size) != nullptr};
+	const bool bSuccess{FMemory::Memcpy(Data, DataView.GetData() + Position, Size) != nullptr};
 	Position += Size;
 
 	return bSuccess;
@@ -69,7 +92,7 @@ bool FRuntimeArchiverMemoryStream::Seek(int64 NewPosition)
 		return true;
 	}
 
-	if (NewPosition > ArchiveData.Num())
+	if (NewPosition > GetDataView().Num())
 	{
 		if (NewPosition != 0)
 		{
@@ -89,5 +112,31 @@ int64 FRuntimeArchiverMemoryStream::Size()
 		return -1;
 	}
 
-	return ArchiveData.Num();
+	return GetDataView().Num();
+}
+
+const uint8* FRuntimeArchiverMemoryStream::GetReadView(int64 Offset, int64 Size)
+{
+	const TArrayView64<const uint8> DataView = GetDataView();
+
+	if (!IsValid() || Offset < 0 || Size < 0 || Offset + Size > DataView.Num())
+	{
+		return nullptr;
+	}
+
+	return DataView.GetData() + Offset;
+}
+
+bool FRuntimeArchiverMemoryStream::MoveData(TArray64<uint8>& OutData)
+{
+	if (!IsValid() || bReferencesData)
+	{
+		return false;
+	}
+
+	OutData = MoveTemp(ArchiveData);
+	ArchiveData.Reset();
+	Position = 0;
+
+	return true;
 }
@@ -0,0 +1,182 @@
+﻿// Georgy Treshchev 2024.
+
+#include "Streams/RuntimeArchiverOodleStream.h"
+
+#if UE_VERSION_NEWER_THAN(5, 0, 0)
+#include "RuntimeArchiverDefines.h"
+#include "ArchiverRaw/RuntimeArchiverOodleConversation.h"
+
+namespace
+{
+	/** Magic number at the beginning and at the end of the data ("OBLK") */
+	constexpr uint32 OodleBlockFormatMagic = 0x4B4C424F;
+
+	/** Version of the written format */
+	constexpr uint32 OodleBlockFormatVersion = 1;
+
+	/** Size of the uncompressed data in each written block */
+	constexpr int64 OodleBlockSize = 4 * 1024 * 1024;
+
+	/** Header size: magic number, version, block size and reserved space */
+	constexpr int64 OodleHeaderSize = 16;
+
+	/** Trailer size: block table offset, number of blocks and magic number */
+	constexpr int64 OodleTrailerSize = 16;
+
+	/** Size of a block table entry: compressed size and uncompressed size */
+	constexpr int64 OodleBlockTableEntrySize = 8;
+
+	/** Compressed size flag marking the block as stored uncompressed */
+	constexpr uint32 OodleBlockUncompressedFlag = 0x80000000;
+}
+
+FRuntimeArchiverOodleStream::FRuntimeArchiverOodleStream(FRuntimeArchiverBaseStream& InCompressedStream, bool bWrite, int32 MaxWorkers)
+	: FRuntimeArchiverBlockStream(InCompressedStream, bWrite, OodleBlockSize, MaxWorkers)
+{
+	Initialize();
+}
+
+FRuntimeArchiverOodleStream::~FRuntimeArchiverOodleStream()
+{
+	if (bWrite)
+	{
+		Finish();
+	}
+}
+
+bool FRuntimeArchiverOodleStream::IsOodleBlockFormat(FRuntimeArchiverBaseStream& Stream)
+{
+	uint8 MagicData[4];
+	if (!Stream.IsValid() || Stream.Size() < OodleHeaderSize + OodleTrailerSize || !Stream.Seek(0) || !Stream.Read(MagicData, 4))
+	{
+		return false;
+	}
+
+	return ReadUInt32(MagicData) == OodleBlockFormatMagic;
+}
+
+bool FRuntimeArchiverOodleStream::WriteStreamHeader()
+{
+	uint8 Header[OodleHeaderSize] = {};
+	WriteUInt32(Header, OodleBlockFormatMagic);
+	WriteUInt32(Header + 4, OodleBlockFormatVersion);
+	WriteUInt32(Header + 8, static_cast<uint32>(BlockSize));
+	return WriteCompressed(Header, OodleHeaderSize);
+}
+
+bool FRuntimeArchiverOodleStream::WriteStreamFooter()
+{
+	const int64 BlockTableOffset = CompressedPosition;
+
+	TArray64<uint8> BlockTable;
+	BlockTable.SetNumUninitialized(Blocks.Num() * OodleBlockTableEntrySize);
+
+	for (int32 BlockIndex = 0; BlockIndex < Blocks.Num(); ++BlockIndex)
+	{
+		const FRuntimeArchiverBlockInfo& Block = Blocks[BlockIndex];
+		uint8* Entry = BlockTable.GetData() + BlockIndex * OodleBlockTableEntrySize;
+
+		WriteUInt32(Entry, static_cast<uint32>(Block.CompressedSize) | (Block.bCompressed ? 0 : OodleBlockUncompressedFlag));
+		WriteUInt32(Entry + 4, static_cast<uint32>(Block.UncompressedSize));
+	}
+
+	uint8 Trailer[OodleTrailerSize];
+	WriteUInt64(Trailer, BlockTableOffset);
+	WriteUInt32(Trailer + 8, Blocks.Num());
+	WriteUInt32(Trailer + 12, OodleBlockFormatMagic);
+
+	return WriteCompressed(BlockTable.GetData(), BlockTable.Num()) && WriteCompressed(Trailer, OodleTrailerSize);
+}
+
+bool FRuntimeArchiverOodleStream::WriteBlock(FRuntimeArchiverBlockInfo& Block, const uint8* Payload)
+{
+	// Block sizes are kept in the block table, so only the payload is written here
+	Block.CompressedOffset = CompressedPosition;
+	return WriteCompressed(Payload, Block.CompressedSize);
+}
+
+bool FRuntimeArchiverOodleStream::ReadBlockTable(TArray<FRuntimeArchiverBlockInfo>& OutBlocks)
+{
+	uint8 Header[OodleHeaderSize];
+	uint8 Trailer[OodleTrailerSize];
+
+	if (!ReadCompressed(0, Header, OodleHeaderSize) || !ReadCompressed(CompressedSize - OodleTrailerSize, Trailer, OodleTrailerSize))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read Oodle block format header and trailer because the data is too small (%lld bytes)"), CompressedSize);
+		return false;
+	}
+
+	if (ReadUInt32(Header) != OodleBlockFormatMagic || ReadUInt32(Trailer + 12) != OodleBlockFormatMagic)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read Oodle block format data because it has an invalid signature, the data is probably truncated"));
+		return false;
+	}
+
+	if (ReadUInt32(Header + 4) != OodleBlockFormatVersion)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read Oodle block format data because its version %u is not supported"), ReadUInt32(Header + 4));
+		return false;
+	}
+
+	const int64 BlockTableOffset = static_cast<int64>(ReadUInt64(Trailer));
+	const int64 NumOfBlocks = ReadUInt32(Trailer + 8);
+
+	if (BlockTableOffset < OodleHeaderSize || BlockTableOffset + NumOfBlocks * OodleBlockTableEntrySize != CompressedSize - OodleTrailerSize)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read Oodle block table because its location is invalid"));
+		return false;
+	}
+
+	TArray64<uint8> BlockTable;
+	BlockTable.SetNumUninitialized(NumOfBlocks * OodleBlockTableEntrySize);
+
+	if (!ReadCompressed(BlockTableOffset, BlockTable.GetData(), BlockTable.Num()))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read Oodle block table"));
+		return false;
+	}
+
+	OutBlocks.Reserve(NumOfBlocks);
+
+	int64 Offset = OodleHeaderSize;
+	for (int64 BlockIndex = 0; BlockIndex < NumOfBlocks; ++BlockIndex)
+	{
+		const uint8* Entry = BlockTable.GetData() + BlockIndex * OodleBlockTableEntrySize;
+		const uint32 CompressedSizeValue = ReadUInt32(Entry);
+		const int64 PayloadSize = CompressedSizeValue & ~OodleBlockUncompressedFlag;
+
+		OutBlocks.Add({Offset, PayloadSize, 0, ReadUInt32(Entry + 4), !(CompressedSizeValue & OodleBlockUncompressedFlag)});
+		Offset += PayloadSize;
+	}
+
+	if (Offset != BlockTableOffset)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Oodle block table does not match the block payloads, the data is probably corrupted"));
+		return false;
+	}
+
+	return true;
+}
+
+bool FRuntimeArchiverOodleStream::CompressBlock(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData) const
+{
+	const int64 CompressedBufferSize = FOodleDataCompression::CompressedBufferSizeNeeded(Size);
+	CompressedData.SetNumUninitialized(CompressedBufferSize);
+
+	const int64 NumOfCompressedBytes = FOodleDataCompression::Compress(CompressedData.GetData(), CompressedBufferSize, Data, Size,
+	                                                                   OodleConversation::GetCompressor(CompressionLevel), OodleConversation::GetCompressionLevel(CompressionLevel));
+	if (NumOfCompressedBytes <= 0)
+	{
+		return false;
+	}
+
+	CompressedData.SetNumUninitialized(NumOfCompressedBytes);
+	return true;
+}
+
+bool FRuntimeArchiverOodleStream::DecompressBlock(const FRuntimeArchiverBlockInfo& Block, const uint8* Payload, uint8* Data, int64& DecompressedSize) const
+{
+	DecompressedSize = Block.UncompressedSize;
+	return FOodleDataCompression::Decompress(Data, Block.UncompressedSize, Payload, Block.CompressedSize);
+}
+#endif
@@ -0,0 +1,263 @@
+﻿// Georgy Treshchev 2024.
+
+#include "Streams/RuntimeArchiverSeekableStream.h"
+
+#include "RuntimeArchiverDefines.h"
+#include "Misc/Compression.h"
+#include "Misc/EngineVersionComparison.h"
+
+namespace
+{
+	/** Magic number at the beginning and at the end of the data ("RASK") */
+	constexpr uint32 SeekableFormatMagic = 0x4B534152;
+
+	/** Version of the written format */
+	constexpr uint32 SeekableFormatVersion = 1;
+
+	/** Uncompressed size of each frame. Small enough for reading a range to decompress little more than the range itself */
+	constexpr int64 SeekableFrameSize = 1024 * 1024;
+
+	/** Header size: magic number, version, frame size and reserved space */
+	constexpr int64 SeekableHeaderSize = 16;
+
+	/** Trailer size: frame index offset, number of frames, file table payload size, uncompressed size and checksum, reserved space and magic number */
+	constexpr int64 SeekableTrailerSize = 32;
+
+	/** Size of a frame index entry: payload size, uncompressed size and checksum */
+	constexpr int64 SeekableFrameIndexEntrySize = 12;
+
+	/** Payload size flag marking the frame or the file table as stored uncompressed */
+	constexpr uint32 SeekableUncompressedFlag = 0x80000000;
+
+	/**
+	 * Compress data with LZ4
+	 *
+	 * @return Whether the data became smaller or not
+	 */
+	bool CompressLZ4(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData)
+	{
+#if UE_VERSION_NEWER_THAN(5, 0, 0)
+		int32 NumOfCompressedBytes = static_cast<int32>(FCompression::GetMaximumCompressedSize(NAME_LZ4, Size));
+#else
+		int32 NumOfCompressedBytes = FCompression::CompressMemoryBound(NAME_LZ4, static_cast<int32>(Size));
+#endif
+
+		CompressedData.SetNumUninitialized(NumOfCompressedBytes);
+
+		if (!FCompression::CompressMemory(NAME_LZ4, CompressedData.GetData(), NumOfCompressedBytes, Data, static_cast<int32>(Size)))
+		{
+			return false;
+		}
+
+		CompressedData.SetNumUninitialized(NumOfCompressedBytes);
+		return NumOfCompressedBytes < Size;
+	}
+}
+
+FRuntimeArchiverSeekableStream::FRuntimeArchiverSeekableStream(FRuntimeArchiverBaseStream& InCompressedStream, bool bWrite, int32 MaxWorkers)
+	: FRuntimeArchiverBlockStream(InCompressedStream, bWrite, SeekableFrameSize, MaxWorkers)
+{
+	bBlockChecksums = true;
+	Initialize();
+}
+
+FRuntimeArchiverSeekableStream::~FRuntimeArchiverSeekableStream()
+{
+	if (bWrite)
+	{
+		Finish();
+	}
+}
+
+bool FRuntimeArchiverSeekableStream::IsSeekableFormat(FRuntimeArchiverBaseStream& Stream)
+{
+	uint8 MagicData[4];
+	if (!Stream.IsValid() || Stream.Size() < SeekableHeaderSize + SeekableTrailerSize || !Stream.Seek(0) || !Stream.Read(MagicData, 4))
+	{
+		return false;
+	}
+
+	return ReadUInt32(MagicData) == SeekableFormatMagic;
+}
+
+bool FRuntimeArchiverSeekableStream::WriteStreamHeader()
+{
+	uint8 Header[SeekableHeaderSize] = {};
+	WriteUInt32(Header, SeekableFormatMagic);
+	WriteUInt32(Header + 4, SeekableFormatVersion);
+	WriteUInt32(Header + 8, static_cast<uint32>(BlockSize));
+	return WriteCompressed(Header, SeekableHeaderSize);
+}
+
+bool FRuntimeArchiverSeekableStream::WriteStreamFooter()
+{
+	const int64 FrameIndexOffset = CompressedPosition;
+
+	TArray64<uint8> FrameIndex;
+	FrameIndex.SetNumUninitialized(Blocks.Num() * SeekableFrameIndexEntrySize);
+
+	for (int32 FrameNumber = 0; FrameNumber < Blocks.Num(); ++FrameNumber)
+	{
+		const FRuntimeArchiverBlockInfo& Block = Blocks[FrameNumber];
+		uint8* Entry = FrameIndex.GetData() + FrameNumber * SeekableFrameIndexEntrySize;
+
+		WriteUInt32(Entry, static_cast<uint32>(Block.CompressedSize) | (Block.bCompressed ? 0 : SeekableUncompressedFlag));
+		WriteUInt32(Entry + 4, static_cast<uint32>(Block.UncompressedSize));
+		WriteUInt32(Entry + 8, Block.Checksum);
+	}
+
+	if (!WriteCompressed(FrameIndex.GetData(), FrameIndex.Num()))
+	{
+		return false;
+	}
+
+	// The file table is compressed as a whole, as it is always read at once
+	TArray64<uint8> CompressedFileTable;
+	const bool bFileTableCompressed = FileTable.Num() > 0 && CompressLZ4(FileTable.GetData(), FileTable.Num(), CompressedFileTable);
+	const TArray64<uint8>& FileTablePayload = bFileTableCompressed ? CompressedFileTable : FileTable;
+
+	if (!WriteCompressed(FileTablePayload.GetData(), FileTablePayload.Num()))
+	{
+		return false;
+	}
+
+	uint8 Trailer[SeekableTrailerSize] = {};
+	WriteUInt64(Trailer, FrameIndexOffset);
+	WriteUInt32(Trailer + 8, Blocks.Num());
+	WriteUInt32(Trailer + 12, static_cast<uint32>(FileTablePayload.Num()) | (bFileTableCompressed ? 0 : SeekableUncompressedFlag));
+	WriteUInt32(Trailer + 16, static_cast<uint32>(FileTable.Num()));
+	WriteUInt32(Trailer + 20, FCrc::MemCrc32(FileTable.GetData(), static_cast<int32>(FileTable.Num())));
+	WriteUInt32(Trailer + 28, SeekableFormatMagic);
+
+	return WriteCompressed(Trailer, SeekableTrailerSize);
+}
+
+bool FRuntimeArchiverSeekableStream::WriteBlock(FRuntimeArchiverBlockInfo& Block, const uint8* Payload)
+{
+	// Frame sizes and checksums are kept in the frame index, so only the payload is written here
+	Block.CompressedOffset = CompressedPosition;
+	return WriteCompressed(Payload, Block.CompressedSize);
+}
+
+bool FRuntimeArchiverSeekableStream::ReadBlockTable(TArray<FRuntimeArchiverBlockInfo>& OutBlocks)
+{
+	uint8 Header[SeekableHeaderSize];
+	uint8 Trailer[SeekableTrailerSize];
+
+	if (!ReadCompressed(0, Header, SeekableHeaderSize) || !ReadCompressed(CompressedSize - SeekableTrailerSize, Trailer, SeekableTrailerSize))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read seekable format header and trailer because the data is too small (%lld bytes)"), CompressedSize);
+		return false;
+	}
+
+	if (ReadUInt32(Header) != SeekableFormatMagic || ReadUInt32(Trailer + 28) != SeekableFormatMagic)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read seekable format data because it has an invalid signature, the data is probably truncated"));
+		return false;
+	}
+
+	if (ReadUInt32(Header + 4) != SeekableFormatVersion)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read seekable format data because its version %u is not supported"), ReadUInt32(Header + 4));
+		return false;
+	}
+
+	const int64 FrameIndexOffset = static_cast<int64>(ReadUInt64(Trailer));
+	const int64 NumOfFrames = ReadUInt32(Trailer + 8);
+	const uint32 FileTablePayloadSizeValue = ReadUInt32(Trailer + 12);
+	const int64 FileTablePayloadSize = FileTablePayloadSizeValue & ~SeekableUncompressedFlag;
+	const int64 FileTableOffset = FrameIndexOffset + NumOfFrames * SeekableFrameIndexEntrySize;
+
+	if (FrameIndexOffset < SeekableHeaderSize || FileTableOffset + FileTablePayloadSize != CompressedSize - SeekableTrailerSize)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read seekable frame index because its location is invalid"));
+		return false;
+	}
+
+	TArray64<uint8> FrameIndex;
+	FrameIndex.SetNumUninitialized(NumOfFrames * SeekableFrameIndexEntrySize);
+
+	if (!ReadCompressed(FrameIndexOffset, FrameIndex.GetData(), FrameIndex.Num()))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read seekable frame index"));
+		return false;
+	}
+
+	OutBlocks.Reserve(NumOfFrames);
+
+	int64 Offset = SeekableHeaderSize;
+	for (int64 FrameNumber = 0; FrameNumber < NumOfFrames; ++FrameNumber)
+	{
+		const uint8* Entry = FrameIndex.GetData() + FrameNumber * SeekableFrameIndexEntrySize;
+		const uint32 PayloadSizeValue = ReadUInt32(Entry);
+		const int64 PayloadSize = PayloadSizeValue & ~SeekableUncompressedFlag;
+
+		OutBlocks.Add({Offset, PayloadSize, 0, ReadUInt32(Entry + 4), !(PayloadSizeValue & SeekableUncompressedFlag), ReadUInt32(Entry + 8)});
+		Offset += PayloadSize;
+	}
+
+	if (Offset != FrameIndexOffset)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Seekable frame index does not match the frame payloads, the data is probably corrupted"));
+		return false;
+	}
+
+	return ReadFileTable(FileTableOffset, FileTablePayloadSize, ReadUInt32(Trailer + 16), !(FileTablePayloadSizeValue & SeekableUncompressedFlag), ReadUInt32(Trailer + 20));
+}
+
+bool FRuntimeArchiverSeekableStream::CompressBlock(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData) const
+{
+	// Data that does not shrink is stored as is by the block stream, which is not an error
+	CompressLZ4(Data, Size, CompressedData);
+	return CompressedData.Num() > 0;
+}
+
+bool FRuntimeArchiverSeekableStream::DecompressBlock(const FRuntimeArchiverBlockInfo& Block, const uint8* Payload, uint8* Data, int64& DecompressedSize) const
+{
+	DecompressedSize = Block.UncompressedSize;
+	return FCompression::UncompressMemory(NAME_LZ4, Data, static_cast<int32>(Block.UncompressedSize), Payload, static_cast<int32>(Block.CompressedSize));
+}
+
+bool FRuntimeArchiverSeekableStream::ReadFileTable(int64 Offset, int64 PayloadSize, int64 UncompressedSize, bool bCompressed, uint32 Checksum)
+{
+	FileTable.Reset();
+
+	if (UncompressedSize == 0)
+	{
+		return true;
+	}
+
+	TArray64<uint8> Payload;
+	Payload.SetNumUninitialized(PayloadSize);
+
+	if (!ReadCompressed(Offset, Payload.GetData(), PayloadSize))
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to read seekable file table at offset %lld with size %lld"), Offset, PayloadSize);
+		return false;
+	}
+
+	if (!bCompressed)
+	{
+		FileTable = MoveTemp(Payload);
+	}
+	else
+	{
+		FileTable.SetNumUninitialized(UncompressedSize);
+
+		if (!FCompression::UncompressMemory(NAME_LZ4, FileTable.GetData(), static_cast<int32>(UncompressedSize), Payload.GetData(), static_cast<int32>(PayloadSize)))
+		{
+			UE_LOG(LogRuntimeArchiver, Error, TEXT("Unable to decompress seekable file table, the data is probably corrupted"));
+			FileTable.Reset();
+			return false;
+		}
+	}
+
+	if (FileTable.Num() != UncompressedSize || FCrc::MemCrc32(FileTable.GetData(), static_cast<int32>(FileTable.Num())) != Checksum)
+	{
+		UE_LOG(LogRuntimeArchiver, Error, TEXT("Seekable file table does not match its checksum, the data is probably corrupted"));
+		FileTable.Reset();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,514 @@
+﻿// Georgy Treshchev 2024.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "RuntimeArchiverBase.h"
+#include "ArchiverZip/RuntimeArchiverZip.h"
+#include "ArchiverTar/RuntimeArchiverTar.h"
+#include "ArchiverGZip/RuntimeArchiverGZip.h"
+#include "ArchiverLZ4/RuntimeArchiverLZ4.h"
+#include "ArchiverOodle/RuntimeArchiverOodle.h"
+#include "ArchiverSeekable/RuntimeArchiverSeekable.h"
+#include "Algo/Find.h"
+#include "Async/Async.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "UObject/StrongObjectPtr.h"
+#include <atomic>
+
+namespace
+{
+	/** Content of a generated corpus */
+	enum class ECorpusType : uint8
+	{
+		/** Many small text files, like configs and scripts */
+		Configs,
+		/** A few large blobs made of repeated, slightly varying records, like packages */
+		Paks,
+		/** Random data, like already compressed media */
+		Media
+	};
+
+	const TCHAR* GetCorpusName(ECorpusType CorpusType)
+	{
+		switch (CorpusType)
+		{
+		case ECorpusType::Configs: return TEXT("Configs");
+		case ECorpusType::Paks: return TEXT("Paks");
+		case ECorpusType::Media: return TEXT("Media");
+		default: return TEXT("Unknown");
+		}
+	}
+
+	const ECorpusType BenchmarkCorpora[] = {ECorpusType::Configs, ECorpusType::Paks, ECorpusType::Media};
+
+	const TCHAR* const BenchmarkArchivers[] = {TEXT("Zip"), TEXT("Tar"), TEXT("GZip"), TEXT("LZ4"), TEXT("Oodle"), TEXT("Seekable")};
+
+	TSubclassOf<URuntimeArchiverBase> FindArchiverClass(const FString& Name)
+	{
+		const TPair<const TCHAR*, TSubclassOf<URuntimeArchiverBase>> ArchiverClasses[] = {
+			{TEXT("Zip"), URuntimeArchiverZip::StaticClass()},
+			{TEXT("Tar"), URuntimeArchiverTar::StaticClass()},
+			{TEXT("GZip"), URuntimeArchiverGZip::StaticClass()},
+			{TEXT("LZ4"), URuntimeArchiverLZ4::StaticClass()},
+			{TEXT("Oodle"), URuntimeArchiverOodle::StaticClass()},
+			{TEXT("Seekable"), URuntimeArchiverSeekable::StaticClass()}
+		};
+
+		for (const TPair<const TCHAR*, TSubclassOf<URuntimeArchiverBase>>& ArchiverClass : ArchiverClasses)
+		{
+			if (Name.Equals(ArchiverClass.Key))
+			{
+				return ArchiverClass.Value;
+			}
+		}
+
+		return nullptr;
+	}
+
+	const ERuntimeArchiverCompressionLevel BenchmarkCompressionLevels[] = {ERuntimeArchiverCompressionLevel::Compression1, ERuntimeArchiverCompressionLevel::Compression6, ERuntimeArchiverCompressionLevel::Compression9};
+
+	/** Size of the generated corpora */
+	constexpr int32 NumOfConfigFiles = 2000;
+	constexpr int64 PakSize = 64 * 1024 * 1024;
+	constexpr int64 MediaSize = 32 * 1024 * 1024;
+
+	/** Measurements of a single archiver, compression level and corpus */
+	struct FRuntimeArchiverBenchmarkResult
+	{
+		FString Corpus;
+		FString Archiver;
+		int32 CompressionLevel = 0;
+		int32 NumOfFiles = 0;
+		int64 InputBytes = 0;
+		int64 ArchiveBytes = 0;
+		double CompressSeconds = 0;
+		double CompressPeakRssMB = 0;
+		double CompressPeakGrowthMB = 0;
+		double ExtractSeconds = 0;
+		double ExtractPeakRssMB = 0;
+		double ExtractPeakGrowthMB = 0;
+		bool bValid = false;
+
+		static FString GetCsvHeader()
+		{
+			return TEXT("Corpus,Archiver,Level,Files,InputBytes,ArchiveBytes,Ratio,CompressSeconds,CompressMBps,CompressPeakRssMB,CompressPeakGrowthMB,ExtractSeconds,ExtractMBps,ExtractPeakRssMB,ExtractPeakGrowthMB,Valid");
+		}
+
+		FString ToCsv() const
+		{
+			return FString::Printf(TEXT("%s,%s,%d,%d,%lld,%lld,%.4f,%.3f,%.2f,%.1f,%.1f,%.3f,%.2f,%.1f,%.1f,%d"),
+				*Corpus, *Archiver, CompressionLevel, NumOfFiles, InputBytes, ArchiveBytes, GetRatio(),
+				CompressSeconds, GetMBps(CompressSeconds), CompressPeakRssMB, CompressPeakGrowthMB,
+				ExtractSeconds, GetMBps(ExtractSeconds), ExtractPeakRssMB, ExtractPeakGrowthMB, bValid ? 1 : 0);
+		}
+
+		/** Archive size relative to the input size. Lower is better */
+		double GetRatio() const
+		{
+			return InputBytes > 0 ? static_cast<double>(ArchiveBytes) / InputBytes : 0;
+		}
+
+		/** Throughput in uncompressed megabytes per second */
+		double GetMBps(double Seconds) const
+		{
+			return Seconds > 0 ? InputBytes / Seconds / (1024.0 * 1024.0) : 0;
+		}
+	};
+
+	/**
+	 * Samples the resident memory of the process on a separate thread while an operation runs, since the archiver operations block the benchmark thread
+	 */
+	class FRuntimeArchiverMemorySampler
+	{
+	public:
+		FRuntimeArchiverMemorySampler()
+			: StartUsedPhysical(FPlatformMemory::GetStats().UsedPhysical)
+			, PeakUsedPhysical(StartUsedPhysical)
+			, bStopped(false)
+		{
+			SamplerFuture = Async(EAsyncExecution::Thread, [this]()
+			{
+				while (!bStopped)
+				{
+					Sample();
+					FPlatformProcess::Sleep(0.005f);
+				}
+			});
+		}
+
+		/** Stop sampling and get the peak resident memory and its growth since the sampler was created, in megabytes */
+		void Stop(double& OutPeakRssMB, double& OutPeakGrowthMB)
+		{
+			bStopped = true;
+			SamplerFuture.Wait();
+			Sample();
+
+			OutPeakRssMB = PeakUsedPhysical.load() / (1024.0 * 1024.0);
+			OutPeakGrowthMB = (static_cast<int64>(PeakUsedPhysical.load()) - static_cast<int64>(StartUsedPhysical)) / (1024.0 * 1024.0);
+		}
+
+	private:
+		void Sample()
+		{
+			const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+
+			uint64 PreviousPeak = PeakUsedPhysical.load();
+			while (UsedPhysical > PreviousPeak && !PeakUsedPhysical.compare_exchange_weak(PreviousPeak, UsedPhysical))
+			{
+			}
+		}
+
+		const uint64 StartUsedPhysical;
+		std::atomic<uint64> PeakUsedPhysical;
+		std::atomic<bool> bStopped;
+		TFuture<void> SamplerFuture;
+	};
+
+	/**
+	 * Exposes the protected archiver operations, so that they are measured without the asynchronous wrappers. Never instantiated
+	 */
+	class FRuntimeArchiverBenchmarkAccess : public URuntimeArchiverBase
+	{
+	public:
+		static bool AddEntriesFromStorage(URuntimeArchiverBase& Archiver, const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel)
+		{
+			// Going through a member pointer, since protected members are only accessible on objects of the derived type
+			return (Archiver.*&FRuntimeArchiverBenchmarkAccess::AddEntriesFromStorage_Internal)(EntryNames, FilePaths, CompressionLevel, [](int64 NumOfBytes) {}, [](int32 EntryIndex, TArrayView64<const uint8> Data) {});
+		}
+
+		static bool ExtractEntriesToStorage(URuntimeArchiverBase& Archiver, const TArray<FRuntimeArchiveEntry>& EntryInfo, const TArray<FString>& FilePaths)
+		{
+			return (Archiver.*&FRuntimeArchiverBenchmarkAccess::ExtractEntriesToStorage_Internal)(EntryInfo, FilePaths, true, [](int64 NumOfBytes) {});
+		}
+
+		static bool GetArchiveEntriesByBaseName(URuntimeArchiverBase& Archiver, const FString& BaseName, TArray<FRuntimeArchiveEntry>& EntryInfo)
+		{
+			return (Archiver.*&FRuntimeArchiverBenchmarkAccess::GetArchiveEntriesByBaseName)(BaseName, EntryInfo);
+		}
+	};
+
+	/**
+	 * Write the corpus files. The content is generated from a fixed seed, so that runs are comparable
+	 */
+	bool GenerateCorpus(ECorpusType CorpusType, const FString& CorpusDirectory, TArray<FString>& EntryNames, TArray<FString>& FilePaths, int64& InputBytes)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.DeleteDirectoryRecursively(*CorpusDirectory);
+
+		FRandomStream RandomStream(0x41524348);
+
+		const auto AddFile = [&](const FString& EntryName, const TArray64<uint8>& Data)
+		{
+			const FString FilePath = FPaths::Combine(CorpusDirectory, EntryName);
+			if (!PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FilePath)) || !FFileHelper::SaveArrayToFile(Data, *FilePath))
+			{
+				return false;
+			}
+
+			EntryNames.Add(EntryName);
+			FilePaths.Add(FilePath);
+			InputBytes += Data.Num();
+			return true;
+		};
+
+		switch (CorpusType)
+		{
+		case ECorpusType::Configs:
+			{
+				for (int32 FileIndex = 0; FileIndex < NumOfConfigFiles; ++FileIndex)
+				{
+					FString Content;
+					const int32 NumOfSections = RandomStream.RandRange(2, 16);
+
+					for (int32 SectionIndex = 0; SectionIndex < NumOfSections; ++SectionIndex)
+					{
+						Content += FString::Printf(TEXT("[/Script/Game.Settings%d]\n"), RandomStream.RandRange(0, 63));
+
+						const int32 NumOfKeys = RandomStream.RandRange(4, 24);
+						for (int32 KeyIndex = 0; KeyIndex < NumOfKeys; ++KeyIndex)
+						{
+							Content += FString::Printf(TEXT("Property%d=%d.%04d\n"), RandomStream.RandRange(0, 255), RandomStream.RandRange(0, 100000), RandomStream.RandRange(0, 9999));
+						}
+					}
+
+					const FTCHARToUTF8 ContentUtf8(*Content);
+					TArray64<uint8> Data(reinterpret_cast<const uint8*>(ContentUtf8.Get()), ContentUtf8.Length());
+
+					if (!AddFile(FString::Printf(TEXT("Config/Group%02d/Settings%05d.ini"), FileIndex % 32, FileIndex), Data))
+					{
+						return false;
+					}
+				}
+				break;
+			}
+		case ECorpusType::Paks:
+			{
+				// Records picked from a small set of templates with a few bytes changed, which compresses like cooked packages do
+				constexpr int32 RecordSize = 4096;
+				constexpr int32 NumOfTemplates = 64;
+
+				TArray<TArray<uint8>> Templates;
+				for (int32 TemplateIndex = 0; TemplateIndex < NumOfTemplates; ++TemplateIndex)
+				{
+					TArray<uint8>& Template = Templates.AddDefaulted_GetRef();
+					Template.SetNumUninitialized(RecordSize);
+
+					for (int32 ByteIndex = 0; ByteIndex < RecordSize; ++ByteIndex)
+					{
+						// Skewed byte distribution, as in real binary data
+						Template[ByteIndex] = static_cast<uint8>(RandomStream.RandRange(0, 255) & RandomStream.RandRange(0, 255));
+					}
+				}
+
+				constexpr int32 NumOfPakFiles = 2;
+				for (int32 PakIndex = 0; PakIndex < NumOfPakFiles; ++PakIndex)
+				{
+					TArray64<uint8> Data;
+					Data.Reserve(PakSize / NumOfPakFiles + RecordSize);
+
+					while (Data.Num() < PakSize / NumOfPakFiles)
+					{
+						const int64 RecordOffset = Data.Num();
+						Data.Append(Templates[RandomStream.RandRange(0, NumOfTemplates - 1)].GetData(), RecordSize);
+
+						for (int32 MutationIndex = 0; MutationIndex < RecordSize / 20; ++MutationIndex)
+						{
+							Data[RecordOffset + RandomStream.RandRange(0, RecordSize - 1)] = static_cast<uint8>(RandomStream.RandRange(0, 255));
+						}
+					}
+
+					if (!AddFile(FString::Printf(TEXT("Content/Paks/Game-Linux-%d.pak"), PakIndex), Data))
+					{
+						return false;
+					}
+				}
+				break;
+			}
+		case ECorpusType::Media:
+			{
+				const TCHAR* Extensions[] = {TEXT("bk2"), TEXT("ogg"), TEXT("png"), TEXT("mp4")};
+
+				for (int32 MediaIndex = 0; MediaIndex < UE_ARRAY_COUNT(Extensions); ++MediaIndex)
+				{
+					TArray64<uint8> Data;
+					Data.SetNumUninitialized(MediaSize / UE_ARRAY_COUNT(Extensions));
+
+					for (int64 ByteIndex = 0; ByteIndex + 4 <= Data.Num(); ByteIndex += 4)
+					{
+						const uint32 RandomValue = RandomStream.GetUnsignedInt();
+						FMemory::Memcpy(Data.GetData() + ByteIndex, &RandomValue, 4);
+					}
+
+					if (!AddFile(FString::Printf(TEXT("Content/Movies/Media%d.%s"), MediaIndex, Extensions[MediaIndex]), Data))
+					{
+						return false;
+					}
+				}
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Compress the corpus into an archive in storage and extract it back, measuring both and comparing the extracted files with the corpus
+	 */
+	void RunArchiver(URuntimeArchiverBase& Archiver, ERuntimeArchiverCompressionLevel CompressionLevel, const FString& BenchmarkDirectory, const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, FRuntimeArchiverBenchmarkResult& Result)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+		const FString RunName = FString::Printf(TEXT("%s-%s-%d"), *Result.Corpus, *Result.Archiver, Result.CompressionLevel);
+		const FString ArchivePath = FPaths::Combine(BenchmarkDirectory, TEXT("Archives"), RunName + TEXT(".archive"));
+		const FString ExtractDirectory = FPaths::Combine(BenchmarkDirectory, TEXT("Extracted"), RunName);
+
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(ArchivePath));
+		PlatformFile.DeleteFile(*ArchivePath);
+		PlatformFile.DeleteDirectoryRecursively(*ExtractDirectory);
+
+		ON_SCOPE_EXIT
+		{
+			PlatformFile.DeleteFile(*ArchivePath);
+			PlatformFile.DeleteDirectoryRecursively(*ExtractDirectory);
+		};
+
+		// Compression
+		{
+			FRuntimeArchiverMemorySampler MemorySampler;
+			const double StartTime = FPlatformTime::Seconds();
+
+			const bool bCompressed = Archiver.CreateArchiveInStorage(ArchivePath)
+				&& FRuntimeArchiverBenchmarkAccess::AddEntriesFromStorage(Archiver, EntryNames, FilePaths, CompressionLevel)
+				&& Archiver.CloseArchive();
+
+			Result.CompressSeconds = FPlatformTime::Seconds() - StartTime;
+			MemorySampler.Stop(Result.CompressPeakRssMB, Result.CompressPeakGrowthMB);
+
+			if (!bCompressed)
+			{
+				Archiver.Reset();
+				return;
+			}
+		}
+
+		Result.ArchiveBytes = PlatformFile.FileSize(*ArchivePath);
+
+		// Extraction
+		TArray<FRuntimeArchiveEntry> Entries;
+		TArray<FString> ExtractedFilePaths;
+		{
+			FRuntimeArchiverMemorySampler MemorySampler;
+			const double StartTime = FPlatformTime::Seconds();
+
+			bool bExtracted = Archiver.OpenArchiveFromStorage(ArchivePath) && FRuntimeArchiverBenchmarkAccess::GetArchiveEntriesByBaseName(Archiver, FString(), Entries);
+
+			if (bExtracted)
+			{
+				ExtractedFilePaths.Reserve(Entries.Num());
+				for (const FRuntimeArchiveEntry& Entry : Entries)
+				{
+					ExtractedFilePaths.Add(FPaths::Combine(ExtractDirectory, Entry.Name));
+				}
+
+				bExtracted = FRuntimeArchiverBenchmarkAccess::ExtractEntriesToStorage(Archiver, Entries, ExtractedFilePaths);
+			}
+
+			bExtracted &= Archiver.CloseArchive();
+
+			Result.ExtractSeconds = FPlatformTime::Seconds() - StartTime;
+			MemorySampler.Stop(Result.ExtractPeakRssMB, Result.ExtractPeakGrowthMB);
+
+			if (!bExtracted)
+			{
+				Archiver.Reset();
+				return;
+			}
+		}
+
+		// Round trip check, outside of the measured time
+		Result.bValid = true;
+		for (int32 FileIndex = 0; FileIndex < FilePaths.Num() && Result.bValid; ++FileIndex)
+		{
+			TArray64<uint8> SourceData, ExtractedData;
+			Result.bValid = FFileHelper::LoadFileToArray(SourceData, *FilePaths[FileIndex])
+				&& FFileHelper::LoadFileToArray(ExtractedData, *FPaths::Combine(ExtractDirectory, EntryNames[FileIndex]))
+				&& SourceData == ExtractedData;
+		}
+	}
+}
+
+/**
+ * Generates a representative corpus, then compresses and extracts it with an archiver at every compression level, saving the measurements as CSV
+ * Fails if any of the round trips does not reproduce the corpus
+ */
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FRuntimeArchiverBenchmarkTest, "RuntimeArchiver.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FRuntimeArchiverBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const ECorpusType CorpusType : BenchmarkCorpora)
+	{
+		for (const TCHAR* ArchiverName : BenchmarkArchivers)
+		{
+			OutBeautifiedNames.Add(FString::Printf(TEXT("%s.%s"), GetCorpusName(CorpusType), ArchiverName));
+			OutTestCommands.Add(FString::Printf(TEXT("%s %s"), GetCorpusName(CorpusType), ArchiverName));
+		}
+	}
+}
+
+bool FRuntimeArchiverBenchmarkTest::RunTest(const FString& Parameters)
+{
+	FString CorpusName, ArchiverName;
+	Parameters.Split(TEXT(" "), &CorpusName, &ArchiverName);
+
+	const ECorpusType* CorpusType = Algo::FindByPredicate(BenchmarkCorpora, [&CorpusName](ECorpusType Candidate)
+	{
+		return CorpusName.Equals(GetCorpusName(Candidate));
+	});
+
+	const TSubclassOf<URuntimeArchiverBase> ArchiverClass = FindArchiverClass(ArchiverName);
+
+	if (!CorpusType || !ArchiverClass)
+	{
+		AddError(FString::Printf(TEXT("Unknown benchmark run '%s'"), *Parameters));
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	const FString BenchmarkDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("RuntimeArchiver"), TEXT("Benchmark"));
+	const FString CorpusDirectory = FPaths::Combine(BenchmarkDirectory, TEXT("Corpus"), CorpusName);
+
+	ON_SCOPE_EXIT
+	{
+		PlatformFile.DeleteDirectoryRecursively(*CorpusDirectory);
+	};
+
+	TArray<FString> EntryNames;
+	TArray<FString> FilePaths;
+	int64 InputBytes = 0;
+
+	if (!GenerateCorpus(*CorpusType, CorpusDirectory, EntryNames, FilePaths, InputBytes))
+	{
+		AddError(FString::Printf(TEXT("Unable to generate the %s corpus in '%s'"), *CorpusName, *CorpusDirectory));
+		return false;
+	}
+
+	const TStrongObjectPtr<URuntimeArchiverBase> Archiver(NewObject<URuntimeArchiverBase>(GetTransientPackage(), ArchiverClass));
+
+	// The corpora use the extensions of real game files, which would otherwise be stored as is at every level
+	Archiver->bStoreIncompressibleEntries = false;
+
+	// Tar does not compress, so a single level is enough
+	const int32 NumOfLevels = Archiver->IsA<URuntimeArchiverTar>() ? 1 : UE_ARRAY_COUNT(BenchmarkCompressionLevels);
+
+	TArray<FString> CsvLines;
+	CsvLines.Add(FRuntimeArchiverBenchmarkResult::GetCsvHeader());
+
+	for (int32 LevelIndex = 0; LevelIndex < NumOfLevels; ++LevelIndex)
+	{
+		const ERuntimeArchiverCompressionLevel CompressionLevel = BenchmarkCompressionLevels[LevelIndex];
+
+		FRuntimeArchiverBenchmarkResult Result;
+		Result.Corpus = CorpusName;
+		Result.Archiver = ArchiverName;
+		Result.CompressionLevel = static_cast<int32>(CompressionLevel);
+		Result.NumOfFiles = FilePaths.Num();
+		Result.InputBytes = InputBytes;
+
+		RunArchiver(*Archiver, CompressionLevel, BenchmarkDirectory, EntryNames, FilePaths, Result);
+
+		AddInfo(FString::Printf(TEXT("Level %d: ratio %.3f, compress %.2f MB/s (peak RSS %.1f MB, +%.1f MB), extract %.2f MB/s (peak RSS %.1f MB, +%.1f MB)"),
+			Result.CompressionLevel, Result.GetRatio(),
+			Result.GetMBps(Result.CompressSeconds), Result.CompressPeakRssMB, Result.CompressPeakGrowthMB,
+			Result.GetMBps(Result.ExtractSeconds), Result.ExtractPeakRssMB, Result.ExtractPeakGrowthMB));
+
+		TestTrue(FString::Printf(TEXT("%s corpus round trip through %s at level %d is valid"), *CorpusName, *ArchiverName, Result.CompressionLevel), Result.bValid);
+
+		CsvLines.Add(Result.ToCsv());
+	}
+
+	const FString ResultsPath = FPaths::Combine(BenchmarkDirectory, FString::Printf(TEXT("Results-%s-%s-%s.csv"), *CorpusName, *ArchiverName, *FDateTime::Now().ToString()));
+	if (FFileHelper::SaveStringArrayToFile(CsvLines, *ResultsPath))
+	{
+		AddInfo(FString::Printf(TEXT("Results saved to '%s'"), *FPaths::ConvertRelativePathToFull(ResultsPath)));
+	}
+	else
+	{
+		AddWarning(FString::Printf(TEXT("Unable to save the results to '%s'"), *ResultsPath));
+	}
+
+	return true;
+}
+
+#endif
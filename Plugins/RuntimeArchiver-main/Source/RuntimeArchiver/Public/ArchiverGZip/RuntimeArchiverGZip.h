@@ -10,7 +10,8 @@
 
 /**
  * GZip archiver class. Works with tar.gz (tgz) archives
- * Archiving of data occurs through the Tar archiver and their subsequent compression through GZip raw archiver (the same applies for unarchiving)
+ * Archiving of data occurs through the Tar archiver and their subsequent compression through GZip raw archiver
+ * Unarchiving inflates the data on the fly while the Tar archiver reads it, so the archive is never decompressed into memory as a whole
  */
 UCLASS(BlueprintType, Category = "Runtime Archiver")
 class RUNTIMEARCHIVER_API URuntimeArchiverGZip : public URuntimeArchiverBase
@@ -26,17 +27,19 @@ public:
 
 	virtual bool OpenArchiveFromStorage(FString ArchivePath) override;
 	virtual bool OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData) override;
+	using URuntimeArchiverBase::OpenArchiveFromMemory;
 
 	virtual bool CloseArchive() override;
 
 	virtual bool GetArchiveData(TArray64<uint8>& ArchiveData) override;
+	virtual bool MoveArchiveData(TArray64<uint8>& ArchiveData) override;
 
 	virtual bool GetArchiveEntries(int32& NumOfArchiveEntries) override;
 
 	virtual bool GetArchiveEntryInfoByName(FString EntryName, FRuntimeArchiveEntry& EntryInfo) override;
 	virtual bool GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeArchiveEntry& EntryInfo) override;
 
-	virtual bool AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
+	virtual bool AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
 
 	virtual bool ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData) override;
 
@@ -45,13 +48,26 @@ public:
 	virtual void Reset() override;
 
 	virtual void ReportError(ERuntimeArchiverErrorCode ErrorCode, const FString& ErrorString) const override;
+
+protected:
+	virtual bool ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed) override;
+	virtual bool TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress) override;
+	virtual bool ExtractEntriesToStorage_Directory_Internal(const FString& BaseName, const FString& DirectoryPath, const FString& BaseDirectoryPathToExclude, bool bForceOverwrite, TArray<FString>& FilePaths) override;
 	//~ End URuntimeArchiverBase Interface
 
 private:
+	/**
+	 * Move the tar data out of the tar archiver and compress it. The tar archiver is closed afterwards
+	 *
+	 * @param ArchiveData GZip compressed archive data
+	 * @return Whether the operation was successful or not
+	 */
+	bool CompressTarArchiveData(TArray64<uint8>& ArchiveData);
+
 	/** Tar archiver used for internal operations */
 	TStrongObjectPtr<URuntimeArchiverTar> TarArchiver;
 
-	/** Stream containing LZ4 compressed data */
+	/** Stream containing GZip compressed data */
 	TUniquePtr<FRuntimeArchiverBaseStream> CompressedStream;
 
 	/** Last saved compression level */
@@ -5,13 +5,14 @@
 #include "CoreMinimal.h"
 #include "RuntimeArchiverBase.h"
 #include "ArchiverTar/RuntimeArchiverTar.h"
+#include "Streams/RuntimeArchiverBlockStream.h"
 #include "UObject/StrongObjectPtr.h"
 #include "RuntimeArchiverLZ4.generated.h"
 
 /**
  * LZ4 archiver class. Works with tar.lz4 (tlz4) archives
- * Archiving of data occurs through the Tar archiver and their subsequent compression through LZ4 raw archiver (the same applies for unarchiving)
- * Note that it currently has some bugs when unarchiving data from a tar archive
+ * Archiving of data occurs through the Tar archiver, with the tar data compressed into an LZ4 frame of independent blocks as it is written (the same applies for unarchiving)
+ * Blocks are compressed and decompressed in parallel, and only a few blocks are kept in memory at once. Archives created by earlier versions, compressed as a single block, can still be opened
  */
 UCLASS(BlueprintType, Category = "Runtime Archiver")
 class RUNTIMEARCHIVER_API URuntimeArchiverLZ4 : public URuntimeArchiverBase
@@ -27,17 +28,19 @@ public:
 
 	virtual bool OpenArchiveFromStorage(FString ArchivePath) override;
 	virtual bool OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData) override;
+	using URuntimeArchiverBase::OpenArchiveFromMemory;
 
 	virtual bool CloseArchive() override;
 
 	virtual bool GetArchiveData(TArray64<uint8>& ArchiveData) override;
+	virtual bool MoveArchiveData(TArray64<uint8>& ArchiveData) override;
 
 	virtual bool GetArchiveEntries(int32& NumOfArchiveEntries) override;
 
 	virtual bool GetArchiveEntryInfoByName(FString EntryName, FRuntimeArchiveEntry& EntryInfo) override;
 	virtual bool GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeArchiveEntry& EntryInfo) override;
 
-	virtual bool AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
+	virtual bool AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
 
 	virtual bool ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData) override;
 
@@ -46,15 +49,31 @@ public:
 	virtual void Reset() override;
 
 	virtual void ReportError(ERuntimeArchiverErrorCode ErrorCode, const FString& ErrorString) const override;
+
+protected:
+	virtual bool ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed) override;
+	virtual bool TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress) override;
 	//~ End URuntimeArchiverBase Interface
 
+public:
+	/** The maximum number of threads used to compress or decompress blocks in parallel. 0 uses the number of logical cores, 1 disables parallel processing. Applied when creating or opening an archive */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver")
+	int32 MaxBlockWorkers;
+
 private:
+	/**
+	 * Write the end of the tar archive and compress the remaining blocks. Nothing can be added afterwards
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool FinishArchive();
+
 	/** Tar archiver used for internal operations */
 	TStrongObjectPtr<URuntimeArchiverTar> TarArchiver;
 
 	/** Stream containing LZ4 compressed data */
 	TUniquePtr<FRuntimeArchiverBaseStream> CompressedStream;
 
-	/** Last saved compression level */
-	ERuntimeArchiverCompressionLevel LastCompressionLevel;
+	/** Stream compressing the tar data into blocks when writing. Owned by the tar archiver */
+	FRuntimeArchiverBlockStream* BlockStream;
 };
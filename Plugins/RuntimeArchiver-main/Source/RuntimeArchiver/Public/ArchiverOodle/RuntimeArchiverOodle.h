@@ -5,12 +5,15 @@
 #include "CoreMinimal.h"
 #include "RuntimeArchiverBase.h"
 #include "ArchiverTar/RuntimeArchiverTar.h"
+#include "Streams/RuntimeArchiverBlockStream.h"
 #include "UObject/StrongObjectPtr.h"
 #include "RuntimeArchiverOodle.generated.h"
 
 /**
  * Oodle archiver class. Works with tar.ood (tood) archives. This doesn't have any specs, but works similarly to tar.gz
- * Archiving of data occurs through the Tar archiver and their subsequent compression through Oodle raw archiver (the same applies for unarchiving)
+ * The tar data is split into independently compressed Oodle blocks as it is written, followed by a block table used to locate them when reading
+ * Blocks are compressed and decompressed in parallel, and only a few blocks are kept in memory at once. Archives created by earlier versions, compressed as a single block, can still be opened
+ * Writing archives requires UE 5.0 or newer
  */
 UCLASS(BlueprintType, Category = "Runtime Archiver")
 class RUNTIMEARCHIVER_API URuntimeArchiverOodle : public URuntimeArchiverBase
@@ -26,17 +29,19 @@ public:
 
 	virtual bool OpenArchiveFromStorage(FString ArchivePath) override;
 	virtual bool OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData) override;
+	using URuntimeArchiverBase::OpenArchiveFromMemory;
 
 	virtual bool CloseArchive() override;
 
 	virtual bool GetArchiveData(TArray64<uint8>& ArchiveData) override;
+	virtual bool MoveArchiveData(TArray64<uint8>& ArchiveData) override;
 
 	virtual bool GetArchiveEntries(int32& NumOfArchiveEntries) override;
 
 	virtual bool GetArchiveEntryInfoByName(FString EntryName, FRuntimeArchiveEntry& EntryInfo) override;
 	virtual bool GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeArchiveEntry& EntryInfo) override;
 
-	virtual bool AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
+	virtual bool AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
 
 	virtual bool ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData) override;
 
@@ -45,15 +50,31 @@ public:
 	virtual void Reset() override;
 
 	virtual void ReportError(ERuntimeArchiverErrorCode ErrorCode, const FString& ErrorString) const override;
+
+protected:
+	virtual bool ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed) override;
+	virtual bool TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress) override;
 	//~ End URuntimeArchiverBase Interface
 
+public:
+	/** The maximum number of threads used to compress or decompress blocks in parallel. 0 uses the number of logical cores, 1 disables parallel processing. Applied when creating or opening an archive */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver")
+	int32 MaxBlockWorkers;
+
 private:
+	/**
+	 * Write the end of the tar archive and compress the remaining blocks. Nothing can be added afterwards
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool FinishArchive();
+
 	/** Tar archiver used for internal operations */
 	TStrongObjectPtr<URuntimeArchiverTar> TarArchiver;
 
 	/** Stream containing LZ4 compressed data */
 	TUniquePtr<FRuntimeArchiverBaseStream> CompressedStream;
 
-	/** Last saved compression level */
-	ERuntimeArchiverCompressionLevel LastCompressionLevel;
+	/** Stream compressing the tar data into blocks when writing. Owned by the tar archiver */
+	FRuntimeArchiverBlockStream* BlockStream;
 };
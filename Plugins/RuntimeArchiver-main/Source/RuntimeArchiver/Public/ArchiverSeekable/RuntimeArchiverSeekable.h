@@ -0,0 +1,113 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RuntimeArchiverBase.h"
+#include "ArchiverTar/RuntimeArchiverTar.h"
+#include "UObject/StrongObjectPtr.h"
+#include "RuntimeArchiverSeekable.generated.h"
+
+class FRuntimeArchiverSeekableStream;
+
+/**
+ * Seekable archiver class. Works with seekable tar (tar.rsk) archives
+ * Archiving of data occurs through the Tar archiver, with the tar data compressed into independent LZ4 frames of a fixed size, followed by a frame index and a file table
+ * Entries are listed from the file table without decompressing anything, and extracting an entry or a byte range of it decompresses the frames at its location instead of everything before it
+ */
+UCLASS(BlueprintType, Category = "Runtime Archiver")
+class RUNTIMEARCHIVER_API URuntimeArchiverSeekable : public URuntimeArchiverBase
+{
+	GENERATED_BODY()
+
+public:
+	URuntimeArchiverSeekable();
+
+	//~ Begin URuntimeArchiverBase Interface
+	virtual bool CreateArchiveInStorage(FString ArchivePath) override;
+	virtual bool CreateArchiveInMemory(int32 InitialAllocationSize = 0) override;
+
+	virtual bool OpenArchiveFromStorage(FString ArchivePath) override;
+	virtual bool OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData) override;
+	using URuntimeArchiverBase::OpenArchiveFromMemory;
+
+	virtual bool CloseArchive() override;
+
+	virtual bool GetArchiveData(TArray64<uint8>& ArchiveData) override;
+	virtual bool MoveArchiveData(TArray64<uint8>& ArchiveData) override;
+
+	virtual bool GetArchiveEntries(int32& NumOfArchiveEntries) override;
+
+	virtual bool GetArchiveEntryInfoByName(FString EntryName, FRuntimeArchiveEntry& EntryInfo) override;
+	virtual bool GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeArchiveEntry& EntryInfo) override;
+
+	virtual bool AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
+
+	virtual bool ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData) override;
+
+	virtual bool Initialize() override;
+	virtual bool IsInitialized() const override;
+	virtual void Reset() override;
+
+	virtual void ReportError(ERuntimeArchiverErrorCode ErrorCode, const FString& ErrorString) const override;
+
+protected:
+	virtual bool ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed) override;
+	virtual bool TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress) override;
+	//~ End URuntimeArchiverBase Interface
+
+public:
+	/**
+	 * Extract a byte range of the entry into memory. Only the frames at the range location are decompressed
+	 *
+	 * @param EntryInfo Information about the entry
+	 * @param Offset Offset of the range within the entry data
+	 * @param Size Size of the range
+	 * @param UnarchivedData Unarchived range data
+	 * @return Whether the operation was successful or not
+	 */
+	bool ExtractEntryRangeToMemory(const FRuntimeArchiveEntry& EntryInfo, int64 Offset, int64 Size, TArray64<uint8>& UnarchivedData);
+
+	/**
+	 * Decompress all frames in parallel and check them against their checksums
+	 *
+	 * @param FirstCorruptedFrame Index of the first corrupted frame, or -1 if all frames are intact
+	 * @return Whether all frames are intact or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Verify")
+	bool VerifyArchive(int32& FirstCorruptedFrame);
+
+	/** The maximum number of threads used to compress or decompress frames in parallel. 0 uses the number of logical cores, 1 disables parallel processing. Applied when creating or opening an archive */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver")
+	int32 MaxFrameWorkers;
+
+private:
+	/**
+	 * Open the tar archiver from the seekable stream, using the file table as the entry index
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool OpenSeekableStream();
+
+	/**
+	 * Write the end of the tar archive, the frame index and the file table. Nothing can be added afterwards
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool FinishArchive();
+
+	/** Tar archiver used for internal operations */
+	TStrongObjectPtr<URuntimeArchiverTar> TarArchiver;
+
+	/** Stream containing the frames */
+	TUniquePtr<FRuntimeArchiverBaseStream> CompressedStream;
+
+	/** Stream compressing or decompressing the tar data frame by frame. Owned by the tar archiver */
+	FRuntimeArchiverSeekableStream* SeekableStream;
+
+	/** Entries read from the file table */
+	TArray<FRuntimeArchiverTarIndexedEntry> FileTableEntries;
+
+	/** File table entry indices by entry name. If the name occurs more than once, the first entry is used */
+	TMap<FString, int32, FDefaultSetAllocator, FRuntimeArchiverTarEntryNameKeyFuncs> FileTableIndicesByName;
+};
@@ -11,6 +11,18 @@
 struct FTarHeader;
 class FRuntimeArchiverTarEncapsulator;
 
+/**
+ * Entry of a tar archive index kept outside of the archive, so that the archive can be opened without scanning its headers
+ */
+struct FRuntimeArchiverTarIndexedEntry
+{
+	/** Information about the entry */
+	FRuntimeArchiveEntry Entry;
+
+	/** Offset of the entry header in the tar data */
+	int64 HeaderOffset;
+};
+
 /**
  * Tar archiver class. Works with tar archives. Inspired by Microtar
  */
@@ -26,17 +38,19 @@ public:
 
 	virtual bool OpenArchiveFromStorage(FString ArchivePath) override;
 	virtual bool OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData) override;
+	using URuntimeArchiverBase::OpenArchiveFromMemory;
 
 	virtual bool CloseArchive() override;
 
 	virtual bool GetArchiveData(TArray64<uint8>& ArchiveData) override;
+	virtual bool MoveArchiveData(TArray64<uint8>& ArchiveData) override;
 
 	virtual bool GetArchiveEntries(int32& NumOfArchiveEntries) override;
 
 	virtual bool GetArchiveEntryInfoByName(FString EntryName, FRuntimeArchiveEntry& EntryInfo) override;
 	virtual bool GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeArchiveEntry& EntryInfo) override;
 
-	virtual bool AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
+	virtual bool AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
 
 	virtual bool ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData) override;
 
@@ -45,15 +59,104 @@ public:
 	virtual void Reset() override;
 
 	virtual void ReportError(ERuntimeArchiverErrorCode ErrorCode, const FString& ErrorString) const override;
+
+protected:
+	virtual bool ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed) override;
+	virtual bool TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress) override;
+	virtual bool ExtractEntriesToStorage_Directory_Internal(const FString& BaseName, const FString& DirectoryPath, const FString& BaseDirectoryPathToExclude, bool bForceOverwrite, TArray<FString>& FilePaths) override;
 	//~ End URuntimeArchiverBase Interface
 
+public:
+	/**
+	 * Create an archive writing to an already opened stream, such as a compressing one
+	 *
+	 * @param Stream Stream to write the tar archive to
+	 * @return Whether the operation was successful or not
+	 */
+	bool CreateArchiveInStream(TUniquePtr<FRuntimeArchiverBaseStream>&& Stream);
+
+	/**
+	 * Open an archive for reading from an already opened stream, such as a decompressing one
+	 *
+	 * @param Stream Stream to read the tar archive from
+	 * @param Index Index of all entries if stored outside of the archive. Avoids scanning the archive headers, which requires reading the whole stream
+	 * @return Whether the operation was successful or not
+	 */
+	bool OpenArchiveFromStream(TUniquePtr<FRuntimeArchiverBaseStream>&& Stream, const TArray<FRuntimeArchiverTarIndexedEntry>* Index = nullptr);
+
+	/**
+	 * Extract a byte range of the entry into memory without reading the rest of the entry
+	 *
+	 * @param EntryInfo Information about the entry
+	 * @param Offset Offset of the range within the entry data
+	 * @param Size Size of the range
+	 * @param UnarchivedData Unarchived range data
+	 * @return Whether the operation was successful or not
+	 */
+	bool ExtractEntryRangeToMemory(const FRuntimeArchiveEntry& EntryInfo, int64 Offset, int64 Size, TArray64<uint8>& UnarchivedData);
+
+	/**
+	 * Write the end of the archive without closing it. Nothing can be added afterwards
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool FinalizeArchive();
+
 private:
+	/**
+	 * Find the header of the specified entry and move the read position to it
+	 *
+	 * @param EntryInfo Information about the entry
+	 * @param Header Found header
+	 * @return Whether the header was found or not
+	 */
+	bool FindEntryHeader(const FRuntimeArchiveEntry& EntryInfo, FTarHeader& Header);
+
 	/** Tar encapsulator */
 	TUniquePtr<FRuntimeArchiverTarEncapsulator> TarEncapsulator;
+
+	/** Archivers wrapping the tar archiver forward file extraction to it */
+	friend class URuntimeArchiverGZip;
+	friend class URuntimeArchiverLZ4;
+	friend class URuntimeArchiverOodle;
+	friend class URuntimeArchiverSeekable;
+};
+
+/**
+ * Location of a tar entry within the archive stream
+ */
+struct FRuntimeArchiverTarEntryLocation
+{
+	/** Offset of the entry header */
+	int64 HeaderOffset;
+
+	/** Offset of the entry data, right after the header */
+	int64 DataOffset;
+
+	/** Size of the entry data in bytes */
+	int64 Size;
+};
+
+/**
+ * Key functions for looking up tar entries by name. Tar entry names are case-sensitive, unlike the default FString keys
+ */
+struct FRuntimeArchiverTarEntryNameKeyFuncs : TDefaultMapKeyFuncs<FString, int32, false>
+{
+	static FORCEINLINE bool Matches(const FString& A, const FString& B)
+	{
+		return A.Equals(B, ESearchCase::CaseSensitive);
+	}
+
+	static FORCEINLINE uint32 GetKeyHash(const FString& Key)
+	{
+		return FCrc::StrCrc32(*Key);
+	}
 };
 
 /**
  * Encapsulator between archiver and stream that implements intermediate operations
+ * Keeps an index of the entries, extended on demand when reading and updated as headers are written, so that lookups do not have to scan the archive
+ * The index is extended by reading the headers in archive order, which avoids decompressing a compressed archive up front
  */
 class FRuntimeArchiverTarEncapsulator
 {
@@ -94,6 +197,25 @@ public:
 	 */
 	bool OpenMemory(const TArray64<uint8>& ArchiveData, int32 InitialAllocationSize, bool bWrite);
 
+	/**
+	 * Open a tar archive from an already opened stream for reading or writing, depending on the stream
+	 *
+	 * @param InStream Stream to read the tar archive from or write it to
+	 * @param Index Index of all entries to use instead of scanning the headers when reading
+	 * @return Whether the archive was successfully opened or not
+	 */
+	bool OpenStream(TUniquePtr<FRuntimeArchiverBaseStream>&& InStream, const TArray<FRuntimeArchiverTarIndexedEntry>* Index = nullptr);
+
+	/**
+	 * Set whether to keep information about every written entry, so that the index can be stored outside of the archive
+	 */
+	void SetRecordIndexedEntries(bool bInRecordIndexedEntries) { bRecordIndexedEntries = bInRecordIndexedEntries; }
+
+	/**
+	 * Get information about every entry written since recording was enabled
+	 */
+	const TArray<FRuntimeArchiverTarIndexedEntry>& GetIndexedEntries() const { return IndexedEntries; }
+
 	/**
 	 * Find header from the tar archive. Optionally updates the reading position of the found header. Works similar to the std::find_if algorithm
 	 *
@@ -105,6 +227,56 @@ public:
 	 */
 	bool FindIf(TFunctionRef<bool(const FTarHeader&, int32)> ComparePredicate, FTarHeader& Header, int32& Index, bool bRemainPosition);
 
+	/**
+	 * Find header from the tar archive by the entry name using the entry index. Optionally updates the reading position of the found header
+	 *
+	 * @param EntryName Entry name to look for. The comparison is case-sensitive
+	 * @param Header Found header
+	 * @param Index Found entry index
+	 * @param bRemainPosition Whether to keep the previous read/write position, or update
+	 * @return Whether the header was found or not
+	 */
+	bool FindByName(const FString& EntryName, FTarHeader& Header, int32& Index, bool bRemainPosition);
+
+	/**
+	 * Check if the tar archive contains an entry with the specified name using the entry index. Headers are only read if the name has not been indexed yet
+	 *
+	 * @param EntryName Entry name to look for. The comparison is case-sensitive
+	 * @return Whether the entry exists or not
+	 */
+	bool Contains(const FString& EntryName);
+
+	/**
+	 * Find header from the tar archive by the entry index. Optionally updates the reading position of the found header
+	 *
+	 * @param Index Entry index
+	 * @param Header Found header
+	 * @param bRemainPosition Whether to keep the previous read/write position, or update
+	 * @return Whether the header was found or not
+	 */
+	bool FindByIndex(int32 Index, FTarHeader& Header, bool bRemainPosition);
+
+	/**
+	 * Get the location of the entry within the archive stream, extending the index up to the entry if needed
+	 *
+	 * @param Index Entry index
+	 * @return The entry location, or nullptr if there is no entry at the specified index
+	 */
+	const FRuntimeArchiverTarEntryLocation* GetEntryLocation(int32 Index);
+
+	/**
+	 * Make sure that the index holds the specified number of entries, reading the following headers if needed. The read position is kept
+	 *
+	 * @param NumOfEntries Number of entries to index. Use MAX_int32 to index the whole archive
+	 * @return Whether the archive has at least this many entries
+	 */
+	bool IndexEntries(int32 NumOfEntries);
+
+	/**
+	 * Check whether the archive data should be read in order, because seeking backwards is expensive (e.g. compressed streams)
+	 */
+	bool IsSequential() const;
+
 	/**
 	 * Get the number of tar archive entries
 	 *
@@ -121,6 +293,24 @@ public:
 	 */
 	bool GetArchiveData(TArray64<uint8>& ArchiveData);
 
+	/**
+	 * Move tar archive data out of the in-memory stream without copying it. The stream is no longer usable afterwards
+	 *
+	 * @param ArchiveData Binary archive data
+	 * @return Whether the operation was successful or not
+	 */
+	bool MoveArchiveData(TArray64<uint8>& ArchiveData);
+
+	/**
+	 * Test every entry of the archive opened for reading. The header checksums and data ranges are verified in parallel if the stream provides direct access to its data
+	 * Otherwise (e.g. compressed streams), the headers and the entry data are read in a single pass, which verifies that it decompresses. The read position is reset afterwards
+	 *
+	 * @param TestResult Test result to fill in. Offsets are within the tar data
+	 * @param OnProgress Called with the percentage of the operation completed. May be called from any thread
+	 * @return Whether the archive is intact or not
+	 */
+	bool TestEntries(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress);
+
 	/**
 	 * Reset read/write position
 	 * 
@@ -151,6 +341,23 @@ public:
 	 */
 	bool ReadData(TArray64<uint8>& UnarchivedData);
 
+	/**
+	 * Read the archived data from the current position without copying it. Only possible if the stream provides direct access to its data
+	 *
+	 * @param Size Size of the data to read
+	 * @return Pointer to the data, or nullptr if the stream does not provide direct access or reading failed
+	 */
+	const uint8* ReadDataView(int64 Size);
+
+	/**
+	 * Read a range of the archived data of the entry at the current position. The position is kept at the entry header
+	 *
+	 * @param Offset Offset of the range within the entry data
+	 * @param Data Range data. Its size determines the range size
+	 * @return Whether the operation was successful or not
+	 */
+	bool ReadDataRange(int64 Offset, TArray64<uint8>& Data);
+
 	/**
 	 * Write the header from the current position
 	 *
@@ -165,7 +372,7 @@ public:
 	 * @param DataToBeArchived Binary data to be archived. Leave it blank if it is a directory
 	 * @return Whether the operation was successful or not
 	 */
-	bool WriteData(const TArray64<uint8>& DataToBeArchived);
+	bool WriteData(TArrayView64<const uint8> DataToBeArchived);
 
 	/**
 	 * Write null bytes represented as null character '\0'
@@ -183,17 +390,56 @@ public:
 	bool Finalize();
 
 private:
+	/**
+	 * Clear the entry index. Nothing is read, the index is extended on demand when reading and updated by WriteHeader when writing
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool ResetIndex();
+
+	/**
+	 * Add the header at the specified offset to the entry index
+	 */
+	void AddToIndex(const FTarHeader& Header, int64 HeaderOffset);
+
+	/**
+	 * Add the entry with the specified name, header offset and data size to the entry index
+	 */
+	void AddToIndex(const FString& EntryName, int64 HeaderOffset, int64 Size);
+
+	/**
+	 * Seek to the beginning of the entry data and set the remaining data size, unless the entry data is already being read
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool BeginReadData();
+
 	/** Used stream */
 	TUniquePtr<FRuntimeArchiverBaseStream> Stream;
 
+	/** Locations of all entries, in the order they appear in the archive */
+	TArray<FRuntimeArchiverTarEntryLocation> EntryLocations;
+
+	/** Entry indices by entry name. If the name occurs more than once, the first entry is used */
+	TMap<FString, int32, FDefaultSetAllocator, FRuntimeArchiverTarEntryNameKeyFuncs> EntryIndicesByName;
+
+	/** Offset of the first header that has not been indexed yet */
+	int64 NextIndexedHeaderOffset;
+
+	/** Whether the index holds every entry of the archive */
+	bool bIsIndexComplete;
+
 	/** Remaining read or write data size */
 	int64 RemainingDataSize;
 
 	/** Last header position */
 	int64 LastHeaderPosition;
 
-	/** Cached number of headers for a small optimization */
-	int32 CachedNumOfHeaders;
+	/** Information about written entries, if recording is enabled */
+	TArray<FRuntimeArchiverTarIndexedEntry> IndexedEntries;
+
+	/** Whether to record information about written entries */
+	bool bRecordIndexedEntries;
 
 	/** Whether the tar archive was finalized or not */
 	bool bIsFinalized;
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "RuntimeArchiverBase.h"
+#include "Streams/RuntimeArchiverBaseStream.h"
 #include "RuntimeArchiverZip.generated.h"
 
 /**
@@ -24,6 +25,7 @@ public:
 
 	virtual bool OpenArchiveFromStorage(FString ArchivePath) override;
 	virtual bool OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData) override;
+	using URuntimeArchiverBase::OpenArchiveFromMemory;
 
 	virtual bool CloseArchive() override;
 
@@ -34,7 +36,7 @@ public:
 	virtual bool GetArchiveEntryInfoByName(FString EntryName, FRuntimeArchiveEntry& EntryInfo) override;
 	virtual bool GetArchiveEntryInfoByIndex(int32 EntryIndex, FRuntimeArchiveEntry& EntryInfo) override;
 
-	virtual bool AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
+	virtual bool AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel) override;
 
 	virtual bool ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData) override;
 
@@ -43,6 +45,13 @@ public:
 	virtual void Reset() override;
 
 	virtual void ReportError(ERuntimeArchiverErrorCode ErrorCode, const FString& ErrorString) const override;
+
+protected:
+	virtual bool ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed) override;
+	virtual bool AddEntriesFromStorage_Internal(const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int64)> OnProcessed, TFunctionRef<void(int32, TArrayView64<const uint8>)> OnEntryData) override;
+	virtual bool ExtractEntriesToStorage_Internal(const TArray<FRuntimeArchiveEntry>& EntryInfo, const TArray<FString>& FilePaths, bool bForceOverwrite, TFunctionRef<void(int64)> OnProcessed) override;
+	virtual bool GetArchiveEntriesByBaseName(const FString& BaseName, TArray<FRuntimeArchiveEntry>& EntryInfo) override;
+	virtual bool TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress) override;
 	//~ End URuntimeArchiverBase Interface
 
 public:
@@ -55,10 +64,35 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Open")
 	bool OpenArchiveFromStorageToAppend(FString ArchivePath);
 
+	/** The maximum number of threads used to compress entries in parallel when adding them from storage. 0 uses the number of logical cores, 1 disables parallel compression */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver|Add")
+	int32 MaxCompressionWorkers;
+
+	/** The maximum number of threads used to extract and test entries in parallel. 0 uses the size of the archiver thread pool (RuntimeArchiver.NumWorkerThreads), 1 disables parallel extraction */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver|Extract")
+	int32 MaxExtractionWorkers;
+
 private:
+	/**
+	 * Index the entry names of the archive opened for reading, so that looking up entries by name or by directory does not scan the central directory
+	 */
+	void BuildEntryNameIndex();
+
 	/** Whether to use append mode or not */
 	bool bAppendMode;
 
+	/** Entry indices by entry name when reading. Case-insensitive, same as miniz name lookups */
+	TMap<FString, int32> EntryIndicesByName;
+
+	/** Entry names and indices when reading, sorted case-sensitively so that the entries under any directory form a contiguous range */
+	TArray<TPair<FString, int32>> SortedEntryNames;
+
+	/** Path to the archive opened from storage for reading. Used by extraction workers to open their own readers */
+	FString ArchiveFilePath;
+
+	/** Memory mapping of the archive opened from storage for reading, if the platform supports it. Miniz reads the archive directly from it */
+	TUniquePtr<FRuntimeArchiverBaseStream> MappedArchiveStream;
+
 	/** Miniz archiver */
 	void* MinizArchiver;
 };
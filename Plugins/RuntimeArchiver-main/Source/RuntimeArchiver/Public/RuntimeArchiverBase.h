@@ -8,6 +8,9 @@
 #include "Templates/SubclassOf.h"
 #include "RuntimeArchiverBase.generated.h"
 
+class IFileHandle;
+class FRuntimeArchiverBaseStream;
+
 /**
  * The base class for the archiver. Do not create it manually!
  */
@@ -72,12 +75,21 @@ public:
 
 	/**
 	 * Open an archive from memory. Prefer to use this function if possible
+	 * Depending on the archiver, the data is either copied or read in place, so it must stay valid until the archive is closed
 	 *
 	 * @param ArchiveData Binary archive data
 	 * @return Whether the operation was successful or not
 	 */
 	virtual bool OpenArchiveFromMemory(const TArray64<uint8>& ArchiveData);
 
+	/**
+	 * Open an archive from memory, taking ownership of the data. The data is kept by the archiver until the archive is closed and read in place, without being copied
+	 *
+	 * @param ArchiveData Binary archive data. Moved into the archiver
+	 * @return Whether the operation was successful or not
+	 */
+	bool OpenArchiveFromMemory(TArray64<uint8>&& ArchiveData);
+
 	/**
 	 * Close previously created/opened archive
 	 *
@@ -103,6 +115,14 @@ public:
 	 */
 	virtual bool GetArchiveData(TArray64<uint8>& ArchiveData);
 
+	/**
+	 * Get archive data created in memory and close the archive. Archivers keeping the archive data in a memory buffer move the buffer out instead of copying it, so the peak memory usage is not doubled
+	 *
+	 * @param ArchiveData Binary archive data
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool MoveArchiveData(TArray64<uint8>& ArchiveData);
+
 	/**
 	 * Get the number of the archive entries
 	 *
@@ -154,6 +174,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Add")
 	void AddEntriesFromStorage(const FRuntimeArchiverAsyncOperationResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress, TArray<FString> FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel = ERuntimeArchiverCompressionLevel::Compression6);
 
+	/**
+	 * Add entries from storage, additionally reporting the throughput and the remaining time
+	 *
+	 * @param OnResult Delegate broadcasting the result
+	 * @param OnProgress Delegate broadcasting the progress
+	 * @param OnDetailedProgress Delegate broadcasting the progress along with the throughput and the remaining time
+	 * @param FilePaths File paths to be archived
+	 * @param CompressionLevel Compression level. The higher the level, the more compression
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Add", meta = (AutoCreateRefTerm = "OnProgress"))
+	void AddEntriesFromStorageWithDetailedProgress(const FRuntimeArchiverAsyncOperationResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress, const FRuntimeArchiverAsyncOperationDetailedProgress& OnDetailedProgress, TArray<FString> FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel = ERuntimeArchiverCompressionLevel::Compression6);
+
 	/**
 	 * Add entries from storage. Must be used for directories only
 	 *
@@ -165,6 +197,30 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Add")
 	void AddEntriesFromStorage_Directory(const FRuntimeArchiverAsyncOperationResult& OnResult, FString DirectoryPath, bool bAddParentDirectory, ERuntimeArchiverCompressionLevel CompressionLevel = ERuntimeArchiverCompressionLevel::Compression6);
 
+	/**
+	 * Add entries from storage under the specified names and in the specified order, blocking until all of them are added
+	 * Uses the same parallel compression as AddEntriesFromStorage. Meant for tools and commandlets that control the archive layout
+	 *
+	 * @param EntryNames Entry names in the archive, including their relative directories
+	 * @param FilePaths Paths to the files to be archived. Must have the same number of elements as EntryNames
+	 * @param CompressionLevel Compression level. The higher the level, the more compression
+	 * @param OnProcessed Called with the number of uncompressed bytes processed since the previous call. May be called from any thread
+	 * @return Whether the operation was successful or not
+	 */
+	bool AddNamedEntriesFromStorage(const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int64)> OnProcessed);
+
+	/**
+	 * Add entries from storage under the specified names, additionally passing the file data to the observer as it is read, e.g. to checksum the files without reading them again
+	 *
+	 * @param EntryNames Entry names in the archive, including their relative directories
+	 * @param FilePaths Paths to the files to be archived. Must have the same number of elements as EntryNames
+	 * @param CompressionLevel Compression level. The higher the level, the more compression
+	 * @param OnProcessed Called with the number of uncompressed bytes processed since the previous call. May be called from any thread
+	 * @param OnEntryData Called with the index of the entry and the next block of its file data. The blocks of an entry come in order, but different entries may be reported from different threads at once
+	 * @return Whether the operation was successful or not
+	 */
+	bool AddNamedEntriesFromStorage(const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int64)> OnProcessed, TFunctionRef<void(int32, TArrayView64<const uint8>)> OnEntryData);
+
 private:
 	/**
 	 * Internal function to recursively add entries from storage
@@ -192,11 +248,11 @@ public:
 	 * Add entry from memory. In other words, import the data in-memory into the archive. Prefer to use this function if possible
 	 *
 	 * @param EntryName Entry name. In other words, the name of the file in the archive
-	 * @param DataToBeArchived Binary data to be archived
+	 * @param DataToBeArchived Binary data to be archived. Only read during the call, so any buffer can be passed without copying it into an array
 	 * @param CompressionLevel Compression level. The higher the level, the more compression
 	 * @return Whether the operation was successful or not
 	 */
-	virtual bool AddEntryFromMemory(FString EntryName, const TArray64<uint8>& DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel = ERuntimeArchiverCompressionLevel::Compression6);
+	virtual bool AddEntryFromMemory(FString EntryName, TArrayView64<const uint8> DataToBeArchived, ERuntimeArchiverCompressionLevel CompressionLevel = ERuntimeArchiverCompressionLevel::Compression6);
 
 	/**
 	 * Extract entry to storage. In other words, extract the file from the archive to storage
@@ -221,6 +277,19 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Extract")
 	void ExtractEntriesToStorage(const FRuntimeArchiverAsyncOperationResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress, TArray<FRuntimeArchiveEntry> EntryInfo, FString DirectoryPath, bool bForceOverwrite = true);
 
+	/**
+	 * Extract entries to storage, additionally reporting the throughput and the remaining time
+	 *
+	 * @param OnResult Delegate broadcasting the result
+	 * @param OnProgress Delegate broadcasting the progress
+	 * @param OnDetailedProgress Delegate broadcasting the progress along with the throughput and the remaining time
+	 * @param EntryInfo Array of all entries to extract
+	 * @param DirectoryPath Path to the directory for exporting entries
+	 * @param bForceOverwrite Whether to force a file to be overwritten if it exists or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Extract", meta = (AutoCreateRefTerm = "OnProgress"))
+	void ExtractEntriesToStorageWithDetailedProgress(const FRuntimeArchiverAsyncOperationResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress, const FRuntimeArchiverAsyncOperationDetailedProgress& OnDetailedProgress, TArray<FRuntimeArchiveEntry> EntryInfo, FString DirectoryPath, bool bForceOverwrite = true);
+
 	/**
 	 * Extract entries to storage. Must be used for directories only
 	 *
@@ -233,6 +302,25 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Extract")
 	void ExtractEntriesToStorage_Directory(const FRuntimeArchiverAsyncOperationResult& OnResult, FString EntryName, FString DirectoryPath, bool bAddParentDirectory, bool bForceOverwrite = true);
 
+	/**
+	 * Make extracted files durable and write the completion marker into the directory. Called by ExtractEntriesToStorage and ExtractEntriesToStorage_Directory when bDurableExtraction is enabled
+	 * Can be called manually after extracting entries one by one with ExtractEntryToStorage
+	 *
+	 * @param DirectoryPath Path to the directory the entries were extracted to
+	 * @param FilePaths Paths to the extracted files and directories
+	 * @return Whether the operation was successful or not
+	 */
+	bool FinishDurableExtraction(const FString& DirectoryPath, const TArray<FString>& FilePaths);
+
+	/**
+	 * Check whether a durable extraction into the directory has been completed, i.e. whether its completion marker exists
+	 *
+	 * @param DirectoryPath Path to the directory the entries were extracted to
+	 * @return Whether the extraction has been completed or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Extract")
+	bool IsExtractionComplete(FString DirectoryPath) const;
+
 	/**
 	 * Extract entry into memory. In other words, extract the file from the archive into memory
 	 *
@@ -252,6 +340,86 @@ public:
 	 */
 	virtual bool ExtractEntryToMemory(const FRuntimeArchiveEntry& EntryInfo, TArray64<uint8>& UnarchivedData);
 
+	/**
+	 * Test the integrity of every entry of the opened archive without extracting anything. Allows detecting corrupted downloads before a long extraction
+	 * The test stops at the first corrupted entry, which is reported along with its offset so that the damaged range can be fetched again
+	 *
+	 * @param OnResult Delegate broadcasting the test result
+	 * @param OnProgress Delegate broadcasting the progress
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Test")
+	void TestArchive(const FRuntimeArchiverAsyncTestResult& OnResult, const FRuntimeArchiverAsyncOperationProgress& OnProgress);
+
+	/**
+	 * Test the integrity of every entry of the opened archive without extracting anything. Blocks until the test is finished
+	 *
+	 * @param TestResult Test result, including the first corrupted entry if any
+	 * @return Whether the archive is intact or not
+	 */
+	bool TestArchive(FRuntimeArchiverTestResult& TestResult);
+
+	/**
+	 * Get the compression level to add an entry with. Entries that are unlikely to compress, such as already compressed media and packages, are stored as is (Compression0) instead of spending time compressing them
+	 * The entry is sampled in a few blocks spread over its data, and the decision is made by ShouldStoreEntry
+	 *
+	 * @param EntryName Entry name
+	 * @param Data Entry data
+	 * @param Size Entry size
+	 * @param CompressionLevel Requested compression level
+	 * @return The requested compression level, or Compression0 if the entry should be stored as is
+	 */
+	ERuntimeArchiverCompressionLevel GetEntryCompressionLevel(const FString& EntryName, const uint8* Data, int64 Size, ERuntimeArchiverCompressionLevel CompressionLevel) const;
+
+	/**
+	 * Get the compression level to add an entry streamed from a file with. The samples are read from the file, so the position of the file handle is not preserved
+	 *
+	 * @param EntryName Entry name
+	 * @param FileHandle File containing the entry data
+	 * @param Size Entry size
+	 * @param CompressionLevel Requested compression level
+	 * @return The requested compression level, or Compression0 if the entry should be stored as is
+	 */
+	ERuntimeArchiverCompressionLevel GetEntryCompressionLevel(const FString& EntryName, IFileHandle& FileHandle, int64 Size, ERuntimeArchiverCompressionLevel CompressionLevel) const;
+
+	/**
+	 * Estimate the Shannon entropy of the data from its byte histogram
+	 *
+	 * @param Data Data to estimate the entropy of
+	 * @return Entropy in bits per byte, from 0 (a single repeated byte) to 8 (random or compressed data)
+	 */
+	static float EstimateEntropy(TArrayView64<const uint8> Data);
+
+	/** Whether to sample entries being added and store those unlikely to compress as is. Only affects archivers compressing each entry separately (zip, tar.lz4, tar.ood and seekable tar) */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver|Add")
+	bool bStoreIncompressibleEntries;
+
+	/** Extensions (without the dot, case-insensitive) of entries that are always stored as is, as their content is already compressed */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver|Add")
+	TArray<FString> IncompressibleExtensions;
+
+	/** Entries smaller than this size in bytes are compressed without sampling, as compressing them is cheap anyway */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver|Add")
+	int64 MinSampledEntrySize;
+
+	/** Entropy in bits per byte above which sampled entries are stored as is. Compressed data is close to 8 */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver|Add")
+	float IncompressibleEntropyThreshold;
+
+	/**
+	 * Whether ExtractEntriesToStorage and ExtractEntriesToStorage_Directory make the extracted files durable. Files are written without syncing, then synced all together once every entry is written, and the completion marker is written last
+	 * After a power loss, the presence of the completion marker guarantees that all files are intact on the storage device
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver|Extract")
+	bool bDurableExtraction;
+
+	/** Name of the completion marker file written into the destination directory by a durable extraction. Leave empty to only sync the files */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver|Extract")
+	FString ExtractionCompletionMarkerName;
+
+	/** Minimum time in seconds between two progress reports of AddEntriesFromStorage and ExtractEntriesToStorage. Progress is computed from the processed bytes, so it moves smoothly regardless of the entry sizes */
+	UPROPERTY(BlueprintReadWrite, Category = "Runtime Archiver")
+	float ProgressReportInterval;
+
 	/**
 	 * Initialize the archiver
 	 */
@@ -268,6 +436,126 @@ public:
 	virtual void Reset();
 
 protected:
+	/**
+	 * Write the file entry to storage. Called by ExtractEntryToStorage after the path and overwrite checks have passed
+	 * By default, the entry is extracted into memory and then saved to the file. Archivers able to decompress incrementally should override this to keep memory usage bounded
+	 *
+	 * @param EntryInfo Information about the entry. Must not be a directory
+	 * @param FilePath Normalized path to the file to extract to
+	 * @param OnProcessed Called with the number of uncompressed bytes written since the previous call. Archivers extracting incrementally call it per chunk
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool ExtractFileEntryToStorage(const FRuntimeArchiveEntry& EntryInfo, const FString& FilePath, TFunctionRef<void(int64)> OnProcessed);
+
+	/**
+	 * Extract entry to storage, reporting the written bytes. Used by ExtractEntryToStorage and ExtractEntriesToStorage_Internal
+	 *
+	 * @param EntryInfo Information about the entry
+	 * @param FilePath Path to the file to extract to
+	 * @param bForceOverwrite Whether to force a file to be overwritten if it exists or not
+	 * @param OnProcessed Called with the number of uncompressed bytes written since the previous call
+	 * @return Whether the operation was successful or not
+	 */
+	bool ExtractEntryToStorage_Internal(const FRuntimeArchiveEntry& EntryInfo, FString FilePath, bool bForceOverwrite, TFunctionRef<void(int64)> OnProcessed);
+
+	/**
+	 * Add the specified files to the archive. Called on a background thread by AddEntriesFromStorage and AddEntriesFromStorage_Directory
+	 * By default, the files are added one after another. Archivers able to compress several entries at once may override this
+	 *
+	 * @param EntryNames Entry names in the archive
+	 * @param FilePaths Paths to the files to be archived. Must have the same number of elements as EntryNames
+	 * @param CompressionLevel Compression level. The higher the level, the more compression
+	 * @param OnProcessed Called with the number of uncompressed bytes processed since the previous call. May be called from any thread
+	 * @param OnEntryData Called with the index of the entry and the next block of its file data, in order for each entry. May be called from any thread
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool AddEntriesFromStorage_Internal(const TArray<FString>& EntryNames, const TArray<FString>& FilePaths, ERuntimeArchiverCompressionLevel CompressionLevel, TFunctionRef<void(int64)> OnProcessed, TFunctionRef<void(int32, TArrayView64<const uint8>)> OnEntryData);
+
+	/**
+	 * Extract the specified entries to storage. Called on a background thread by ExtractEntriesToStorage and ExtractEntriesToStorage_Directory
+	 * By default, the entries are extracted one after another. Archivers able to decompress several entries at once may override this
+	 *
+	 * @param EntryInfo Entries to extract
+	 * @param FilePaths Paths to extract the entries to. Must have the same number of elements as EntryInfo
+	 * @param bForceOverwrite Whether to force a file to be overwritten if it exists or not
+	 * @param OnProcessed Called with the number of uncompressed bytes processed since the previous call. May be called from any thread
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool ExtractEntriesToStorage_Internal(const TArray<FRuntimeArchiveEntry>& EntryInfo, const TArray<FString>& FilePaths, bool bForceOverwrite, TFunctionRef<void(int64)> OnProcessed);
+
+	/**
+	 * Test the integrity of every entry of the archive opened for reading. Called by TestArchive, possibly on a background thread
+	 * By default, the entries are extracted into memory one after another. Archivers able to verify entries without extracting them, or several at once, should override this
+	 *
+	 * @param TestResult Test result to fill in
+	 * @param OnProgress Called with the percentage of the operation completed. May be called from any thread
+	 * @return Whether the archive is intact or not
+	 */
+	virtual bool TestArchive_Internal(FRuntimeArchiverTestResult& TestResult, TFunctionRef<void(int32)> OnProgress);
+
+	/**
+	 * Get all entries belonging to the specified directory. Called on a background thread by ExtractEntriesToStorage_Directory
+	 * By default, every entry of the archive is checked. Archivers indexing the entry names may override this
+	 *
+	 * @param BaseName Directory entry name without the trailing slash. Leave empty to get all entries
+	 * @param EntryInfo Found entries, in the order of their indices
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool GetArchiveEntriesByBaseName(const FString& BaseName, TArray<FRuntimeArchiveEntry>& EntryInfo);
+
+	/**
+	 * Extract all entries belonging to the specified directory. Called on a background thread by ExtractEntriesToStorage_Directory
+	 * By default, the entries are found by GetArchiveEntriesByBaseName and extracted by ExtractEntriesToStorage_Internal afterwards. Archivers that can only be read in order efficiently may override this to do both in a single pass
+	 *
+	 * @param BaseName Directory entry name without the trailing slash. Leave empty to extract all entries
+	 * @param DirectoryPath Path to the directory for exporting entries
+	 * @param BaseDirectoryPathToExclude The part of the entry names to be excluded from the file paths
+	 * @param bForceOverwrite Whether to force a file to be overwritten if it exists or not
+	 * @param FilePaths Paths of the extracted entries
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool ExtractEntriesToStorage_Directory_Internal(const FString& BaseName, const FString& DirectoryPath, const FString& BaseDirectoryPathToExclude, bool bForceOverwrite, TArray<FString>& FilePaths);
+
+	/**
+	 * Check whether the entry name belongs to the base name. For example, the entry name "SubFolder/File.txt" belongs to the base name "SubFolder", but the entry name "SubFolderNew/File.txt" does not belong to the base name "SubFolder"
+	 */
+	static bool CheckEntryNameBelongsToBaseName(const FString& BaseName, const FString& EntryName);
+
+	/**
+	 * Decide whether an entry should be stored as is instead of being compressed. Called by GetEntryCompressionLevel, possibly from multiple threads at once
+	 * By default, entries with one of IncompressibleExtensions are stored, as well as entries whose samples have an entropy above IncompressibleEntropyThreshold. Override to change the heuristics
+	 *
+	 * @param EntryName Entry name
+	 * @param Size Entry size
+	 * @param Samples Blocks sampled evenly over the entry data, or the whole data for small entries
+	 * @return Whether the entry should be stored as is or not
+	 */
+	virtual bool ShouldStoreEntry(const FString& EntryName, int64 Size, TArrayView64<const uint8> Samples) const;
+
+	/**
+	 * Create a stream reading the archive data opened from memory. Data owned by the archiver is read in place, any other data is copied into the stream
+	 *
+	 * @param ArchiveData Binary archive data passed to OpenArchiveFromMemory
+	 * @return The created stream
+	 */
+	FRuntimeArchiverBaseStream* CreateMemoryReadStream(const TArray64<uint8>& ArchiveData) const;
+
+	/**
+	 * Remove the completion marker from the directory before extracting into it, so that an interrupted extraction is not mistaken for a complete one
+	 *
+	 * @param DirectoryPath Path to the directory the entries are going to be extracted to
+	 * @return Whether the operation was successful or not
+	 */
+	bool BeginDurableExtraction(const FString& DirectoryPath) const;
+
+	/**
+	 * Get the path to the completion marker of the directory
+	 *
+	 * @param DirectoryPath Normalized path to the directory the entries are extracted to
+	 * @return The path to the completion marker, or an empty string if no marker is used
+	 */
+	FString GetExtractionCompletionMarkerPath(const FString& DirectoryPath) const;
+
 	/**
 	 * Report an error in the archiver
 	 *
@@ -281,4 +569,7 @@ protected:
 
 	/** Archive location */
 	ERuntimeArchiverLocation Location;
+
+	/** Archive data moved into the archiver by OpenArchiveFromMemory. Kept until the archiver is reset */
+	TArray64<uint8> OwnedArchiveData;
 };
@@ -115,11 +115,94 @@ struct FRuntimeArchiveEntry
 	}
 };
 
+/** Result of testing the integrity of an archive */
+USTRUCT(BlueprintType, Category = "Runtime Archiver")
+struct FRuntimeArchiverTestResult
+{
+	GENERATED_BODY()
+
+	/** Whether all tested entries are intact or not */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	bool bIsValid;
+
+	/** Number of entries tested before the test was finished */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	int32 NumOfTestedEntries;
+
+	/** Index of the first corrupted entry. INDEX_NONE if the archive is intact or the corruption is not related to a specific entry (e.g. the archive is truncated) */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	int32 BadEntryIndex;
+
+	/** Name of the first corrupted entry, if it can be read */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	FString BadEntryName;
+
+	/** Offset of the corrupted data: the local header of the zip entry, or the header of the tar entry within the uncompressed tar data. -1 if unknown */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	int64 BadEntryOffset;
+
+	/** Description of the detected corruption */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	FString ErrorDescription;
+
+	/** Default constructor */
+	FRuntimeArchiverTestResult()
+		: bIsValid(false)
+	  , NumOfTestedEntries(0)
+	  , BadEntryIndex(INDEX_NONE)
+	  , BadEntryOffset(-1)
+	{
+	}
+};
+
+/** Progress of an asynchronous archive operation, based on the number of uncompressed bytes processed */
+USTRUCT(BlueprintType, Category = "Runtime Archiver")
+struct FRuntimeArchiverProgress
+{
+	GENERATED_BODY()
+
+	/** Percentage of the operation completed, from 0 to 100 */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	float Percentage;
+
+	/** Number of uncompressed bytes processed so far */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	int64 ProcessedBytes;
+
+	/** Total number of uncompressed bytes to process */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	int64 TotalBytes;
+
+	/** Current throughput in megabytes per second, smoothed over the recent reports */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	float MegabytesPerSecond;
+
+	/** Estimated remaining time in seconds. -1 if it cannot be estimated yet */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Archiver")
+	float RemainingSeconds;
+
+	/** Default constructor */
+	FRuntimeArchiverProgress()
+		: Percentage(0)
+	  , ProcessedBytes(0)
+	  , TotalBytes(0)
+	  , MegabytesPerSecond(0)
+	  , RemainingSeconds(-1)
+	{
+	}
+};
+
+/** Delegate broadcasting the result of asynchronous archive tests */
+DECLARE_DYNAMIC_DELEGATE_OneParam(FRuntimeArchiverAsyncTestResult, const FRuntimeArchiverTestResult&, TestResult);
+
 /** Delegate broadcasting the result of asynchronous archive operations */
 DECLARE_DYNAMIC_DELEGATE_OneParam(FRuntimeArchiverAsyncOperationResult, bool, bSuccess);
 
 /** Delegate broadcasting the progress of asynchronous archive operations */
 DECLARE_DYNAMIC_DELEGATE_OneParam(FRuntimeArchiverAsyncOperationProgress, int32, Percentage);
 
+/** Delegate broadcasting the detailed progress of asynchronous archive operations, including the throughput and the remaining time */
+DECLARE_DYNAMIC_DELEGATE_OneParam(FRuntimeArchiverAsyncOperationDetailedProgress, const FRuntimeArchiverProgress&, Progress);
+
 /** Dynamic delegate broadcasting the result of asynchronous archive actions */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FRuntimeArchiverAsyncActionResult, int32, Percentage);
@@ -24,4 +24,24 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Runtime Archiver|Utilities")
 	static TArray<FString> ParseDirectories(const FString& FilePath);
+
+	/**
+	 * Flush the written files to the storage device, so that they survive a power loss. Meant to be called once after writing many files without syncing each of them
+	 * The files are synced in parallel or, on Linux, with a single syncfs call per file system when there are many of them. The directories containing the files are synced as well, up to and including the root directory
+	 *
+	 * @param RootDirectory Directory the files were written into
+	 * @param FilePaths Paths to the written files. Paths to directories are allowed
+	 * @return Whether everything was synced or not
+	 */
+	static bool SyncFilesToStorage(const FString& RootDirectory, const TArray<FString>& FilePaths);
+
+	/**
+	 * Save the string to a file so that the file either has the whole content or does not exist, even after a power loss
+	 * The content is written to a temporary file, synced and then renamed to the file path
+	 *
+	 * @param FilePath Path to the file to save to
+	 * @param Content Content of the file
+	 * @return Whether the file was saved or not
+	 */
+	static bool SaveStringToFileAtomically(const FString& FilePath, const FString& Content);
 };
@@ -90,6 +90,48 @@ public:
 		return 0;
 	}
 
+	/**
+	 * Check whether seeking backwards is expensive, such as in decompressing streams, so the data should be read in order
+	 */
+	virtual bool IsSequential() const
+	{
+		return false;
+	}
+
+	/**
+	 * Get how much of the data has been read so far, from 0 to 1. Decompressing streams report it for the compressed data, since the uncompressed size is not known up front
+	 */
+	virtual float GetReadProgress()
+	{
+		const int64 TotalSize = Size();
+		return TotalSize > 0 ? FMath::Clamp(static_cast<float>(static_cast<double>(Position) / TotalSize), 0.f, 1.f) : 1.f;
+	}
+
+	/**
+	 * Get direct read-only access to the archived data, which allows reading it without copying. Only available if the data is addressable in memory, such as in memory or memory-mapped streams
+	 * The pointer remains valid until the stream is written to or destroyed. The current position is not changed
+	 *
+	 * @param Offset Offset of the data
+	 * @param Size Data size
+	 * @return Pointer to the data, or nullptr if the stream does not provide direct access or the range is out of bounds
+	 */
+	virtual const uint8* GetReadView(int64 Offset, int64 Size)
+	{
+		return nullptr;
+	}
+
+	/**
+	 * Move the written data out of the stream, which avoids copying it. Only available for in-memory streams
+	 * The stream is left empty and should not be used afterwards
+	 *
+	 * @param OutData Data moved out of the stream
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool MoveData(TArray64<uint8>& OutData)
+	{
+		return false;
+	}
+
 protected:
 	/** Current read or write position */
 	int64 Position;
@@ -0,0 +1,266 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "RuntimeArchiverBaseStream.h"
+#include "RuntimeArchiverTypes.h"
+
+/**
+ * Location and size of a single independently compressed block
+ */
+struct FRuntimeArchiverBlockInfo
+{
+	/** Offset of the block payload in the compressed stream */
+	int64 CompressedOffset;
+
+	/** Size of the block payload in the compressed stream */
+	int64 CompressedSize;
+
+	/** Offset of the block data in the uncompressed data. Only valid once the sizes of all previous blocks are known */
+	int64 UncompressedOffset;
+
+	/** Size of the block data when uncompressed, or -1 if the format does not store it. Unknown sizes are filled in once the block is decompressed */
+	int64 UncompressedSize;
+
+	/** Whether the payload is compressed or stored as is */
+	bool bCompressed;
+
+	/** CRC32 of the uncompressed block data. Only used by formats storing block checksums */
+	uint32 Checksum;
+};
+
+/**
+ * Base stream for formats that split the data into independently compressed blocks. Do not create it directly
+ * Writing compresses full blocks in parallel and appends them in order. Reading decompresses consecutive blocks in parallel into a window, so memory usage only depends on the block size and the number of workers
+ * If the format does not store the uncompressed block sizes, the data can only be reached in order up to the first block that has not been decompressed yet, and the size is an estimate until then
+ * The compressed stream is not owned and must outlive this stream. Its position is set before every access, so it can be shared
+ */
+class RUNTIMEARCHIVER_API FRuntimeArchiverBlockStream : public FRuntimeArchiverBaseStream
+{
+protected:
+	/**
+	 * Base constructor. Derived classes must call Initialize once constructed
+	 *
+	 * @param InCompressedStream Stream to read the compressed data from or write it to
+	 * @param bWrite Whether to compress data written to the stream or to decompress data read from it
+	 * @param InBlockSize Size of the uncompressed data in each block. Only used for writing
+	 * @param MaxWorkers The maximum number of threads used to process blocks in parallel. 0 uses the number of logical cores
+	 */
+	FRuntimeArchiverBlockStream(FRuntimeArchiverBaseStream& InCompressedStream, bool bWrite, int64 InBlockSize, int32 MaxWorkers);
+
+public:
+	/** It should be impossible to create this object by the default constructor */
+	FRuntimeArchiverBlockStream() = delete;
+
+	virtual ~FRuntimeArchiverBlockStream() override;
+
+	//~ Begin FRuntimeArchiverBaseStream Interface
+	virtual bool IsValid() const override;
+	virtual bool Read(void* Data, int64 Size) override;
+	virtual bool Write(const void* Data, int64 Size) override;
+	virtual bool Seek(int64 NewPosition) override;
+	virtual int64 Size() override;
+	virtual bool IsSequential() const override;
+	//~ End FRuntimeArchiverBaseStream Interface
+
+	/**
+	 * Compress the remaining data and write the end of the compressed data. Nothing can be written afterwards
+	 * Called automatically on destruction of the derived streams, but calling it explicitly allows handling errors
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool Finish();
+
+	/**
+	 * Decompress all blocks in parallel to check that they are intact, including their checksums if the format stores them. The read position is not changed
+	 *
+	 * @param FirstCorruptedBlock Index of the first block that could not be read or decompressed, or INDEX_NONE
+	 * @return Whether all blocks are intact or not
+	 */
+	bool Verify(int32& FirstCorruptedBlock);
+
+	/**
+	 * Get all blocks of the compressed data, in the order of the uncompressed data
+	 */
+	const TArray<FRuntimeArchiverBlockInfo>& GetBlocks() const { return Blocks; }
+
+	/**
+	 * Set the compression level used for the data written from now on. Compression0 stores the blocks as is
+	 * Full blocks buffered with a different level are compressed first, so only the block in progress is affected by both levels
+	 */
+	void SetCompressionLevel(ERuntimeArchiverCompressionLevel InCompressionLevel);
+
+	/**
+	 * Create a block stream of the specified format
+	 *
+	 * @param Format Format of the blocks. Only LZ4 and Oodle (UE 5.0 and newer) are split into blocks
+	 * @param CompressedStream Stream to read the blocks from or write them to. Must outlive the created stream
+	 * @param bWrite Whether to compress data written to the stream or to decompress data read from it
+	 * @param MaxWorkers The maximum number of threads used to process blocks in parallel. 0 uses the number of logical cores
+	 * @return The created stream, or nullptr if the format cannot be split into blocks
+	 */
+	static FRuntimeArchiverBlockStream* Create(ERuntimeArchiverRawFormat Format, FRuntimeArchiverBaseStream& CompressedStream, bool bWrite, int32 MaxWorkers);
+
+	/**
+	 * Check if the compressed data of the specified format is split into blocks rather than compressed as a whole
+	 */
+	static bool IsBlockFormat(ERuntimeArchiverRawFormat Format, FRuntimeArchiverBaseStream& CompressedStream);
+
+protected:
+	/**
+	 * Write the stream header when writing, or read the block table when reading. Must be called by the derived constructors
+	 */
+	void Initialize();
+
+	/**
+	 * Write the beginning of the compressed data
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool WriteStreamHeader();
+
+	/**
+	 * Write the end of the compressed data once all blocks are written
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool WriteStreamFooter();
+
+	/**
+	 * Write a compressed block. The block info is filled in except for the compressed offset, which should be set to where the payload is written
+	 *
+	 * @param Block Block to write
+	 * @param Payload Block payload of Block.CompressedSize bytes
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool WriteBlock(FRuntimeArchiverBlockInfo& Block, const uint8* Payload);
+
+	/**
+	 * Read all blocks of the compressed data
+	 *
+	 * @param OutBlocks Blocks in the order of the uncompressed data
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool ReadBlockTable(TArray<FRuntimeArchiverBlockInfo>& OutBlocks);
+
+	/**
+	 * Compress a block. Called from multiple threads at once
+	 *
+	 * @param Data Uncompressed block data
+	 * @param Size Uncompressed block size
+	 * @param CompressedData Compressed block payload
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool CompressBlock(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData) const;
+
+	/**
+	 * Decompress a block. Called from multiple threads at once
+	 *
+	 * @param Block Block to decompress
+	 * @param Payload Compressed block payload
+	 * @param Data Buffer to decompress the block to, of Block.UncompressedSize bytes, or of MaxBlockUncompressedSize bytes if the size is not known
+	 * @param DecompressedSize Size of the decompressed data
+	 * @return Whether the operation was successful or not
+	 */
+	virtual bool DecompressBlock(const FRuntimeArchiverBlockInfo& Block, const uint8* Payload, uint8* Data, int64& DecompressedSize) const;
+
+	/**
+	 * Read compressed data at the specified offset
+	 */
+	bool ReadCompressed(int64 Offset, void* Data, int64 Size);
+
+	/**
+	 * Write compressed data at the current compressed position
+	 */
+	bool WriteCompressed(const void* Data, int64 Size);
+
+	static uint32 ReadUInt32(const uint8* Data);
+	static uint64 ReadUInt64(const uint8* Data);
+	static void WriteUInt32(uint8* Data, uint32 Value);
+	static void WriteUInt64(uint8* Data, uint64 Value);
+
+	/** Stream containing the compressed data */
+	FRuntimeArchiverBaseStream& CompressedStream;
+
+	/** Size of the compressed data when reading */
+	int64 CompressedSize;
+
+	/** Offset in the compressed stream where the next compressed data is written */
+	int64 CompressedPosition;
+
+	/** Size of the uncompressed data in each written block */
+	int64 BlockSize;
+
+	/** Compression level used to compress blocks */
+	ERuntimeArchiverCompressionLevel CompressionLevel;
+
+	/** All blocks read from the block table, or written so far */
+	TArray<FRuntimeArchiverBlockInfo> Blocks;
+
+	/** Upper bound of the uncompressed size of blocks whose size is not stored. Set by derived classes when reading the block table */
+	int64 MaxBlockUncompressedSize;
+
+	/** Whether the checksum of each block is computed when writing and checked when reading. Set by derived classes whose format stores block checksums */
+	bool bBlockChecksums;
+
+private:
+	/**
+	 * Compress the buffered data in parallel and write it as blocks
+	 *
+	 * @param bFinal Whether to write the last partial block as well
+	 * @return Whether the operation was successful or not
+	 */
+	bool WritePendingBlocks(bool bFinal);
+
+	/**
+	 * Decompress the blocks starting with the one containing the specified uncompressed offset into the window
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool DecompressBatch(int64 Offset);
+
+	/**
+	 * Decompress blocks in order until the sizes of the blocks up to the specified uncompressed offset are known, or all of them are
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool DecompressBlocksUpTo(int64 Offset);
+
+	/**
+	 * Check the decompressed block data against the block checksum, if the format stores block checksums
+	 */
+	bool IsBlockDataValid(const FRuntimeArchiverBlockInfo& Block, const uint8* Data, int64 Size) const;
+
+	/** The number of blocks processed in parallel */
+	int32 NumOfWorkers;
+
+	/** Uncompressed data waiting to be compressed when writing, or the window of decompressed blocks when reading */
+	TArray64<uint8> Buffer;
+
+	/** Number of valid bytes in the buffer */
+	int64 BufferNum;
+
+	/** Compressed payloads of the blocks being processed */
+	TArray<TArray64<uint8>> Payloads;
+
+	/** Index of the first block in the window */
+	int32 WindowFirstBlock;
+
+	/** Number of blocks in the window */
+	int32 WindowNumOfBlocks;
+
+	/** Uncompressed offset of the first byte in the window */
+	int64 WindowStart;
+
+	/** Total uncompressed size of the blocks with known sizes */
+	int64 UncompressedSize;
+
+	/** Number of leading blocks whose uncompressed size and offset are known */
+	int32 NumOfSizedBlocks;
+
+	/** Whether the stream has been finished when writing */
+	bool bFinished;
+
+	/** Whether an operation failed and the stream can no longer be used */
+	bool bFailed;
+};
@@ -0,0 +1,103 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "RuntimeArchiverBaseStream.h"
+
+struct mz_stream_s;
+
+/**
+ * Read-only stream that inflates gzip compressed data on the fly. Used to read tar.gz archives without decompressing them into memory
+ * Reading forward is sequential and keeps memory usage constant. Seeking backwards within the recently inflated window is free, anything further restarts inflation from the beginning
+ * The size is only exact once the end of the data has been inflated. Until then it is an estimate that is at least a bit ahead of the current position
+ */
+class RUNTIMEARCHIVER_API FRuntimeArchiverGZipStream : public FRuntimeArchiverBaseStream
+{
+public:
+	/** It should be impossible to create this object by the default constructor */
+	FRuntimeArchiverGZipStream() = delete;
+
+	/**
+	 * Open a gzip inflate stream
+	 *
+	 * @param InCompressedStream Stream containing the gzip compressed data. Not owned, must outlive this stream. Its position is set before every read, so it can be shared
+	 */
+	explicit FRuntimeArchiverGZipStream(FRuntimeArchiverBaseStream& InCompressedStream);
+
+	virtual ~FRuntimeArchiverGZipStream() override;
+
+	//~ Begin FRuntimeArchiverBaseStream Interface
+	virtual bool IsValid() const override;
+	virtual bool Read(void* Data, int64 Size) override;
+	virtual bool Seek(int64 NewPosition) override;
+	virtual int64 Size() override;
+	virtual bool IsSequential() const override;
+	virtual float GetReadProgress() override;
+	//~ End FRuntimeArchiverBaseStream Interface
+
+private:
+	/**
+	 * Start inflating from the beginning of the compressed data
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool Restart();
+
+	/**
+	 * Parse the gzip member header at the current compressed position and move past it
+	 *
+	 * @return Whether the operation was successful or not
+	 */
+	bool ReadMemberHeader();
+
+	/**
+	 * Inflate more data into the window until it reaches the specified uncompressed offset or the end of the data
+	 * Data before the current position, apart from a small retained part, is dropped to make room
+	 *
+	 * @param TargetOffset Uncompressed offset to inflate up to
+	 * @return Whether the operation was successful or not. Reaching the end of the data is not a failure
+	 */
+	bool FillWindow(int64 TargetOffset);
+
+	/**
+	 * Read compressed data from the current compressed position
+	 *
+	 * @param Data In-memory data pointer to fill
+	 * @param Size Data size
+	 * @return Whether the operation was successful or not
+	 */
+	bool ReadCompressed(void* Data, int64 Size);
+
+	/** Stream containing the gzip compressed data */
+	FRuntimeArchiverBaseStream& CompressedStream;
+
+	/** Size of the compressed data */
+	int64 CompressedSize;
+
+	/** Offset of the next compressed byte to read from the compressed stream */
+	int64 CompressedPosition;
+
+	/** Inflate state of the current gzip member */
+	TUniquePtr<mz_stream_s> InflateStream;
+
+	/** Compressed data read from the compressed stream but not yet inflated */
+	TArray64<uint8> InputBuffer;
+
+	/** Recently inflated data */
+	TArray64<uint8> Window;
+
+	/** Uncompressed offset of the first byte in the window */
+	int64 WindowStart;
+
+	/** Number of valid bytes in the window */
+	int64 WindowNum;
+
+	/** Running CRC-32 of the current gzip member, checked against the member trailer */
+	uint32 MemberCrc;
+
+	/** Whether the end of the compressed data has been reached */
+	bool bFinished;
+
+	/** Whether the compressed data turned out to be corrupted */
+	bool bCorrupted;
+};
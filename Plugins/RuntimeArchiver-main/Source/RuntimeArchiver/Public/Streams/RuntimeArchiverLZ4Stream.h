@@ -0,0 +1,62 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "RuntimeArchiverBlockStream.h"
+
+/**
+ * LZ4 frame stream. Compresses or decompresses data in the standard LZ4 frame format with independent blocks, readable by the lz4 command line tool
+ */
+class RUNTIMEARCHIVER_API FRuntimeArchiverLZ4Stream : public FRuntimeArchiverBlockStream
+{
+public:
+	/**
+	 * Open an LZ4 frame stream
+	 *
+	 * @param InCompressedStream Stream to read the frames from or write them to
+	 * @param bWrite Whether to compress data written to the stream or to decompress data read from it
+	 * @param MaxWorkers The maximum number of threads used to process blocks in parallel. 0 uses the number of logical cores
+	 */
+	explicit FRuntimeArchiverLZ4Stream(FRuntimeArchiverBaseStream& InCompressedStream, bool bWrite, int32 MaxWorkers = 0);
+
+	virtual ~FRuntimeArchiverLZ4Stream() override;
+
+	/**
+	 * Check if the data starts with an LZ4 frame
+	 *
+	 * @param Stream Stream to check from the beginning
+	 * @return Whether the data starts with an LZ4 frame or not
+	 */
+	static bool IsLZ4Frame(FRuntimeArchiverBaseStream& Stream);
+
+protected:
+	//~ Begin FRuntimeArchiverBlockStream Interface
+	virtual bool WriteStreamHeader() override;
+	virtual bool WriteStreamFooter() override;
+	virtual bool WriteBlock(FRuntimeArchiverBlockInfo& Block, const uint8* Payload) override;
+	virtual bool ReadBlockTable(TArray<FRuntimeArchiverBlockInfo>& OutBlocks) override;
+	virtual bool CompressBlock(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData) const override;
+	virtual bool DecompressBlock(const FRuntimeArchiverBlockInfo& Block, const uint8* Payload, uint8* Data, int64& DecompressedSize) const override;
+	//~ End FRuntimeArchiverBlockStream Interface
+
+private:
+	/**
+	 * Read a single frame at the specified offset
+	 *
+	 * @param Offset Offset of the frame. Updated to the offset right after the frame
+	 * @param OutBlocks Blocks to add the frame blocks to
+	 * @return Whether the operation was successful or not
+	 */
+	bool ReadFrame(int64& Offset, TArray<FRuntimeArchiverBlockInfo>& OutBlocks);
+
+	/**
+	 * Fill in the frame header, including the header checksum
+	 *
+	 * @param Header Header data to fill
+	 * @param ContentSize Uncompressed size of the frame
+	 */
+	static void MakeFrameHeader(uint8* Header, uint64 ContentSize);
+
+	/** Offset of the written frame header, used to fill in the content size once finished */
+	int64 FrameHeaderOffset;
+};
@@ -0,0 +1,49 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "RuntimeArchiverBaseStream.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Read-only memory-mapped file stream. Reads are served straight from the mapped memory without a system call each, and the data can be accessed without copying
+ * Not all platforms support memory mapping, and mapping may fail for very large files on 32-bit platforms. Check IsValid and fall back to the file stream if needed
+ */
+class RUNTIMEARCHIVER_API FRuntimeArchiverMappedFileStream : public FRuntimeArchiverBaseStream
+{
+public:
+	/** It should be impossible to create this object by the default constructor */
+	FRuntimeArchiverMappedFileStream() = delete;
+
+	/**
+	 * Map an archive file to read
+	 *
+	 * @param ArchivePath Path to the archive to map
+	 */
+	explicit FRuntimeArchiverMappedFileStream(const FString& ArchivePath);
+
+	virtual ~FRuntimeArchiverMappedFileStream() override;
+
+	//~ Begin FRuntimeArchiverBaseStream Interface
+	virtual bool IsValid() const override;
+	virtual bool Read(void* Data, int64 Size) override;
+	virtual bool Seek(int64 NewPosition) override;
+	virtual int64 Size() override;
+	virtual const uint8* GetReadView(int64 Offset, int64 Size) override;
+	//~ End FRuntimeArchiverBaseStream Interface
+
+private:
+	/** The mapped file handle. Must outlive the mapped region */
+	TUniquePtr<IMappedFileHandle> MappedFileHandle;
+
+	/** The region covering the whole file */
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** Pointer to the mapped file data */
+	const uint8* MappedData;
+
+	/** Size of the mapped file data */
+	int64 MappedSize;
+};
@@ -22,6 +22,20 @@ public:
 	 */
 	explicit FRuntimeArchiverMemoryStream(const TArray64<uint8>& ArchiveData);
 
+	/**
+	 * Read-only constructor taking ownership of the data
+	 *
+	 * @param ArchiveData Binary archive data
+	 */
+	explicit FRuntimeArchiverMemoryStream(TArray64<uint8>&& ArchiveData);
+
+	/**
+	 * Read-only constructor referencing the data without copying it. The data must outlive the stream
+	 *
+	 * @param ArchiveDataView Binary archive data
+	 */
+	explicit FRuntimeArchiverMemoryStream(TArrayView64<const uint8> ArchiveDataView);
+
 	/**
 	 * Write constructor
 	 *
@@ -35,9 +49,20 @@ public:
 	virtual bool Write(const void* Data, int64 Size) override;
 	virtual bool Seek(int64 NewPosition) override;
 	virtual int64 Size() override;
+	virtual const uint8* GetReadView(int64 Offset, int64 Size) override;
+	virtual bool MoveData(TArray64<uint8>& OutData) override;
 	//~ End FArchiverTarBaseStream Interface
 
 protected:
+	/** Get the data the stream operates on, either the owned or the referenced one */
+	TArrayView64<const uint8> GetDataView() const;
+
 	/** Binary archive data */
 	TArray64<uint8> ArchiveData;
+
+	/** Referenced binary archive data, used instead of the owned one if set */
+	TArrayView64<const uint8> ArchiveDataView;
+
+	/** Whether the stream references external data instead of owning it */
+	bool bReferencesData;
 };
@@ -0,0 +1,45 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "RuntimeArchiverBlockStream.h"
+#include "Misc/EngineVersionComparison.h"
+
+#if UE_VERSION_NEWER_THAN(5, 0, 0)
+/**
+ * Oodle block stream. Compresses or decompresses data split into independently compressed Oodle blocks
+ * The data starts with a small header, followed by the block payloads, the block table with the size of each block, and a trailer pointing to the block table
+ */
+class RUNTIMEARCHIVER_API FRuntimeArchiverOodleStream : public FRuntimeArchiverBlockStream
+{
+public:
+	/**
+	 * Open an Oodle block stream
+	 *
+	 * @param InCompressedStream Stream to read the blocks from or write them to
+	 * @param bWrite Whether to compress data written to the stream or to decompress data read from it
+	 * @param MaxWorkers The maximum number of threads used to process blocks in parallel. 0 uses the number of logical cores
+	 */
+	explicit FRuntimeArchiverOodleStream(FRuntimeArchiverBaseStream& InCompressedStream, bool bWrite, int32 MaxWorkers = 0);
+
+	virtual ~FRuntimeArchiverOodleStream() override;
+
+	/**
+	 * Check if the data is in the Oodle block format
+	 *
+	 * @param Stream Stream to check from the beginning
+	 * @return Whether the data is in the Oodle block format or not
+	 */
+	static bool IsOodleBlockFormat(FRuntimeArchiverBaseStream& Stream);
+
+protected:
+	//~ Begin FRuntimeArchiverBlockStream Interface
+	virtual bool WriteStreamHeader() override;
+	virtual bool WriteStreamFooter() override;
+	virtual bool WriteBlock(FRuntimeArchiverBlockInfo& Block, const uint8* Payload) override;
+	virtual bool ReadBlockTable(TArray<FRuntimeArchiverBlockInfo>& OutBlocks) override;
+	virtual bool CompressBlock(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData) const override;
+	virtual bool DecompressBlock(const FRuntimeArchiverBlockInfo& Block, const uint8* Payload, uint8* Data, int64& DecompressedSize) const override;
+	//~ End FRuntimeArchiverBlockStream Interface
+};
+#endif
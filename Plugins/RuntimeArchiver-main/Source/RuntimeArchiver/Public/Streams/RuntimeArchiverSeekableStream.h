@@ -0,0 +1,71 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "RuntimeArchiverBlockStream.h"
+
+/**
+ * Seekable block stream. Compresses or decompresses data split into independently LZ4 compressed frames of a fixed uncompressed size
+ * The data starts with a small header, followed by the frame payloads, the frame index with the size and CRC32 of each frame, an optional file table, and a trailer pointing to the frame index
+ * Since every frame can be located from the frame index, any byte range can be read without decompressing the data before it
+ */
+class RUNTIMEARCHIVER_API FRuntimeArchiverSeekableStream : public FRuntimeArchiverBlockStream
+{
+public:
+	/**
+	 * Open a seekable stream
+	 *
+	 * @param InCompressedStream Stream to read the frames from or write them to
+	 * @param bWrite Whether to compress data written to the stream or to decompress data read from it
+	 * @param MaxWorkers The maximum number of threads used to process frames in parallel. 0 uses the number of logical cores
+	 */
+	explicit FRuntimeArchiverSeekableStream(FRuntimeArchiverBaseStream& InCompressedStream, bool bWrite, int32 MaxWorkers = 0);
+
+	virtual ~FRuntimeArchiverSeekableStream() override;
+
+	/**
+	 * Check if the data is in the seekable format
+	 *
+	 * @param Stream Stream to check from the beginning
+	 * @return Whether the data is in the seekable format or not
+	 */
+	static bool IsSeekableFormat(FRuntimeArchiverBaseStream& Stream);
+
+	/**
+	 * Set the file table written after the frame index. Must be called before the stream is finished
+	 *
+	 * @param InFileTable Arbitrary data describing the stored files. Compressed as a whole
+	 */
+	void SetFileTable(TArray64<uint8>&& InFileTable) { FileTable = MoveTemp(InFileTable); }
+
+	/**
+	 * Get the file table read when opening the stream. Empty if the data has no file table
+	 */
+	const TArray64<uint8>& GetFileTable() const { return FileTable; }
+
+protected:
+	//~ Begin FRuntimeArchiverBlockStream Interface
+	virtual bool WriteStreamHeader() override;
+	virtual bool WriteStreamFooter() override;
+	virtual bool WriteBlock(FRuntimeArchiverBlockInfo& Block, const uint8* Payload) override;
+	virtual bool ReadBlockTable(TArray<FRuntimeArchiverBlockInfo>& OutBlocks) override;
+	virtual bool CompressBlock(const uint8* Data, int64 Size, TArray64<uint8>& CompressedData) const override;
+	virtual bool DecompressBlock(const FRuntimeArchiverBlockInfo& Block, const uint8* Payload, uint8* Data, int64& DecompressedSize) const override;
+	//~ End FRuntimeArchiverBlockStream Interface
+
+private:
+	/**
+	 * Read the file table stored right before the trailer
+	 *
+	 * @param Offset Offset of the file table payload
+	 * @param PayloadSize Size of the file table payload
+	 * @param UncompressedSize Size of the file table when uncompressed
+	 * @param bCompressed Whether the payload is compressed or stored as is
+	 * @param Checksum CRC32 of the uncompressed file table
+	 * @return Whether the operation was successful or not
+	 */
+	bool ReadFileTable(int64 Offset, int64 PayloadSize, int64 UncompressedSize, bool bCompressed, uint32 Checksum);
+
+	/** Arbitrary data describing the stored files */
+	TArray64<uint8> FileTable;
+};
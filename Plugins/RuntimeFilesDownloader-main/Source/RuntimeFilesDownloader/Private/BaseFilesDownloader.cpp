@@ -25,6 +25,15 @@ bool UBaseFilesDownloader::CancelDownload()
 	return true;
 }
 
+FRuntimeDownloadStats UBaseFilesDownloader::GetDownloadStats() const
+{
+	if (RuntimeChunkDownloaderPtr.IsValid())
+	{
+		return RuntimeChunkDownloaderPtr->GetStats();
+	}
+	return FRuntimeDownloadStats();
+}
+
 void UBaseFilesDownloader::GetContentSize(const FString& URL, float Timeout, const FOnGetDownloadContentLength& OnComplete)
 {
 	GetContentSize(URL, Timeout, FOnGetDownloadContentLengthNative::CreateLambda([OnComplete](int64 ContentSize)
@@ -1,8 +1,10 @@
-// Georgy Treshchev 2024.
+﻿// Georgy Treshchev 2024.
 
 #include "FileToMemoryDownloader.h"
 #include "RuntimeChunkDownloader.h"
 #include "RuntimeFilesDownloaderDefines.h"
+#include "RuntimeHttpCache.h"
+#include "Misc/SecureHash.h"
 
 UFileToMemoryDownloader* UFileToMemoryDownloader::DownloadFileToMemoryPerChunk(const FString& URL, float Timeout, const FString& ContentType, int32 MaxChunkSize, const FOnDownloadProgress& OnProgress, const FOnFileToMemoryChunkDownloadComplete& OnChunkComplete, const FOnFileToMemoryAllChunksDownloadComplete& OnAllChunksDownloadComplete)
 {
@@ -62,6 +64,38 @@ UFileToMemoryDownloader* UFileToMemoryDownloader::DownloadFileToMemory(const FSt
 	return Downloader;
 }
 
+UFileToMemoryDownloader* UFileToMemoryDownloader::DownloadFileToMemoryCached(const FString& URL, float Timeout, const FString& ContentType, const FOnDownloadProgress& OnProgress, const FOnFileToMemoryDownloadComplete& OnComplete)
+{
+	return DownloadFileToMemoryCached(URL, Timeout, ContentType, FOnDownloadProgressNative::CreateLambda([OnProgress](int64 BytesReceived, int64 ContentSize, float Progress)
+	{
+		OnProgress.ExecuteIfBound(BytesReceived, ContentSize, Progress);
+	}), FOnFileToMemoryDownloadCompleteNative::CreateLambda([OnComplete](const TArray64<uint8>& DownloadedContent, EDownloadToMemoryResult Result, UFileToMemoryDownloader* Downloader)
+	{
+		if (DownloadedContent.Num() > TNumericLimits<int32>::Max())
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("The size of the downloaded content exceeds the maximum limit for an int32 array. Maximum length: %d, Retrieved length: %lld\nA standard byte array can hold a maximum of 2 GB of data. If you need to download more than 2 GB of data into memory, consider using the C++ native equivalent instead of the Blueprint dynamic delegate"), TNumericLimits<int32>::Max(), DownloadedContent.Num());
+			OnComplete.ExecuteIfBound(TArray<uint8>(), EDownloadToMemoryResult::DownloadFailed, Downloader);
+			return;
+		}
+		OnComplete.ExecuteIfBound(TArray<uint8>(DownloadedContent), Result, Downloader);
+	}));
+}
+
+UFileToMemoryDownloader* UFileToMemoryDownloader::DownloadFileToMemoryCached(const FString& URL, float Timeout, const FString& ContentType, const FOnDownloadProgressNative& OnProgress, const FOnFileToMemoryDownloadCompleteNative& OnComplete)
+{
+	UFileToMemoryDownloader* Downloader = NewObject<UFileToMemoryDownloader>(StaticClass());
+	Downloader->AddToRoot();
+	Downloader->OnDownloadProgress = OnProgress;
+	Downloader->OnDownloadComplete = OnComplete;
+	Downloader->DownloadFileToMemoryCached(URL, Timeout, ContentType);
+	return Downloader;
+}
+
+bool UFileToMemoryDownloader::ClearHttpCache()
+{
+	return FRuntimeHttpCache::Get().Clear();
+}
+
 bool UFileToMemoryDownloader::CancelDownload()
 {
 	if (RuntimeChunkDownloaderPtr.IsValid())
@@ -130,12 +164,107 @@ void UFileToMemoryDownloader::DownloadFileToMemoryPerChunk(const FString& URL, f
 	RuntimeChunkDownloaderPtr->DownloadFilePerChunk(URL, Timeout, ContentType, MaxChunkSize, FInt64Vector2(), [this](int64 BytesReceived, int64 ContentSize)
 	{
 		BroadcastProgress(BytesReceived, ContentSize, ContentSize <= 0 ? 0 : static_cast<float>(BytesReceived) / ContentSize);
-	}, [this](TArray64<uint8> DownloadedContent)
+	}, [this](TArray64<uint8>&& DownloadedContent)
 	{
 		OnChunkDownloadComplete.ExecuteIfBound(DownloadedContent, this);
+
+		// The delegate only views the chunk, so its buffer can be reused for the next chunk
+		if (RuntimeChunkDownloaderPtr.IsValid())
+		{
+			RuntimeChunkDownloaderPtr->GetBufferPool()->Release(MoveTemp(DownloadedContent));
+		}
 	}).Next([this](EDownloadToMemoryResult Result)
 	{
 		RemoveFromRoot();
 		OnAllChunksDownloadComplete.ExecuteIfBound(Result, this);
 	});
 }
+
+void UFileToMemoryDownloader::DownloadFileToMemoryCached(const FString& URL, float Timeout, const FString& ContentType)
+{
+	if (URL.IsEmpty())
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("You have not provided an URL to download the file"));
+		OnDownloadComplete.ExecuteIfBound(TArray64<uint8>(), EDownloadToMemoryResult::InvalidURL, this);
+		RemoveFromRoot();
+		return;
+	}
+
+	if (Timeout < 0)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("The specified timeout (%f) is less than 0, setting it to 0"), Timeout);
+		Timeout = 0;
+	}
+
+	FRuntimeHttpCacheEntry CachedEntry;
+	bool bServedFromCache = false;
+	FSHAHash CachedDataHash;
+	{
+		TArray64<uint8> CachedData;
+		if (FRuntimeHttpCache::Get().Find(URL, CachedEntry, CachedData))
+		{
+			bServedFromCache = true;
+			FSHA1::HashBuffer(CachedData.GetData(), CachedData.Num(), CachedDataHash.Hash);
+			BroadcastProgress(CachedData.Num(), CachedData.Num(), 1.f);
+			OnDownloadComplete.ExecuteIfBound(CachedData, EDownloadToMemoryResult::SucceededFromCache, this);
+
+			if (CachedEntry.IsFresh())
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("HTTP cache entry for %s is still fresh, skipping revalidation"), *URL);
+				RemoveFromRoot();
+				return;
+			}
+		}
+		else
+		{
+			CachedEntry = FRuntimeHttpCacheEntry();
+		}
+	}
+
+	auto OnProgress = [this, bServedFromCache](int64 BytesReceived, int64 ContentSize)
+	{
+		// Progress has already been reported as complete for the cached content
+		if (!bServedFromCache)
+		{
+			BroadcastProgress(BytesReceived, ContentSize, ContentSize <= 0 ? 0 : static_cast<float>(BytesReceived) / ContentSize);
+		}
+	};
+
+	RuntimeChunkDownloaderPtr = MakeShared<FRuntimeChunkDownloader>();
+	RuntimeChunkDownloaderPtr->DownloadFileConditional(URL, Timeout, ContentType, CachedEntry, OnProgress).Next([this, URL, bServedFromCache, CachedDataHash](FRuntimeChunkDownloaderResult&& Result) mutable
+	{
+		RemoveFromRoot();
+
+		if (bServedFromCache)
+		{
+			// The cached content has already been broadcast, so only a changed file is worth reporting
+			// A server ignoring the validators replies 200 with the same content, which is not a change
+			if (Result.Result == EDownloadToMemoryResult::Success)
+			{
+				FSHAHash DataHash;
+				FSHA1::HashBuffer(Result.Data.GetData(), Result.Data.Num(), DataHash.Hash);
+				if (DataHash == CachedDataHash)
+				{
+					UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("HTTP cache entry for %s was revalidated with unchanged content"), *URL);
+				}
+				else
+				{
+					OnDownloadComplete.ExecuteIfBound(Result.Data, Result.Result, this);
+				}
+			}
+			else if (Result.Result != EDownloadToMemoryResult::SucceededFromCache)
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Unable to revalidate HTTP cache entry for %s (%s), keeping the cached content"), *URL, *UEnum::GetValueAsString(Result.Result));
+			}
+			return;
+		}
+
+		if (Result.Result == EDownloadToMemoryResult::SucceededFromCache)
+		{
+			// The server replied 304 to an unconditional request, which should not happen
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file from %s: server reported not modified, but nothing is cached"), *URL);
+			Result.Result = EDownloadToMemoryResult::DownloadFailed;
+		}
+		OnDownloadComplete.ExecuteIfBound(Result.Data, Result.Result, this);
+	});
+}
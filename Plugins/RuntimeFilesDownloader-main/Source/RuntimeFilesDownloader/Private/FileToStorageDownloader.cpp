@@ -1,4 +1,4 @@
-// Georgy Treshchev 2024.
+﻿// Georgy Treshchev 2024.
 
 #include "FileToStorageDownloader.h"
 
@@ -9,6 +9,7 @@
 #include "HAL/FileManager.h"
 #include "HAL/PlatformFileManager.h"
 #include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/ScopeLock.h"
 
 UFileToStorageDownloader* UFileToStorageDownloader::DownloadFileToStorage(const FString& URL, const FString& SavePath, float Timeout, const FString& ContentType, bool bForceByPayload, const FOnDownloadProgress& OnProgress, const FOnFileToStorageDownloadComplete& OnComplete)
 {
@@ -66,103 +67,198 @@ void UFileToStorageDownloader::DownloadFileToStorage(const FString& URL, const F
 	}
 
 	FileSavePath = SavePath;
-
-	auto OnProgress = [this](int64 BytesReceived, int64 ContentSize)
-	{
-		BroadcastProgress(BytesReceived, ContentSize, ContentSize <= 0 ? 0 : static_cast<float>(BytesReceived) / ContentSize);
-	};
-
-	auto OnResult = [this](FRuntimeChunkDownloaderResult&& Result) mutable
 	{
-		OnComplete_Internal(Result.Result, MoveTemp(Result.Data));
-	};
+		FScopeLock Lock(&StorageSinkMutex);
+		bStorageWriteFailed = false;
+	}
 
 	RuntimeChunkDownloaderPtr = MakeShared<FRuntimeChunkDownloader>();
 
 	if (bForceByPayload)
 	{
-		RuntimeChunkDownloaderPtr->DownloadFileByPayload(URL, Timeout, ContentType, OnProgress).Next(OnResult);
+		DownloadFileToStorageByPayload(URL, Timeout, ContentType);
+		return;
 	}
-	else
+
+	RuntimeChunkDownloaderPtr->GetContentSize(URL, Timeout).Next([this, URL, Timeout, ContentType](int64 ContentSize)
+	{
+		if (ContentSize <= 0)
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Unable to get content size for %s. Trying to download the file by payload"), *URL);
+			DownloadFileToStorageByPayload(URL, Timeout, ContentType);
+			return;
+		}
+
+		// Reserve the full size up front so that the chunks can be written at their offsets as soon as they arrive
+		if (!OpenStorageSink(ContentSize))
+		{
+			RemoveFromRoot();
+			return;
+		}
+
+		// Write the chunks straight from the HTTP responses to their offsets, without intermediate chunk buffers
+		RuntimeChunkDownloaderPtr->SetChunkDataConsumer([this](int64 ChunkOffset, TArrayView64<const uint8> ChunkData)
+		{
+			FScopeLock Lock(&StorageSinkMutex);
+			if (!StorageSink.IsValid() || !StorageSink->Write(ChunkOffset, ChunkData.GetData(), ChunkData.Num()))
+			{
+				bStorageWriteFailed = true;
+				return false;
+			}
+			return true;
+		});
+
+		RuntimeChunkDownloaderPtr->DownloadFilePerChunk(URL, Timeout, ContentType, StorageChunkSize, FInt64Vector2(), [this](int64 BytesReceived, int64 InternalContentSize)
+		{
+			BroadcastProgress(BytesReceived, InternalContentSize, InternalContentSize <= 0 ? 0 : static_cast<float>(BytesReceived) / InternalContentSize);
+		}, nullptr, ContentSize).Next([this, URL, Timeout, ContentType](EDownloadToMemoryResult Result)
+		{
+			OnChunksComplete_Internal(Result, URL, Timeout, ContentType);
+		});
+	});
+}
+
+void UFileToStorageDownloader::DownloadFileToStorageByPayload(const FString& URL, float Timeout, const FString& ContentType)
+{
+	RuntimeChunkDownloaderPtr->DownloadFileByPayload(URL, Timeout, ContentType, [this](int64 BytesReceived, int64 ContentSize)
+	{
+		BroadcastProgress(BytesReceived, ContentSize, ContentSize <= 0 ? 0 : static_cast<float>(BytesReceived) / ContentSize);
+	}).Next([this](FRuntimeChunkDownloaderResult&& Result) mutable
+	{
+		OnComplete_Internal(Result.Result, MoveTemp(Result.Data));
+	});
+}
+
+bool UFileToStorageDownloader::OpenStorageSink(int64 ContentSize)
+{
+	TUniquePtr<FRuntimeStorageSink> NewStorageSink = MakeUnique<FRuntimeStorageSink>();
+
+	switch (NewStorageSink->Open(FileSavePath, ContentSize))
 	{
-		RuntimeChunkDownloaderPtr->DownloadFile(URL, Timeout, ContentType, TNumericLimits<TArray<uint8>::SizeType>::Max(), OnProgress).Next(OnResult);
+	case ERuntimeStorageSinkOpenResult::Success:
+		{
+			FScopeLock Lock(&StorageSinkMutex);
+			StorageSink = MoveTemp(NewStorageSink);
+			bStorageWriteFailed = false;
+		}
+		return true;
+	case ERuntimeStorageSinkOpenResult::DirectoryCreationFailed:
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::DirectoryCreationFailed, FileSavePath, this);
+		break;
+	case ERuntimeStorageSinkOpenResult::NotEnoughSpace:
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::NotEnoughSpace, FileSavePath, this);
+		break;
+	default:
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::SaveFailed, FileSavePath, this);
+		break;
 	}
+
+	return false;
 }
 
-void UFileToStorageDownloader::OnComplete_Internal(EDownloadToMemoryResult Result, TArray64<uint8> DownloadedContent)
+void UFileToStorageDownloader::OnChunksComplete_Internal(EDownloadToMemoryResult Result, const FString& URL, float Timeout, const FString& ContentType)
 {
+	RuntimeChunkDownloaderPtr->SetChunkDataConsumer(nullptr);
+
+	// Take the sink over from the chunk data consumer, so that it is no longer shared with the HTTP thread
+	TUniquePtr<FRuntimeStorageSink> CompletedStorageSink;
+	bool bWriteFailed;
+	{
+		FScopeLock Lock(&StorageSinkMutex);
+		CompletedStorageSink = MoveTemp(StorageSink);
+		bWriteFailed = bStorageWriteFailed;
+	}
+
+	if (bWriteFailed)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Something went wrong while writing the response data to the file '%s'"), *FileSavePath);
+		CompletedStorageSink.Reset();
+		RemoveFromRoot();
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::SaveFailed, FileSavePath, this);
+		return;
+	}
+
+	if (Result == EDownloadToMemoryResult::DownloadFailed)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: download failed. Trying to download the file by payload"), *URL);
+		CompletedStorageSink.Reset();
+		DownloadFileToStorageByPayload(URL, Timeout, ContentType);
+		return;
+	}
+
 	RemoveFromRoot();
 
 	if (Result != EDownloadToMemoryResult::Success && Result != EDownloadToMemoryResult::SucceededByPayload)
 	{
-		// TODO: redesign in a more elegant way
-		switch (Result)
-		{
-		case EDownloadToMemoryResult::Cancelled:
-			OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::Cancelled, FileSavePath, this);
-			break;
-		case EDownloadToMemoryResult::DownloadFailed:
-			OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::DownloadFailed, FileSavePath, this);
-			break;
-		case EDownloadToMemoryResult::InvalidURL:
-			OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::InvalidURL, FileSavePath, this);
-			break;
-		}
+		CompletedStorageSink.Reset();
+		BroadcastResult(Result);
 		return;
 	}
 
-	if (!DownloadedContent.IsValidIndex(0))
+	if (!CompletedStorageSink.IsValid() || !CompletedStorageSink->Finalize())
 	{
-		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("An error occurred while downloading the file to storage"));
-		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::DownloadFailed, FileSavePath, this);
+		CompletedStorageSink.Reset();
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::SaveFailed, FileSavePath, this);
 		return;
 	}
 
-	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	CompletedStorageSink.Reset();
+	OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::Success, FileSavePath, this);
+}
 
-	// Create save directory if it does not exist
+void UFileToStorageDownloader::OnComplete_Internal(EDownloadToMemoryResult Result, TArray64<uint8> DownloadedContent)
+{
+	RemoveFromRoot();
+
+	if (Result != EDownloadToMemoryResult::Success && Result != EDownloadToMemoryResult::SucceededByPayload)
 	{
-		FString Path, Filename, Extension;
-		FPaths::Split(FileSavePath, Path, Filename, Extension);
-		if (!PlatformFile.DirectoryExists(*Path))
-		{
-			if (!PlatformFile.CreateDirectoryTree(*Path))
-			{
-				UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to create a directory '%s' to save the downloaded file"), *Path);
-				OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::DirectoryCreationFailed, FileSavePath, this);
-				return;
-			}
-		}
+		BroadcastResult(Result);
+		return;
 	}
 
-	// Delete the file if it already exists
-	if (FPaths::FileExists(*FileSavePath))
+	if (!DownloadedContent.IsValidIndex(0))
 	{
-		IFileManager& FileManager = IFileManager::Get();
-		if (!FileManager.Delete(*FileSavePath))
-		{
-			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Something went wrong while deleting the existing file '%s'"), *FileSavePath);
-			OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::SaveFailed, FileSavePath, this);
-			return;
-		}
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("An error occurred while downloading the file to storage"));
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::DownloadFailed, FileSavePath, this);
+		return;
 	}
 
-	IFileHandle* FileHandle = PlatformFile.OpenWrite(*FileSavePath);
-	if (!FileHandle)
+	if (!OpenStorageSink(DownloadedContent.Num()))
 	{
-		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Something went wrong while saving the file '%s'"), *FileSavePath);
-		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::SaveFailed, FileSavePath, this);
 		return;
 	}
 
-	if (!FileHandle->Write(DownloadedContent.GetData(), DownloadedContent.Num()))
+	if (!StorageSink->Write(0, DownloadedContent.GetData(), DownloadedContent.Num()) || !StorageSink->Finalize())
 	{
 		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Something went wrong while writing the response data to the file '%s'"), *FileSavePath);
-		delete FileHandle;
+		StorageSink.Reset();
 		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::SaveFailed, FileSavePath, this);
 		return;
 	}
 
-	delete FileHandle;
+	StorageSink.Reset();
 	OnDownloadComplete.ExecuteIfBound(Result == EDownloadToMemoryResult::SucceededByPayload ? EDownloadToStorageResult::SucceededByPayload : EDownloadToStorageResult::Success, FileSavePath, this);
 }
+
+void UFileToStorageDownloader::BroadcastResult(EDownloadToMemoryResult Result)
+{
+	switch (Result)
+	{
+	case EDownloadToMemoryResult::Success:
+	case EDownloadToMemoryResult::SucceededFromCache:
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::Success, FileSavePath, this);
+		break;
+	case EDownloadToMemoryResult::SucceededByPayload:
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::SucceededByPayload, FileSavePath, this);
+		break;
+	case EDownloadToMemoryResult::Cancelled:
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::Cancelled, FileSavePath, this);
+		break;
+	case EDownloadToMemoryResult::DownloadFailed:
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::DownloadFailed, FileSavePath, this);
+		break;
+	case EDownloadToMemoryResult::InvalidURL:
+		OnDownloadComplete.ExecuteIfBound(EDownloadToStorageResult::InvalidURL, FileSavePath, this);
+		break;
+	}
+}
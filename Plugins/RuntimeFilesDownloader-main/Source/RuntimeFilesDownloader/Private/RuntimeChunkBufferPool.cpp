@@ -0,0 +1,81 @@
+// Georgy Treshchev 2024.
+
+#include "RuntimeChunkBufferPool.h"
+#include "Misc/ScopeLock.h"
+
+FRuntimeChunkBufferPool::FRuntimeChunkBufferPool(int32 InMaxPooledBuffers)
+	: MaxPooledBuffers(FMath::Max(InMaxPooledBuffers, 0))
+	, NumAllocations(0)
+{}
+
+TArray64<uint8> FRuntimeChunkBufferPool::Acquire(int64 Size)
+{
+	TArray64<uint8> Buffer;
+	{
+		FScopeLock Lock(&PoolMutex);
+
+		// Prefer the smallest buffer that fits, otherwise take the largest one to keep the reallocation small
+		int32 BestIndex = INDEX_NONE;
+		for (int32 Index = 0; Index < FreeBuffers.Num(); ++Index)
+		{
+			const int64 Capacity = FreeBuffers[Index].Max();
+			if (BestIndex == INDEX_NONE)
+			{
+				BestIndex = Index;
+				continue;
+			}
+
+			const int64 BestCapacity = FreeBuffers[BestIndex].Max();
+			const bool bFits = Capacity >= Size;
+			const bool bBestFits = BestCapacity >= Size;
+			if ((bFits && (!bBestFits || Capacity < BestCapacity)) || (!bFits && !bBestFits && Capacity > BestCapacity))
+			{
+				BestIndex = Index;
+			}
+		}
+
+		if (BestIndex != INDEX_NONE)
+		{
+			Buffer = MoveTemp(FreeBuffers[BestIndex]);
+			FreeBuffers.RemoveAtSwap(BestIndex);
+		}
+
+		if (Buffer.Max() < Size)
+		{
+			++NumAllocations;
+		}
+	}
+
+	// Reset keeps the existing allocation when it is large enough
+	Buffer.Reset(Size);
+	Buffer.AddUninitialized(Size);
+	return Buffer;
+}
+
+void FRuntimeChunkBufferPool::Release(TArray64<uint8>&& Buffer)
+{
+	TArray64<uint8> ReleasedBuffer = MoveTemp(Buffer);
+	if (ReleasedBuffer.Max() == 0)
+	{
+		return;
+	}
+
+	FScopeLock Lock(&PoolMutex);
+	if (FreeBuffers.Num() < MaxPooledBuffers)
+	{
+		ReleasedBuffer.Reset();
+		FreeBuffers.Add(MoveTemp(ReleasedBuffer));
+	}
+}
+
+void FRuntimeChunkBufferPool::Trim()
+{
+	FScopeLock Lock(&PoolMutex);
+	FreeBuffers.Empty();
+}
+
+int64 FRuntimeChunkBufferPool::GetNumAllocations() const
+{
+	FScopeLock Lock(&PoolMutex);
+	return NumAllocations;
+}
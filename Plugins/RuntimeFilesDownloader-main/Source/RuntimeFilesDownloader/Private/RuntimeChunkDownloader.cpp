@@ -4,7 +4,12 @@
 
 #include "FileToMemoryDownloader.h"
 #include "RuntimeFilesDownloaderDefines.h"
+#include "RuntimeHttpCache.h"
 #include "Misc/EngineVersionComparison.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformTime.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
 #if PLATFORM_ANDROID
 #include "Async/Future.h"
@@ -13,13 +18,34 @@
 #include "Android/AndroidPlatformMisc.h"
 #endif
 
+// Since UE 5.4, the response body of a chunk can be streamed into its destination instead of being accumulated by the HTTP module and copied afterwards
+#define RUNTIMEFILESDOWNLOADER_STREAM_CHUNK_RESPONSES !UE_VERSION_OLDER_THAN(5, 4, 0)
+
+DECLARE_STATS_GROUP(TEXT("RuntimeFilesDownloader"), STATGROUP_RuntimeFilesDownloader, STATCAT_Advanced);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Requests In Flight"), STAT_RuntimeFilesDownloader_RequestsInFlight, STATGROUP_RuntimeFilesDownloader);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Requests Issued"), STAT_RuntimeFilesDownloader_RequestsIssued, STATGROUP_RuntimeFilesDownloader);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Requests Failed"), STAT_RuntimeFilesDownloader_RequestsFailed, STATGROUP_RuntimeFilesDownloader);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Retries"), STAT_RuntimeFilesDownloader_Retries, STATGROUP_RuntimeFilesDownloader);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Received (MB)"), STAT_RuntimeFilesDownloader_ReceivedMB, STATGROUP_RuntimeFilesDownloader);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Wasted (MB)"), STAT_RuntimeFilesDownloader_WastedMB, STATGROUP_RuntimeFilesDownloader);
+
 FRuntimeChunkDownloader::FRuntimeChunkDownloader()
 	: bCanceled(false)
+	, BufferPool(MakeShared<FRuntimeChunkBufferPool>())
+	, TransferStartTime(0)
+	, LastThroughputSampleTime(0)
+	, LastThroughputSampleBytes(0)
+	, InFlightRequestBytes(0)
 {}
 
 FRuntimeChunkDownloader::~FRuntimeChunkDownloader()
 {
-	UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("FRuntimeChunkDownloader destroyed"));
+	UE_LOG(LogRuntimeFilesDownloader, Verbose, TEXT("FRuntimeChunkDownloader destroyed"));
+
+	if (Stats.RequestCount > 0)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Transfer metrics for %s: %s"), *StatsURL, *Stats.ToString());
+	}
 }
 
 TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFile(const FString& URL, float Timeout, const FString& ContentType, int64 MaxChunkSize, const FOnProgress& OnProgress)
@@ -51,6 +77,7 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFile(con
 
 		auto DownloadByPayload = [SharedThis, WeakThisPtr, PromisePtr, URL, Timeout, ContentType, OnProgress]()
 		{
+			SharedThis->RecordRetry();
 			SharedThis->DownloadFileByPayload(URL, Timeout, ContentType, OnProgress).Next([WeakThisPtr, PromisePtr, URL, Timeout, ContentType, OnProgress](FRuntimeChunkDownloaderResult Result) mutable
 			{
 				TSharedPtr<FRuntimeChunkDownloader> InternalSharedThis = WeakThisPtr.Pin();
@@ -160,9 +187,13 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFile(con
 
 			// Append the downloaded chunk to the result data
 			FMemory::Memcpy(OverallDownloadedDataPtr->GetData() + *ChunkOffsetPtr, ResultData.GetData(), ResultData.Num());
+			const int64 ResultDataSize = ResultData.Num();
+
+			// The chunk buffer is no longer needed, so hand it back for the next chunk
+			InternalSharedThis->BufferPool->Release(MoveTemp(ResultData));
 
 			// If the download is complete, return the result data
-			if (*ChunkOffsetPtr + ResultData.Num() >= ContentSize)
+			if (*ChunkOffsetPtr + ResultDataSize >= ContentSize)
 			{
 				PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Success, MoveTemp(*OverallDownloadedDataPtr.Get())});
 				OnChunkDownloadedFilled();
@@ -170,10 +201,10 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFile(con
 			}
 
 			// Increase the offset by the size of the downloaded chunk
-			*ChunkOffsetPtr += ResultData.Num();
+			*ChunkOffsetPtr += ResultDataSize;
 		};
 
-		SharedThis->DownloadFilePerChunk(URL, Timeout, ContentType, MaxChunkSize, ChunkRange, OnProgress, OnChunkDownloaded).Next([PromisePtr, bChunkDownloadedFilledPtr, URL, OverallDownloadedDataPtr, OnChunkDownloadedFilled, DownloadByPayload](EDownloadToMemoryResult Result) mutable
+		SharedThis->DownloadFilePerChunk(URL, Timeout, ContentType, MaxChunkSize, ChunkRange, OnProgress, OnChunkDownloaded, ContentSize).Next([PromisePtr, bChunkDownloadedFilledPtr, URL, OverallDownloadedDataPtr, OnChunkDownloadedFilled, DownloadByPayload](EDownloadToMemoryResult Result) mutable
 		{
 			// Only return data if no chunk was downloaded
 			if (bChunkDownloadedFilledPtr.IsValid() && (*bChunkDownloadedFilledPtr.Get() == false))
@@ -193,7 +224,7 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFile(con
 	return PromisePtr->GetFuture();
 }
 
-TFuture<EDownloadToMemoryResult> FRuntimeChunkDownloader::DownloadFilePerChunk(const FString& URL, float Timeout, const FString& ContentType, int64 MaxChunkSize, FInt64Vector2 ChunkRange, const FOnProgress& OnProgress, const FOnChunkDownloaded& OnChunkDownloaded)
+TFuture<EDownloadToMemoryResult> FRuntimeChunkDownloader::DownloadFilePerChunk(const FString& URL, float Timeout, const FString& ContentType, int64 MaxChunkSize, FInt64Vector2 ChunkRange, const FOnProgress& OnProgress, const FOnChunkDownloaded& OnChunkDownloaded, int64 KnownContentSize)
 {
 	if (bCanceled)
 	{
@@ -203,7 +234,9 @@ TFuture<EDownloadToMemoryResult> FRuntimeChunkDownloader::DownloadFilePerChunk(c
 
 	TSharedPtr<TPromise<EDownloadToMemoryResult>> PromisePtr = MakeShared<TPromise<EDownloadToMemoryResult>>();
 	TWeakPtr<FRuntimeChunkDownloader> WeakThisPtr = AsShared();
-	GetContentSize(URL, Timeout).Next([WeakThisPtr, PromisePtr, URL, Timeout, ContentType, MaxChunkSize, OnProgress, OnChunkDownloaded, ChunkRange](int64 ContentSize) mutable
+	// The content size is only requested once per download, the following chunks reuse it
+	TFuture<int64> ContentSizeFuture = KnownContentSize > 0 ? MakeFulfilledPromise<int64>(KnownContentSize).GetFuture() : GetContentSize(URL, Timeout);
+	ContentSizeFuture.Next([WeakThisPtr, PromisePtr, URL, Timeout, ContentType, MaxChunkSize, OnProgress, OnChunkDownloaded, ChunkRange](int64 ContentSize) mutable
 	{
 		TSharedPtr<FRuntimeChunkDownloader> SharedThis = WeakThisPtr.Pin();
 		if (!SharedThis.IsValid())
@@ -254,8 +287,23 @@ TFuture<EDownloadToMemoryResult> FRuntimeChunkDownloader::DownloadFilePerChunk(c
 					return;
 				}
 
+				if (InternalSharedThis->ChunkDataConsumer)
+				{
+					if (!InternalSharedThis->ChunkDataConsumer(0, TArrayView64<const uint8>(Result.Data.GetData(), Result.Data.Num())))
+					{
+						UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: chunk data consumer failed"), *URL);
+						PromisePtr->SetValue(EDownloadToMemoryResult::DownloadFailed);
+						return;
+					}
+					PromisePtr->SetValue(Result.Result);
+					return;
+				}
+
 				PromisePtr->SetValue(Result.Result);
-				OnChunkDownloaded(MoveTemp(Result.Data));
+				if (OnChunkDownloaded)
+				{
+					OnChunkDownloaded(MoveTemp(Result.Data));
+				}
 			});
 			return;
 		}
@@ -286,7 +334,7 @@ TFuture<EDownloadToMemoryResult> FRuntimeChunkDownloader::DownloadFilePerChunk(c
 			if (InternalSharedThis.IsValid())
 			{
 				const float Progress = InternalContentSize <= 0 ? 0.0f : static_cast<float>(BytesReceived + ChunkRange.X) / InternalContentSize;
-				UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Downloaded %lld bytes of file chunk from %s. Range: {%lld; %lld}, Overall: %lld, Progress: %f"), BytesReceived, *URL, ChunkRange.X, ChunkRange.Y, InternalContentSize, Progress);
+				UE_LOG(LogRuntimeFilesDownloader, VeryVerbose, TEXT("Downloaded %lld bytes of file chunk from %s. Range: {%lld; %lld}, Overall: %lld, Progress: %f"), BytesReceived, *URL, ChunkRange.X, ChunkRange.Y, InternalContentSize, Progress);
 				OnProgress(BytesReceived + ChunkRange.X, InternalContentSize);
 			}
 		};
@@ -315,7 +363,11 @@ TFuture<EDownloadToMemoryResult> FRuntimeChunkDownloader::DownloadFilePerChunk(c
 				return;
 			}
 
-			OnChunkDownloaded(MoveTemp(Result.Data));
+			// The chunk data has already been consumed in place if a consumer is set
+			if (!InternalSharedThis->ChunkDataConsumer && OnChunkDownloaded)
+			{
+				OnChunkDownloaded(MoveTemp(Result.Data));
+			}
 
 			// Check if the download is complete
 			if (ContentSize > ChunkRange.Y + 1)
@@ -323,7 +375,7 @@ TFuture<EDownloadToMemoryResult> FRuntimeChunkDownloader::DownloadFilePerChunk(c
 				const int64 ChunkStart = ChunkRange.Y + 1;
 				const int64 ChunkEnd = FMath::Min(ChunkStart + MaxChunkSize, ContentSize) - 1;
 
-				InternalSharedThis->DownloadFilePerChunk(URL, Timeout, ContentType, MaxChunkSize, FInt64Vector2(ChunkStart, ChunkEnd), OnProgress, OnChunkDownloaded).Next([WeakThisPtr, PromisePtr](EDownloadToMemoryResult InternalResult)
+				InternalSharedThis->DownloadFilePerChunk(URL, Timeout, ContentType, MaxChunkSize, FInt64Vector2(ChunkStart, ChunkEnd), OnProgress, OnChunkDownloaded, ContentSize).Next([WeakThisPtr, PromisePtr](EDownloadToMemoryResult InternalResult)
 				{
 					PromisePtr->SetValue(InternalResult);
 				});
@@ -394,14 +446,114 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFileByCh
 		if (SharedThis.IsValid())
 		{
 			const float Progress = ContentSize <= 0 ? 0.0f : static_cast<float>(BytesReceived) / ContentSize;
-			UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Downloaded %lld bytes of file chunk from %s. Range: {%lld; %lld}, Overall: %lld, Progress: %f"), static_cast<int64>(BytesReceived), *Request->GetURL(), ChunkRange.X, ChunkRange.Y, ContentSize, Progress);
+			UE_LOG(LogRuntimeFilesDownloader, VeryVerbose, TEXT("Downloaded %lld bytes of file chunk from %s. Range: {%lld; %lld}, Overall: %lld, Progress: %f"), static_cast<int64>(BytesReceived), *Request->GetURL(), ChunkRange.X, ChunkRange.Y, ContentSize, Progress);
+			SharedThis->RecordRequestProgress(BytesReceived);
 			OnProgress(BytesReceived, ContentSize);
 		}
 	});
 
+#if RUNTIMEFILESDOWNLOADER_STREAM_CHUNK_RESPONSES
+	// The body goes straight to the chunk data consumer at its file offset, or into a pooled buffer, as it is received
+	struct FChunkStreamState
+	{
+		/** The pooled buffer, or the data held back from the chunk data consumer until the response has been validated */
+		TArray64<uint8> Data;
+		int64 ReceivedSize = 0;
+		bool bResponseValidated = false;
+	};
+
+	TSharedRef<FChunkStreamState> StreamState = MakeShared<FChunkStreamState>();
+	const int64 ChunkSize = ChunkRange.Y - ChunkRange.X + 1;
+	if (!ChunkDataConsumer)
+	{
+		StreamState->Data = BufferPool->Acquire(ChunkSize);
+	}
+
+	const TWeakPtr<IHttpRequest, ESPMode::ThreadSafe> WeakRequestPtr = HttpRequestRef;
+	auto ReceiveBody = [WeakThisPtr, WeakRequestPtr, StreamState, ChunkRange, ChunkSize](const void* Ptr, int64 Length)
+	{
+		TSharedPtr<FRuntimeChunkDownloader> SharedThis = WeakThisPtr.Pin();
+		if (!SharedThis.IsValid() || SharedThis->bCanceled || StreamState->ReceivedSize + Length > ChunkSize)
+		{
+			return false;
+		}
+
+		if (!SharedThis->ChunkDataConsumer)
+		{
+			// The pooled buffer is only handed out after the response has been validated on completion
+			FMemory::Memcpy(StreamState->Data.GetData() + StreamState->ReceivedSize, Ptr, Length);
+			StreamState->ReceivedSize += Length;
+			return true;
+		}
+
+		// Nothing reaches the consumer before the status code and Content-Range are known to match the requested chunk,
+		// so that an error page or a wrong range cannot overwrite the data at the chunk offset
+		if (!StreamState->bResponseValidated)
+		{
+			const TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request = WeakRequestPtr.Pin();
+			const FHttpResponsePtr Response = Request.IsValid() ? Request->GetResponse() : nullptr;
+			if (!Response.IsValid() || Response->GetResponseCode() <= 0)
+			{
+				// The headers are not available yet, so the data is held back until they are
+				StreamState->Data.Append(static_cast<const uint8*>(Ptr), Length);
+				StreamState->ReceivedSize += Length;
+				return true;
+			}
+
+			if (!IsValidChunkResponse(Response, ChunkRange))
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: response code %d with Content-Range '%s' does not match the requested range (%lld; %lld)"), *Request->GetURL(), Response->GetResponseCode(), *Response->GetHeader(TEXT("Content-Range")), ChunkRange.X, ChunkRange.Y);
+				return false;
+			}
+
+			StreamState->bResponseValidated = true;
+			if (StreamState->Data.Num() > 0)
+			{
+				if (!SharedThis->ChunkDataConsumer(ChunkRange.X, TArrayView64<const uint8>(StreamState->Data.GetData(), StreamState->Data.Num())))
+				{
+					return false;
+				}
+				StreamState->Data.Empty();
+			}
+		}
+
+		if (!SharedThis->ChunkDataConsumer(ChunkRange.X + StreamState->ReceivedSize, TArrayView64<const uint8>(static_cast<const uint8*>(Ptr), Length)))
+		{
+			return false;
+		}
+
+		StreamState->ReceivedSize += Length;
+		return true;
+	};
+
+#if UE_VERSION_OLDER_THAN(5, 5, 0)
+	HttpRequestRef->SetResponseBodyReceiveStreamDelegate(FHttpRequestStreamDelegate::CreateLambda([ReceiveBody](void* Ptr, int64 Length)
+	{
+		return ReceiveBody(Ptr, Length);
+	}));
+#else
+	HttpRequestRef->SetResponseBodyReceiveStreamDelegateV2(FHttpRequestStreamDelegateV2::CreateLambda([ReceiveBody](void* Ptr, int64& Length)
+	{
+		if (!ReceiveBody(Ptr, Length))
+		{
+			// Consuming less than received fails the request
+			Length = 0;
+		}
+	}));
+#endif
+#endif
+
+	const double RequestStartTime = RecordRequestStarted(URL);
+
 	TSharedPtr<TPromise<FRuntimeChunkDownloaderResult>> PromisePtr = MakeShared<TPromise<FRuntimeChunkDownloaderResult>>();
-	HttpRequestRef->OnProcessRequestComplete().BindLambda([WeakThisPtr, PromisePtr, URL, ChunkRange](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess) mutable
+	HttpRequestRef->OnProcessRequestComplete().BindLambda([WeakThisPtr, PromisePtr, URL, ChunkRange, RequestStartTime
+#if RUNTIMEFILESDOWNLOADER_STREAM_CHUNK_RESPONSES
+		, StreamState
+#endif
+	](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess) mutable
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(FRuntimeChunkDownloader::DownloadFileByChunk::OnComplete);
+
 		TSharedPtr<FRuntimeChunkDownloader> SharedThis = WeakThisPtr.Pin();
 		if (!SharedThis.IsValid())
 		{
@@ -410,6 +562,13 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFileByCh
 			return;
 		}
 
+#if RUNTIMEFILESDOWNLOADER_STREAM_CHUNK_RESPONSES
+		const int64 ReceivedSize = StreamState->ReceivedSize;
+#else
+		const int64 ReceivedSize = Response.IsValid() ? Response->GetContent().Num() : 0;
+#endif
+		SharedThis->RecordRequestCompleted(RequestStartTime, ReceivedSize, bSuccess && Response.IsValid() && EHttpResponseCodes::IsOk(Response->GetResponseCode()), true);
+
 		if (SharedThis->bCanceled)
 		{
 			UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Canceled file chunk download from %s"), *URL);
@@ -424,28 +583,66 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFileByCh
 			return;
 		}
 
-		if (Response->GetContentLength() <= 0)
+		if (!IsValidChunkResponse(Response, ChunkRange))
 		{
-			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: content length is 0"), *Request->GetURL());
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: response code %d with Content-Range '%s' does not match the requested range (%lld; %lld)"), *Request->GetURL(), Response->GetResponseCode(), *Response->GetHeader(TEXT("Content-Range")), ChunkRange.X, ChunkRange.Y);
 			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()});
 			return;
 		}
 
-		const int64 ContentLength = FCString::Atoi64(*Response->GetHeader("Content-Length"));
-
-		if (ContentLength != ChunkRange.Y - ChunkRange.X + 1)
+		// The received payload is checked rather than the Content-Length header, which chunked responses do not have
+		if (ReceivedSize != ChunkRange.Y - ChunkRange.X + 1)
 		{
-			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: content length (%lld) does not match the expected length (%lld)"), *Request->GetURL(), ContentLength, ChunkRange.Y - ChunkRange.X + 1);
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: received %lld bytes, expected %lld"), *Request->GetURL(), ReceivedSize, ChunkRange.Y - ChunkRange.X + 1);
 			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()});
 			return;
 		}
 
-		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Successfully downloaded file chunk from %s. Range: {%lld; %lld}, Overall: %lld"), *Request->GetURL(), ChunkRange.X, ChunkRange.Y, ContentLength);
-		PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Success, TArray64<uint8>(Response->GetContent())});
+		UE_LOG(LogRuntimeFilesDownloader, Verbose, TEXT("Successfully downloaded file chunk from %s. Range: {%lld; %lld}, Overall: %lld"), *Request->GetURL(), ChunkRange.X, ChunkRange.Y, ReceivedSize);
+
+#if RUNTIMEFILESDOWNLOADER_STREAM_CHUNK_RESPONSES
+
+		if (SharedThis->ChunkDataConsumer)
+		{
+			// The whole body may have arrived before the headers could be checked, in which case it has been held back until now
+			if (!StreamState->bResponseValidated && StreamState->Data.Num() > 0 && !SharedThis->ChunkDataConsumer(ChunkRange.X, TArrayView64<const uint8>(StreamState->Data.GetData(), StreamState->Data.Num())))
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: chunk data consumer failed"), *Request->GetURL());
+				PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()});
+				return;
+			}
+			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Success, TArray64<uint8>()});
+			return;
+		}
+
+		// The data has already been received into the pooled buffer
+		PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Success, MoveTemp(StreamState->Data)});
+#else
+		const TArray<uint8>& Content = Response->GetContent();
+		if (SharedThis->ChunkDataConsumer)
+		{
+			if (!SharedThis->ChunkDataConsumer(ChunkRange.X, TArrayView64<const uint8>(Content.GetData(), Content.Num())))
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: chunk data consumer failed"), *Request->GetURL());
+				PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()});
+				return;
+			}
+			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Success, TArray64<uint8>()});
+			return;
+		}
+
+		TArray64<uint8> ChunkData = SharedThis->BufferPool->Acquire(Content.Num());
+		FMemory::Memcpy(ChunkData.GetData(), Content.GetData(), Content.Num());
+		PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Success, MoveTemp(ChunkData)});
+#endif
 	});
 
 	if (!HttpRequestRef->ProcessRequest())
 	{
+		// The completion delegate will not report this request, so it is accounted for here
+		HttpRequestRef->OnProcessRequestComplete().Unbind();
+		RecordRequestCompleted(RequestStartTime, 0, false, false);
+
 		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file chunk from %s: request failed"), *URL);
 		return MakeFulfilledPromise<FRuntimeChunkDownloaderResult>(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()}).GetFuture();
 	}
@@ -491,14 +688,19 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFileByPa
 		{
 			const int64 ContentLength = Request->GetContentLength();
 			const float Progress = ContentLength <= 0 ? 0.0f : static_cast<float>(BytesReceived) / ContentLength;
-			UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Downloaded %lld bytes of file chunk from %s by payload. Overall: %lld, Progress: %f"), static_cast<int64>(BytesReceived), *Request->GetURL(), static_cast<int64>(Request->GetContentLength()), Progress);
+			UE_LOG(LogRuntimeFilesDownloader, VeryVerbose, TEXT("Downloaded %lld bytes of file chunk from %s by payload. Overall: %lld, Progress: %f"), static_cast<int64>(BytesReceived), *Request->GetURL(), static_cast<int64>(Request->GetContentLength()), Progress);
+			SharedThis->RecordRequestProgress(BytesReceived);
 			OnProgress(BytesReceived, ContentLength);
 		}
 	});
 
+	const double RequestStartTime = RecordRequestStarted(URL);
+
 	TSharedPtr<TPromise<FRuntimeChunkDownloaderResult>> PromisePtr = MakeShared<TPromise<FRuntimeChunkDownloaderResult>>();
-	HttpRequestRef->OnProcessRequestComplete().BindLambda([WeakThisPtr, PromisePtr, URL](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess) mutable
+	HttpRequestRef->OnProcessRequestComplete().BindLambda([WeakThisPtr, PromisePtr, URL, RequestStartTime](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess) mutable
 	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(FRuntimeChunkDownloader::DownloadFileByPayload::OnComplete);
+
 		TSharedPtr<FRuntimeChunkDownloader> SharedThis = WeakThisPtr.Pin();
 		if (!SharedThis.IsValid())
 		{
@@ -507,6 +709,8 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFileByPa
 			return;
 		}
 
+		SharedThis->RecordRequestCompleted(RequestStartTime, Response.IsValid() ? Response->GetContent().Num() : 0, bSuccess && Response.IsValid() && EHttpResponseCodes::IsOk(Response->GetResponseCode()), true);
+
 		if (SharedThis->bCanceled)
 		{
 			UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Canceled file download from %s by payload"), *URL);
@@ -521,19 +725,24 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFileByPa
 			return;
 		}
 
-		if (Response->GetContentLength() <= 0)
+		// The payload is what was downloaded by definition, so its size is checked rather than the Content-Length header, which chunked responses do not have
+		if (Response->GetContent().Num() <= 0)
 		{
-			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file from %s by payload: content length is 0"), *Request->GetURL());
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file from %s by payload: the response is empty"), *Request->GetURL());
 			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()});
 			return;
 		}
 
-		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Successfully downloaded file from %s by payload. Overall: %lld"), *Request->GetURL(), static_cast<int64>(Response->GetContentLength()));
+		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Successfully downloaded file from %s by payload. Overall: %lld"), *Request->GetURL(), static_cast<int64>(Response->GetContent().Num()));
 		return PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::SucceededByPayload, TArray64<uint8>(Response->GetContent())});
 	});
 
 	if (!HttpRequestRef->ProcessRequest())
 	{
+		// The completion delegate will not report this request, so it is accounted for here
+		HttpRequestRef->OnProcessRequestComplete().Unbind();
+		RecordRequestCompleted(RequestStartTime, 0, false, false);
+
 		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file from %s by payload: request failed"), *URL);
 		return MakeFulfilledPromise<FRuntimeChunkDownloaderResult>(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()}).GetFuture();
 	}
@@ -542,6 +751,119 @@ TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFileByPa
 	return PromisePtr->GetFuture();
 }
 
+TFuture<FRuntimeChunkDownloaderResult> FRuntimeChunkDownloader::DownloadFileConditional(const FString& URL, float Timeout, const FString& ContentType, const FRuntimeHttpCacheEntry& CachedEntry, const FOnProgress& OnProgress)
+{
+	if (bCanceled)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Canceled file download from %s"), *URL);
+		return MakeFulfilledPromise<FRuntimeChunkDownloaderResult>(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Cancelled, TArray64<uint8>()}).GetFuture();
+	}
+
+	TWeakPtr<FRuntimeChunkDownloader> WeakThisPtr = AsShared();
+
+#if UE_VERSION_NEWER_THAN(4, 26, 0)
+	const TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequestRef = FHttpModule::Get().CreateRequest();
+#else
+	const TSharedRef<IHttpRequest> HttpRequestRef = FHttpModule::Get().CreateRequest();
+#endif
+
+	HttpRequestRef->SetVerb("GET");
+	HttpRequestRef->SetURL(URL);
+
+#if UE_VERSION_NEWER_THAN(4, 26, 0)
+	HttpRequestRef->SetTimeout(Timeout);
+#else
+	UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("The Timeout feature is only supported in engine version 4.26 or later. Please update your engine to use this feature"));
+#endif
+
+	if (!ContentType.IsEmpty())
+	{
+		HttpRequestRef->SetHeader(TEXT("Content-Type"), ContentType);
+	}
+
+	FRuntimeHttpCache::ApplyConditionalHeaders(HttpRequestRef, CachedEntry);
+
+	HttpRequestRef->
+#if UE_VERSION_OLDER_THAN(5, 4, 0)
+		OnRequestProgress().BindLambda([WeakThisPtr, OnProgress](FHttpRequestPtr Request, int32 BytesSent, int32 BytesReceived)
+#else
+		OnRequestProgress64().BindLambda([WeakThisPtr, OnProgress](FHttpRequestPtr Request, uint64 BytesSent, uint64 BytesReceived)
+#endif
+	{
+		TSharedPtr<FRuntimeChunkDownloader> SharedThis = WeakThisPtr.Pin();
+		if (SharedThis.IsValid())
+		{
+			SharedThis->RecordRequestProgress(BytesReceived);
+			OnProgress(BytesReceived, Request->GetContentLength());
+		}
+	});
+
+	const double RequestStartTime = RecordRequestStarted(URL);
+
+	TSharedPtr<TPromise<FRuntimeChunkDownloaderResult>> PromisePtr = MakeShared<TPromise<FRuntimeChunkDownloaderResult>>();
+	HttpRequestRef->OnProcessRequestComplete().BindLambda([WeakThisPtr, PromisePtr, URL, RequestStartTime](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccess) mutable
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(FRuntimeChunkDownloader::DownloadFileConditional::OnComplete);
+
+		TSharedPtr<FRuntimeChunkDownloader> SharedThis = WeakThisPtr.Pin();
+		if (!SharedThis.IsValid())
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Failed to download file from %s conditionally: downloader has been destroyed"), *URL);
+			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()});
+			return;
+		}
+
+		SharedThis->RecordRequestCompleted(RequestStartTime, Response.IsValid() ? Response->GetContent().Num() : 0, bSuccess && Response.IsValid() && (EHttpResponseCodes::IsOk(Response->GetResponseCode()) || Response->GetResponseCode() == EHttpResponseCodes::NotModified), true);
+
+		if (SharedThis->bCanceled)
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Canceled file download from %s conditionally"), *URL);
+			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Cancelled, TArray64<uint8>()});
+			return;
+		}
+
+		if (!bSuccess || !Response.IsValid())
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file from %s conditionally: request failed"), *URL);
+			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()});
+			return;
+		}
+
+		if (Response->GetResponseCode() == EHttpResponseCodes::NotModified)
+		{
+			FRuntimeHttpCache::Get().Refresh(URL, Response);
+			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::SucceededFromCache, TArray64<uint8>()});
+			return;
+		}
+
+		if (!EHttpResponseCodes::IsOk(Response->GetResponseCode()) || Response->GetContent().Num() <= 0)
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file from %s conditionally: response code %d, payload size %lld"), *URL, Response->GetResponseCode(), static_cast<int64>(Response->GetContent().Num()));
+			PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()});
+			return;
+		}
+
+		TArray64<uint8> Data(Response->GetContent());
+		FRuntimeHttpCache::Get().Store(URL, Response, Data);
+
+		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Successfully downloaded file from %s conditionally. Overall: %lld"), *URL, Data.Num());
+		PromisePtr->SetValue(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::Success, MoveTemp(Data)});
+	});
+
+	if (!HttpRequestRef->ProcessRequest())
+	{
+		// The completion delegate will not report this request, so it is accounted for here
+		HttpRequestRef->OnProcessRequestComplete().Unbind();
+		RecordRequestCompleted(RequestStartTime, 0, false, false);
+
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to download file from %s conditionally: request failed"), *URL);
+		return MakeFulfilledPromise<FRuntimeChunkDownloaderResult>(FRuntimeChunkDownloaderResult{EDownloadToMemoryResult::DownloadFailed, TArray64<uint8>()}).GetFuture();
+	}
+
+	HttpRequestPtr = HttpRequestRef;
+	return PromisePtr->GetFuture();
+}
+
 TFuture<int64> FRuntimeChunkDownloader::GetContentSize(const FString& URL, float Timeout)
 {
 	TSharedPtr<TPromise<int64>> PromisePtr = MakeShared<TPromise<int64>>();
@@ -555,14 +877,22 @@ TFuture<int64> FRuntimeChunkDownloader::GetContentSize(const FString& URL, float
 	HttpRequestRef->SetVerb("HEAD");
 	HttpRequestRef->SetURL(URL);
 
+	TWeakPtr<FRuntimeChunkDownloader> WeakThisPtr = AsShared();
+	const double RequestStartTime = RecordRequestStarted(URL);
+
 #if UE_VERSION_NEWER_THAN(4, 26, 0)
 	HttpRequestRef->SetTimeout(Timeout);
 #else
 	UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("The Timeout feature is only supported in engine version 4.26 or later. Please update your engine to use this feature"));
 #endif
 
-	HttpRequestRef->OnProcessRequestComplete().BindLambda([PromisePtr, URL](const FHttpRequestPtr& Request, const FHttpResponsePtr& Response, const bool bSucceeded)
+	HttpRequestRef->OnProcessRequestComplete().BindLambda([WeakThisPtr, PromisePtr, URL, RequestStartTime](const FHttpRequestPtr& Request, const FHttpResponsePtr& Response, const bool bSucceeded)
 	{
+		if (TSharedPtr<FRuntimeChunkDownloader> SharedThis = WeakThisPtr.Pin())
+		{
+			SharedThis->RecordRequestCompleted(RequestStartTime, 0, bSucceeded && Response.IsValid(), false);
+		}
+
 		if (!bSucceeded || !Response.IsValid())
 		{
 			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to get size of file from %s: request failed"), *URL);
@@ -584,6 +914,10 @@ TFuture<int64> FRuntimeChunkDownloader::GetContentSize(const FString& URL, float
 
 	if (!HttpRequestRef->ProcessRequest())
 	{
+		// The completion delegate will not report this request, so it is accounted for here
+		HttpRequestRef->OnProcessRequestComplete().Unbind();
+		RecordRequestCompleted(RequestStartTime, 0, false, false);
+
 		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Failed to get size of file from %s: request failed"), *URL);
 		return MakeFulfilledPromise<int64>(0).GetFuture();
 	}
@@ -608,6 +942,136 @@ void FRuntimeChunkDownloader::CancelDownload()
 	UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Download canceled"));
 }
 
+FRuntimeDownloadStats FRuntimeChunkDownloader::GetStats() const
+{
+	FScopeLock Lock(&StatsMutex);
+	return Stats;
+}
+
+TSharedRef<FRuntimeChunkBufferPool> FRuntimeChunkDownloader::GetBufferPool() const
+{
+	return BufferPool;
+}
+
+void FRuntimeChunkDownloader::SetBufferPool(const TSharedRef<FRuntimeChunkBufferPool>& InBufferPool)
+{
+	BufferPool = InBufferPool;
+}
+
+void FRuntimeChunkDownloader::SetChunkDataConsumer(FOnChunkData InChunkDataConsumer)
+{
+	ChunkDataConsumer = MoveTemp(InChunkDataConsumer);
+}
+
+bool FRuntimeChunkDownloader::IsValidChunkResponse(const FHttpResponsePtr& Response, FInt64Vector2 ChunkRange)
+{
+	if (!Response.IsValid() || !EHttpResponseCodes::IsOk(Response->GetResponseCode()))
+	{
+		return false;
+	}
+
+	// A server ignoring the Range header responds with the file from its beginning
+	if (Response->GetResponseCode() != EHttpResponseCodes::PartialContent)
+	{
+		return ChunkRange.X == 0;
+	}
+
+	// Content-Range: bytes <first>-<last>/<size>
+	FString Unit, Range, First, LastAndSize, Last;
+	if (!Response->GetHeader(TEXT("Content-Range")).Split(TEXT(" "), &Unit, &Range) || Unit != TEXT("bytes") || !Range.Split(TEXT("-"), &First, &LastAndSize) || !LastAndSize.Split(TEXT("/"), &Last, nullptr))
+	{
+		return false;
+	}
+
+	return FCString::Atoi64(*First) == ChunkRange.X && FCString::Atoi64(*Last) == ChunkRange.Y;
+}
+
+double FRuntimeChunkDownloader::RecordRequestStarted(const FString& URL)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FScopeLock Lock(&StatsMutex);
+	if (Stats.RequestCount == 0)
+	{
+		StatsURL = URL;
+		TransferStartTime = Now;
+		LastThroughputSampleTime = Now;
+		LastThroughputSampleBytes = 0;
+	}
+	++Stats.RequestCount;
+	InFlightRequestBytes = 0;
+
+	INC_DWORD_STAT(STAT_RuntimeFilesDownloader_RequestsInFlight);
+	INC_DWORD_STAT(STAT_RuntimeFilesDownloader_RequestsIssued);
+	return Now;
+}
+
+void FRuntimeChunkDownloader::RecordRequestProgress(int64 RequestBytesReceived)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FScopeLock Lock(&StatsMutex);
+	InFlightRequestBytes = RequestBytesReceived;
+
+	if (Stats.TimeToFirstByte < 0 && RequestBytesReceived > 0)
+	{
+		Stats.TimeToFirstByte = Now - TransferStartTime;
+	}
+
+	const double SampleDuration = Now - LastThroughputSampleTime;
+	if (SampleDuration >= FRuntimeDownloadStats::ThroughputSampleInterval)
+	{
+		const int64 OverallBytesReceived = Stats.BytesReceived + InFlightRequestBytes;
+		const float Throughput = (OverallBytesReceived - LastThroughputSampleBytes) / SampleDuration;
+		Stats.ThroughputSamples.Add(Throughput);
+		Stats.PeakThroughput = FMath::Max(Stats.PeakThroughput, Throughput);
+		LastThroughputSampleTime = Now;
+		LastThroughputSampleBytes = OverallBytesReceived;
+	}
+}
+
+void FRuntimeChunkDownloader::RecordRequestCompleted(double RequestStartTime, int64 RequestBytesReceived, bool bSucceeded, bool bRecordLatency)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FScopeLock Lock(&StatsMutex);
+	InFlightRequestBytes = 0;
+	Stats.BytesReceived += RequestBytesReceived;
+	Stats.ElapsedTime = Now - TransferStartTime;
+	Stats.AverageThroughput = Stats.ElapsedTime > 0 ? Stats.BytesReceived / Stats.ElapsedTime : 0;
+
+	if (Stats.TimeToFirstByte < 0 && RequestBytesReceived > 0)
+	{
+		Stats.TimeToFirstByte = Stats.ElapsedTime;
+	}
+
+	if (bRecordLatency)
+	{
+		Stats.AddRangeLatency(Now - RequestStartTime);
+	}
+
+	if (!bSucceeded)
+	{
+		++Stats.FailedRequests;
+		INC_DWORD_STAT(STAT_RuntimeFilesDownloader_RequestsFailed);
+	}
+
+	DEC_DWORD_STAT(STAT_RuntimeFilesDownloader_RequestsInFlight);
+	INC_FLOAT_STAT_BY(STAT_RuntimeFilesDownloader_ReceivedMB, RequestBytesReceived / (1024.f * 1024.f));
+}
+
+void FRuntimeChunkDownloader::RecordRetry()
+{
+	FScopeLock Lock(&StatsMutex);
+
+	const int64 DiscardedBytes = Stats.BytesReceived + InFlightRequestBytes - Stats.WastedBytes;
+	Stats.WastedBytes += DiscardedBytes;
+	++Stats.Retries;
+
+	INC_DWORD_STAT(STAT_RuntimeFilesDownloader_Retries);
+	INC_FLOAT_STAT_BY(STAT_RuntimeFilesDownloader_WastedMB, DiscardedBytes / (1024.f * 1024.f));
+}
+
 TFuture<bool> FRuntimeChunkDownloader::CheckAndRequestPermissions()
 {
 #if PLATFORM_ANDROID
@@ -0,0 +1,60 @@
+// Georgy Treshchev 2024.
+
+#include "RuntimeDownloadStats.h"
+
+FRuntimeDownloadStats::FRuntimeDownloadStats()
+	: TimeToFirstByte(-1.f)
+	, ElapsedTime(0.f)
+	, BytesReceived(0)
+	, WastedBytes(0)
+	, RequestCount(0)
+	, Retries(0)
+	, FailedRequests(0)
+	, AverageThroughput(0.f)
+	, PeakThroughput(0.f)
+{
+	RangeLatencyHistogram.SetNumZeroed(GetRangeLatencyBucketBounds().Num() + 1);
+}
+
+const TArray<float>& FRuntimeDownloadStats::GetRangeLatencyBucketBounds()
+{
+	static const TArray<float> BucketBounds = {50.f, 100.f, 250.f, 500.f, 1000.f, 2500.f, 5000.f, 10000.f};
+	return BucketBounds;
+}
+
+void FRuntimeDownloadStats::AddRangeLatency(double LatencySeconds)
+{
+	const TArray<float>& BucketBounds = GetRangeLatencyBucketBounds();
+	const double LatencyMs = LatencySeconds * 1000.0;
+
+	int32 BucketIndex = 0;
+	while (BucketIndex < BucketBounds.Num() && LatencyMs > BucketBounds[BucketIndex])
+	{
+		++BucketIndex;
+	}
+
+	if (RangeLatencyHistogram.Num() != BucketBounds.Num() + 1)
+	{
+		RangeLatencyHistogram.SetNumZeroed(BucketBounds.Num() + 1);
+	}
+	++RangeLatencyHistogram[BucketIndex];
+}
+
+FString FRuntimeDownloadStats::ToString() const
+{
+	const TArray<float>& BucketBounds = GetRangeLatencyBucketBounds();
+
+	FString Histogram;
+	for (int32 BucketIndex = 0; BucketIndex < RangeLatencyHistogram.Num(); ++BucketIndex)
+	{
+		if (RangeLatencyHistogram[BucketIndex] == 0)
+		{
+			continue;
+		}
+		const FString BucketName = BucketBounds.IsValidIndex(BucketIndex) ? FString::Printf(TEXT("<=%.0fms"), BucketBounds[BucketIndex]) : FString::Printf(TEXT(">%.0fms"), BucketBounds.Last());
+		Histogram += FString::Printf(TEXT("%s%s: %d"), Histogram.IsEmpty() ? TEXT("") : TEXT(", "), *BucketName, RangeLatencyHistogram[BucketIndex]);
+	}
+
+	return FString::Printf(TEXT("TTFB: %.3fs, elapsed: %.3fs, received: %lld bytes, wasted: %lld bytes, requests: %d (failed: %d), retries: %d, throughput: avg %.1f KB/s, peak %.1f KB/s, latency: {%s}"),
+		TimeToFirstByte, ElapsedTime, BytesReceived, WastedBytes, RequestCount, FailedRequests, Retries, AverageThroughput / 1024.f, PeakThroughput / 1024.f, *Histogram);
+}
@@ -0,0 +1,290 @@
+﻿// Georgy Treshchev 2024.
+
+#include "RuntimeHttpCache.h"
+#include "RuntimeFilesDownloaderDefines.h"
+#include "RuntimeStorageSink.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Templates/UniquePtr.h"
+
+namespace
+{
+	/** Bumped whenever the layout of the metadata file changes, invalidating previously cached entries */
+	constexpr int32 RuntimeHttpCacheVersion = 1;
+
+	/**
+	 * Write the data to a temporary file next to the target and move it into place, so that readers never observe a partially written file
+	 */
+	bool WriteFileAtomically(const FString& FilePath, const uint8* Data, int64 Size)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		const FString TempFilePath = FilePath + TEXT(".tmp");
+
+		{
+			TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*TempFilePath));
+			if (!FileHandle.IsValid())
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to open '%s' for writing the HTTP cache"), *TempFilePath);
+				return false;
+			}
+
+			if (Size > 0 && !FileHandle->Write(Data, Size))
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to write %lld bytes to '%s' for the HTTP cache"), Size, *TempFilePath);
+				FileHandle.Reset();
+				PlatformFile.DeleteFile(*TempFilePath);
+				return false;
+			}
+		}
+
+		// Replaced in a single step, so that the previous version stays readable until the new one is in place
+		if (!FRuntimeStorageSink::ReplaceFile(TempFilePath, FilePath))
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to move '%s' to '%s' for the HTTP cache"), *TempFilePath, *FilePath);
+			PlatformFile.DeleteFile(*TempFilePath);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+FRuntimeHttpCacheEntry::FRuntimeHttpCacheEntry()
+	: StoredTime(0)
+	, MaxAge(0)
+{}
+
+bool FRuntimeHttpCacheEntry::IsFresh() const
+{
+	return MaxAge > 0 && (FDateTime::UtcNow() - StoredTime).GetTotalSeconds() < MaxAge;
+}
+
+bool FRuntimeHttpCacheEntry::HasValidators() const
+{
+	return !ETag.IsEmpty() || !LastModified.IsEmpty();
+}
+
+FArchive& operator<<(FArchive& Ar, FRuntimeHttpCacheEntry& Entry)
+{
+	return Ar << Entry.URL << Entry.ETag << Entry.LastModified << Entry.StoredTime << Entry.MaxAge;
+}
+
+FRuntimeHttpCache& FRuntimeHttpCache::Get()
+{
+	static FRuntimeHttpCache Instance;
+	return Instance;
+}
+
+bool FRuntimeHttpCache::Find(const FString& URL, FRuntimeHttpCacheEntry& OutEntry, TArray64<uint8>& OutData) const
+{
+	FScopeLock Lock(&CacheMutex);
+
+	if (!ReadEntry(URL, OutEntry))
+	{
+		return false;
+	}
+
+	TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*GetDataFilePath(URL)));
+	if (!FileHandle.IsValid())
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("HTTP cache entry for %s has no body, ignoring it"), *URL);
+		return false;
+	}
+
+	OutData.SetNumUninitialized(FileHandle->Size());
+	if (!FileHandle->Read(OutData.GetData(), OutData.Num()))
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Unable to read the HTTP cache body for %s, ignoring it"), *URL);
+		OutData.Empty();
+		return false;
+	}
+
+	UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Found HTTP cache entry for %s (%lld bytes, ETag: '%s', Last-Modified: '%s')"), *URL, OutData.Num(), *OutEntry.ETag, *OutEntry.LastModified);
+	return true;
+}
+
+bool FRuntimeHttpCache::FindEntry(const FString& URL, FRuntimeHttpCacheEntry& OutEntry) const
+{
+	FScopeLock Lock(&CacheMutex);
+	return ReadEntry(URL, OutEntry);
+}
+
+bool FRuntimeHttpCache::Store(const FString& URL, const FHttpResponsePtr& Response, const TArray64<uint8>& Data)
+{
+	if (!Response.IsValid())
+	{
+		return false;
+	}
+
+	const FString CacheControl = Response->GetHeader(TEXT("Cache-Control"));
+	if (CacheControl.Contains(TEXT("no-store")))
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Not caching response from %s: Cache-Control is '%s'"), *URL, *CacheControl);
+		Remove(URL);
+		return false;
+	}
+
+	FRuntimeHttpCacheEntry Entry;
+	Entry.URL = URL;
+	Entry.ETag = Response->GetHeader(TEXT("ETag"));
+	Entry.LastModified = Response->GetHeader(TEXT("Last-Modified"));
+	Entry.StoredTime = FDateTime::UtcNow();
+	Entry.MaxAge = CacheControl.Contains(TEXT("no-cache")) ? 0 : ParseMaxAge(CacheControl);
+
+	if (!Entry.HasValidators() && Entry.MaxAge <= 0)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Not caching response from %s: no ETag, Last-Modified or max-age provided"), *URL);
+		return false;
+	}
+
+	FScopeLock Lock(&CacheMutex);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.DirectoryExists(*GetCacheDirectory()) && !PlatformFile.CreateDirectoryTree(*GetCacheDirectory()))
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to create HTTP cache directory '%s'"), *GetCacheDirectory());
+		return false;
+	}
+
+	// The body is written before the metadata so that a metadata file always refers to a complete body
+	if (!WriteFileAtomically(GetDataFilePath(URL), Data.GetData(), Data.Num()) || !WriteEntry(Entry))
+	{
+		PlatformFile.DeleteFile(*GetEntryFilePath(URL));
+		return false;
+	}
+
+	UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Stored response from %s in HTTP cache (%lld bytes, ETag: '%s', Last-Modified: '%s', max-age: %lld)"), *URL, Data.Num(), *Entry.ETag, *Entry.LastModified, Entry.MaxAge);
+	return true;
+}
+
+bool FRuntimeHttpCache::Refresh(const FString& URL, const FHttpResponsePtr& Response)
+{
+	FScopeLock Lock(&CacheMutex);
+
+	FRuntimeHttpCacheEntry Entry;
+	if (!ReadEntry(URL, Entry))
+	{
+		return false;
+	}
+
+	Entry.StoredTime = FDateTime::UtcNow();
+	if (Response.IsValid())
+	{
+		const FString ETag = Response->GetHeader(TEXT("ETag"));
+		if (!ETag.IsEmpty())
+		{
+			Entry.ETag = ETag;
+		}
+
+		const FString LastModified = Response->GetHeader(TEXT("Last-Modified"));
+		if (!LastModified.IsEmpty())
+		{
+			Entry.LastModified = LastModified;
+		}
+
+		const FString CacheControl = Response->GetHeader(TEXT("Cache-Control"));
+		if (!CacheControl.IsEmpty())
+		{
+			Entry.MaxAge = CacheControl.Contains(TEXT("no-cache")) ? 0 : ParseMaxAge(CacheControl);
+		}
+	}
+
+	UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("HTTP cache entry for %s revalidated (not modified)"), *URL);
+	return WriteEntry(Entry);
+}
+
+void FRuntimeHttpCache::Remove(const FString& URL)
+{
+	FScopeLock Lock(&CacheMutex);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.DeleteFile(*GetEntryFilePath(URL));
+	PlatformFile.DeleteFile(*GetDataFilePath(URL));
+}
+
+bool FRuntimeHttpCache::Clear()
+{
+	FScopeLock Lock(&CacheMutex);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.DirectoryExists(*GetCacheDirectory()))
+	{
+		return true;
+	}
+	return PlatformFile.DeleteDirectoryRecursively(*GetCacheDirectory());
+}
+
+FString FRuntimeHttpCache::GetCacheDirectory()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("RuntimeFilesDownloader"), TEXT("HttpCache"));
+}
+
+FString FRuntimeHttpCache::GetEntryFilePath(const FString& URL)
+{
+	return FPaths::Combine(GetCacheDirectory(), FMD5::HashAnsiString(*URL) + TEXT(".meta"));
+}
+
+FString FRuntimeHttpCache::GetDataFilePath(const FString& URL)
+{
+	return FPaths::Combine(GetCacheDirectory(), FMD5::HashAnsiString(*URL) + TEXT(".bin"));
+}
+
+bool FRuntimeHttpCache::WriteEntry(const FRuntimeHttpCacheEntry& Entry) const
+{
+	TArray<uint8> SerializedEntry;
+	FMemoryWriter Writer(SerializedEntry);
+
+	int32 Version = RuntimeHttpCacheVersion;
+	Writer << Version;
+	Writer << const_cast<FRuntimeHttpCacheEntry&>(Entry);
+
+	return WriteFileAtomically(GetEntryFilePath(Entry.URL), SerializedEntry.GetData(), SerializedEntry.Num());
+}
+
+bool FRuntimeHttpCache::ReadEntry(const FString& URL, FRuntimeHttpCacheEntry& OutEntry) const
+{
+	TArray<uint8> SerializedEntry;
+	if (!FFileHelper::LoadFileToArray(SerializedEntry, *GetEntryFilePath(URL), FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(SerializedEntry);
+
+	int32 Version = 0;
+	Reader << Version;
+	if (Version != RuntimeHttpCacheVersion)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("HTTP cache entry for %s has an outdated version (%d, expected %d), ignoring it"), *URL, Version, RuntimeHttpCacheVersion);
+		return false;
+	}
+
+	Reader << OutEntry;
+	if (Reader.IsError() || OutEntry.URL != URL)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("HTTP cache entry for %s is corrupted, ignoring it"), *URL);
+		return false;
+	}
+
+	return true;
+}
+
+int64 FRuntimeHttpCache::ParseMaxAge(const FString& CacheControl)
+{
+	TArray<FString> Directives;
+	CacheControl.ParseIntoArray(Directives, TEXT(","));
+	for (FString& Directive : Directives)
+	{
+		Directive.TrimStartAndEndInline();
+		if (Directive.StartsWith(TEXT("max-age="), ESearchCase::IgnoreCase))
+		{
+			return FMath::Max<int64>(0, FCString::Atoi64(*Directive.RightChop(8)));
+		}
+	}
+	return 0;
+}
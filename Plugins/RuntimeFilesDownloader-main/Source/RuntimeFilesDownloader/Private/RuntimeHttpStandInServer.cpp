@@ -0,0 +1,343 @@
+// Georgy Treshchev 2024.
+
+#include "RuntimeHttpStandInServer.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "RuntimeFilesDownloaderDefines.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+namespace
+{
+	/** The size of each slice of the body sent at once, which also defines the granularity of bandwidth throttling */
+	constexpr int32 StandInSendSliceSize = 16 * 1024;
+
+	/** The maximum size of the request headers */
+	constexpr int32 StandInMaxRequestSize = 16 * 1024;
+
+	/**
+	 * Parse a "bytes=Start-End" Range header value. Open-ended and suffix ranges are supported
+	 */
+	bool ParseRangeHeader(const FString& RangeValue, int64 PayloadSize, int64& OutStart, int64& OutEnd)
+	{
+		FString Range = RangeValue.TrimStartAndEnd();
+		if (!Range.RemoveFromStart(TEXT("bytes=")))
+		{
+			return false;
+		}
+
+		FString StartString, EndString;
+		if (!Range.Split(TEXT("-"), &StartString, &EndString))
+		{
+			return false;
+		}
+
+		if (StartString.IsEmpty())
+		{
+			// Suffix range, i.e. the last N bytes
+			const int64 SuffixLength = FCString::Atoi64(*EndString);
+			OutStart = FMath::Max<int64>(PayloadSize - SuffixLength, 0);
+			OutEnd = PayloadSize - 1;
+		}
+		else
+		{
+			OutStart = FCString::Atoi64(*StartString);
+			OutEnd = EndString.IsEmpty() ? PayloadSize - 1 : FMath::Min(FCString::Atoi64(*EndString), PayloadSize - 1);
+		}
+
+		return OutStart >= 0 && OutStart <= OutEnd;
+	}
+}
+
+FRuntimeHttpStandInServerSettings::FRuntimeHttpStandInServerSettings()
+	: Port(0)
+	, PayloadSize(64 * 1024 * 1024)
+	, BandwidthBytesPerSecond(0)
+	, LatencySeconds(0)
+	, FailureRate(0)
+	, bSupportRange(true)
+	, bSendContentLength(true)
+{}
+
+FRuntimeHttpStandInServer::FRuntimeHttpStandInServer(const FRuntimeHttpStandInServerSettings& InSettings)
+	: Settings(InSettings)
+	, ListenSocket(nullptr)
+	, Thread(nullptr)
+	, BoundPort(0)
+	, bStopping(false)
+	, FailureRandomStream(0x5EED)
+{}
+
+FRuntimeHttpStandInServer::~FRuntimeHttpStandInServer()
+{
+	Shutdown();
+}
+
+bool FRuntimeHttpStandInServer::Start()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (!SocketSubsystem)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to start the HTTP stand-in server: no socket subsystem"));
+		return false;
+	}
+
+	ListenSocket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("RuntimeHttpStandInServer"), false);
+	if (!ListenSocket)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to start the HTTP stand-in server: failed to create a socket"));
+		return false;
+	}
+
+	TSharedRef<FInternetAddr> Address = SocketSubsystem->CreateInternetAddr();
+	Address->SetLoopbackAddress();
+	Address->SetPort(Settings.Port);
+
+	ListenSocket->SetReuseAddr();
+	if (!ListenSocket->Bind(*Address) || !ListenSocket->Listen(8))
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to start the HTTP stand-in server: failed to listen on port %d"), Settings.Port);
+		SocketSubsystem->DestroySocket(ListenSocket);
+		ListenSocket = nullptr;
+		return false;
+	}
+
+	BoundPort = ListenSocket->GetPortNo();
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("RuntimeHttpStandInServer"));
+
+	UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("HTTP stand-in server listening on %s (size: %lld, bandwidth: %lld B/s, latency: %.3fs, failure rate: %.2f, range: %d, content length: %d)"),
+		*GetURL(), Settings.PayloadSize, Settings.BandwidthBytesPerSecond, Settings.LatencySeconds, Settings.FailureRate, Settings.bSupportRange, Settings.bSendContentLength);
+	return Thread != nullptr;
+}
+
+void FRuntimeHttpStandInServer::Shutdown()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (ListenSocket)
+	{
+		ListenSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+		ListenSocket = nullptr;
+	}
+}
+
+FString FRuntimeHttpStandInServer::GetURL() const
+{
+	return FString::Printf(TEXT("http://127.0.0.1:%d/payload.bin"), BoundPort);
+}
+
+uint8 FRuntimeHttpStandInServer::GetPayloadByte(int64 Offset)
+{
+	// A cheap pattern that does not repeat at power-of-two boundaries, so misplaced chunks are detected
+	return static_cast<uint8>((Offset * 31 + (Offset >> 11)) % 251);
+}
+
+bool FRuntimeHttpStandInServer::VerifyPayload(const uint8* Data, int64 Size, int64 Offset)
+{
+	for (int64 Index = 0; Index < Size; ++Index)
+	{
+		if (Data[Index] != GetPayloadByte(Offset + Index))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32 FRuntimeHttpStandInServer::Run()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	while (!bStopping)
+	{
+		bool bHasPendingConnection = false;
+		if (!ListenSocket->WaitForPendingConnection(bHasPendingConnection, FTimespan::FromMilliseconds(100)) || !bHasPendingConnection)
+		{
+			continue;
+		}
+
+		FSocket* Connection = ListenSocket->Accept(TEXT("RuntimeHttpStandInConnection"));
+		if (!Connection)
+		{
+			continue;
+		}
+
+		ServeConnection(Connection);
+
+		Connection->Close();
+		SocketSubsystem->DestroySocket(Connection);
+	}
+	return 0;
+}
+
+void FRuntimeHttpStandInServer::Stop()
+{
+	bStopping = true;
+}
+
+void FRuntimeHttpStandInServer::ServeConnection(FSocket* Connection)
+{
+	// Read the request headers
+	TArray<uint8> RequestData;
+	{
+		uint8 Buffer[4096];
+		while (!bStopping && RequestData.Num() < StandInMaxRequestSize)
+		{
+			if (!Connection->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(5)))
+			{
+				return;
+			}
+
+			int32 BytesRead = 0;
+			if (!Connection->Recv(Buffer, sizeof(Buffer), BytesRead) || BytesRead <= 0)
+			{
+				return;
+			}
+			RequestData.Append(Buffer, BytesRead);
+
+			const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(RequestData.GetData()), RequestData.Num());
+			if (FString(Converted.Length(), Converted.Get()).Contains(TEXT("\r\n\r\n")))
+			{
+				break;
+			}
+		}
+	}
+
+	const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(RequestData.GetData()), RequestData.Num());
+	TArray<FString> Lines;
+	FString(Converted.Length(), Converted.Get()).ParseIntoArray(Lines, TEXT("\r\n"));
+	if (Lines.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FString> RequestLine;
+	Lines[0].ParseIntoArrayWS(RequestLine);
+	if (RequestLine.Num() < 2)
+	{
+		return;
+	}
+
+	const bool bIsHead = RequestLine[0].Equals(TEXT("HEAD"));
+	FString RangeValue;
+	for (int32 LineIndex = 1; LineIndex < Lines.Num(); ++LineIndex)
+	{
+		FString HeaderName, HeaderValue;
+		if (Lines[LineIndex].Split(TEXT(":"), &HeaderName, &HeaderValue) && HeaderName.TrimStartAndEnd().Equals(TEXT("Range"), ESearchCase::IgnoreCase))
+		{
+			RangeValue = HeaderValue;
+		}
+	}
+
+	NumRequests.Increment();
+
+	if (Settings.LatencySeconds > 0)
+	{
+		FPlatformProcess::Sleep(Settings.LatencySeconds);
+	}
+
+	// Build the response headers
+	int64 BodyStart = 0;
+	int64 BodyEnd = Settings.PayloadSize - 1;
+	FString Headers;
+	if (Settings.bSupportRange && !RangeValue.IsEmpty() && !bIsHead)
+	{
+		if (!ParseRangeHeader(RangeValue, Settings.PayloadSize, BodyStart, BodyEnd))
+		{
+			Headers = FString::Printf(TEXT("HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%lld\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"), Settings.PayloadSize);
+			const FTCHARToUTF8 HeadersUtf8(*Headers);
+			SendAll(Connection, reinterpret_cast<const uint8*>(HeadersUtf8.Get()), HeadersUtf8.Length());
+			return;
+		}
+		Headers = FString::Printf(TEXT("HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %lld-%lld/%lld\r\n"), BodyStart, BodyEnd, Settings.PayloadSize);
+	}
+	else
+	{
+		Headers = TEXT("HTTP/1.1 200 OK\r\n");
+	}
+
+	const int64 BodySize = BodyEnd - BodyStart + 1;
+	if (Settings.bSendContentLength)
+	{
+		Headers += FString::Printf(TEXT("Content-Length: %lld\r\n"), BodySize);
+	}
+	if (Settings.bSupportRange)
+	{
+		Headers += TEXT("Accept-Ranges: bytes\r\n");
+	}
+	Headers += TEXT("Content-Type: application/octet-stream\r\nConnection: close\r\n\r\n");
+
+	const FTCHARToUTF8 HeadersUtf8(*Headers);
+	if (!SendAll(Connection, reinterpret_cast<const uint8*>(HeadersUtf8.Get()), HeadersUtf8.Length()) || bIsHead)
+	{
+		return;
+	}
+
+	// Decide up front whether this response gets cut off, and where
+	const int64 FailureOffset = Settings.FailureRate > 0 && FailureRandomStream.FRand() < Settings.FailureRate ? BodySize / 2 : BodySize;
+
+	TArray<uint8> Slice;
+	Slice.SetNumUninitialized(StandInSendSliceSize);
+
+	const double SendStartTime = FPlatformTime::Seconds();
+	int64 SentBytes = 0;
+	while (SentBytes < FailureOffset && !bStopping)
+	{
+		const int32 SliceSize = static_cast<int32>(FMath::Min<int64>(StandInSendSliceSize, FailureOffset - SentBytes));
+		for (int32 Index = 0; Index < SliceSize; ++Index)
+		{
+			Slice[Index] = GetPayloadByte(BodyStart + SentBytes + Index);
+		}
+
+		if (!SendAll(Connection, Slice.GetData(), SliceSize))
+		{
+			return;
+		}
+		SentBytes += SliceSize;
+		NumBytesSent.Add(SliceSize);
+
+		// Sleep until the sending rate is back within the bandwidth limit
+		if (Settings.BandwidthBytesPerSecond > 0)
+		{
+			const double ExpectedTime = static_cast<double>(SentBytes) / Settings.BandwidthBytesPerSecond;
+			const double ElapsedTime = FPlatformTime::Seconds() - SendStartTime;
+			if (ExpectedTime > ElapsedTime)
+			{
+				FPlatformProcess::Sleep(ExpectedTime - ElapsedTime);
+			}
+		}
+	}
+
+	if (FailureOffset < BodySize)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("HTTP stand-in server dropped the connection after %lld of %lld bytes"), SentBytes, BodySize);
+	}
+}
+
+bool FRuntimeHttpStandInServer::SendAll(FSocket* Connection, const uint8* Data, int32 Size)
+{
+	int32 TotalSent = 0;
+	while (TotalSent < Size)
+	{
+		int32 BytesSent = 0;
+		if (!Connection->Send(Data + TotalSent, Size - TotalSent, BytesSent))
+		{
+			return false;
+		}
+		TotalSent += BytesSent;
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,301 @@
+﻿// Georgy Treshchev 2024.
+
+#include "RuntimeStorageSink.h"
+#include "RuntimeFilesDownloaderDefines.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/Paths.h"
+
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsHWrapper.h"
+#elif PLATFORM_UNIX || PLATFORM_MAC || PLATFORM_ANDROID
+#include <errno.h>
+#include <stdio.h>
+#endif
+
+FRuntimeStorageSink::FRuntimeStorageSink()
+	: ExpectedSize(0)
+	, WrittenSize(0)
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+	, FileDescriptor(-1)
+#endif
+{}
+
+FRuntimeStorageSink::~FRuntimeStorageSink()
+{
+	if (IsOpen())
+	{
+		Abort();
+	}
+}
+
+ERuntimeStorageSinkOpenResult FRuntimeStorageSink::Open(const FString& InFilePath, int64 InExpectedSize)
+{
+	if (IsOpen())
+	{
+		Abort();
+	}
+
+	FilePath = InFilePath;
+	TempFilePath = GetTempFilePath(InFilePath);
+	ExpectedSize = FMath::Max<int64>(InExpectedSize, 0);
+	WrittenSize = 0;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Create save directory if it does not exist
+	const FString Directory = FPaths::GetPath(FilePath);
+	if (!Directory.IsEmpty() && !PlatformFile.DirectoryExists(*Directory))
+	{
+		if (!PlatformFile.CreateDirectoryTree(*Directory))
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to create a directory '%s' to save the downloaded file"), *Directory);
+			return ERuntimeStorageSinkOpenResult::DirectoryCreationFailed;
+		}
+	}
+
+	// Fail fast instead of running out of space halfway through the download
+	// The file being replaced and the leftover of an interrupted download give their space back, so they are not counted as required
+	{
+		const int64 ReclaimedSize = FMath::Max<int64>(PlatformFile.FileSize(*FilePath), 0) + FMath::Max<int64>(PlatformFile.FileSize(*TempFilePath), 0);
+		const int64 RequiredSize = FMath::Max<int64>(ExpectedSize - ReclaimedSize, 0);
+
+		uint64 TotalBytes = 0, FreeBytes = 0;
+		if (FPlatformMisc::GetDiskTotalAndFreeSpace(Directory, TotalBytes, FreeBytes) && FreeBytes < static_cast<uint64>(RequiredSize))
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Not enough disk space to save the downloaded file '%s': %lld bytes required, %llu bytes available"), *FilePath, RequiredSize, FreeBytes);
+			return ERuntimeStorageSinkOpenResult::NotEnoughSpace;
+		}
+	}
+
+	// Remove any leftover of an interrupted download
+	if (PlatformFile.FileExists(*TempFilePath))
+	{
+		PlatformFile.DeleteFile(*TempFilePath);
+	}
+
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+	FileDescriptor = open(TCHAR_TO_UTF8(*TempFilePath), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+	if (FileDescriptor < 0)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to open '%s' to save the downloaded file (errno %d)"), *TempFilePath, errno);
+		return ERuntimeStorageSinkOpenResult::OpenFailed;
+	}
+#else
+	FileHandle.Reset(PlatformFile.OpenWrite(*TempFilePath));
+	if (!FileHandle.IsValid())
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to open '%s' to save the downloaded file"), *TempFilePath);
+		return ERuntimeStorageSinkOpenResult::OpenFailed;
+	}
+#endif
+
+	if (!Preallocate())
+	{
+		Abort();
+		return ERuntimeStorageSinkOpenResult::NotEnoughSpace;
+	}
+
+	UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Opened '%s' with %lld bytes reserved for the downloaded file '%s'"), *TempFilePath, ExpectedSize, *FilePath);
+	return ERuntimeStorageSinkOpenResult::Success;
+}
+
+bool FRuntimeStorageSink::Write(int64 Offset, const uint8* Data, int64 Size)
+{
+	if (!IsOpen())
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to write to '%s': the storage sink is not open"), *TempFilePath);
+		return false;
+	}
+
+	if (Offset < 0 || Size < 0)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to write to '%s': invalid offset (%lld) or size (%lld)"), *TempFilePath, Offset, Size);
+		return false;
+	}
+
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+	int64 WrittenBytes = 0;
+	while (WrittenBytes < Size)
+	{
+		const ssize_t Result = pwrite(FileDescriptor, Data + WrittenBytes, Size - WrittenBytes, Offset + WrittenBytes);
+		if (Result < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to write %lld bytes at offset %lld to '%s' (errno %d)"), Size, Offset, *TempFilePath, errno);
+			return false;
+		}
+		WrittenBytes += Result;
+	}
+#else
+	if (!FileHandle->Seek(Offset) || !FileHandle->Write(Data, Size))
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to write %lld bytes at offset %lld to '%s'"), Size, Offset, *TempFilePath);
+		return false;
+	}
+#endif
+
+	WrittenSize = FMath::Max(WrittenSize, Offset + Size);
+	return true;
+}
+
+bool FRuntimeStorageSink::Finalize()
+{
+	if (!IsOpen())
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to finalize '%s': the storage sink is not open"), *FilePath);
+		return false;
+	}
+
+	// The reserved size may exceed the amount of data actually received (e.g. when the server reported a wrong size)
+	if (WrittenSize != ExpectedSize)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Warning, TEXT("Downloaded file '%s' has %lld bytes while %lld bytes were reserved, truncating"), *FilePath, WrittenSize, ExpectedSize);
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+		if (ftruncate(FileDescriptor, WrittenSize) != 0)
+#else
+		if (!FileHandle->Truncate(WrittenSize))
+#endif
+		{
+			UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to truncate '%s' to %lld bytes"), *TempFilePath, WrittenSize);
+			Abort();
+			return false;
+		}
+	}
+
+	// The data has to reach the disk before the rename does, otherwise a crash right after it may leave an empty or partially written file at the final path
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+	if (fsync(FileDescriptor) != 0)
+#else
+	if (!FileHandle->Flush(true))
+#endif
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to flush '%s' to disk"), *TempFilePath);
+		Abort();
+		return false;
+	}
+
+	Close();
+
+	if (!ReplaceFile(TempFilePath, FilePath))
+	{
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*TempFilePath);
+		return false;
+	}
+
+	return true;
+}
+
+void FRuntimeStorageSink::Abort()
+{
+	Close();
+	if (!TempFilePath.IsEmpty())
+	{
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*TempFilePath);
+	}
+}
+
+bool FRuntimeStorageSink::IsOpen() const
+{
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+	return FileDescriptor >= 0;
+#else
+	return FileHandle.IsValid();
+#endif
+}
+
+FString FRuntimeStorageSink::GetTempFilePath(const FString& FilePath)
+{
+	return FilePath + TEXT(".part");
+}
+
+bool FRuntimeStorageSink::ReplaceFile(const FString& SourcePath, const FString& DestinationPath)
+{
+	const FString FullSourcePath = FPaths::ConvertRelativePathToFull(SourcePath);
+	const FString FullDestinationPath = FPaths::ConvertRelativePathToFull(DestinationPath);
+
+#if PLATFORM_WINDOWS
+	// MOVEFILE_REPLACE_EXISTING swaps the file in place instead of deleting the existing one first
+	if (!MoveFileExW(*FullSourcePath, *FullDestinationPath, MOVEFILE_REPLACE_EXISTING))
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to move '%s' to '%s' (error %u)"), *SourcePath, *DestinationPath, static_cast<uint32>(GetLastError()));
+		return false;
+	}
+#elif PLATFORM_UNIX || PLATFORM_MAC || PLATFORM_ANDROID
+	// rename() atomically replaces the existing file, so readers observe either the old or the new file
+	if (rename(TCHAR_TO_UTF8(*FullSourcePath), TCHAR_TO_UTF8(*FullDestinationPath)) != 0)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to move '%s' to '%s' (errno %d)"), *SourcePath, *DestinationPath, errno);
+		return false;
+	}
+#else
+	if (!IFileManager::Get().Move(*FullDestinationPath, *FullSourcePath, true))
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to move '%s' to '%s'"), *SourcePath, *DestinationPath);
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+bool FRuntimeStorageSink::Preallocate()
+{
+	if (ExpectedSize <= 0)
+	{
+		return true;
+	}
+
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+	const int32 Result = posix_fallocate(FileDescriptor, 0, ExpectedSize);
+	if (Result == 0)
+	{
+		return true;
+	}
+
+	if (Result == ENOSPC || Result == EFBIG)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Not enough disk space to reserve %lld bytes for '%s'"), ExpectedSize, *TempFilePath);
+		return false;
+	}
+
+	// The file system does not support allocation, so only extend the file and let the blocks be allocated on write
+	UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("posix_fallocate is not supported for '%s' (error %d), extending the file instead"), *TempFilePath, Result);
+	if (ftruncate(FileDescriptor, ExpectedSize) != 0)
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to extend '%s' to %lld bytes (errno %d)"), *TempFilePath, ExpectedSize, errno);
+		return false;
+	}
+	return true;
+#else
+	// Extending the file makes the file system allocate its clusters up front on platforms where this is supported
+	if (!FileHandle->Truncate(ExpectedSize))
+	{
+		UE_LOG(LogRuntimeFilesDownloader, Error, TEXT("Unable to reserve %lld bytes for '%s'"), ExpectedSize, *TempFilePath);
+		return false;
+	}
+	return true;
+#endif
+}
+
+void FRuntimeStorageSink::Close()
+{
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+	if (FileDescriptor >= 0)
+	{
+		close(FileDescriptor);
+		FileDescriptor = -1;
+	}
+#else
+	FileHandle.Reset();
+#endif
+}
@@ -0,0 +1,346 @@
+﻿// Georgy Treshchev 2024.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "RuntimeHttpStandInServer.h"
+#include "FileToMemoryDownloader.h"
+#include "FileToStorageDownloader.h"
+#include "RuntimeFilesDownloaderDefines.h"
+#include "Algo/Find.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Tests/AutomationCommon.h"
+
+namespace
+{
+	/** Measurements of a single download mode */
+	struct FRuntimeFilesDownloaderBenchmarkResult
+	{
+		FString Mode;
+		FString Result;
+		int64 ReceivedBytes = 0;
+		double Seconds = 0;
+		double PeakMemoryGrowthMB = 0;
+		bool bSucceeded = false;
+		bool bValid = false;
+		FRuntimeDownloadStats Stats;
+
+		static FString GetCsvHeader()
+		{
+			return TEXT("Scenario,Mode,Result,ReceivedBytes,Seconds,MBps,PeakMemoryGrowthMB,Valid,Requests,Retries,FailedRequests,WastedBytes,TimeToFirstByte");
+		}
+
+		FString ToCsv(const FString& Scenario) const
+		{
+			return FString::Printf(TEXT("%s,%s,%s,%lld,%.3f,%.2f,%.2f,%d,%d,%d,%d,%lld,%.3f"),
+				*Scenario, *Mode, *Result, ReceivedBytes, Seconds, GetMBps(), PeakMemoryGrowthMB, bValid ? 1 : 0,
+				Stats.RequestCount, Stats.Retries, Stats.FailedRequests, Stats.WastedBytes, Stats.TimeToFirstByte);
+		}
+
+		double GetMBps() const
+		{
+			return Seconds > 0 ? ReceivedBytes / Seconds / (1024.0 * 1024.0) : 0;
+		}
+	};
+
+	/**
+	 * Runs every download mode against the HTTP stand-in server one after another, verifying the downloaded content and measuring throughput, memory and transfer metrics for each
+	 */
+	class FRuntimeFilesDownloaderBenchmark : public TSharedFromThis<FRuntimeFilesDownloaderBenchmark>
+	{
+	public:
+		enum class EMode : uint8
+		{
+			Memory,
+			MemoryByPayload,
+			MemoryPerChunk,
+			Storage,
+			Count
+		};
+
+		explicit FRuntimeFilesDownloaderBenchmark(const FRuntimeHttpStandInServerSettings& InSettings)
+			: Server(MakeUnique<FRuntimeHttpStandInServer>(InSettings))
+			, PayloadSize(InSettings.PayloadSize)
+			, ModeIndex(0)
+			, ModeStartTime(0)
+			, ModeStartUsedPhysical(0)
+			, ModePeakUsedPhysical(0)
+			, ModeReceivedBytes(0)
+			, bModeContentValid(false)
+		{}
+
+		bool Start()
+		{
+			if (!Server->Start())
+			{
+				return false;
+			}
+			RunNextMode();
+			return true;
+		}
+
+		bool IsFinished() const
+		{
+			return ModeIndex >= static_cast<int32>(EMode::Count);
+		}
+
+		const TArray<FRuntimeFilesDownloaderBenchmarkResult>& GetResults() const
+		{
+			return Results;
+		}
+
+	private:
+		static const TCHAR* GetModeName(EMode Mode)
+		{
+			switch (Mode)
+			{
+			case EMode::Memory: return TEXT("Memory");
+			case EMode::MemoryByPayload: return TEXT("MemoryByPayload");
+			case EMode::MemoryPerChunk: return TEXT("MemoryPerChunk");
+			case EMode::Storage: return TEXT("Storage");
+			default: return TEXT("Unknown");
+			}
+		}
+
+		void SampleMemory()
+		{
+			ModePeakUsedPhysical = FMath::Max<uint64>(ModePeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+		}
+
+		void RunNextMode()
+		{
+			if (IsFinished())
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Download benchmark finished: %lld requests served, %lld bytes sent"), Server->GetNumRequests(), Server->GetNumBytesSent());
+				Server->Shutdown();
+				return;
+			}
+
+			const EMode Mode = static_cast<EMode>(ModeIndex);
+			const FString URL = Server->GetURL();
+			TSharedRef<FRuntimeFilesDownloaderBenchmark> SharedThis = AsShared();
+
+			ModeStartTime = FPlatformTime::Seconds();
+			ModeStartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+			ModePeakUsedPhysical = ModeStartUsedPhysical;
+			ModeReceivedBytes = 0;
+			bModeContentValid = true;
+
+			const FOnDownloadProgressNative OnProgress = FOnDownloadProgressNative::CreateLambda([SharedThis](int64 BytesReceived, int64 ContentLength, float ProgressRatio)
+			{
+				SharedThis->SampleMemory();
+			});
+
+			switch (Mode)
+			{
+			case EMode::Memory:
+			case EMode::MemoryByPayload:
+				UFileToMemoryDownloader::DownloadFileToMemory(URL, 0, FString(), Mode == EMode::MemoryByPayload, OnProgress, FOnFileToMemoryDownloadCompleteNative::CreateLambda([SharedThis](const TArray64<uint8>& DownloadedContent, EDownloadToMemoryResult Result, UFileToMemoryDownloader* Downloader)
+				{
+					SharedThis->SampleMemory();
+					const bool bSucceeded = Result == EDownloadToMemoryResult::Success || Result == EDownloadToMemoryResult::SucceededByPayload;
+					const bool bValid = DownloadedContent.Num() == SharedThis->PayloadSize && FRuntimeHttpStandInServer::VerifyPayload(DownloadedContent.GetData(), DownloadedContent.Num());
+					SharedThis->FinishMode(UEnum::GetValueAsString(Result), DownloadedContent.Num(), bSucceeded, bValid, Downloader);
+				}));
+				break;
+			case EMode::MemoryPerChunk:
+				UFileToMemoryDownloader::DownloadFileToMemoryPerChunk(URL, 0, FString(), 16 * 1024 * 1024, OnProgress, FOnFileToMemoryChunkDownloadCompleteNative::CreateLambda([SharedThis](const TArray64<uint8>& DownloadedContent, UFileToMemoryDownloader* Downloader)
+				{
+					SharedThis->SampleMemory();
+					SharedThis->bModeContentValid &= FRuntimeHttpStandInServer::VerifyPayload(DownloadedContent.GetData(), DownloadedContent.Num(), SharedThis->ModeReceivedBytes);
+					SharedThis->ModeReceivedBytes += DownloadedContent.Num();
+				}), FOnFileToMemoryAllChunksDownloadCompleteNative::CreateLambda([SharedThis](EDownloadToMemoryResult Result, UFileToMemoryDownloader* Downloader)
+				{
+					const bool bValid = SharedThis->bModeContentValid && SharedThis->ModeReceivedBytes == SharedThis->PayloadSize;
+					SharedThis->FinishMode(UEnum::GetValueAsString(Result), SharedThis->ModeReceivedBytes, Result == EDownloadToMemoryResult::Success, bValid, Downloader);
+				}));
+				break;
+			case EMode::Storage:
+			{
+				const FString SavePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("RuntimeFilesDownloader"), TEXT("Benchmark"), TEXT("payload.bin"));
+				UFileToStorageDownloader::DownloadFileToStorage(URL, SavePath, 0, FString(), false, OnProgress, FOnFileToStorageDownloadCompleteNative::CreateLambda([SharedThis](EDownloadToStorageResult Result, const FString& SavedPath, UFileToStorageDownloader* Downloader)
+				{
+					SharedThis->SampleMemory();
+
+					// Measured before reading the file back for verification
+					const double Duration = FPlatformTime::Seconds() - SharedThis->ModeStartTime;
+
+					TArray64<uint8> SavedContent;
+					const bool bValid = FFileHelper::LoadFileToArray(SavedContent, *SavedPath)
+						&& SavedContent.Num() == SharedThis->PayloadSize
+						&& FRuntimeHttpStandInServer::VerifyPayload(SavedContent.GetData(), SavedContent.Num());
+
+					FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*SavedPath);
+					const bool bSucceeded = Result == EDownloadToStorageResult::Success || Result == EDownloadToStorageResult::SucceededByPayload;
+					SharedThis->FinishMode(UEnum::GetValueAsString(Result), SavedContent.Num(), bSucceeded, bValid, Downloader, Duration);
+				}));
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		void FinishMode(const FString& Result, int64 ReceivedBytes, bool bSucceeded, bool bValid, UBaseFilesDownloader* Downloader, double Duration = -1)
+		{
+			FRuntimeFilesDownloaderBenchmarkResult& ModeResult = Results.AddDefaulted_GetRef();
+			ModeResult.Mode = GetModeName(static_cast<EMode>(ModeIndex));
+			ModeResult.Result = Result;
+			ModeResult.ReceivedBytes = ReceivedBytes;
+			ModeResult.Seconds = Duration >= 0 ? Duration : FPlatformTime::Seconds() - ModeStartTime;
+			ModeResult.PeakMemoryGrowthMB = (static_cast<int64>(ModePeakUsedPhysical) - static_cast<int64>(ModeStartUsedPhysical)) / (1024.0 * 1024.0);
+			ModeResult.bSucceeded = bSucceeded;
+			ModeResult.bValid = bValid;
+			if (Downloader)
+			{
+				ModeResult.Stats = Downloader->GetDownloadStats();
+			}
+
+			UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Download benchmark [%s]: %s, %lld bytes in %.3fs (%.2f MB/s), content %s, peak memory growth %.2f MB"),
+				*ModeResult.Mode, *Result, ReceivedBytes, ModeResult.Seconds, ModeResult.GetMBps(), bValid ? TEXT("valid") : TEXT("INVALID"), ModeResult.PeakMemoryGrowthMB);
+			if (Downloader)
+			{
+				UE_LOG(LogRuntimeFilesDownloader, Log, TEXT("Download benchmark [%s] metrics: %s"), *ModeResult.Mode, *ModeResult.Stats.ToString());
+			}
+
+			++ModeIndex;
+			RunNextMode();
+		}
+
+		TUniquePtr<FRuntimeHttpStandInServer> Server;
+		int64 PayloadSize;
+		int32 ModeIndex;
+		double ModeStartTime;
+		uint64 ModeStartUsedPhysical;
+		uint64 ModePeakUsedPhysical;
+		int64 ModeReceivedBytes;
+		bool bModeContentValid;
+		TArray<FRuntimeFilesDownloaderBenchmarkResult> Results;
+	};
+
+	/** Server conditions the download modes are run against */
+	struct FRuntimeFilesDownloaderBenchmarkScenario
+	{
+		const TCHAR* Name;
+		float BandwidthMBps;
+		float LatencyMs;
+		float FailureRate;
+		bool bSupportRange;
+		bool bSendContentLength;
+	};
+
+	const FRuntimeFilesDownloaderBenchmarkScenario BenchmarkScenarios[] = {
+		{TEXT("Loopback"), 0, 0, 0, true, true},
+		{TEXT("Throttled"), 32, 20, 0, true, true},
+		{TEXT("Flaky"), 0, 0, 0.2f, true, true},
+		{TEXT("NoRange"), 0, 0, 0, false, true},
+		{TEXT("NoContentLength"), 0, 0, 0, true, false}
+	};
+
+	/** Size of the served file */
+	constexpr int64 BenchmarkPayloadSize = 64 * 1024 * 1024;
+
+	/** Time after which a scenario is considered hung */
+	constexpr double BenchmarkTimeoutSeconds = 300;
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FRuntimeFilesDownloaderBenchmarkTest, "RuntimeFilesDownloader.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FRuntimeFilesDownloaderBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const FRuntimeFilesDownloaderBenchmarkScenario& Scenario : BenchmarkScenarios)
+	{
+		OutBeautifiedNames.Add(Scenario.Name);
+		OutTestCommands.Add(Scenario.Name);
+	}
+}
+
+bool FRuntimeFilesDownloaderBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const FRuntimeFilesDownloaderBenchmarkScenario* Scenario = Algo::FindByPredicate(BenchmarkScenarios, [&Parameters](const FRuntimeFilesDownloaderBenchmarkScenario& Candidate)
+	{
+		return Parameters.Equals(Candidate.Name);
+	});
+
+	if (!Scenario)
+	{
+		AddError(FString::Printf(TEXT("Unknown benchmark scenario '%s'"), *Parameters));
+		return false;
+	}
+
+	FRuntimeHttpStandInServerSettings Settings;
+	Settings.PayloadSize = BenchmarkPayloadSize;
+	Settings.BandwidthBytesPerSecond = static_cast<int64>(Scenario->BandwidthMBps * 1024 * 1024);
+	Settings.LatencySeconds = Scenario->LatencyMs / 1000.f;
+	Settings.FailureRate = Scenario->FailureRate;
+	Settings.bSupportRange = Scenario->bSupportRange;
+	Settings.bSendContentLength = Scenario->bSendContentLength;
+
+	TSharedRef<FRuntimeFilesDownloaderBenchmark> Benchmark = MakeShared<FRuntimeFilesDownloaderBenchmark>(Settings);
+	if (!Benchmark->Start())
+	{
+		AddError(TEXT("Unable to start the HTTP stand-in server"));
+		return false;
+	}
+
+	const FString ScenarioName = Scenario->Name;
+	const bool bInjectsFailures = Scenario->FailureRate > 0;
+	const double StartTime = FPlatformTime::Seconds();
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Benchmark, ScenarioName, bInjectsFailures, StartTime]()
+	{
+		if (!Benchmark->IsFinished())
+		{
+			if (FPlatformTime::Seconds() - StartTime < BenchmarkTimeoutSeconds)
+			{
+				return false;
+			}
+			AddError(FString::Printf(TEXT("The %s scenario did not finish within %.0f seconds"), *ScenarioName, BenchmarkTimeoutSeconds));
+		}
+
+		TArray<FString> CsvLines;
+		CsvLines.Add(FRuntimeFilesDownloaderBenchmarkResult::GetCsvHeader());
+
+		for (const FRuntimeFilesDownloaderBenchmarkResult& Result : Benchmark->GetResults())
+		{
+			CsvLines.Add(Result.ToCsv(ScenarioName));
+
+			// The downloader does not retry interrupted responses, so whether a download survives the injected failures depends on which requests are hit
+			// What must hold is that the failures are reported: no download succeeds with invalid content, and a failed one has its failed requests recorded
+			if (bInjectsFailures)
+			{
+				TestTrue(FString::Printf(TEXT("%s download in the %s scenario does not report success with invalid content"), *Result.Mode, *ScenarioName), !Result.bSucceeded || Result.bValid);
+				if (!Result.bSucceeded)
+				{
+					TestTrue(FString::Printf(TEXT("%s download failed in the %s scenario records the failed requests"), *Result.Mode, *ScenarioName), Result.Stats.FailedRequests > 0);
+				}
+				continue;
+			}
+
+			TestTrue(FString::Printf(TEXT("%s content downloaded in the %s scenario is valid"), *Result.Mode, *ScenarioName), Result.bValid);
+		}
+
+		const FString ResultsPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("RuntimeFilesDownloader"), TEXT("Benchmark"), FString::Printf(TEXT("Results-%s-%s.csv"), *ScenarioName, *FDateTime::Now().ToString()));
+		if (FFileHelper::SaveStringArrayToFile(CsvLines, *ResultsPath))
+		{
+			AddInfo(FString::Printf(TEXT("Results saved to '%s'"), *FPaths::ConvertRelativePathToFull(ResultsPath)));
+		}
+		else
+		{
+			AddWarning(FString::Printf(TEXT("Unable to save the results to '%s'"), *ResultsPath));
+		}
+
+		return true;
+	}));
+
+	return true;
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "Http.h"
 #include "Templates/SharedPointer.h"
 #include "Misc/EngineVersionComparison.h"
+#include "RuntimeDownloadStats.h"
 #include "BaseFilesDownloader.generated.h"
 
 /** Dynamic delegate to track download progress */
@@ -44,6 +45,14 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Runtime Files Downloader|Main")
 	virtual bool CancelDownload();
 
+	/**
+	 * Get the metrics collected for the current or last download: time-to-first-byte, request latency histogram, throughput, retries and wasted bytes
+	 *
+	 * @return The collected metrics, or default metrics if no download has been started
+	 */
+	UFUNCTION(BlueprintPure, Category = "Runtime Files Downloader|Main")
+	FRuntimeDownloadStats GetDownloadStats() const;
+
 	/**
 	 * Get the content length of the file to be downloaded
 	 *
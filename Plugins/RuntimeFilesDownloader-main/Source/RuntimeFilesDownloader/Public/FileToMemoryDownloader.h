@@ -16,6 +16,8 @@ enum class EDownloadToMemoryResult : uint8
 	Success,
 	/** Downloaded successfully, but there was no Content-Length header in the response and thus downloaded by payload */
 	SucceededByPayload,
+	/** Served from the local HTTP cache, either because the cached response is still fresh or because the server confirmed it was not modified */
+	SucceededFromCache,
 	Cancelled,
 	DownloadFailed,
 	InvalidURL
@@ -27,7 +29,7 @@ DECLARE_DELEGATE_ThreeParams(FOnFileToMemoryDownloadCompleteNative, const TArray
 /** Dynamic delegate to track download completion */
 DECLARE_DYNAMIC_DELEGATE_ThreeParams(FOnFileToMemoryDownloadComplete, const TArray<uint8>&, DownloadedContent, EDownloadToMemoryResult, Result, UFileToMemoryDownloader*, Downloader);
 
-/** Static delegate to track chunk download completion */
+/** Static delegate to track chunk download completion. The chunk data is only valid during the call, since its buffer is reused for the next chunk */
 DECLARE_DELEGATE_TwoParams(FOnFileToMemoryChunkDownloadCompleteNative, const TArray64<uint8>&, UFileToMemoryDownloader*);
 
 /** Dynamic delegate to track chunk download completion */
@@ -110,6 +112,41 @@ public:
 	 */
 	static UFileToMemoryDownloader* DownloadFileToMemoryPerChunk(const FString& URL, float Timeout, const FString& ContentType, int64 MaxChunkSize, const FOnDownloadProgressNative& OnProgress, const FOnFileToMemoryChunkDownloadCompleteNative& OnChunkDownloadComplete, const FOnFileToMemoryAllChunksDownloadCompleteNative& OnAllChunksDownloadComplete);
 
+	/**
+	 * Download the file through the local HTTP cache and save it as a byte array in temporary memory (RAM)
+	 * If a cached response exists, it is broadcast immediately with the SucceededFromCache result and then revalidated in the background using If-None-Match/If-Modified-Since (stale-while-revalidate)
+	 * If the server reports that the file has changed, OnComplete is broadcast a second time with the fresh content and the Success result
+	 *
+	 * @param URL The URL of the file to be downloaded
+	 * @param Timeout The maximum time to wait for the download to complete, in seconds. Works only for engine versions >= 4.26
+	 * @param ContentType A string to set in the Content-Type header field. Use a MIME type to specify the file type
+	 * @param OnProgress Delegate for download progress updates
+	 * @param OnComplete Delegate for broadcasting the completion of the download. May be called twice, see above
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Runtime Files Downloader|Memory")
+	static UFileToMemoryDownloader* DownloadFileToMemoryCached(const FString& URL, float Timeout, const FString& ContentType, const FOnDownloadProgress& OnProgress, const FOnFileToMemoryDownloadComplete& OnComplete);
+
+	/**
+	 * Download the file through the local HTTP cache and save it as a byte array in temporary memory (RAM). Suitable for use in C++
+	 * If a cached response exists, it is broadcast immediately with the SucceededFromCache result and then revalidated in the background using If-None-Match/If-Modified-Since (stale-while-revalidate)
+	 * If the server reports that the file has changed, OnComplete is broadcast a second time with the fresh content and the Success result
+	 *
+	 * @param URL The URL of the file to be downloaded
+	 * @param Timeout The maximum time to wait for the download to complete, in seconds. Works only for engine versions >= 4.26
+	 * @param ContentType A string to set in the Content-Type header field. Use a MIME type to specify the file type
+	 * @param OnProgress Delegate for download progress updates
+	 * @param OnComplete Delegate for broadcasting the completion of the download. May be called twice, see above
+	 */
+	static UFileToMemoryDownloader* DownloadFileToMemoryCached(const FString& URL, float Timeout, const FString& ContentType, const FOnDownloadProgressNative& OnProgress, const FOnFileToMemoryDownloadCompleteNative& OnComplete);
+
+	/**
+	 * Remove all responses stored in the local HTTP cache
+	 *
+	 * @return Whether the cache was cleared successfully or not
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Runtime Files Downloader|Utilities")
+	static bool ClearHttpCache();
+
 	//~ Begin UBaseFilesDownloader Interface
 	virtual bool CancelDownload() override;
 	//~ End UBaseFilesDownloader Interface
@@ -134,4 +171,13 @@ protected:
 	 * @param MaxChunkSize The maximum size of each chunk to download in bytes
 	 */
 	void DownloadFileToMemoryPerChunk(const FString& URL, float Timeout, const FString& ContentType, int64 MaxChunkSize);
+
+	/**
+	 * Download the file through the local HTTP cache and save it as a byte array in temporary memory (RAM)
+	 *
+	 * @param URL The URL of the file to be downloaded
+	 * @param Timeout The maximum time to wait for the download to complete, in seconds. Works only for engine versions >= 4.26
+	 * @param ContentType A string to set in the Content-Type header field. Use a MIME type to specify the file type
+	 */
+	void DownloadFileToMemoryCached(const FString& URL, float Timeout, const FString& ContentType);
 };
@@ -1,8 +1,10 @@
-// Georgy Treshchev 2024.
+﻿// Georgy Treshchev 2024.
 
 #pragma once
 
 #include "BaseFilesDownloader.h"
+#include "RuntimeStorageSink.h"
+#include "HAL/CriticalSection.h"
 #include "FileToStorageDownloader.generated.h"
 
 class UFileToStorageDownloader;
@@ -18,6 +20,8 @@ enum class EDownloadToStorageResult : uint8
 	DownloadFailed,
 	SaveFailed,
 	DirectoryCreationFailed,
+	/** There is not enough free disk space to store the file */
+	NotEnoughSpace,
 	InvalidURL,
 	InvalidSavePath
 };
@@ -87,12 +91,51 @@ protected:
 	 */
 	void DownloadFileToStorage(const FString& URL, const FString& SavePath, float Timeout, const FString& ContentType, bool bForceByPayload);
 
+	/**
+	 * Download the file by payload and save it to the device disk once the whole content has been received
+	 *
+	 * @param URL The file URL to be downloaded
+	 * @param Timeout The maximum time to wait for the download to complete, in seconds. Works only for engine versions >= 4.26
+	 * @param ContentType A string to set in the Content-Type header field. Use a MIME type to specify the file type
+	 */
+	void DownloadFileToStorageByPayload(const FString& URL, float Timeout, const FString& ContentType);
+
+	/**
+	 * Open the storage sink with the specified size reserved, broadcasting the failure if it could not be opened
+	 *
+	 * @param ContentSize The size of the file in bytes
+	 * @return True if the storage sink was opened successfully
+	 */
+	bool OpenStorageSink(int64 ContentSize);
+
+	/**
+	 * Internal callback for when file downloading by chunks has finished
+	 */
+	void OnChunksComplete_Internal(EDownloadToMemoryResult Result, const FString& URL, float Timeout, const FString& ContentType);
+
 	/**
 	 * Internal callback for when file downloading has finished
 	 */
 	void OnComplete_Internal(EDownloadToMemoryResult Result, TArray64<uint8> DownloadedContent);
 
+	/**
+	 * Broadcast the download result converted to the storage download result
+	 */
+	void BroadcastResult(EDownloadToMemoryResult Result);
+
 protected:
 	/** The destination path to save the downloaded file */
 	FString FileSavePath;
+
+	/** The sink the downloaded data is written to */
+	TUniquePtr<FRuntimeStorageSink> StorageSink;
+
+	/** Whether writing a chunk to the storage sink has failed */
+	bool bStorageWriteFailed;
+
+	/** Guards the storage sink and the write failure flag, which are accessed from the HTTP thread while the chunks are streamed */
+	FCriticalSection StorageSinkMutex;
+
+	/** The maximum size of each chunk to download and write at once, in bytes */
+	static constexpr int64 StorageChunkSize = 64 * 1024 * 1024;
 };
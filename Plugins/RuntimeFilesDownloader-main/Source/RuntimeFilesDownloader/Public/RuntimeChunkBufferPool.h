@@ -0,0 +1,57 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * A thread-safe pool of reusable byte buffers used to deliver downloaded chunks
+ * Buffers are handed out with Acquire and must be handed back with Release once the consumer is done with them, so that steady-state downloading does not allocate per chunk
+ */
+class RUNTIMEFILESDOWNLOADER_API FRuntimeChunkBufferPool
+{
+public:
+	/**
+	 * @param InMaxPooledBuffers The maximum number of released buffers kept for reuse. Buffers released beyond this limit are freed
+	 */
+	explicit FRuntimeChunkBufferPool(int32 InMaxPooledBuffers = 4);
+
+	/**
+	 * Get a buffer of the specified size, reusing the allocation of a released buffer when possible. The contents of the buffer are uninitialized
+	 *
+	 * @param Size The required size of the buffer in bytes
+	 * @return The buffer, with Num() equal to Size
+	 */
+	TArray64<uint8> Acquire(int64 Size);
+
+	/**
+	 * Hand a buffer back to the pool so its allocation can be reused by a later Acquire
+	 *
+	 * @param Buffer The buffer to release. It is empty after the call
+	 */
+	void Release(TArray64<uint8>&& Buffer);
+
+	/**
+	 * Free all pooled buffers
+	 */
+	void Trim();
+
+	/**
+	 * Get the number of times Acquire had to allocate memory instead of reusing a pooled buffer
+	 */
+	int64 GetNumAllocations() const;
+
+private:
+	/** Buffers released for reuse */
+	TArray<TArray64<uint8>> FreeBuffers;
+
+	/** The maximum number of buffers kept in FreeBuffers */
+	int32 MaxPooledBuffers;
+
+	/** The number of times Acquire had to allocate memory */
+	int64 NumAllocations;
+
+	/** Guards FreeBuffers, since chunks may be released from any thread */
+	mutable FCriticalSection PoolMutex;
+};
@@ -7,11 +7,15 @@
 #include "Templates/SharedPointer.h"
 #include "Async/Future.h"
 #include "Misc/EngineVersionComparison.h"
+#include "HAL/CriticalSection.h"
+#include "RuntimeDownloadStats.h"
+#include "RuntimeChunkBufferPool.h"
 #if UE_VERSION_OLDER_THAN(5, 1, 0)
 #include <type_traits>
 #endif
 
 enum class EDownloadToMemoryResult : uint8;
+struct FRuntimeHttpCacheEntry;
 
 /**
  * A struct that contains the result of downloading a file
@@ -71,8 +75,13 @@ public:
 	virtual ~FRuntimeChunkDownloader();
 
 	using FOnProgress = TFunction<void(int64, int64)>;
+
+	/** Called with each downloaded chunk. The buffer comes from the buffer pool and may be handed back with GetBufferPool()->Release once consumed */
 	using FOnChunkDownloaded = TFunction<void(TArray64<uint8>&&)>;
 
+	/** Called with the offset of each downloaded chunk in the file and a view over the response content, valid only during the call. Returns false to fail the download */
+	using FOnChunkData = TFunction<bool(int64, TArrayView64<const uint8>)>;
+
 	/**
 	 * Download a file from the specified URL
 	 *
@@ -94,10 +103,11 @@ public:
 	 * @param MaxChunkSize The maximum size of each chunk to download in bytes
 	 * @param ChunkRange The range of chunks to download
 	 * @param OnProgress A function that is called with the progress as BytesReceived and ContentSize
-	 * @param OnChunkDownloaded A function that is called when each chunk is downloaded
+	 * @param OnChunkDownloaded A function that is called when each chunk is downloaded. May be null when the chunks are consumed by the chunk data consumer
+	 * @param KnownContentSize The content size if already known, e.g. from a previous HEAD request. If 0 or less, the content size is requested first
 	 * @return A future that resolves to true if all chunks are downloaded successfully, false otherwise
 	 */
-	virtual TFuture<EDownloadToMemoryResult> DownloadFilePerChunk(const FString& URL, float Timeout, const FString& ContentType, int64 MaxChunkSize, FInt64Vector2 ChunkRange, const FOnProgress& OnProgress, const FOnChunkDownloaded& OnChunkDownloaded);
+	virtual TFuture<EDownloadToMemoryResult> DownloadFilePerChunk(const FString& URL, float Timeout, const FString& ContentType, int64 MaxChunkSize, FInt64Vector2 ChunkRange, const FOnProgress& OnProgress, const FOnChunkDownloaded& OnChunkDownloaded, int64 KnownContentSize = 0);
 
 	/**
 	 * Download a single chunk of a file
@@ -123,6 +133,20 @@ public:
 	 * @note This approach cannot be used to download files that are larger than 2 GB
 	 */
 	virtual TFuture<FRuntimeChunkDownloaderResult> DownloadFileByPayload(const FString& URL, float Timeout, const FString& ContentType, const FOnProgress& OnProgress);
+
+	/**
+	 * Download a file using payload-based approach, sending the validators of a cached response as a conditional request (If-None-Match/If-Modified-Since)
+	 * A successful response is stored in the HTTP cache. If the server replies with 304 Not Modified, the cached entry is refreshed and the result is SucceededFromCache with empty data
+	 *
+	 * @param URL The URL of the file to download
+	 * @param Timeout The timeout value in seconds
+	 * @param ContentType The content type of the file
+	 * @param CachedEntry The cached entry whose validators to send. May have no validators, in which case a regular request is made
+	 * @param OnProgress A function that is called with the progress as BytesReceived and ContentSize
+	 * @return A future that resolves to the downloaded data as a TArray64<uint8>
+	 * @note This approach cannot be used to download files that are larger than 2 GB
+	 */
+	virtual TFuture<FRuntimeChunkDownloaderResult> DownloadFileConditional(const FString& URL, float Timeout, const FString& ContentType, const FRuntimeHttpCacheEntry& CachedEntry, const FOnProgress& OnProgress);
 	
 	/**
 	 * Get the content size of the file to be downloaded
@@ -138,13 +162,80 @@ public:
 	 */
 	virtual void CancelDownload();
 
+	/**
+	 * Get a snapshot of the metrics collected for the transfer made by this downloader
+	 *
+	 * @return The collected metrics
+	 */
+	FRuntimeDownloadStats GetStats() const;
+
+	/**
+	 * Get the pool that chunk buffers are acquired from
+	 */
+	TSharedRef<FRuntimeChunkBufferPool> GetBufferPool() const;
+
+	/**
+	 * Set the pool that chunk buffers are acquired from, e.g. to share buffers between several downloaders
+	 *
+	 * @param InBufferPool The pool to use
+	 */
+	void SetBufferPool(const TSharedRef<FRuntimeChunkBufferPool>& InBufferPool);
+
+	/**
+	 * Set a function that consumes the chunk data directly from the HTTP response, without copying it into a chunk buffer
+	 * While set, DownloadFilePerChunk passes the data to this function instead of calling OnChunkDownloaded, and DownloadFileByChunk resolves with empty data
+	 * Since UE 5.4 the data is passed piece by piece at increasing offsets as it is received, possibly from the HTTP thread
+	 *
+	 * @param InChunkDataConsumer The function consuming the chunk data, or nullptr to deliver chunks as buffers again
+	 */
+	void SetChunkDataConsumer(FOnChunkData InChunkDataConsumer);
+
 protected:
+	/**
+	 * Record that an HTTP request has been issued
+	 *
+	 * @param URL The URL of the request
+	 * @return The time at which the request was issued, to be passed to RecordRequestCompleted
+	 */
+	double RecordRequestStarted(const FString& URL);
+
+	/**
+	 * Record the progress of the request currently in flight
+	 *
+	 * @param RequestBytesReceived The number of body bytes received so far by the request
+	 */
+	void RecordRequestProgress(int64 RequestBytesReceived);
+
+	/**
+	 * Record the completion of an HTTP request
+	 *
+	 * @param RequestStartTime The time returned by RecordRequestStarted
+	 * @param RequestBytesReceived The number of body bytes received by the request
+	 * @param bSucceeded Whether the request succeeded
+	 * @param bRecordLatency Whether the request latency should be added to the range latency histogram
+	 */
+	void RecordRequestCompleted(double RequestStartTime, int64 RequestBytesReceived, bool bSucceeded, bool bRecordLatency);
+
+	/**
+	 * Record that the transfer is restarted using a different approach, discarding everything received so far
+	 */
+	void RecordRetry();
+
 	/**
 	 * Check and request permissions required for downloading files
 	 *
 	 * @return A future that resolves to true if the permissions are granted, false otherwise
 	 */
 	static TFuture<bool> CheckAndRequestPermissions();
+
+	/**
+	 * Check whether the response carries the requested chunk, i.e. has a successful status code and a Content-Range matching the requested range
+	 *
+	 * @param Response The response to check
+	 * @param ChunkRange The requested range of the chunk
+	 * @return True if the response body is the requested chunk
+	 */
+	static bool IsValidChunkResponse(const FHttpResponsePtr& Response, FInt64Vector2 ChunkRange);
 	
 	/** A weak pointer to the HTTP request being used for the download */
 #if UE_VERSION_NEWER_THAN(4, 26, 0)
@@ -155,4 +246,29 @@ protected:
 
 	/** A flag indicating whether the download has been canceled */
 	bool bCanceled;
+
+	/** The pool that chunk buffers are acquired from */
+	TSharedRef<FRuntimeChunkBufferPool> BufferPool;
+
+	/** The function consuming the chunk data in place, if any */
+	FOnChunkData ChunkDataConsumer;
+
+	/** Metrics collected for the transfer */
+	FRuntimeDownloadStats Stats;
+
+	/** The URL of the first request of the transfer, used when logging the metrics */
+	FString StatsURL;
+
+	/** The time at which the first request of the transfer was issued */
+	double TransferStartTime;
+
+	/** The time and overall received bytes at the last throughput sample */
+	double LastThroughputSampleTime;
+	int64 LastThroughputSampleBytes;
+
+	/** The number of body bytes received so far by the request in flight */
+	int64 InFlightRequestBytes;
+
+	/** Guards the metrics, which are updated from the HTTP callbacks */
+	mutable FCriticalSection StatsMutex;
 };
@@ -0,0 +1,81 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RuntimeDownloadStats.generated.h"
+
+/**
+ * Metrics collected over a single transfer made by a downloader
+ */
+USTRUCT(BlueprintType, Category = "Runtime Files Downloader")
+struct RUNTIMEFILESDOWNLOADER_API FRuntimeDownloadStats
+{
+	GENERATED_BODY()
+
+	FRuntimeDownloadStats();
+
+	/** Time from starting the transfer until the first byte of the body was received, in seconds. Negative if no byte has been received yet */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	float TimeToFirstByte;
+
+	/** Time from starting the transfer until the last request completed, in seconds */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	float ElapsedTime;
+
+	/** Total number of body bytes received, including bytes that were later discarded */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	int64 BytesReceived;
+
+	/** Number of bytes received by requests whose result was discarded, e.g. chunks downloaded before falling back to a payload download */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	int64 WastedBytes;
+
+	/** Number of HTTP requests issued, including the HEAD request used to obtain the content size */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	int32 RequestCount;
+
+	/** Number of times the transfer was restarted using a different approach, e.g. falling back from chunks to payload */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	int32 Retries;
+
+	/** Number of failed requests */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	int32 FailedRequests;
+
+	/** Average throughput over the whole transfer, in bytes per second */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	float AverageThroughput;
+
+	/** Highest throughput observed in a single sampling interval, in bytes per second */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	float PeakThroughput;
+
+	/** Throughput sampled every ThroughputSampleInterval seconds, in bytes per second */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	TArray<float> ThroughputSamples;
+
+	/** Number of completed range (and payload) requests per latency bucket. The upper bounds of the buckets are given by GetRangeLatencyBucketBounds */
+	UPROPERTY(BlueprintReadOnly, Category = "Runtime Files Downloader")
+	TArray<int32> RangeLatencyHistogram;
+
+	/** Interval between the throughput samples, in seconds */
+	static constexpr double ThroughputSampleInterval = 0.5;
+
+	/**
+	 * Get the upper bounds of the latency histogram buckets, in milliseconds. The last bucket is unbounded
+	 */
+	static const TArray<float>& GetRangeLatencyBucketBounds();
+
+	/**
+	 * Add a request latency to the histogram
+	 *
+	 * @param LatencySeconds The time between issuing the request and its completion, in seconds
+	 */
+	void AddRangeLatency(double LatencySeconds);
+
+	/**
+	 * Get a short human-readable summary of the metrics, suitable for logging
+	 */
+	FString ToString() const;
+};
@@ -0,0 +1,157 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Http.h"
+#include "HAL/CriticalSection.h"
+
+/**
+ * Metadata of a single cached HTTP response
+ */
+struct RUNTIMEFILESDOWNLOADER_API FRuntimeHttpCacheEntry
+{
+	FRuntimeHttpCacheEntry();
+
+	/** The URL the response was fetched from */
+	FString URL;
+
+	/** Value of the ETag response header, sent back as If-None-Match */
+	FString ETag;
+
+	/** Value of the Last-Modified response header, sent back as If-Modified-Since */
+	FString LastModified;
+
+	/** UTC time at which the response was stored or last revalidated */
+	FDateTime StoredTime;
+
+	/** Freshness lifetime in seconds taken from Cache-Control: max-age. While fresh, the entry is served without revalidation */
+	int64 MaxAge;
+
+	/**
+	 * Check whether the entry can still be served without contacting the server
+	 *
+	 * @return True if the entry is within its freshness lifetime
+	 */
+	bool IsFresh() const;
+
+	/**
+	 * Check whether the entry carries any validator usable for a conditional request
+	 *
+	 * @return True if either ETag or Last-Modified is known
+	 */
+	bool HasValidators() const;
+
+	/** Serialize the entry metadata */
+	friend FArchive& operator<<(FArchive& Ar, FRuntimeHttpCacheEntry& Entry);
+};
+
+/**
+ * On-disk cache of HTTP responses keyed by URL. Honours ETag/Last-Modified validators and Cache-Control max-age/no-store
+ * Each entry is stored as a pair of files (metadata and body) in the cache directory, written to a temporary file first and then moved into place
+ */
+class RUNTIMEFILESDOWNLOADER_API FRuntimeHttpCache
+{
+public:
+	/**
+	 * Get the process-wide cache instance
+	 */
+	static FRuntimeHttpCache& Get();
+
+	/**
+	 * Look up a cached response
+	 *
+	 * @param URL The URL of the cached response
+	 * @param OutEntry The metadata of the cached response
+	 * @param OutData The cached response body
+	 * @return True if the response was found in the cache
+	 */
+	bool Find(const FString& URL, FRuntimeHttpCacheEntry& OutEntry, TArray64<uint8>& OutData) const;
+
+	/**
+	 * Look up the metadata of a cached response without loading its body
+	 *
+	 * @param URL The URL of the cached response
+	 * @param OutEntry The metadata of the cached response
+	 * @return True if the response was found in the cache
+	 */
+	bool FindEntry(const FString& URL, FRuntimeHttpCacheEntry& OutEntry) const;
+
+	/**
+	 * Store a successful (200) response in the cache. Responses marked with Cache-Control: no-store or without any validators and max-age are not stored
+	 *
+	 * @param URL The URL the response was fetched from
+	 * @param Response The HTTP response containing the headers
+	 * @param Data The response body
+	 * @return True if the response was stored
+	 */
+	bool Store(const FString& URL, const FHttpResponsePtr& Response, const TArray64<uint8>& Data);
+
+	/**
+	 * Renew the freshness of a cached response after the server replied with 304 Not Modified
+	 *
+	 * @param URL The URL of the cached response
+	 * @param Response The 304 response, whose validators and max-age replace the stored ones when present
+	 * @return True if the entry exists and was updated
+	 */
+	bool Refresh(const FString& URL, const FHttpResponsePtr& Response);
+
+	/**
+	 * Remove a cached response
+	 *
+	 * @param URL The URL of the cached response
+	 */
+	void Remove(const FString& URL);
+
+	/**
+	 * Remove all cached responses
+	 *
+	 * @return True if the cache directory was deleted successfully
+	 */
+	bool Clear();
+
+	/**
+	 * Get the directory in which cached responses are stored
+	 */
+	static FString GetCacheDirectory();
+
+	/**
+	 * Add the conditional request headers (If-None-Match/If-Modified-Since) for the given entry to the request
+	 *
+	 * @param Request The request to add the headers to
+	 * @param Entry The cached entry containing the validators
+	 */
+	template <typename RequestType>
+	static void ApplyConditionalHeaders(const RequestType& Request, const FRuntimeHttpCacheEntry& Entry)
+	{
+		if (!Entry.ETag.IsEmpty())
+		{
+			Request->SetHeader(TEXT("If-None-Match"), Entry.ETag);
+		}
+		if (!Entry.LastModified.IsEmpty())
+		{
+			Request->SetHeader(TEXT("If-Modified-Since"), Entry.LastModified);
+		}
+	}
+
+private:
+	FRuntimeHttpCache() = default;
+
+	/** Get the path of the metadata file for the given URL */
+	static FString GetEntryFilePath(const FString& URL);
+
+	/** Get the path of the body file for the given URL */
+	static FString GetDataFilePath(const FString& URL);
+
+	/** Write the entry metadata to disk */
+	bool WriteEntry(const FRuntimeHttpCacheEntry& Entry) const;
+
+	/** Read the entry metadata from disk */
+	bool ReadEntry(const FString& URL, FRuntimeHttpCacheEntry& OutEntry) const;
+
+	/** Parse the max-age directive of Cache-Control. Returns 0 if absent */
+	static int64 ParseMaxAge(const FString& CacheControl);
+
+	/** Guards concurrent access to the cache files */
+	mutable FCriticalSection CacheMutex;
+};
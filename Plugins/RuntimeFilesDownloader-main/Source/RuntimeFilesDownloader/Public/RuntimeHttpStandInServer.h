@@ -0,0 +1,124 @@
+// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Math/RandomStream.h"
+
+#if !UE_BUILD_SHIPPING
+
+class FSocket;
+class FRunnableThread;
+
+/**
+ * Settings of the HTTP stand-in server
+ */
+struct RUNTIMEFILESDOWNLOADER_API FRuntimeHttpStandInServerSettings
+{
+	FRuntimeHttpStandInServerSettings();
+
+	/** The loopback port to listen on. 0 picks a free port */
+	int32 Port;
+
+	/** The size of the served file in bytes */
+	int64 PayloadSize;
+
+	/** The maximum sending rate in bytes per second. 0 means unlimited */
+	int64 BandwidthBytesPerSecond;
+
+	/** The delay before responding to each request, in seconds */
+	float LatencySeconds;
+
+	/** The probability, from 0 to 1, that a GET response is cut off halfway through the body */
+	float FailureRate;
+
+	/** Whether Range requests are honoured with 206 Partial Content. If false, the full file is always sent */
+	bool bSupportRange;
+
+	/** Whether the Content-Length header is sent. If false, the connection is closed to delimit the body */
+	bool bSendContentLength;
+};
+
+/**
+ * A minimal HTTP/1.1 server on the loopback interface that serves a deterministic file of a configurable size
+ * It simulates bandwidth limits, latency, dropped connections and servers with and without Range support, so that downloader behaviour and performance can be measured offline
+ * Connections are served one at a time and closed after each response. Intended for development builds only
+ */
+class RUNTIMEFILESDOWNLOADER_API FRuntimeHttpStandInServer : public FRunnable
+{
+public:
+	explicit FRuntimeHttpStandInServer(const FRuntimeHttpStandInServerSettings& InSettings);
+	virtual ~FRuntimeHttpStandInServer();
+
+	/**
+	 * Start listening and serving requests on a background thread
+	 *
+	 * @return True if the server has started
+	 */
+	bool Start();
+
+	/**
+	 * Stop serving requests and wait for the server thread to exit
+	 */
+	void Shutdown();
+
+	/**
+	 * Get the URL of the served file
+	 */
+	FString GetURL() const;
+
+	/**
+	 * Get the byte at the specified offset of the served file, for verifying downloaded content
+	 */
+	static uint8 GetPayloadByte(int64 Offset);
+
+	/**
+	 * Check whether the data matches the served file starting at the specified offset
+	 */
+	static bool VerifyPayload(const uint8* Data, int64 Size, int64 Offset = 0);
+
+	/** Get the number of requests served so far */
+	int64 GetNumRequests() const { return NumRequests.GetValue(); }
+
+	/** Get the number of body bytes sent so far */
+	int64 GetNumBytesSent() const { return NumBytesSent.GetValue(); }
+
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+private:
+	/** Read a request from the connection and send the response */
+	void ServeConnection(FSocket* Connection);
+
+	/** Send the whole buffer, returning false if the connection was closed */
+	bool SendAll(FSocket* Connection, const uint8* Data, int32 Size);
+
+	/** The server settings */
+	FRuntimeHttpStandInServerSettings Settings;
+
+	/** The socket accepting connections */
+	FSocket* ListenSocket;
+
+	/** The thread serving connections */
+	FRunnableThread* Thread;
+
+	/** The port actually listened on */
+	int32 BoundPort;
+
+	/** Whether the server thread should exit */
+	FThreadSafeBool bStopping;
+
+	/** Random stream used for failure injection */
+	FRandomStream FailureRandomStream;
+
+	/** Counters exposed for benchmarks */
+	FThreadSafeCounter64 NumRequests;
+	FThreadSafeCounter64 NumBytesSent;
+};
+
+#endif
@@ -0,0 +1,112 @@
+﻿// Georgy Treshchev 2024.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+/** Whether the sink writes through a POSIX file descriptor, which allows real preallocation with posix_fallocate */
+#define RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK (PLATFORM_LINUX || PLATFORM_ANDROID)
+
+/**
+ * Possible results of opening a storage sink
+ */
+enum class ERuntimeStorageSinkOpenResult : uint8
+{
+	Success,
+	DirectoryCreationFailed,
+	NotEnoughSpace,
+	OpenFailed
+};
+
+/**
+ * Writes a downloaded file to storage. The full size is reserved up front and the data is written at offsets into a temporary file,
+ * which is atomically renamed into place once the download has completed. An unfinished sink removes its temporary file
+ */
+class RUNTIMEFILESDOWNLOADER_API FRuntimeStorageSink
+{
+public:
+	FRuntimeStorageSink();
+	~FRuntimeStorageSink();
+
+	FRuntimeStorageSink(const FRuntimeStorageSink&) = delete;
+	FRuntimeStorageSink& operator=(const FRuntimeStorageSink&) = delete;
+
+	/**
+	 * Create the destination directory, check the free disk space and open a temporary file with the full size reserved
+	 *
+	 * @param InFilePath The final path of the file
+	 * @param InExpectedSize The expected size of the file in bytes
+	 * @return The result of the operation
+	 */
+	ERuntimeStorageSinkOpenResult Open(const FString& InFilePath, int64 InExpectedSize);
+
+	/**
+	 * Write data at the specified offset of the file
+	 *
+	 * @param Offset The offset in bytes to write the data at
+	 * @param Data The data to write
+	 * @param Size The size of the data in bytes
+	 * @return True if the data was written successfully
+	 */
+	bool Write(int64 Offset, const uint8* Data, int64 Size);
+
+	/**
+	 * Flush the temporary file to disk, close it and atomically move it to the final path, replacing any existing file
+	 *
+	 * @return True if the file was moved into place successfully
+	 */
+	bool Finalize();
+
+	/**
+	 * Close and delete the temporary file, leaving any existing file at the final path untouched
+	 */
+	void Abort();
+
+	/**
+	 * Check whether the sink is open for writing
+	 */
+	bool IsOpen() const;
+
+	/**
+	 * Get the path of the temporary file used while downloading to the specified path
+	 */
+	static FString GetTempFilePath(const FString& FilePath);
+
+	/**
+	 * Move a file to the specified path, replacing any existing file in a single step so that the path never goes missing in between
+	 *
+	 * @param SourcePath The path of the file to move
+	 * @param DestinationPath The path to move the file to
+	 * @return True if the file was moved successfully
+	 */
+	static bool ReplaceFile(const FString& SourcePath, const FString& DestinationPath);
+
+private:
+	/** Reserve the expected size for the opened temporary file */
+	bool Preallocate();
+
+	/** Close the temporary file */
+	void Close();
+
+	/** The final path of the file */
+	FString FilePath;
+
+	/** The path of the temporary file the data is written to */
+	FString TempFilePath;
+
+	/** The expected size of the file in bytes */
+	int64 ExpectedSize;
+
+	/** The highest offset written so far, which becomes the final size of the file */
+	int64 WrittenSize;
+
+#if RUNTIMEFILESDOWNLOADER_POSIX_STORAGE_SINK
+	/** The descriptor of the temporary file, -1 if closed */
+	int32 FileDescriptor;
+#else
+	/** The handle of the temporary file */
+	TUniquePtr<IFileHandle> FileHandle;
+#endif
+};
@@ -17,6 +17,14 @@ public class RuntimeFilesDownloader : ModuleRules
 				"HTTP"
 			}
 		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Sockets",
+				"Networking"
+			}
+		);
 		
 		if (Target.Platform == UnrealTargetPlatform.Android)
 		{
@@ -26,7 +26,7 @@ public class PiozaGameLauncher : ModuleRules
 			"Sockets",
 			"Networking"
 		});
-		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore", "ImageWrapper", "RenderCore", "RHI" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore", "ImageWrapper", "RenderCore", "RHI", "RuntimeArchiver" });
 		if (Target.Platform == UnrealTargetPlatform.Android)
 		{
 			PrivateDependencyModuleNames.Add("Launch");
@@ -21,60 +21,17 @@ bool UChecksumLibrary::CalculateFileChecksum(const FString& FilePath, EChecksumA
         return false;
     }
 
-    switch (Algorithm)
+    FChecksumBuilder Builder(Algorithm);
+    bool bSuccess = ReadFileInChunks(FilePath, [&Builder](const uint8* Data, int32 Size)
     {
-        case EChecksumAlgorithm::MD5:
-        {
-            FMD5 MD5;
-            bool bSuccess = ReadFileInChunks(FilePath, [&MD5](const uint8* Data, int32 Size)
-            {
-                MD5.Update(Data, Size);
-            });
-            
-            if (bSuccess)
-            {
-                uint8 Digest[16];
-                MD5.Final(Digest);
-                OutChecksum = BytesToHexString(Digest, 16);
-            }
-            return bSuccess;
-        }
+        Builder.Update(Data, Size);
+    });
 
-        case EChecksumAlgorithm::SHA1:
-        {
-            FSHA1 SHA1;
-            bool bSuccess = ReadFileInChunks(FilePath, [&SHA1](const uint8* Data, int32 Size)
-            {
-                SHA1.Update(Data, Size);
-            });
-            
-            if (bSuccess)
-            {
-                uint8 Digest[20];
-                SHA1.Final();
-                SHA1.GetHash(Digest);
-                OutChecksum = BytesToHexString(Digest, 20);
-            }
-            return bSuccess;
-        }
-
-        case EChecksumAlgorithm::CRC32:
-        {
-            uint32 CRC = 0;
-            bool bSuccess = ReadFileInChunks(FilePath, [&CRC](const uint8* Data, int32 Size)
-            {
-                CRC = FCrc::MemCrc32(Data, Size, CRC);
-            });
-            
-            if (bSuccess)
-            {
-                OutChecksum = FString::Printf(TEXT("%08x"), CRC);
-            }
-            return bSuccess;
-        }
+    if (bSuccess)
+    {
+        OutChecksum = Builder.Finalize();
     }
-
-    return false;
+    return bSuccess;
 }
 
 bool UChecksumLibrary::VerifyFileChecksum(const FString& FilePath, const FString& ExpectedChecksum, EChecksumAlgorithm Algorithm)
@@ -172,6 +129,60 @@ bool UChecksumLibrary::ReadFileInChunks(const FString& FilePath, TFunction<void(
     return true;
 }
 
+FChecksumBuilder::FChecksumBuilder(EChecksumAlgorithm InAlgorithm)
+    : Algorithm(InAlgorithm)
+    , CRC(0)
+{
+}
+
+void FChecksumBuilder::Update(const uint8* Data, int64 Size)
+{
+    switch (Algorithm)
+    {
+        case EChecksumAlgorithm::MD5:
+            MD5.Update(Data, Size);
+            break;
+
+        case EChecksumAlgorithm::SHA1:
+            SHA1.Update(Data, Size);
+            break;
+
+        case EChecksumAlgorithm::CRC32:
+            // MemCrc32 takes a 32-bit length, whole files may be larger
+            for (int64 Offset = 0; Offset < Size; Offset += MAX_int32)
+            {
+                CRC = FCrc::MemCrc32(Data + Offset, static_cast<int32>(FMath::Min<int64>(Size - Offset, MAX_int32)), CRC);
+            }
+            break;
+    }
+}
+
+FString FChecksumBuilder::Finalize()
+{
+    switch (Algorithm)
+    {
+        case EChecksumAlgorithm::MD5:
+        {
+            uint8 Digest[16];
+            MD5.Final(Digest);
+            return UChecksumLibrary::BytesToHexString(Digest, 16);
+        }
+
+        case EChecksumAlgorithm::SHA1:
+        {
+            uint8 Digest[20];
+            SHA1.Final();
+            SHA1.GetHash(Digest);
+            return UChecksumLibrary::BytesToHexString(Digest, 20);
+        }
+
+        case EChecksumAlgorithm::CRC32:
+            return FString::Printf(TEXT("%08x"), CRC);
+    }
+
+    return FString();
+}
+
 FString UChecksumLibrary::BytesToHexString(const uint8* Bytes, int32 Length)
 {
     FString Result;
@@ -6,6 +6,7 @@
 
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "Misc/SecureHash.h"
 #include "ChecksumLibrary.generated.h"
 
 UENUM(BlueprintType)
@@ -16,6 +17,33 @@ enum class EChecksumAlgorithm : uint8
     CRC32    UMETA(DisplayName = "CRC-32 (Fastest, weakest)")
 };
 
+/**
+ * Computes a checksum incrementally, from data passed block by block
+ * Produces the same hex strings as UChecksumLibrary::CalculateFileChecksum, so data read by someone else (e.g. an archiver) can be checksummed without reading it again
+ */
+class PIOZAGAMELAUNCHER_API FChecksumBuilder
+{
+public:
+    explicit FChecksumBuilder(EChecksumAlgorithm InAlgorithm);
+
+    /**
+     * Add the next block of data
+     */
+    void Update(const uint8* Data, int64 Size);
+
+    /**
+     * Finish the checksum. The builder must not be updated afterwards
+     * @return Checksum as hex string (lowercase)
+     */
+    FString Finalize();
+
+private:
+    EChecksumAlgorithm Algorithm;
+    FMD5 MD5;
+    FSHA1 SHA1;
+    uint32 CRC;
+};
+
 /**
  * Blueprint Function Library for file checksum verification
  * Supports MD5, SHA1, SHA256, and CRC32 algorithms
@@ -63,6 +91,8 @@ public:
     static FString GetAlgorithmName(EChecksumAlgorithm Algorithm);
 
 private:
+    friend class FChecksumBuilder;
+
     // Internal helper functions
     static bool ReadFileInChunks(const FString& FilePath, TFunction<void(const uint8*, int32)> ProcessChunk);
     static FString BytesToHexString(const uint8* Bytes, int32 Length);
@@ -4,10 +4,10 @@
 
 #include "ChecksumLibraryAsync.h"
 #include "ChecksumLibrary.h"
+#include "FileTaskHelpers.h"
 #include "Async/Async.h"
 #include "Async/ParallelFor.h"
 #include "Misc/ScopeLock.h"
-#include "HAL/PlatformTime.h"
 #include "HAL/ThreadSafeCounter.h"
 #include "Misc/Paths.h"
 
@@ -54,10 +54,7 @@ void UChecksumLibraryAsync::VerifyFileListAsync(const TArray<FString>& RelativeF
 
 		FThreadSafeCounter ProcessedCount(0);
 		FCriticalSection ResultMutex;
-
-		// Throttling settings
-		double LastUpdateTime = FPlatformTime::Seconds();
-		const double UpdateInterval = 0.05; // ~20 updates per second max
+		FileTaskHelpers::TThrottledProgress<FOnVerificationProgress> Progress(OnProgress);
 
 		ParallelFor(RelativeFilePaths.Num(), [&](int32 Index)
 		{
@@ -66,27 +63,7 @@ void UChecksumLibraryAsync::VerifyFileListAsync(const TArray<FString>& RelativeF
 			// -----------------------------------------------------------------
 			// 1. Check Ignored Files (Wildcard Support)
 			// -----------------------------------------------------------------
-			bool bIgnored = false;
-
-			// Fast check
-			if (FilesToIgnore.Contains(RelativePath))
-			{
-				bIgnored = true;
-			}
-			else
-			{
-				// Wildcard check (mimics Blueprint "MatchesAnyWildcard")
-				for (const FString& Pattern : FilesToIgnore)
-				{
-					if (RelativePath.MatchesWildcard(Pattern, ESearchCase::IgnoreCase))
-					{
-						bIgnored = true;
-						break;
-					}
-				}
-			}
-
-			if (bIgnored) return; // Skip this file
+			if (FileTaskHelpers::IsIgnored(RelativePath, FilesToIgnore)) return; // Skip this file
 			// -----------------------------------------------------------------
 
 			// 2. Construct Absolute Path
@@ -133,27 +110,7 @@ void UChecksumLibraryAsync::VerifyFileListAsync(const TArray<FString>& RelativeF
 
 			// 6. Update Progress (Throttled)
 			int32 CurrentCount = ProcessedCount.Increment();
-
-			double CurrentTime = FPlatformTime::Seconds();
-			if (CurrentTime - LastUpdateTime > UpdateInterval)
-			{
-				// Non-blocking try-lock to prevent stalling worker threads
-				if (ResultMutex.TryLock())
-				{
-					if (FPlatformTime::Seconds() - LastUpdateTime > UpdateInterval)
-					{
-						LastUpdateTime = FPlatformTime::Seconds();
-						float Percent = (float)CurrentCount / (float)RelativeFilePaths.Num();
-						FString FileForUI = RelativePath;
-
-						AsyncTask(ENamedThreads::GameThread, [OnProgress, Percent, FileForUI]()
-						{
-							OnProgress.ExecuteIfBound(Percent, FileForUI);
-						});
-					}
-					ResultMutex.Unlock();
-				}
-			}
+			Progress.Report((float)CurrentCount / (float)RelativeFilePaths.Num(), RelativePath);
 		});
 
 		// Set total files (approximate, based on input list size)
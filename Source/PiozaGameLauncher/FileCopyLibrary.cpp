@@ -0,0 +1,548 @@
+// Pioza Launcher
+// Copyright (c) 2025 DashoGames
+// Licensed under the MIT License - see LICENSE file for details
+
+#include "FileCopyLibrary.h"
+#include "FileTaskHelpers.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include <atomic>
+
+#if PLATFORM_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#endif
+
+namespace
+{
+	/** Size of the chunks copied between progress and cancellation checks */
+	constexpr int64 CopyChunkSize = 8 * 1024 * 1024;
+
+	/** Cancellation flags of the running async operations, by operation id */
+	FCriticalSection OperationsMutex;
+	TMap<int32, TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe>> RunningOperations;
+	int32 LastOperationId = 0;
+
+	struct FCopyJob
+	{
+		FString RelativePath;
+		int64 Size = 0;
+	};
+
+	FString NormalizeDirectory(const FString& Directory)
+	{
+		FString Normalized = FPaths::ConvertRelativePathToFull(Directory);
+		FPaths::NormalizeDirectoryName(Normalized);
+		return Normalized;
+	}
+
+#if PLATFORM_LINUX
+	enum class EKernelCopyResult : uint8
+	{
+		Copied,
+		Unsupported,
+		Failed,
+		Stopped
+	};
+
+	/**
+	 * Copies the file in chunks with an in-kernel copy method. The method is reported as unsupported if it fails or copies nothing before copying anything,
+	 * so the next one can be tried (e.g. copy_file_range across file systems on older kernels, or on file systems where it silently copies nothing).
+	 */
+	EKernelCopyResult CopyWithKernel(int64 Size, TFunctionRef<bool(int64)> OnBytesCopied, TFunctionRef<ssize_t(int64 Offset, size_t ChunkSize)> CopyChunk)
+	{
+		int64 Offset = 0;
+		while (Offset < Size)
+		{
+			const ssize_t Copied = CopyChunk(Offset, static_cast<size_t>(FMath::Min(Size - Offset, CopyChunkSize)));
+			if (Copied < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				const bool bUnsupported = errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP || errno == EBADF;
+				return Offset == 0 && bUnsupported ? EKernelCopyResult::Unsupported : EKernelCopyResult::Failed;
+			}
+
+			// Nothing copied at the start means the method does not work for these files, later on that the source file was truncated while being copied
+			if (Copied == 0)
+			{
+				return Offset == 0 ? EKernelCopyResult::Unsupported : EKernelCopyResult::Failed;
+			}
+
+			Offset += Copied;
+
+			if (!OnBytesCopied(Copied))
+			{
+				return EKernelCopyResult::Stopped;
+			}
+		}
+
+		return EKernelCopyResult::Copied;
+	}
+
+	bool IsSameFileSystem(const FString& SourceDir, const FString& DestDir)
+	{
+		struct stat SourceStat;
+		if (stat(TCHAR_TO_UTF8(*SourceDir), &SourceStat) != 0)
+		{
+			return false;
+		}
+
+		// The destination may not exist yet, so its closest existing parent decides
+		FString ExistingDest = DestDir;
+		struct stat DestStat;
+		while (stat(TCHAR_TO_UTF8(*ExistingDest), &DestStat) != 0)
+		{
+			const FString Parent = FPaths::GetPath(ExistingDest);
+			if (Parent.IsEmpty() || Parent == ExistingDest)
+			{
+				return false;
+			}
+			ExistingDest = Parent;
+		}
+
+		return SourceStat.st_dev == DestStat.st_dev;
+	}
+
+	bool RenamePath(const FString& Source, const FString& Dest)
+	{
+		return rename(TCHAR_TO_UTF8(*Source), TCHAR_TO_UTF8(*Dest)) == 0;
+	}
+#endif
+
+	/**
+	 * Copies or moves a directory tree. Shared by the blocking and the async version.
+	 */
+	bool RunCopy(const FString& InSourceDir, const FString& InDestDir, const FFileCopyOptions& Options, const std::atomic<bool>& bCancelled, TFunctionRef<void(float, const FString&)> OnProgress, FString& OutError)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+		const FString SourceDir = NormalizeDirectory(InSourceDir);
+		const FString DestDir = NormalizeDirectory(InDestDir);
+
+		if (!PlatformFile.DirectoryExists(*SourceDir))
+		{
+			OutError = FString::Printf(TEXT("Source directory does not exist: %s"), *SourceDir);
+			return false;
+		}
+
+		if (DestDir == SourceDir || DestDir.StartsWith(SourceDir / TEXT("")))
+		{
+			OutError = FString::Printf(TEXT("Destination directory cannot be inside the source directory: %s"), *DestDir);
+			return false;
+		}
+
+		bool bSameFileSystem = false;
+#if PLATFORM_LINUX
+		bSameFileSystem = Options.bMove && IsSameFileSystem(SourceDir, DestDir);
+
+		// Moving the whole tree at once when nothing is in the way
+		if (bSameFileSystem && !PlatformFile.DirectoryExists(*DestDir))
+		{
+			PlatformFile.CreateDirectoryTree(*FPaths::GetPath(DestDir));
+			if (RenamePath(SourceDir, DestDir))
+			{
+				OnProgress(1.0f, FString());
+				return true;
+			}
+		}
+#endif
+
+		TArray<FCopyJob> Jobs;
+		TArray<FString> Directories;
+		int64 TotalBytes = 0;
+
+		const FString SourcePrefix = SourceDir / TEXT("");
+		PlatformFile.IterateDirectoryStatRecursively(*SourceDir, [&](const TCHAR* Path, const FFileStatData& StatData)
+		{
+			FString RelativePath = FString(Path).RightChop(SourcePrefix.Len());
+			if (StatData.bIsDirectory)
+			{
+				Directories.Add(MoveTemp(RelativePath));
+			}
+			else
+			{
+				Jobs.Add({MoveTemp(RelativePath), StatData.FileSize});
+				TotalBytes += StatData.FileSize;
+			}
+			return true;
+		});
+
+		// Empty directories are part of the tree as well
+		if (!PlatformFile.CreateDirectoryTree(*DestDir))
+		{
+			OutError = FString::Printf(TEXT("Failed to create directory: %s"), *DestDir);
+			return false;
+		}
+
+		for (const FString& Directory : Directories)
+		{
+			if (!PlatformFile.CreateDirectoryTree(*(DestDir / Directory)))
+			{
+				OutError = FString::Printf(TEXT("Failed to create directory: %s"), *(DestDir / Directory));
+				return false;
+			}
+		}
+
+		// Largest files first, so a single big file does not finish alone at the end
+		Jobs.Sort([](const FCopyJob& A, const FCopyJob& B) { return A.Size > B.Size; });
+
+		// Files renamed into the destination, so a cancelled or failed move can put them back
+		TArray<bool> bRenamed;
+		bRenamed.Init(false, Jobs.Num());
+
+		const int32 NumOfWorkers = FMath::Min(Options.MaxParallelFiles > 0 ? Options.MaxParallelFiles : FMath::Clamp(FPlatformMisc::NumberOfCores(), 2, 8), Jobs.Num());
+
+		std::atomic<int32> NextJob{0};
+		std::atomic<int64> CopiedBytes{0};
+		std::atomic<bool> bFailed{false};
+		FCriticalSection ErrorMutex;
+
+		auto ShouldStop = [&bCancelled, &bFailed]()
+		{
+			return bCancelled.load() || bFailed.load();
+		};
+
+		auto ReportProgress = [&OnProgress, &CopiedBytes, TotalBytes](const FString& CurrentFile)
+		{
+			OnProgress(TotalBytes > 0 ? static_cast<float>(static_cast<double>(CopiedBytes.load()) / TotalBytes) : 0.0f, CurrentFile);
+		};
+
+		ParallelFor(NumOfWorkers, [&](int32 WorkerIndex)
+		{
+			for (int32 JobIndex = NextJob++; JobIndex < Jobs.Num() && !ShouldStop(); JobIndex = NextJob++)
+			{
+				const FCopyJob& Job = Jobs[JobIndex];
+				const FString SourceFile = SourceDir / Job.RelativePath;
+				const FString DestFile = DestDir / Job.RelativePath;
+
+				ReportProgress(Job.RelativePath);
+
+				FString Error;
+				bool bTransferred = false;
+
+#if PLATFORM_LINUX
+				// Within the same file system, moving a file is only a metadata update. Existing files are copied over instead,
+				// as a rename would drop them for good if the move is rolled back
+				if (bSameFileSystem && !PlatformFile.FileExists(*DestFile) && RenamePath(SourceFile, DestFile))
+				{
+					bRenamed[JobIndex] = true;
+					CopiedBytes += Job.Size;
+					bTransferred = true;
+				}
+#endif
+
+				if (!bTransferred)
+				{
+					bTransferred = UFileCopyLibrary::CopySingleFile(SourceFile, DestFile, [&](int64 NumOfBytes)
+					{
+						CopiedBytes += NumOfBytes;
+						// Large files take a while, so the progress moves along with each copied block rather than once per file
+						ReportProgress(Job.RelativePath);
+						return !ShouldStop();
+					}, Error);
+				}
+
+				if (bTransferred && Options.bVerifySize)
+				{
+					const int64 DestSize = PlatformFile.FileSize(*DestFile);
+					if (DestSize != Job.Size)
+					{
+						Error = FString::Printf(TEXT("Size mismatch after copy: %s (expected %lld, got %lld)"), *Job.RelativePath, Job.Size, DestSize);
+						bTransferred = false;
+					}
+				}
+
+				if (!bTransferred)
+				{
+					if (bCancelled.load())
+					{
+						return;
+					}
+
+					FScopeLock Lock(&ErrorMutex);
+					if (!bFailed.exchange(true))
+					{
+						OutError = Error;
+					}
+					return;
+				}
+			}
+		});
+
+		if (bCancelled.load() || bFailed.load())
+		{
+#if PLATFORM_LINUX
+			// The source tree is left as it was. Copied files stay at the destination, like for a cancelled copy
+			for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+			{
+				if (bRenamed[JobIndex] && !RenamePath(DestDir / Jobs[JobIndex].RelativePath, SourceDir / Jobs[JobIndex].RelativePath))
+				{
+					UE_LOG(LogTemp, Error, TEXT("FileCopy: Failed to move file back to the source directory: %s"), *Jobs[JobIndex].RelativePath);
+				}
+			}
+#endif
+
+			if (bCancelled.load())
+			{
+				OutError = TEXT("Cancelled");
+				return false;
+			}
+
+			UE_LOG(LogTemp, Error, TEXT("FileCopy: %s"), *OutError);
+			return false;
+		}
+
+		// The source is removed only once everything is safely at the destination
+		if (Options.bMove && !PlatformFile.DeleteDirectoryRecursively(*SourceDir))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FileCopy: Files were moved but the source directory could not be removed: %s"), *SourceDir);
+		}
+
+		OnProgress(1.0f, FString());
+		return true;
+	}
+}
+
+int32 UFileCopyLibrary::CopyDirectoryAsync(const FString& SourceDir,
+										   const FString& DestDir,
+										   const FFileCopyOptions& Options,
+										   const FOnFileCopyProgress& OnProgress,
+										   const FOnFileCopyComplete& OnComplete)
+{
+	TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe> bCancelled = MakeShared<std::atomic<bool>, ESPMode::ThreadSafe>(false);
+
+	int32 OperationId;
+	{
+		FScopeLock Lock(&OperationsMutex);
+		OperationId = ++LastOperationId;
+		RunningOperations.Add(OperationId, bCancelled);
+	}
+
+	Async(EAsyncExecution::ThreadPool, [SourceDir, DestDir, Options, OnProgress, OnComplete, bCancelled, OperationId]()
+	{
+		FileTaskHelpers::TThrottledProgress<FOnFileCopyProgress> Progress(OnProgress);
+
+		FString ErrorMessage;
+		const bool bSuccess = RunCopy(SourceDir, DestDir, Options, *bCancelled, [&Progress](float Percent, const FString& CurrentFile)
+		{
+			Progress.Report(Percent, CurrentFile);
+		}, ErrorMessage);
+
+		const bool bWasCancelled = bCancelled->load();
+
+		{
+			FScopeLock Lock(&OperationsMutex);
+			RunningOperations.Remove(OperationId);
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [OnComplete, bSuccess, bWasCancelled, ErrorMessage]()
+		{
+			OnComplete.ExecuteIfBound(bSuccess, bWasCancelled, ErrorMessage);
+		});
+	});
+
+	return OperationId;
+}
+
+bool UFileCopyLibrary::CancelCopyOperation(int32 OperationId)
+{
+	FScopeLock Lock(&OperationsMutex);
+
+	const TSharedPtr<std::atomic<bool>, ESPMode::ThreadSafe>* bCancelled = RunningOperations.Find(OperationId);
+	if (!bCancelled)
+	{
+		return false;
+	}
+
+	(*bCancelled)->store(true);
+	return true;
+}
+
+bool UFileCopyLibrary::CopyDirectory(const FString& SourceDir, const FString& DestDir, const FFileCopyOptions& Options, FString& OutError)
+{
+	const std::atomic<bool> bCancelled{false};
+	return RunCopy(SourceDir, DestDir, Options, bCancelled, [](float, const FString&) {}, OutError);
+}
+
+bool UFileCopyLibrary::CopySingleFile(const FString& SourceFile, const FString& DestFile, TFunctionRef<bool(int64)> OnBytesCopied, FString& OutError)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+#if PLATFORM_LINUX
+	const int SourceFd = open(TCHAR_TO_UTF8(*SourceFile), O_RDONLY | O_CLOEXEC);
+	if (SourceFd < 0)
+	{
+		OutError = FString::Printf(TEXT("Failed to open file: %s"), *SourceFile);
+		return false;
+	}
+
+	struct stat SourceStat;
+	if (fstat(SourceFd, &SourceStat) != 0)
+	{
+		close(SourceFd);
+		OutError = FString::Printf(TEXT("Failed to read file attributes: %s"), *SourceFile);
+		return false;
+	}
+
+	// Existing files are overwritten, even read-only ones
+	PlatformFile.SetReadOnly(*DestFile, false);
+
+	const int DestFd = open(TCHAR_TO_UTF8(*DestFile), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, SourceStat.st_mode & 0777);
+	if (DestFd < 0)
+	{
+		close(SourceFd);
+		OutError = FString::Printf(TEXT("Failed to create file: %s"), *DestFile);
+		return false;
+	}
+
+	const int64 Size = SourceStat.st_size;
+	EKernelCopyResult Result = EKernelCopyResult::Unsupported;
+
+#ifdef FICLONE
+	// A reflink shares the data blocks with the source until either file is modified
+	if (ioctl(DestFd, FICLONE, SourceFd) == 0)
+	{
+		Result = OnBytesCopied(Size) ? EKernelCopyResult::Copied : EKernelCopyResult::Stopped;
+	}
+#endif
+
+#ifdef SYS_copy_file_range
+	// Called through syscall, as the glibc wrapper is missing from older sysroots
+	if (Result == EKernelCopyResult::Unsupported)
+	{
+		Result = CopyWithKernel(Size, OnBytesCopied, [SourceFd, DestFd](int64 Offset, size_t ChunkSize)
+		{
+			loff_t SourceOffset = Offset;
+			loff_t DestOffset = Offset;
+			return static_cast<ssize_t>(syscall(SYS_copy_file_range, SourceFd, &SourceOffset, DestFd, &DestOffset, ChunkSize, 0u));
+		});
+	}
+#endif
+
+	if (Result == EKernelCopyResult::Unsupported)
+	{
+		// Writes at the current destination position, which is still at the start
+		Result = CopyWithKernel(Size, OnBytesCopied, [SourceFd, DestFd](int64 Offset, size_t ChunkSize)
+		{
+			off_t SourceOffset = Offset;
+			return sendfile(DestFd, SourceFd, &SourceOffset, ChunkSize);
+		});
+	}
+
+	if (Result == EKernelCopyResult::Unsupported)
+	{
+		TArray<uint8> Buffer;
+		Buffer.SetNumUninitialized(static_cast<int32>(FMath::Min(Size, CopyChunkSize)));
+
+		Result = CopyWithKernel(Size, OnBytesCopied, [SourceFd, DestFd, &Buffer](int64 Offset, size_t ChunkSize)
+		{
+			const ssize_t Read = pread(SourceFd, Buffer.GetData(), ChunkSize, Offset);
+			if (Read <= 0)
+			{
+				return Read;
+			}
+			return pwrite(DestFd, Buffer.GetData(), Read, Offset) == Read ? Read : static_cast<ssize_t>(-1);
+		});
+
+		// Plain reads and writes do not depend on kernel support
+		if (Result == EKernelCopyResult::Unsupported)
+		{
+			Result = EKernelCopyResult::Failed;
+		}
+	}
+
+	if (Result == EKernelCopyResult::Copied)
+	{
+		// Keeping the modification time, which is what change detection relies on
+		const struct timespec Times[2] = {SourceStat.st_atim, SourceStat.st_mtim};
+		futimens(DestFd, Times);
+	}
+
+	close(SourceFd);
+
+	if (close(DestFd) != 0 && Result == EKernelCopyResult::Copied)
+	{
+		Result = EKernelCopyResult::Failed;
+	}
+
+	if (Result != EKernelCopyResult::Copied)
+	{
+		unlink(TCHAR_TO_UTF8(*DestFile));
+		OutError = Result == EKernelCopyResult::Stopped ? TEXT("Cancelled") : FString::Printf(TEXT("Failed to copy file: %s"), *SourceFile);
+		return false;
+	}
+
+	return true;
+#else
+	TUniquePtr<IFileHandle> SourceHandle(PlatformFile.OpenRead(*SourceFile));
+	if (!SourceHandle)
+	{
+		OutError = FString::Printf(TEXT("Failed to open file: %s"), *SourceFile);
+		return false;
+	}
+
+	PlatformFile.SetReadOnly(*DestFile, false);
+
+	TUniquePtr<IFileHandle> DestHandle(PlatformFile.OpenWrite(*DestFile));
+	if (!DestHandle)
+	{
+		OutError = FString::Printf(TEXT("Failed to create file: %s"), *DestFile);
+		return false;
+	}
+
+	const int64 Size = SourceHandle->Size();
+
+	TArray<uint8> Buffer;
+	Buffer.SetNumUninitialized(static_cast<int32>(FMath::Min(Size, CopyChunkSize)));
+
+	bool bCopied = true;
+	bool bStopped = false;
+	for (int64 Offset = 0; Offset < Size; )
+	{
+		const int64 ChunkSize = FMath::Min(Size - Offset, CopyChunkSize);
+		if (!SourceHandle->Read(Buffer.GetData(), ChunkSize) || !DestHandle->Write(Buffer.GetData(), ChunkSize))
+		{
+			bCopied = false;
+			break;
+		}
+
+		Offset += ChunkSize;
+
+		if (!OnBytesCopied(ChunkSize))
+		{
+			bCopied = false;
+			bStopped = true;
+			break;
+		}
+	}
+
+	bCopied = bCopied && DestHandle->Flush();
+
+	SourceHandle.Reset();
+	DestHandle.Reset();
+
+	if (!bCopied)
+	{
+		PlatformFile.DeleteFile(*DestFile);
+		OutError = bStopped ? TEXT("Cancelled") : FString::Printf(TEXT("Failed to copy file: %s"), *SourceFile);
+		return false;
+	}
+
+	// Keeping the modification time, which is what change detection relies on
+	PlatformFile.SetTimeStamp(*DestFile, PlatformFile.GetTimeStamp(*SourceFile));
+	return true;
+#endif
+}
@@ -0,0 +1,110 @@
+// Pioza Launcher
+// Copyright (c) 2025 DashoGames
+// Licensed under the MIT License - see LICENSE file for details
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "FileCopyLibrary.generated.h"
+
+/**
+ * Options of a directory copy or move.
+ */
+USTRUCT(BlueprintType)
+struct FFileCopyOptions
+{
+	GENERATED_BODY()
+
+	/** Whether to move the files instead of copying them. Source files are deleted only once all of them were transferred, and files already renamed into the destination are moved back if the move is cancelled or fails */
+	UPROPERTY(BlueprintReadWrite, Category = "FileCopy")
+	bool bMove = false;
+
+	/** Number of files transferred at the same time. 0 picks a value based on the number of CPU cores */
+	UPROPERTY(BlueprintReadWrite, Category = "FileCopy")
+	int32 MaxParallelFiles = 0;
+
+	/** Whether to check the size of every transferred file against its source */
+	UPROPERTY(BlueprintReadWrite, Category = "FileCopy")
+	bool bVerifySize = true;
+};
+
+/**
+ * Delegate for progress updates.
+ * @param ProgressPercent - Value between 0.0 and 1.0, based on the transferred bytes.
+ * @param CurrentFile - The relative path of the file currently being transferred.
+ */
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnFileCopyProgress, float, ProgressPercent, FString, CurrentFile);
+
+/**
+ * Delegate for completion.
+ * @param bSuccess - Whether every file was transferred.
+ * @param bCancelled - Whether the operation was cancelled.
+ * @param ErrorMessage - Reason of the failure, empty on success.
+ */
+DECLARE_DYNAMIC_DELEGATE_ThreeParams(FOnFileCopyComplete, bool, bSuccess, bool, bCancelled, FString, ErrorMessage);
+
+/**
+ * Fast copy and move of directory trees, used for moving games to another drive and restoring them.
+ *
+ * Each file goes through the fastest available path:
+ *   1. rename, when moving within the same file system
+ *   2. reflink (FICLONE), sharing the data blocks on copy-on-write file systems like btrfs or XFS (Linux)
+ *   3. in-kernel copy with copy_file_range or sendfile, without passing the data through user space (Linux)
+ *   4. buffered read/write copy otherwise
+ * Several files are transferred in parallel.
+ */
+UCLASS()
+class PIOZAGAMELAUNCHER_API UFileCopyLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Copies or moves a directory tree without blocking the game thread.
+	 *
+	 * @param SourceDir  The directory to copy from.
+	 * @param DestDir    The directory to copy to. Existing files are overwritten.
+	 * @param Options    Copy options.
+	 * @param OnProgress Event fired to update UI (throttled).
+	 * @param OnComplete Event fired when the operation is finished.
+	 * @return Id of the operation, to be passed to CancelCopyOperation.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FileCopy", meta = (AutoCreateRefTerm = "Options,OnProgress,OnComplete"))
+	static int32 CopyDirectoryAsync(const FString& SourceDir,
+									const FString& DestDir,
+									const FFileCopyOptions& Options,
+									const FOnFileCopyProgress& OnProgress,
+									const FOnFileCopyComplete& OnComplete);
+
+	/**
+	 * Requests the cancellation of a running operation. Files being transferred are stopped and removed from the destination.
+	 *
+	 * @return true if the operation was still running; false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FileCopy")
+	static bool CancelCopyOperation(int32 OperationId);
+
+	/**
+	 * Copies or moves a directory tree, blocking until it is finished.
+	 *
+	 * @param SourceDir The directory to copy from.
+	 * @param DestDir   The directory to copy to. Existing files are overwritten.
+	 * @param Options   Copy options.
+	 * @param OutError  Reason of the failure.
+	 * @return true if every file was transferred; false otherwise.
+	 */
+	static bool CopyDirectory(const FString& SourceDir, const FString& DestDir, const FFileCopyOptions& Options, FString& OutError);
+
+	/**
+	 * Copies a single file through the fastest available path, keeping its modification time.
+	 * A partially copied file is removed.
+	 *
+	 * @param SourceFile    The file to copy.
+	 * @param DestFile      The file to create or overwrite.
+	 * @param OnBytesCopied Called with the number of bytes copied since the previous call. Returning false stops the copy.
+	 * @param OutError      Reason of the failure.
+	 * @return true if the file was copied; false otherwise.
+	 */
+	static bool CopySingleFile(const FString& SourceFile, const FString& DestFile, TFunctionRef<bool(int64)> OnBytesCopied, FString& OutError);
+};
@@ -3,6 +3,7 @@
 // Licensed under the MIT License - see LICENSE file for details
 
 #include "FileNodes.h"
+#include "FileCopyLibrary.h"
 #include "Misc/FileHelper.h"
 #include "Misc/OutputDeviceDebug.h"
 #include "Misc/Paths.h"
@@ -36,8 +37,14 @@ bool UFileNodes::ReadBytes(const FString& FilePath, TArray<uint8>& OutBytes)
 
 bool UFileNodes::CopyDirectory(const FString& SourceDir, const FString& DestDir)
 {
-    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-    return PlatformFile.CopyDirectoryTree(*DestDir, *SourceDir, /* bOverwriteExisting = */ true);
+    // Goes through the fast copy paths (reflinks, in-kernel copies) and copies several files at once
+    FString Error;
+    if (!UFileCopyLibrary::CopyDirectory(SourceDir, DestDir, FFileCopyOptions(), Error))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("CopyDirectory failed: %s"), *Error);
+        return false;
+    }
+    return true;
 }
 
 int64 UFileNodes::GetFileSize(const FString& FilePath)
@@ -52,7 +52,8 @@ public:
     static bool ReadBytes(const FString& FilePath, TArray<uint8>& OutBytes);
 
     /**
-     * Copies a directory tree recursively from source to destination.
+     * Copies a directory tree recursively from source to destination, several files at once.
+     * Use UFileCopyLibrary::CopyDirectoryAsync for progress, cancellation or moving.
      * @param SourceDir - The directory to copy from.
      * @param DestDir - The directory to copy to.
      * @return true if the copy was successful; false otherwise.
@@ -0,0 +1,80 @@
+// Pioza Launcher
+// Copyright (c) 2025 DashoGames
+// Licensed under the MIT License - see LICENSE file for details
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Async.h"
+#include "HAL/PlatformTime.h"
+
+/**
+ * Helpers shared by the background file operations (verification, backups, copies).
+ */
+namespace FileTaskHelpers
+{
+	/**
+	 * Forwards progress to the game thread at most ~20 times per second. Safe to call from worker threads.
+	 * @tparam ProgressDelegateType - Any delegate taking the progress percent and the current file.
+	 */
+	template <typename ProgressDelegateType>
+	class TThrottledProgress
+	{
+	public:
+		explicit TThrottledProgress(const ProgressDelegateType& InOnProgress)
+			: OnProgress(InOnProgress)
+			, LastUpdateTime(0.0)
+		{
+		}
+
+		void Report(float Percent, const FString& CurrentFile)
+		{
+			const double UpdateInterval = 0.05;
+
+			// Non-blocking try-lock to prevent stalling worker threads. LastUpdateTime is only accessed under the lock
+			if (!Mutex.TryLock())
+			{
+				return;
+			}
+
+			const double Now = FPlatformTime::Seconds();
+			if (Now - LastUpdateTime >= UpdateInterval)
+			{
+				LastUpdateTime = Now;
+
+				AsyncTask(ENamedThreads::GameThread, [OnProgress = OnProgress, Percent, CurrentFile]()
+				{
+					OnProgress.ExecuteIfBound(Percent, CurrentFile);
+				});
+			}
+			Mutex.Unlock();
+		}
+
+	private:
+		ProgressDelegateType OnProgress;
+		FCriticalSection Mutex;
+		double LastUpdateTime;
+	};
+
+	/**
+	 * Whether the relative path is listed in FilesToIgnore, either as is or through a wildcard pattern like "*.log".
+	 */
+	inline bool IsIgnored(const FString& RelativePath, const TArray<FString>& FilesToIgnore)
+	{
+		if (FilesToIgnore.Contains(RelativePath))
+		{
+			return true;
+		}
+
+		// Wildcard check (mimics Blueprint "MatchesAnyWildcard")
+		for (const FString& Pattern : FilesToIgnore)
+		{
+			if (RelativePath.MatchesWildcard(Pattern, ESearchCase::IgnoreCase))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,262 @@
+// Pioza Launcher
+// Copyright (c) 2025 DashoGames
+// Licensed under the MIT License - see LICENSE file for details
+
+#include "GamePackageCommandlet.h"
+#include "ChecksumLibrary.h"
+#include "ArchiverZip/RuntimeArchiverZip.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "UObject/StrongObjectPtr.h"
+
+namespace
+{
+	const TCHAR* VersionFileName = TEXT("version.txt");
+
+	bool ParseAlgorithm(const FString& Name, EChecksumAlgorithm& OutAlgorithm)
+	{
+		for (const EChecksumAlgorithm Algorithm : {EChecksumAlgorithm::MD5, EChecksumAlgorithm::SHA1, EChecksumAlgorithm::CRC32})
+		{
+			if (Name.Equals(UChecksumLibrary::GetAlgorithmName(Algorithm).Replace(TEXT("-"), TEXT("")), ESearchCase::IgnoreCase))
+			{
+				OutAlgorithm = Algorithm;
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+UGamePackageCommandlet::UGamePackageCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UGamePackageCommandlet::Main(const FString& Params)
+{
+	FString SourceDirectory, OutputPath, Version, ManifestPath;
+	FString AlgorithmName = TEXT("MD5");
+	int32 CompressionLevel = 6;
+	int32 NumOfWorkers = 0;
+
+	if (!FParse::Value(*Params, TEXT("Source="), SourceDirectory) || !FParse::Value(*Params, TEXT("Output="), OutputPath) || !FParse::Value(*Params, TEXT("Version="), Version))
+	{
+		UE_LOG(LogTemp, Error, TEXT("GamePackage: usage: -run=GamePackage -Source=<GameFolder> -Output=<Package.zip> -Version=<N> [-CompressionLevel=6] [-Algorithm=MD5|SHA1|CRC32] [-Manifest=<checksums.txt>] [-Workers=0]"));
+		return 1;
+	}
+
+	FParse::Value(*Params, TEXT("CompressionLevel="), CompressionLevel);
+	FParse::Value(*Params, TEXT("Algorithm="), AlgorithmName);
+	FParse::Value(*Params, TEXT("Workers="), NumOfWorkers);
+
+	// Versions are integers, as in the Python packager
+	if (!Version.IsNumeric() || Version.Contains(TEXT(".")) || Version.StartsWith(TEXT("-")))
+	{
+		UE_LOG(LogTemp, Error, TEXT("GamePackage: version must be a non-negative integer, got '%s'"), *Version);
+		return 1;
+	}
+
+	EChecksumAlgorithm Algorithm;
+	if (!ParseAlgorithm(AlgorithmName, Algorithm))
+	{
+		UE_LOG(LogTemp, Error, TEXT("GamePackage: unknown checksum algorithm '%s'"), *AlgorithmName);
+		return 1;
+	}
+
+	SourceDirectory = FPaths::ConvertRelativePathToFull(SourceDirectory);
+	FPaths::NormalizeDirectoryName(SourceDirectory);
+	OutputPath = FPaths::ConvertRelativePathToFull(OutputPath);
+
+	if (!FParse::Value(*Params, TEXT("Manifest="), ManifestPath))
+	{
+		ManifestPath = FPaths::Combine(FPaths::GetPath(OutputPath), TEXT("checksums.txt"));
+	}
+	ManifestPath = FPaths::ConvertRelativePathToFull(ManifestPath);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.DirectoryExists(*SourceDirectory))
+	{
+		UE_LOG(LogTemp, Error, TEXT("GamePackage: source folder not found: %s"), *SourceDirectory);
+		return 1;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// -----------------------------------------------------------------
+	// 1. version.txt in the game folder, so it ships inside the package
+	// -----------------------------------------------------------------
+	if (!FFileHelper::SaveStringToFile(Version, *FPaths::Combine(SourceDirectory, VersionFileName), FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(LogTemp, Error, TEXT("GamePackage: unable to write %s"), VersionFileName);
+		return 1;
+	}
+
+	const FString TempOutputPath = OutputPath + TEXT(".tmp");
+	const TArray<FString> RelativePaths = CollectPackageFiles(SourceDirectory, {OutputPath, TempOutputPath, ManifestPath});
+
+	TArray<FString> FilePaths;
+	FilePaths.Reserve(RelativePaths.Num());
+
+	int64 TotalBytes = 0;
+	for (const FString& RelativePath : RelativePaths)
+	{
+		FString& FilePath = FilePaths.Add_GetRef(FPaths::Combine(SourceDirectory, RelativePath));
+		TotalBytes += FMath::Max<int64>(PlatformFile.FileSize(*FilePath), 0);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("GamePackage: packing %d files (%lld bytes) from %s"), RelativePaths.Num(), TotalBytes, *SourceDirectory);
+
+	// -----------------------------------------------------------------
+	// 2. Checksums, computed from the file data the archiver reads, so that every file is read only once
+	// -----------------------------------------------------------------
+	TArray<FChecksumBuilder> ChecksumBuilders;
+	ChecksumBuilders.Reserve(RelativePaths.Num());
+	for (int32 Index = 0; Index < RelativePaths.Num(); ++Index)
+	{
+		ChecksumBuilders.Emplace(Algorithm);
+	}
+
+	// -----------------------------------------------------------------
+	// 3. The package itself, written to a temporary file first so a failed run never leaves a truncated package behind
+	// -----------------------------------------------------------------
+	TStrongObjectPtr<URuntimeArchiverZip> Archiver(NewObject<URuntimeArchiverZip>());
+	Archiver->MaxCompressionWorkers = NumOfWorkers;
+
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(OutputPath));
+	PlatformFile.DeleteFile(*TempOutputPath);
+
+	int64 ProcessedBytes = 0;
+	int32 LastReportedPercent = -1;
+
+	bool bPacked = Archiver->CreateArchiveInStorage(TempOutputPath)
+		&& Archiver->AddNamedEntriesFromStorage(RelativePaths, FilePaths, static_cast<ERuntimeArchiverCompressionLevel>(FMath::Clamp(CompressionLevel, 0, 10)), [&](int64 NumOfBytes)
+		{
+			ProcessedBytes += NumOfBytes;
+
+			const int32 Percent = TotalBytes > 0 ? static_cast<int32>(ProcessedBytes * 100 / TotalBytes) : 100;
+			if (Percent / 5 != LastReportedPercent / 5)
+			{
+				LastReportedPercent = Percent;
+				UE_LOG(LogTemp, Display, TEXT("GamePackage: %d%%"), Percent);
+			}
+		}, [&ChecksumBuilders](int32 EntryIndex, TArrayView64<const uint8> Data)
+		{
+			// Each entry is read by a single thread at a time, so the builders need no locking
+			ChecksumBuilders[EntryIndex].Update(Data.GetData(), Data.Num());
+		});
+	bPacked &= Archiver->CloseArchive();
+
+	if (!bPacked)
+	{
+		PlatformFile.DeleteFile(*TempOutputPath);
+		UE_LOG(LogTemp, Error, TEXT("GamePackage: unable to write the package %s"), *OutputPath);
+		return 1;
+	}
+
+	if (!IFileManager::Get().Move(*OutputPath, *TempOutputPath, true))
+	{
+		PlatformFile.DeleteFile(*TempOutputPath);
+		UE_LOG(LogTemp, Error, TEXT("GamePackage: unable to move the package to %s"), *OutputPath);
+		return 1;
+	}
+
+	// -----------------------------------------------------------------
+	// 4. Checksum manifest
+	// -----------------------------------------------------------------
+	TArray<FString> Checksums;
+	Checksums.Reserve(ChecksumBuilders.Num());
+	for (FChecksumBuilder& ChecksumBuilder : ChecksumBuilders)
+	{
+		Checksums.Add(ChecksumBuilder.Finalize());
+	}
+
+	if (!SaveChecksumManifest(ManifestPath, UChecksumLibrary::GetAlgorithmName(Algorithm), Version, RelativePaths, Checksums))
+	{
+		UE_LOG(LogTemp, Error, TEXT("GamePackage: unable to write the checksum manifest %s"), *ManifestPath);
+		return 1;
+	}
+
+	const int64 PackageSize = PlatformFile.FileSize(*OutputPath);
+	const double CompressionRatio = TotalBytes > 0 ? (1.0 - static_cast<double>(PackageSize) / TotalBytes) * 100.0 : 0.0;
+
+	UE_LOG(LogTemp, Display, TEXT("GamePackage: game packaged to %s in %.1fs. Original size: %lld bytes, compressed size: %lld bytes, compression ratio: %.1f%%. Checksums: %s"),
+		*OutputPath, FPlatformTime::Seconds() - StartTime, TotalBytes, PackageSize, CompressionRatio, *ManifestPath);
+
+	return 0;
+}
+
+TArray<FString> UGamePackageCommandlet::CollectPackageFiles(const FString& SourceDirectory, const TArray<FString>& ExcludedFiles)
+{
+	TArray<FString> AbsolutePaths;
+	IFileManager::Get().FindFilesRecursive(AbsolutePaths, *SourceDirectory, TEXT("*"), true, false);
+
+	const FString SourcePrefix = SourceDirectory / TEXT("");
+
+	TArray<FString> RelativePaths;
+	RelativePaths.Reserve(AbsolutePaths.Num());
+
+	for (FString& AbsolutePath : AbsolutePaths)
+	{
+		FPaths::NormalizeFilename(AbsolutePath);
+
+		if (AbsolutePath.StartsWith(SourcePrefix) && !ExcludedFiles.ContainsByPredicate([&AbsolutePath](const FString& ExcludedFile) { return FPaths::IsSamePath(AbsolutePath, ExcludedFile); }))
+		{
+			RelativePaths.Add(AbsolutePath.RightChop(SourcePrefix.Len()));
+		}
+	}
+
+	// Files of the same directory, and files of the same type within it, are kept next to each other so that
+	// installation writes each directory in one go. version.txt goes last: an interrupted install never looks complete
+	RelativePaths.Sort([](const FString& A, const FString& B)
+	{
+		const bool bIsVersionA = A.Equals(VersionFileName, ESearchCase::IgnoreCase);
+		const bool bIsVersionB = B.Equals(VersionFileName, ESearchCase::IgnoreCase);
+		if (bIsVersionA != bIsVersionB)
+		{
+			return bIsVersionB;
+		}
+
+		const int32 DirectoryCompare = FPaths::GetPath(A).Compare(FPaths::GetPath(B), ESearchCase::IgnoreCase);
+		if (DirectoryCompare != 0)
+		{
+			return DirectoryCompare < 0;
+		}
+
+		const int32 ExtensionCompare = FPaths::GetExtension(A).Compare(FPaths::GetExtension(B), ESearchCase::IgnoreCase);
+		if (ExtensionCompare != 0)
+		{
+			return ExtensionCompare < 0;
+		}
+
+		return A.Compare(B, ESearchCase::IgnoreCase) < 0;
+	});
+
+	return RelativePaths;
+}
+
+bool UGamePackageCommandlet::SaveChecksumManifest(const FString& ManifestPath, const FString& AlgorithmName, const FString& Version, const TArray<FString>& RelativePaths, const TArray<FString>& Checksums)
+{
+	TArray<FString> Lines;
+	Lines.Reserve(RelativePaths.Num() + 3);
+
+	Lines.Add(FString::Printf(TEXT("# Algorithm: %s"), *AlgorithmName));
+	Lines.Add(FString::Printf(TEXT("# Version: %s"), *Version));
+	Lines.Add(FString::Printf(TEXT("# Files: %d"), RelativePaths.Num()));
+
+	for (int32 Index = 0; Index < RelativePaths.Num(); ++Index)
+	{
+		Lines.Add(FString::Printf(TEXT("%s %s"), *Checksums[Index], *RelativePaths[Index]));
+	}
+
+	// Written to a temporary file first, so a crash never leaves a truncated manifest behind
+	const FString TempManifestPath = ManifestPath + TEXT(".tmp");
+	return FFileHelper::SaveStringArrayToFile(Lines, *TempManifestPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM)
+		&& IFileManager::Get().Move(*ManifestPath, *TempManifestPath, true);
+}
@@ -0,0 +1,43 @@
+// Pioza Launcher
+// Copyright (c) 2025 DashoGames
+// Licensed under the MIT License - see LICENSE file for details
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "GamePackageCommandlet.generated.h"
+
+/**
+ * Headless counterpart of Tools/game_package_creator.py.
+ * Writes version.txt into the game folder, packs the folder into a ZIP archive with parallel compression
+ * (incompressible files are stored as is) and writes the checksum manifest of the packed files,
+ * computed from the data read for packing so that every file is read once.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd PiozaGameLauncher.uproject -run=GamePackage -Source=<GameFolder> -Output=<Package.zip> -Version=<N>
+ *     [-CompressionLevel=6] [-Algorithm=MD5|SHA1|CRC32] [-Manifest=<checksums.txt>] [-Workers=0]
+ */
+UCLASS()
+class PIOZAGAMELAUNCHER_API UGamePackageCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGamePackageCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+private:
+	/**
+	 * Collect the files of the game folder as paths relative to it, in the order they are packed
+	 * @param SourceDirectory - Normalized absolute game folder
+	 * @param ExcludedFiles - Absolute paths never packed (the package and the manifest themselves)
+	 */
+	static TArray<FString> CollectPackageFiles(const FString& SourceDirectory, const TArray<FString>& ExcludedFiles);
+
+	/** Write the manifest in the "checksum filepath" format read by UChecksumLibrary::LoadChecksumsFromFile */
+	static bool SaveChecksumManifest(const FString& ManifestPath, const FString& AlgorithmName, const FString& Version, const TArray<FString>& RelativePaths, const TArray<FString>& Checksums);
+};
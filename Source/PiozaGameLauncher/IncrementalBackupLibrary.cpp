@@ -0,0 +1,558 @@
+// Pioza Launcher
+// Copyright (c) 2025 DashoGames
+// Licensed under the MIT License - see LICENSE file for details
+
+#include "IncrementalBackupLibrary.h"
+#include "ChecksumLibrary.h"
+#include "FileTaskHelpers.h"
+#include "ArchiverZip/RuntimeArchiverZip.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/StrongObjectPtr.h"
+#include <atomic>
+
+namespace
+{
+	using FThrottledBackupProgress = FileTaskHelpers::TThrottledProgress<FOnBackupProgress>;
+
+	/** Key identifying file content regardless of its path */
+	FString MakeContentKey(const FBackupManifestFile& File)
+	{
+		return FString::Printf(TEXT("%s:%lld"), *File.Checksum.ToLower(), File.Size);
+	}
+
+	/**
+	 * Lists the game files as paths relative to the game directory, skipping ignored files and the backup directory itself.
+	 */
+	TArray<FString> FindGameFiles(const FString& GameDirectory, const FString& BackupDirectory, const TArray<FString>& FilesToIgnore)
+	{
+		TArray<FString> AbsolutePaths;
+		IFileManager::Get().FindFilesRecursive(AbsolutePaths, *GameDirectory, TEXT("*"), true, false);
+
+		const FString GamePrefix = GameDirectory / TEXT("");
+		const FString BackupPrefix = BackupDirectory / TEXT("");
+
+		TArray<FString> RelativePaths;
+		RelativePaths.Reserve(AbsolutePaths.Num());
+
+		for (FString& AbsolutePath : AbsolutePaths)
+		{
+			FPaths::NormalizeFilename(AbsolutePath);
+
+			if (!AbsolutePath.StartsWith(GamePrefix) || AbsolutePath.StartsWith(BackupPrefix))
+			{
+				continue;
+			}
+
+			FString RelativePath = AbsolutePath.RightChop(GamePrefix.Len());
+			if (!FileTaskHelpers::IsIgnored(RelativePath, FilesToIgnore))
+			{
+				RelativePaths.Add(MoveTemp(RelativePath));
+			}
+		}
+
+		// Stable order keeps manifests and archives diff-friendly
+		RelativePaths.Sort();
+		return RelativePaths;
+	}
+
+	/**
+	 * Manifests store times with millisecond precision, while file systems like NTFS keep finer ones
+	 */
+	bool IsSameModificationTime(const FDateTime& A, const FDateTime& B)
+	{
+		return FMath::Abs((A - B).GetTicks()) < ETimespan::TicksPerMillisecond;
+	}
+
+	FString NormalizeDirectory(const FString& Directory)
+	{
+		FString Normalized = FPaths::ConvertRelativePathToFull(Directory);
+		FPaths::NormalizeDirectoryName(Normalized);
+		return Normalized;
+	}
+}
+
+void UIncrementalBackupLibrary::CreateIncrementalBackupAsync(const FString& GameDirectory,
+															 const FString& BackupDirectory,
+															 const TArray<FString>& FilesToIgnore,
+															 EChecksumAlgorithm Algorithm,
+															 const FOnBackupProgress& OnProgress,
+															 const FOnBackupComplete& OnComplete)
+{
+	// Archivers are UObjects, so they are created on the game thread and kept alive until the task reports back
+	TStrongObjectPtr<URuntimeArchiverZip> Archiver(NewObject<URuntimeArchiverZip>());
+
+	const FString GameDir = NormalizeDirectory(GameDirectory);
+	const FString BackupDir = NormalizeDirectory(BackupDirectory);
+
+	Async(EAsyncExecution::ThreadPool, [Archiver, GameDir, BackupDir, FilesToIgnore, Algorithm, OnProgress, OnComplete]() mutable
+	{
+		auto Finish = [&Archiver, OnComplete](bool bSuccess, const FBackupSnapshotInfo& Snapshot, const FString& ErrorMessage)
+		{
+			if (!bSuccess)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Incremental backup failed: %s"), *ErrorMessage);
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [Archiver = MoveTemp(Archiver), OnComplete, bSuccess, Snapshot, ErrorMessage]()
+			{
+				OnComplete.ExecuteIfBound(bSuccess, Snapshot, ErrorMessage);
+			});
+		};
+
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+		if (!PlatformFile.DirectoryExists(*GameDir))
+		{
+			Finish(false, FBackupSnapshotInfo(), FString::Printf(TEXT("Game directory not found: %s"), *GameDir));
+			return;
+		}
+
+		// -----------------------------------------------------------------
+		// 1. Previous snapshot, used as the base for change detection
+		// -----------------------------------------------------------------
+		FBackupManifest Parent;
+		const bool bHasParent = LoadLatestBackupManifest(BackupDir, Parent);
+
+		// Checksums of different algorithms cannot be compared, such a backup is a full one
+		const bool bUseParent = bHasParent && Parent.Algorithm == Algorithm;
+
+		TMap<FString, const FBackupManifestFile*> ParentFilesByPath;
+		TMap<FString, const FBackupManifestFile*> StoredContent;
+
+		// Older snapshots may still hold content the parent no longer has (e.g. a file restored to an earlier version)
+		TArray<FBackupManifest> Ancestors;
+
+		if (bUseParent)
+		{
+			TSet<FString> VisitedSnapshots;
+			VisitedSnapshots.Add(Parent.SnapshotId);
+
+			FBackupManifest Ancestor;
+			for (FString AncestorId = Parent.ParentSnapshotId; !AncestorId.IsEmpty() && !VisitedSnapshots.Contains(AncestorId); AncestorId = Ancestor.ParentSnapshotId)
+			{
+				if (!LoadBackupManifest(BackupDir, AncestorId, Ancestor))
+				{
+					UE_LOG(LogTemp, Warning, TEXT("Backup snapshot %s is missing, older snapshots are not used for deduplication"), *AncestorId);
+					break;
+				}
+
+				VisitedSnapshots.Add(AncestorId);
+
+				if (Ancestor.Algorithm == Algorithm)
+				{
+					Ancestors.Add(Ancestor);
+				}
+			}
+
+			for (const FBackupManifest& OlderSnapshot : Ancestors)
+			{
+				for (const FBackupManifestFile& File : OlderSnapshot.Files)
+				{
+					StoredContent.Add(MakeContentKey(File), &File);
+				}
+			}
+
+			// Added last, so the parent's copy is preferred when several snapshots hold the same content
+			for (const FBackupManifestFile& File : Parent.Files)
+			{
+				ParentFilesByPath.Add(File.Path, &File);
+				StoredContent.Add(MakeContentKey(File), &File);
+			}
+		}
+
+		FBackupManifest Manifest;
+		Manifest.SnapshotId = FDateTime::UtcNow().ToString(TEXT("%Y%m%d-%H%M%S"));
+		Manifest.ParentSnapshotId = bHasParent ? Parent.SnapshotId : FString();
+		Manifest.CreatedAt = FDateTime::UtcNow();
+		Manifest.Algorithm = Algorithm;
+		Manifest.FilesToIgnore = FilesToIgnore;
+
+		// Two backups within the same second must not overwrite each other
+		for (int32 Suffix = 1; PlatformFile.FileExists(*GetManifestPath(BackupDir, Manifest.SnapshotId)); ++Suffix)
+		{
+			Manifest.SnapshotId = FString::Printf(TEXT("%s-%d"), *FDateTime::UtcNow().ToString(TEXT("%Y%m%d-%H%M%S")), Suffix);
+		}
+
+		// -----------------------------------------------------------------
+		// 2. Change detection: size/mtime first, checksum only when they differ
+		// -----------------------------------------------------------------
+		const TArray<FString> RelativePaths = FindGameFiles(GameDir, BackupDir, FilesToIgnore);
+
+		Manifest.Files.SetNum(RelativePaths.Num());
+		TArray<bool> bCalcSucceeded;
+		bCalcSucceeded.Init(true, RelativePaths.Num());
+
+		FThrottledBackupProgress Progress(OnProgress);
+		FThreadSafeCounter ProcessedCount(0);
+
+		ParallelFor(RelativePaths.Num(), [&](int32 Index)
+		{
+			const FString& RelativePath = RelativePaths[Index];
+			const FString FullFilePath = FPaths::Combine(GameDir, RelativePath);
+			const FFileStatData StatData = PlatformFile.GetStatData(*FullFilePath);
+
+			FBackupManifestFile& File = Manifest.Files[Index];
+			File.Path = RelativePath;
+			File.Size = StatData.FileSize;
+			File.ModifiedTime = StatData.ModificationTime;
+
+			const FBackupManifestFile* const* ParentFile = ParentFilesByPath.Find(RelativePath);
+			if (ParentFile && (*ParentFile)->Size == File.Size && IsSameModificationTime((*ParentFile)->ModifiedTime, File.ModifiedTime))
+			{
+				File.Checksum = (*ParentFile)->Checksum;
+				File.Archive = (*ParentFile)->Archive;
+				File.Entry = (*ParentFile)->Entry;
+			}
+			else
+			{
+				bCalcSucceeded[Index] = StatData.bIsValid && UChecksumLibrary::CalculateFileChecksum(FullFilePath, Algorithm, File.Checksum);
+			}
+
+			// Hashing is the first half of the work, storing the second
+			Progress.Report(0.5f * ProcessedCount.Increment() / FMath::Max(RelativePaths.Num(), 1), RelativePath);
+		});
+
+		const int32 FailedIndex = bCalcSucceeded.Find(false);
+		if (FailedIndex != INDEX_NONE)
+		{
+			Finish(false, FBackupSnapshotInfo(), FString::Printf(TEXT("Unable to read file: %s"), *RelativePaths[FailedIndex]));
+			return;
+		}
+
+		// -----------------------------------------------------------------
+		// 3. Deduplication: content already stored by any snapshot in the chain, or earlier in this one, is referenced
+		// -----------------------------------------------------------------
+		TArray<int32> FilesToStore;
+
+		for (int32 Index = 0; Index < Manifest.Files.Num(); ++Index)
+		{
+			FBackupManifestFile& File = Manifest.Files[Index];
+			if (!File.Archive.IsEmpty())
+			{
+				continue;
+			}
+
+			const FString ContentKey = MakeContentKey(File);
+			if (const FBackupManifestFile* const* Stored = StoredContent.Find(ContentKey))
+			{
+				File.Archive = (*Stored)->Archive;
+				File.Entry = (*Stored)->Entry;
+				continue;
+			}
+
+			File.Archive = Manifest.SnapshotId;
+			File.Entry = File.Path;
+			FilesToStore.Add(Index);
+			StoredContent.Add(ContentKey, &File);
+		}
+
+		// -----------------------------------------------------------------
+		// 4. Storing the changed content through the archiver
+		// -----------------------------------------------------------------
+		if (FilesToStore.Num() > 0)
+		{
+			const FString ArchivePath = GetArchivePath(BackupDir, Manifest.SnapshotId);
+
+			if (!Archiver->CreateArchiveInStorage(ArchivePath))
+			{
+				Finish(false, FBackupSnapshotInfo(), FString::Printf(TEXT("Unable to create archive: %s"), *ArchivePath));
+				return;
+			}
+
+			TArray<FString> EntryNames;
+			TArray<FString> FilePaths;
+			int64 TotalBytesToStore = 0;
+
+			for (const int32 Index : FilesToStore)
+			{
+				const FBackupManifestFile& File = Manifest.Files[Index];
+				EntryNames.Add(File.Entry);
+				FilePaths.Add(FPaths::Combine(GameDir, File.Path));
+				TotalBytesToStore += File.Size;
+			}
+
+			// Compressed in parallel by the archiver, so the progress follows the stored bytes rather than the files
+			// The archiver may report them from any thread
+			std::atomic<int64> StoredBytes{0};
+
+			if (!Archiver->AddNamedEntriesFromStorage(EntryNames, FilePaths, ERuntimeArchiverCompressionLevel::Compression6, [&](int64 NumOfBytes)
+			{
+				const int64 NewStoredBytes = StoredBytes.fetch_add(NumOfBytes) + NumOfBytes;
+				Progress.Report(0.5f + 0.5f * NewStoredBytes / FMath::Max<int64>(TotalBytesToStore, 1), FString());
+			}))
+			{
+				Archiver->CloseArchive();
+				PlatformFile.DeleteFile(*ArchivePath);
+				Finish(false, FBackupSnapshotInfo(), FString::Printf(TEXT("Unable to store the changed files in archive: %s"), *ArchivePath));
+				return;
+			}
+
+			if (!Archiver->CloseArchive())
+			{
+				PlatformFile.DeleteFile(*ArchivePath);
+				Finish(false, FBackupSnapshotInfo(), FString::Printf(TEXT("Unable to write archive: %s"), *ArchivePath));
+				return;
+			}
+		}
+
+		// The manifest is written last, so an interrupted backup never shows up as a snapshot
+		if (!SaveBackupManifest(BackupDir, Manifest))
+		{
+			PlatformFile.DeleteFile(*GetArchivePath(BackupDir, Manifest.SnapshotId));
+			Finish(false, FBackupSnapshotInfo(), TEXT("Unable to write the snapshot manifest"));
+			return;
+		}
+
+		const FBackupSnapshotInfo Snapshot = MakeSnapshotInfo(Manifest);
+		UE_LOG(LogTemp, Log, TEXT("Backup snapshot %s: %d files, %d stored (%lld of %lld bytes)"),
+			*Snapshot.SnapshotId, Snapshot.TotalFiles, Snapshot.StoredFiles, Snapshot.StoredBytes, Snapshot.TotalBytes);
+
+		Finish(true, Snapshot, FString());
+	});
+}
+
+void UIncrementalBackupLibrary::RestoreSnapshotAsync(const FString& BackupDirectory,
+													 const FString& SnapshotId,
+													 const FString& GameDirectory,
+													 bool bRemoveExtraFiles,
+													 const FOnBackupProgress& OnProgress,
+													 const FOnRestoreComplete& OnComplete)
+{
+	TStrongObjectPtr<URuntimeArchiverZip> Archiver(NewObject<URuntimeArchiverZip>());
+
+	const FString GameDir = NormalizeDirectory(GameDirectory);
+	const FString BackupDir = NormalizeDirectory(BackupDirectory);
+
+	Async(EAsyncExecution::ThreadPool, [Archiver, BackupDir, SnapshotId, GameDir, bRemoveExtraFiles, OnProgress, OnComplete]() mutable
+	{
+		auto Finish = [&Archiver, OnComplete](bool bSuccess, const FString& ErrorMessage)
+		{
+			if (!bSuccess)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Snapshot restore failed: %s"), *ErrorMessage);
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [Archiver = MoveTemp(Archiver), OnComplete, bSuccess, ErrorMessage]()
+			{
+				OnComplete.ExecuteIfBound(bSuccess, ErrorMessage);
+			});
+		};
+
+		FBackupManifest Manifest;
+		const bool bLoaded = SnapshotId.IsEmpty() ? LoadLatestBackupManifest(BackupDir, Manifest) : LoadBackupManifest(BackupDir, SnapshotId, Manifest);
+		if (!bLoaded)
+		{
+			Finish(false, FString::Printf(TEXT("Snapshot not found: %s"), SnapshotId.IsEmpty() ? TEXT("latest") : *SnapshotId));
+			return;
+		}
+
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		FThrottledBackupProgress Progress(OnProgress);
+
+		// -----------------------------------------------------------------
+		// 1. Files that already have the snapshot content are left untouched
+		// -----------------------------------------------------------------
+		TArray<bool> bNeedsRestore;
+		bNeedsRestore.Init(true, Manifest.Files.Num());
+
+		ParallelFor(Manifest.Files.Num(), [&](int32 Index)
+		{
+			const FBackupManifestFile& File = Manifest.Files[Index];
+			const FString FullFilePath = FPaths::Combine(GameDir, File.Path);
+
+			const FFileStatData StatData = PlatformFile.GetStatData(*FullFilePath);
+			if (!StatData.bIsValid || StatData.FileSize != File.Size)
+			{
+				return;
+			}
+
+			// Restored files keep the snapshot time, so an unchanged size and time means the content is already there
+			if (IsSameModificationTime(StatData.ModificationTime, File.ModifiedTime))
+			{
+				bNeedsRestore[Index] = false;
+			}
+			else
+			{
+				FString Checksum;
+				bNeedsRestore[Index] = !UChecksumLibrary::CalculateFileChecksum(FullFilePath, Manifest.Algorithm, Checksum) || !Checksum.Equals(File.Checksum, ESearchCase::IgnoreCase);
+			}
+		});
+
+		// -----------------------------------------------------------------
+		// 2. Reassembling the snapshot from the archives holding its content
+		// -----------------------------------------------------------------
+		TMap<FString, TArray<int32>> FilesByArchive;
+		int32 NumToRestore = 0;
+
+		for (int32 Index = 0; Index < Manifest.Files.Num(); ++Index)
+		{
+			if (bNeedsRestore[Index])
+			{
+				FilesByArchive.FindOrAdd(Manifest.Files[Index].Archive).Add(Index);
+				++NumToRestore;
+			}
+		}
+
+		int32 NumRestored = 0;
+
+		for (const TPair<FString, TArray<int32>>& ArchiveFiles : FilesByArchive)
+		{
+			const FString ArchivePath = GetArchivePath(BackupDir, ArchiveFiles.Key);
+
+			if (!Archiver->OpenArchiveFromStorage(ArchivePath))
+			{
+				Finish(false, FString::Printf(TEXT("Unable to open archive: %s"), *ArchivePath));
+				return;
+			}
+
+			for (const int32 Index : ArchiveFiles.Value)
+			{
+				const FBackupManifestFile& File = Manifest.Files[Index];
+				const FString FullFilePath = FPaths::Combine(GameDir, File.Path);
+
+				FRuntimeArchiveEntry EntryInfo;
+				if (!Archiver->GetArchiveEntryInfoByName(File.Entry, EntryInfo) || !Archiver->ExtractEntryToStorage(EntryInfo, FullFilePath, true))
+				{
+					Archiver->CloseArchive();
+					Finish(false, FString::Printf(TEXT("Unable to restore file: %s"), *File.Path));
+					return;
+				}
+
+				// Keeping the snapshot time lets the next backup skip hashing the restored file
+				PlatformFile.SetTimeStamp(*FullFilePath, File.ModifiedTime);
+
+				Progress.Report(static_cast<float>(++NumRestored) / NumToRestore, File.Path);
+			}
+
+			Archiver->CloseArchive();
+		}
+
+		// -----------------------------------------------------------------
+		// 3. Optionally removing files that are not part of the snapshot
+		// -----------------------------------------------------------------
+		if (bRemoveExtraFiles)
+		{
+			TSet<FString> SnapshotPaths;
+			for (const FBackupManifestFile& File : Manifest.Files)
+			{
+				SnapshotPaths.Add(File.Path);
+			}
+
+			// Ignored files (saves, configs) were never stored, so they must not be deleted either
+			for (const FString& RelativePath : FindGameFiles(GameDir, BackupDir, Manifest.FilesToIgnore))
+			{
+				if (!SnapshotPaths.Contains(RelativePath))
+				{
+					PlatformFile.DeleteFile(*FPaths::Combine(GameDir, RelativePath));
+				}
+			}
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Restored snapshot %s: %d of %d files extracted"), *Manifest.SnapshotId, NumRestored, Manifest.Files.Num());
+		Finish(true, FString());
+	});
+}
+
+bool UIncrementalBackupLibrary::GetBackupSnapshots(const FString& BackupDirectory, TArray<FBackupSnapshotInfo>& OutSnapshots)
+{
+	OutSnapshots.Empty();
+
+	const FString BackupDir = NormalizeDirectory(BackupDirectory);
+
+	TArray<FString> ManifestFiles;
+	IFileManager::Get().FindFiles(ManifestFiles, *(BackupDir / TEXT("Snapshots") / TEXT("*.json")), true, false);
+
+	for (const FString& ManifestFile : ManifestFiles)
+	{
+		FBackupManifest Manifest;
+		if (LoadBackupManifest(BackupDir, FPaths::GetBaseFilename(ManifestFile), Manifest))
+		{
+			OutSnapshots.Add(MakeSnapshotInfo(Manifest));
+		}
+	}
+
+	OutSnapshots.Sort([](const FBackupSnapshotInfo& A, const FBackupSnapshotInfo& B)
+	{
+		return A.CreatedAt < B.CreatedAt;
+	});
+
+	return OutSnapshots.Num() > 0;
+}
+
+bool UIncrementalBackupLibrary::LoadBackupManifest(const FString& BackupDirectory, const FString& SnapshotId, FBackupManifest& OutManifest)
+{
+	FString JsonString;
+	if (!FFileHelper::LoadFileToString(JsonString, *GetManifestPath(BackupDirectory, SnapshotId)))
+	{
+		return false;
+	}
+
+	if (!FJsonObjectConverter::JsonObjectStringToUStruct(JsonString, &OutManifest, 0, 0))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("LoadBackupManifest: Failed to parse manifest of snapshot %s"), *SnapshotId);
+		return false;
+	}
+
+	return OutManifest.SnapshotId == SnapshotId;
+}
+
+bool UIncrementalBackupLibrary::SaveBackupManifest(const FString& BackupDirectory, const FBackupManifest& Manifest)
+{
+	FString JsonString;
+	if (!FJsonObjectConverter::UStructToJsonObjectString(Manifest, JsonString))
+	{
+		return false;
+	}
+
+	// Written to a temporary file first, so a crash never leaves a truncated manifest behind
+	const FString ManifestPath = GetManifestPath(BackupDirectory, Manifest.SnapshotId);
+	const FString TempPath = ManifestPath + TEXT(".tmp");
+
+	return FFileHelper::SaveStringToFile(JsonString, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM)
+		&& IFileManager::Get().Move(*ManifestPath, *TempPath, true);
+}
+
+bool UIncrementalBackupLibrary::LoadLatestBackupManifest(const FString& BackupDirectory, FBackupManifest& OutManifest)
+{
+	TArray<FBackupSnapshotInfo> Snapshots;
+	return GetBackupSnapshots(BackupDirectory, Snapshots) && LoadBackupManifest(BackupDirectory, Snapshots.Last().SnapshotId, OutManifest);
+}
+
+FBackupSnapshotInfo UIncrementalBackupLibrary::MakeSnapshotInfo(const FBackupManifest& Manifest)
+{
+	FBackupSnapshotInfo Info;
+	Info.SnapshotId = Manifest.SnapshotId;
+	Info.ParentSnapshotId = Manifest.ParentSnapshotId;
+	Info.CreatedAt = Manifest.CreatedAt;
+	Info.TotalFiles = Manifest.Files.Num();
+
+	for (const FBackupManifestFile& File : Manifest.Files)
+	{
+		Info.TotalBytes += File.Size;
+
+		if (File.Archive == Manifest.SnapshotId && File.Entry == File.Path)
+		{
+			++Info.StoredFiles;
+			Info.StoredBytes += File.Size;
+		}
+	}
+
+	return Info;
+}
+
+FString UIncrementalBackupLibrary::GetManifestPath(const FString& BackupDirectory, const FString& SnapshotId)
+{
+	return FPaths::Combine(BackupDirectory, TEXT("Snapshots"), SnapshotId + TEXT(".json"));
+}
+
+FString UIncrementalBackupLibrary::GetArchivePath(const FString& BackupDirectory, const FString& SnapshotId)
+{
+	return FPaths::Combine(BackupDirectory, TEXT("Archives"), SnapshotId + TEXT(".zip"));
+}
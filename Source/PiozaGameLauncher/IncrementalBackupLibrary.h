@@ -0,0 +1,206 @@
+// Pioza Launcher
+// Copyright (c) 2025 DashoGames
+// Licensed under the MIT License - see LICENSE file for details
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "ChecksumLibrary.h" // Needed for EChecksumAlgorithm
+#include "IncrementalBackupLibrary.generated.h"
+
+/**
+ * A single file of a backup snapshot.
+ */
+USTRUCT(BlueprintType)
+struct FBackupManifestFile
+{
+	GENERATED_BODY()
+
+	/** Path relative to the game directory */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FString Path;
+
+	/** File size in bytes */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	int64 Size = 0;
+
+	/** Last modification time when the snapshot was taken. Stored with millisecond precision */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FDateTime ModifiedTime;
+
+	/** Checksum of the file content, computed with the snapshot algorithm */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FString Checksum;
+
+	/** Id of the snapshot whose archive stores the file content */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FString Archive;
+
+	/** Entry name of the content inside that archive. Differs from Path when the content was deduplicated from another file */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FString Entry;
+};
+
+/**
+ * Manifest of a backup snapshot. Lists every file of the game directory at the time of the backup,
+ * pointing to the archive of the snapshot that stored its content. Snapshots form a chain through ParentSnapshotId.
+ */
+USTRUCT(BlueprintType)
+struct FBackupManifest
+{
+	GENERATED_BODY()
+
+	/** Manifest layout version. 2 added FilesToIgnore */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	int32 Version = 2;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FString SnapshotId;
+
+	/** Snapshot this one was compared against. Empty for the first (full) snapshot */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FString ParentSnapshotId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FDateTime CreatedAt;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	EChecksumAlgorithm Algorithm = EChecksumAlgorithm::MD5;
+
+	/** Patterns skipped by the backup. Restoring never removes the matching files, as their content was not stored */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	TArray<FString> FilesToIgnore;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	TArray<FBackupManifestFile> Files;
+};
+
+/**
+ * Summary of a backup snapshot, for displaying the backup history.
+ */
+USTRUCT(BlueprintType)
+struct FBackupSnapshotInfo
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FString SnapshotId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FString ParentSnapshotId;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	FDateTime CreatedAt;
+
+	/** Number of files in the snapshot */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	int32 TotalFiles = 0;
+
+	/** Number of files whose content was stored by this snapshot, the rest is shared with earlier snapshots */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	int32 StoredFiles = 0;
+
+	/** Size of all files in the snapshot */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	int64 TotalBytes = 0;
+
+	/** Size of the files stored by this snapshot */
+	UPROPERTY(BlueprintReadOnly, Category = "Backup")
+	int64 StoredBytes = 0;
+};
+
+/**
+ * Delegate for progress updates.
+ * @param ProgressPercent - Value between 0.0 and 1.0.
+ * @param CurrentFile - The relative path of the file currently being processed.
+ */
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnBackupProgress, float, ProgressPercent, FString, CurrentFile);
+
+/**
+ * Delegate for backup completion.
+ * @param bSuccess - Whether the snapshot was written.
+ * @param Snapshot - Summary of the written snapshot.
+ * @param ErrorMessage - Reason of the failure, empty on success.
+ */
+DECLARE_DYNAMIC_DELEGATE_ThreeParams(FOnBackupComplete, bool, bSuccess, FBackupSnapshotInfo, Snapshot, FString, ErrorMessage);
+
+/**
+ * Delegate for restore completion.
+ * @param bSuccess - Whether every file of the snapshot was restored.
+ * @param ErrorMessage - Reason of the failure, empty on success.
+ */
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnRestoreComplete, bool, bSuccess, FString, ErrorMessage);
+
+/**
+ * Incremental, deduplicated backups of a game directory.
+ *
+ * Layout of the backup directory:
+ *   Snapshots/<SnapshotId>.json - manifest of every snapshot
+ *   Archives/<SnapshotId>.zip   - content stored by the snapshot (only files that changed since the previous one)
+ *
+ * A file is considered unchanged if its size and modification time match the previous snapshot; otherwise its checksum
+ * is computed and compared, so touched but identical files are not stored again. Identical content under different paths
+ * (renamed or duplicated files) is stored only once.
+ */
+UCLASS()
+class PIOZAGAMELAUNCHER_API UIncrementalBackupLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Takes a snapshot of the game directory, storing only files changed since the latest snapshot.
+	 *
+	 * @param GameDirectory   Absolute path to the game root folder.
+	 * @param BackupDirectory Folder holding the snapshots of this game.
+	 * @param FilesToIgnore   List of patterns to skip (supports wildcards like "*.log" or "Saved*").
+	 * @param Algorithm       The hashing algorithm used for change detection.
+	 * @param OnProgress      Event fired to update UI (throttled).
+	 * @param OnComplete      Event fired when the snapshot is written.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Backup", meta = (AutoCreateRefTerm = "OnProgress,OnComplete,FilesToIgnore"))
+	static void CreateIncrementalBackupAsync(const FString& GameDirectory,
+											 const FString& BackupDirectory,
+											 const TArray<FString>& FilesToIgnore,
+											 EChecksumAlgorithm Algorithm,
+											 const FOnBackupProgress& OnProgress,
+											 const FOnBackupComplete& OnComplete);
+
+	/**
+	 * Restores the game directory to the state of any snapshot.
+	 *
+	 * @param BackupDirectory   Folder holding the snapshots of this game.
+	 * @param SnapshotId        Snapshot to restore. Empty restores the latest one.
+	 * @param GameDirectory     Absolute path to the game root folder.
+	 * @param bRemoveExtraFiles Whether to delete files that are not part of the snapshot. Files ignored by the backup are kept.
+	 * @param OnProgress        Event fired to update UI (throttled).
+	 * @param OnComplete        Event fired when the restore is finished.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Backup", meta = (AutoCreateRefTerm = "OnProgress,OnComplete"))
+	static void RestoreSnapshotAsync(const FString& BackupDirectory,
+									 const FString& SnapshotId,
+									 const FString& GameDirectory,
+									 bool bRemoveExtraFiles,
+									 const FOnBackupProgress& OnProgress,
+									 const FOnRestoreComplete& OnComplete);
+
+	/**
+	 * Lists all snapshots in the backup directory, oldest first.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Backup")
+	static bool GetBackupSnapshots(const FString& BackupDirectory, TArray<FBackupSnapshotInfo>& OutSnapshots);
+
+	/**
+	 * Loads the manifest of a snapshot.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Backup")
+	static bool LoadBackupManifest(const FString& BackupDirectory, const FString& SnapshotId, FBackupManifest& OutManifest);
+
+private:
+	static bool SaveBackupManifest(const FString& BackupDirectory, const FBackupManifest& Manifest);
+	static bool LoadLatestBackupManifest(const FString& BackupDirectory, FBackupManifest& OutManifest);
+	static FBackupSnapshotInfo MakeSnapshotInfo(const FBackupManifest& Manifest);
+	static FString GetManifestPath(const FString& BackupDirectory, const FString& SnapshotId);
+	static FString GetArchivePath(const FString& BackupDirectory, const FString& SnapshotId);
+};